@@ -46,17 +46,298 @@
 #include <iostream>
 #include <cstdio>
 #include <jpeglib.h>
+#include <jerror.h>
 #include <cstdlib>
+#include <cstring>
 #include <setjmp.h>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#ifdef LIBJPEGWRAP_WITH_STATS
+#include <chrono>
+#endif
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define LIBJPEGWRAP_HAS_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+#ifdef LIBJPEGWRAP_WITH_V4L2
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 typedef unsigned char byte;
 typedef unsigned long ulong;
 
+// Codec backends selectable per encoder/decoder instance
+#define JPEG_BACKEND_LIBJPEG 0    // libjpeg v6 API (scanline / raw-data loops)
+#define JPEG_BACKEND_TURBOJPEG 1  // TurboJPEG 3 API (tj3*), requires LIBJPEGWRAP_WITH_TURBOJPEG
+
+static bool IsBackendSupported(int backend) {
+    if (backend == JPEG_BACKEND_LIBJPEG) return true;
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+    if (backend == JPEG_BACKEND_TURBOJPEG) return true;
+#endif
+    return false;
+}
+
+// Per-handle codec statistics, cumulative since the handle was created (GetDecoderStats & co.).
+// Collected when built with LIBJPEGWRAP_WITH_STATS; otherwise the getters return 0.
+//   headerNs: marker/table parsing and jpeg_start_decompress for decoders; the rate-control estimate and
+//             jpeg_start_compress (tables, headers) for encoders. TurboJPEG calls report the header probe only.
+//   codingNs: the rest of the call. libjpeg runs entropy coding, (I)DCT and resampling fused per iMCU row,
+//             so they are one phase; the wrapper's per-row copies and blends are included.
+//   peakPoolBytes: most bytes held at once through libjpeg's memory manager by one set of counters
+//                  (libjpeg backend only); snapshots over several keep the largest, like CodecStats.operator+
+typedef struct {
+    uint64_t calls;
+    uint64_t errors;            // Calls that returned 0
+    uint64_t bytesIn;           // Of successful calls: JPEG bytes for decoders, raw frame bytes for encoders
+    uint64_t bytesOut;
+    uint64_t headerNs;
+    uint64_t codingNs;
+    uint64_t peakPoolBytes;
+} CodecStats;
+
+// Counters behind CodecStats. A handle is used by one thread at a time; the relaxed atomics only make
+// concurrent snapshots from a monitoring thread safe.
+class CodecCounters {
+public:
+#ifdef LIBJPEGWRAP_WITH_STATS
+    // Nested calls (an entry point delegating to another) count once, as the outermost call
+    void Begin()
+    {
+        if (depth++ == 0) {
+            start = Now();
+            header_mark = 0;
+        }
+    }
+
+    // End of the header phase of the current call; later marks are ignored
+    void MarkHeader()
+    {
+        if (depth > 0 && header_mark == 0) header_mark = Now();
+    }
+
+    void End(ulong bytesIn, ulong written)
+    {
+        if (--depth != 0) return;
+        uint64_t end = Now();
+        uint64_t header = header_mark ? header_mark - start : 0;
+        Add(calls, 1);
+        if (written == 0) {
+            Add(errors, 1);
+        } else {
+            Add(bytes_in, bytesIn);
+            Add(bytes_out, written);
+        }
+        Add(header_ns, header);
+        Add(coding_ns, end - start - header);
+    }
+
+    void PoolAlloc(size_t bytes)
+    {
+        pool_held += bytes;
+        if (pool_held > peak_pool.load(std::memory_order_relaxed)) peak_pool.store(pool_held, std::memory_order_relaxed);
+    }
+
+    void PoolFree(size_t bytes) { pool_held -= bytes; }
+
+    // Adds this handle's totals to stats; the peak keeps the larger of the two
+    void AddTo(CodecStats* stats) const
+    {
+        stats->calls += calls.load(std::memory_order_relaxed);
+        stats->errors += errors.load(std::memory_order_relaxed);
+        stats->bytesIn += bytes_in.load(std::memory_order_relaxed);
+        stats->bytesOut += bytes_out.load(std::memory_order_relaxed);
+        stats->headerNs += header_ns.load(std::memory_order_relaxed);
+        stats->codingNs += coding_ns.load(std::memory_order_relaxed);
+        stats->peakPoolBytes = std::max<uint64_t>(stats->peakPoolBytes, peak_pool.load(std::memory_order_relaxed));
+    }
+
+private:
+    std::atomic<uint64_t> calls{0}, errors{0}, bytes_in{0}, bytes_out{0}, header_ns{0}, coding_ns{0}, peak_pool{0};
+    uint64_t start = 0;
+    uint64_t header_mark = 0;
+    uint64_t pool_held = 0;
+    int depth = 0;
+
+    static uint64_t Now()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Single writer: a plain load/store pair, no locked read-modify-write
+    static void Add(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+#else
+    void Begin() {}
+    void MarkHeader() {}
+    void End(ulong, ulong) {}
+    void AddTo(CodecStats*) const {}
+#endif
+};
+
+// One public codec call: the counters see it from construction to destruction.
+// Done records the result; a call left without Done (an early error return) counts as failed.
+class CodecCall {
+public:
+    CodecCall(CodecCounters& counters, ulong bytesIn) : counters(counters), bytes_in(bytesIn) { counters.Begin(); }
+    ~CodecCall() { counters.End(bytes_in, written); }
+    CodecCall(const CodecCall&) = delete;
+    CodecCall& operator=(const CodecCall&) = delete;
+
+    ulong Done(ulong result)
+    {
+        written = result;
+        return result;
+    }
+
+private:
+    CodecCounters& counters;
+    ulong bytes_in;
+    ulong written = 0;
+};
+
+// Counts what a libjpeg object holds through its memory manager by wrapping the allocation methods
+// (jpeg_memory_mgr is public, unlike the manager's own bookkeeping). Virtual arrays are counted when
+// requested, since they are realized inside the manager; free_pool releases a pool's count.
+struct PoolMeter {
+#ifdef LIBJPEGWRAP_WITH_STATS
+    CodecCounters* counters = nullptr;
+    size_t held[JPOOL_NUMPOOLS] = {};
+    decltype(jpeg_memory_mgr::alloc_small) alloc_small = nullptr;
+    decltype(jpeg_memory_mgr::alloc_large) alloc_large = nullptr;
+    decltype(jpeg_memory_mgr::alloc_sarray) alloc_sarray = nullptr;
+    decltype(jpeg_memory_mgr::alloc_barray) alloc_barray = nullptr;
+    decltype(jpeg_memory_mgr::request_virt_sarray) request_virt_sarray = nullptr;
+    decltype(jpeg_memory_mgr::request_virt_barray) request_virt_barray = nullptr;
+    decltype(jpeg_memory_mgr::free_pool) free_pool = nullptr;
+#endif
+};
+
+#ifdef LIBJPEGWRAP_WITH_STATS
+static void pool_meter_add(j_common_ptr cinfo, int pool_id, size_t bytes) {
+    PoolMeter* meter = (PoolMeter*)cinfo->client_data;
+    if (pool_id < 0 || pool_id >= JPOOL_NUMPOOLS) return;
+    meter->held[pool_id] += bytes;
+    meter->counters->PoolAlloc(bytes);
+}
+
+static void* pool_meter_alloc_small(j_common_ptr cinfo, int pool_id, size_t size) {
+    void* result = ((PoolMeter*)cinfo->client_data)->alloc_small(cinfo, pool_id, size);
+    if (result) pool_meter_add(cinfo, pool_id, size);
+    return result;
+}
+
+static void* pool_meter_alloc_large(j_common_ptr cinfo, int pool_id, size_t size) {
+    void* result = ((PoolMeter*)cinfo->client_data)->alloc_large(cinfo, pool_id, size);
+    if (result) pool_meter_add(cinfo, pool_id, size);
+    return result;
+}
+
+static JSAMPARRAY pool_meter_alloc_sarray(j_common_ptr cinfo, int pool_id, JDIMENSION samplesperrow,
+    JDIMENSION numrows) {
+    JSAMPARRAY result = ((PoolMeter*)cinfo->client_data)->alloc_sarray(cinfo, pool_id, samplesperrow, numrows);
+    if (result) pool_meter_add(cinfo, pool_id, (size_t)numrows * (samplesperrow * sizeof(JSAMPLE) + sizeof(JSAMPROW)));
+    return result;
+}
+
+static JBLOCKARRAY pool_meter_alloc_barray(j_common_ptr cinfo, int pool_id, JDIMENSION blocksperrow,
+    JDIMENSION numrows) {
+    JBLOCKARRAY result = ((PoolMeter*)cinfo->client_data)->alloc_barray(cinfo, pool_id, blocksperrow, numrows);
+    if (result) pool_meter_add(cinfo, pool_id, (size_t)numrows * (blocksperrow * sizeof(JBLOCK) + sizeof(JBLOCKROW)));
+    return result;
+}
+
+static jvirt_sarray_ptr pool_meter_request_virt_sarray(j_common_ptr cinfo, int pool_id, boolean pre_zero,
+    JDIMENSION samplesperrow, JDIMENSION numrows, JDIMENSION maxaccess) {
+    jvirt_sarray_ptr result = ((PoolMeter*)cinfo->client_data)->request_virt_sarray(
+        cinfo, pool_id, pre_zero, samplesperrow, numrows, maxaccess);
+    if (result) pool_meter_add(cinfo, pool_id, (size_t)numrows * samplesperrow * sizeof(JSAMPLE));
+    return result;
+}
+
+static jvirt_barray_ptr pool_meter_request_virt_barray(j_common_ptr cinfo, int pool_id, boolean pre_zero,
+    JDIMENSION blocksperrow, JDIMENSION numrows, JDIMENSION maxaccess) {
+    jvirt_barray_ptr result = ((PoolMeter*)cinfo->client_data)->request_virt_barray(
+        cinfo, pool_id, pre_zero, blocksperrow, numrows, maxaccess);
+    if (result) pool_meter_add(cinfo, pool_id, (size_t)numrows * blocksperrow * sizeof(JBLOCK));
+    return result;
+}
+
+static void pool_meter_free_pool(j_common_ptr cinfo, int pool_id) {
+    PoolMeter* meter = (PoolMeter*)cinfo->client_data;
+    meter->free_pool(cinfo, pool_id);
+    if (pool_id < 0 || pool_id >= JPOOL_NUMPOOLS) return;
+    meter->counters->PoolFree(meter->held[pool_id]);
+    meter->held[pool_id] = 0;
+}
+#endif
+
+// Call right after jpeg_create_*; cinfo->client_data points at the meter from then on
+static void pool_meter_install(j_common_ptr cinfo, PoolMeter* meter, CodecCounters* counters) {
+#ifdef LIBJPEGWRAP_WITH_STATS
+    jpeg_memory_mgr* mem = cinfo->mem;
+    meter->counters = counters;
+    meter->alloc_small = mem->alloc_small;
+    meter->alloc_large = mem->alloc_large;
+    meter->alloc_sarray = mem->alloc_sarray;
+    meter->alloc_barray = mem->alloc_barray;
+    meter->request_virt_sarray = mem->request_virt_sarray;
+    meter->request_virt_barray = mem->request_virt_barray;
+    meter->free_pool = mem->free_pool;
+    mem->alloc_small = pool_meter_alloc_small;
+    mem->alloc_large = pool_meter_alloc_large;
+    mem->alloc_sarray = pool_meter_alloc_sarray;
+    mem->alloc_barray = pool_meter_alloc_barray;
+    mem->request_virt_sarray = pool_meter_request_virt_sarray;
+    mem->request_virt_barray = pool_meter_request_virt_barray;
+    mem->free_pool = pool_meter_free_pool;
+    cinfo->client_data = meter;
+#else
+    (void)cinfo; (void)meter; (void)counters;
+#endif
+}
+
+// Copies counters into stats; 0 when built without LIBJPEGWRAP_WITH_STATS
+static int codec_stats_snapshot(const CodecCounters* const* counters, int count, CodecStats* stats) {
+    memset(stats, 0, sizeof(CodecStats));
+#ifdef LIBJPEGWRAP_WITH_STATS
+    for (int i = 0; i < count; i++) counters[i]->AddTo(stats);
+    return 1;
+#else
+    (void)counters; (void)count;
+    return 0;
+#endif
+}
+
 typedef struct {
     struct jpeg_destination_mgr pub; /* Public fields */
     byte* buffer;                 /* Start of the buffer */
     ulong buffer_size;              /* Buffer size */
-    ulong data_size;                /* Final data size */
+    ulong data_size;                /* Final data size, 0 after an overflow */
+    bool failed;                    /* Output did not fit the buffer */
+    byte overflow[512];             /* Sink used after an overflow */
 } memory_destination_mgr;
 
 void init_destination(j_compress_ptr cinfo) {
@@ -64,20 +345,22 @@ void init_destination(j_compress_ptr cinfo) {
     dest->pub.next_output_byte = dest->buffer;
     dest->pub.free_in_buffer = dest->buffer_size;
     dest->data_size = 0; // No data written yet
+    dest->failed = false;
 }
 
 boolean empty_output_buffer(j_compress_ptr cinfo) {
-    // Handle buffer overflow. This could involve reallocating the buffer
-    // and updating the relevant fields in the destination manager.
-    // For simplicity, this example just prints an error and stops.
-    
-    std::cerr << "Buffer overflow in custom destination manager\n";
-    return FALSE; // Causes the library to terminate with an error.
+    // Buffer overflow: keep libjpeg running into a discard buffer, as the chunked destination
+    // does; a FALSE return would suspend, which the compressor cannot do. Callers see data_size 0.
+    memory_destination_mgr* dest = (memory_destination_mgr*)cinfo->dest;
+    dest->failed = true;
+    dest->pub.next_output_byte = dest->overflow;
+    dest->pub.free_in_buffer = sizeof(dest->overflow);
+    return TRUE;
 }
 
 void term_destination(j_compress_ptr cinfo) {
     memory_destination_mgr* dest = (memory_destination_mgr*)cinfo->dest;
-    dest->data_size = dest->buffer_size - dest->pub.free_in_buffer;
+    dest->data_size = dest->failed ? 0 : dest->buffer_size - dest->pub.free_in_buffer;
     // At this point, dest->data_size contains the size of the JPEG data.
 }
 memory_destination_mgr* jpeg_memory_dest(j_compress_ptr cinfo, byte* buffer, ulong size) {
@@ -93,6 +376,7 @@ memory_destination_mgr* jpeg_memory_dest(j_compress_ptr cinfo, byte* buffer, ulo
         dest->buffer = buffer;
         dest->buffer_size = size;
         dest->data_size = 0; // No data written yet
+        dest->failed = false;
         return dest;
     }
     else 
@@ -102,20 +386,300 @@ memory_destination_mgr* jpeg_memory_dest(j_compress_ptr cinfo, byte* buffer, ulo
         dest->buffer = buffer;
         dest->buffer_size = size;
         dest->data_size = 0; // No data written yet
+        dest->failed = false;
         return dest;
     }
 }
 
+// One contiguous piece of a chunked JPEG output.
+typedef struct {
+    byte* data;
+    ulong size;
+} JpegSegment;
+
+// Chunk allocator supplied by the caller of the chunked encode functions.
+// committed: bytes written into the previously returned chunk (0 on the first call).
+// chunkSize: receives the size of the returned chunk. nullptr on the final call,
+//            which only commits the tail of the last chunk; the return value is ignored.
+// Returns the next chunk, or nullptr when no more memory can be provided.
+typedef byte* (*jpeg_chunk_alloc)(void* ctx, ulong committed, ulong* chunkSize);
+
+// Destination manager that grows into caller-provided chunks instead of failing on overflow.
+// Storage is owned by the caller (not the libjpeg pool) so it can be swapped with
+// memory_destination_mgr on the same compress struct.
+typedef struct {
+    struct jpeg_destination_mgr pub;
+    jpeg_chunk_alloc alloc;
+    void* ctx;
+    byte* chunk;                    /* Current chunk */
+    ulong chunk_size;               /* Size of current chunk */
+    JpegSegment* segments;          /* Optional scatter list, may be nullptr */
+    int max_segments;
+    int segment_count;              /* Total chunks used (may exceed max_segments) */
+    ulong data_size;                /* Total bytes written */
+    bool failed;                    /* Allocator returned nullptr */
+    byte overflow[512];             /* Sink used after a failed allocation */
+} chunked_destination_mgr;
+
+static void chunked_next_chunk(chunked_destination_mgr* dest, ulong committed) {
+    ulong size = 0;
+    byte* chunk = dest->failed ? nullptr : dest->alloc(dest->ctx, committed, &size);
+    if (chunk == nullptr || size == 0) {
+        // Keep libjpeg running into a discard buffer; a FALSE return would suspend forever.
+        dest->failed = true;
+        dest->chunk = dest->overflow;
+        dest->chunk_size = sizeof(dest->overflow);
+    } else {
+        if (dest->segment_count < dest->max_segments) {
+            dest->segments[dest->segment_count].data = chunk;
+            dest->segments[dest->segment_count].size = 0;
+        }
+        dest->segment_count++;
+        dest->chunk = chunk;
+        dest->chunk_size = size;
+    }
+    dest->pub.next_output_byte = dest->chunk;
+    dest->pub.free_in_buffer = dest->chunk_size;
+}
+
+static void chunked_commit(chunked_destination_mgr* dest, ulong used) {
+    if (dest->failed) return;
+    if (dest->segment_count > 0 && dest->segment_count <= dest->max_segments) {
+        dest->segments[dest->segment_count - 1].size = used;
+    }
+    dest->data_size += used;
+}
+
+void init_chunked_destination(j_compress_ptr cinfo) {
+    chunked_destination_mgr* dest = (chunked_destination_mgr*)cinfo->dest;
+    dest->segment_count = 0;
+    dest->data_size = 0;
+    dest->failed = false;
+    chunked_next_chunk(dest, 0);
+}
+
+boolean empty_chunked_output_buffer(j_compress_ptr cinfo) {
+    chunked_destination_mgr* dest = (chunked_destination_mgr*)cinfo->dest;
+    // libjpeg requires the whole buffer to be flushed, free_in_buffer is not meaningful here.
+    chunked_commit(dest, dest->chunk_size);
+    chunked_next_chunk(dest, dest->failed ? 0 : dest->chunk_size);
+    return TRUE;
+}
+
+void term_chunked_destination(j_compress_ptr cinfo) {
+    chunked_destination_mgr* dest = (chunked_destination_mgr*)cinfo->dest;
+    ulong used = dest->chunk_size - dest->pub.free_in_buffer;
+    chunked_commit(dest, used);
+    if (!dest->failed) {
+        dest->alloc(dest->ctx, used, nullptr);
+    }
+}
+
+void jpeg_chunked_dest(j_compress_ptr cinfo, chunked_destination_mgr* dest,
+    jpeg_chunk_alloc alloc, void* ctx, JpegSegment* segments, int maxSegments) {
+    dest->pub.init_destination = init_chunked_destination;
+    dest->pub.empty_output_buffer = empty_chunked_output_buffer;
+    dest->pub.term_destination = term_chunked_destination;
+    dest->alloc = alloc;
+    dest->ctx = ctx;
+    dest->chunk = nullptr;
+    dest->chunk_size = 0;
+    dest->segments = segments;
+    dest->max_segments = segments != nullptr ? maxSegments : 0;
+    dest->segment_count = 0;
+    dest->data_size = 0;
+    dest->failed = false;
+    cinfo->dest = &dest->pub;
+}
+
+// Recoverable libjpeg errors: error_exit longjmps back to JPEG_CATCH in the function that made the
+// failing call, which aborts the codec object and fails - libjpeg never runs on after an error.
+// Warnings ("Corrupt JPEG data: ...") are counted by libjpeg but not printed.
+// Emscripten builds do not use setjmp (see safe_error_mgr): there error_exit only sets failed and
+// returns, JPEG_CATCH is never taken, and callers also check failed after each libjpeg call.
+struct jump_error_mgr {
+    struct jpeg_error_mgr pub;
+    bool failed;
+#ifndef __EMSCRIPTEN__
+    jmp_buf jump;
+#endif
+};
+
+static void jump_error_exit(j_common_ptr cinfo) {
+    jump_error_mgr* err = (jump_error_mgr*)cinfo->err;
+    err->failed = true;
+#ifndef __EMSCRIPTEN__
+    longjmp(err->jump, 1);
+#endif
+}
+
+static void quiet_output_message(j_common_ptr) {}
+
+static struct jpeg_error_mgr* jump_error(jump_error_mgr* err) {
+    jpeg_std_error(&err->pub);
+    err->pub.error_exit = jump_error_exit;
+    err->pub.output_message = quiet_output_message;
+    err->failed = false;
+    return &err->pub;
+}
+
+// Nonzero once a libjpeg call after this point failed; use only as the whole condition of an if,
+// in a function that is still on the stack when those calls run
+#ifdef __EMSCRIPTEN__
+#define JPEG_CATCH(err) (0)
+#else
+#define JPEG_CATCH(err) setjmp((err).jump)
+#endif
+
+// Rate control flags (match RateControlMode)
+#define RATE_FEEDBACK 1     // Learn the size model from previous frames' output
+#define RATE_COMPLEXITY 2   // Scale the prediction by a luma gradient estimate of the frame
+
+// Picks a quality per frame so encoded frames stay close to a target size.
+// Model: bytes = gain * pixels * sqrt(1 + complexity) * (scale(q) / 100)^-0.55, where complexity is
+// the mean absolute luma gradient of every 4th row pair and scale(q) libjpeg's quality scaling.
+// The exponents come from fitting sizes of natural and synthetic images over q = 5..100;
+// gain is an exponential average of what the previous frames actually produced.
+class RateControl {
+public:
+    ulong target = 0;               // Bytes per frame, 0 = disabled
+    int min_quality = 25;
+    int max_quality = 95;
+    int mode = RATE_FEEDBACK | RATE_COMPLEXITY;
+
+    bool Enabled() const { return target != 0; }
+
+    void Configure(ulong targetBytes, int minQuality, int maxQuality, int flags)
+    {
+        target = targetBytes;
+        min_quality = std::clamp(minQuality, 1, 100);
+        max_quality = std::clamp(maxQuality, min_quality, 100);
+        mode = flags;
+        gain = DefaultGain;
+        complexity = DefaultComplexity;
+    }
+
+    // Returns the quality to encode the next frame with
+    int Choose(const byte* y, int yStride, int width, int height)
+    {
+        if (mode & RATE_COMPLEXITY) complexity = Complexity(y, yStride, width, height);
+        pixels = (double)width * height;
+        double budget = (double)target / (gain * pixels * std::sqrt(1.0 + complexity));
+        // Size grows monotonically with quality: take the highest one that fits the budget
+        int q = min_quality;
+        for (int candidate = max_quality; candidate > min_quality; candidate--) {
+            if (QualityCurve(candidate) <= budget) { q = candidate; break; }
+        }
+        chosen = q;
+        return q;
+    }
+
+    void Account(ulong size)
+    {
+        if (!(mode & RATE_FEEDBACK) || size == 0 || pixels == 0) return;
+        double observed = size / (pixels * std::sqrt(1.0 + complexity) * QualityCurve(chosen));
+        gain = 0.5 * gain + 0.5 * observed;
+    }
+
+    // Mean |dx| + |dy| over every 4th row pair
+    static double Complexity(const byte* y, int stride, int width, int height)
+    {
+        if (width < 2 || height < 2) return 0;
+        uint64_t sum = 0;
+        ulong count = 0;
+        for (int row = 0; row + 1 < height; row += 4) {
+            const byte* a = y + (size_t)row * stride;
+            const byte* b = a + stride;
+            int x = 0;
+#if defined(__SSE2__)
+            __m128i acc = _mm_setzero_si128();
+            for (; x + 17 <= width; x += 16) {
+                __m128i p = _mm_loadu_si128((const __m128i*)(a + x));
+                __m128i right = _mm_loadu_si128((const __m128i*)(a + x + 1));
+                __m128i below = _mm_loadu_si128((const __m128i*)(b + x));
+                acc = _mm_add_epi64(acc, _mm_sad_epu8(p, right));
+                acc = _mm_add_epi64(acc, _mm_sad_epu8(p, below));
+            }
+            sum += (uint64_t)_mm_cvtsi128_si32(acc) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#elif defined(__ARM_NEON)
+            uint32x4_t acc = vdupq_n_u32(0);
+            for (; x + 17 <= width; x += 16) {
+                uint8x16_t p = vld1q_u8(a + x);
+                uint16x8_t d = vpaddlq_u8(vabdq_u8(p, vld1q_u8(a + x + 1)));
+                d = vpadalq_u8(d, vabdq_u8(p, vld1q_u8(b + x)));
+                acc = vpadalq_u16(acc, d);
+            }
+            sum += vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+            for (; x + 1 < width; x++)
+                sum += abs(a[x] - a[x + 1]) + abs(a[x] - b[x]);
+            count += width - 1;
+        }
+        return count == 0 ? 0 : (double)sum / count;
+    }
+
+private:
+    // Calibrated on a 720x477 photo at quality 50 (1.38 bpp, complexity 22)
+    static constexpr double DefaultGain = 0.036;
+    static constexpr double DefaultComplexity = 22.0;
+
+    double gain = DefaultGain;
+    double complexity = DefaultComplexity;
+    double pixels = 0;
+    int chosen = 0;
+
+    static double QualityCurve(int q)
+    {
+        double scale = q < 50 ? 5000.0 / q : 200.0 - 2.0 * q;
+        return std::pow(std::max(scale, 5.0) / 100.0, -0.55);
+    }
+};
+
+// Planar YUV layouts: tight Y, U, V planes back to back. Chroma planes round odd sizes up, so
+// I420 chroma is (w+1)/2 x (h+1)/2, I422 (w+1)/2 x h and I444 w x h.
+#define YUV_LAYOUT_I420 0
+#define YUV_LAYOUT_I422 1
+#define YUV_LAYOUT_I444 2
+#define YUV_LAYOUT_NATIVE 3     // Request only: the JPEG's own sampling, I420 when it has no planar equivalent
+
+static void yuv_chroma_size(int layout, int width, int height, int* chromaWidth, int* chromaHeight) {
+    *chromaWidth = layout == YUV_LAYOUT_I444 ? width : (width + 1) / 2;
+    *chromaHeight = layout == YUV_LAYOUT_I420 ? (height + 1) / 2 : height;
+}
+
+static ulong yuv_frame_size(int layout, int width, int height) {
+    int cw, ch;
+    yuv_chroma_size(layout, width, height, &cw, &ch);
+    return (ulong)width * height + 2 * (ulong)cw * ch;
+}
+
 class YuvEncoder {
 public:
    
 	struct jpeg_compress_struct cinfo;
 	struct jpeg_error_mgr jerr;
+    memory_destination_mgr* mem_dest;
+    chunked_destination_mgr chunk_dest;
+    std::vector<byte> nv12_cb, nv12_cr;     // One iMCU row of chroma: deinterleaved NV12 or padded planes
+    size_t nv12_row = 0;
+    std::vector<byte> pad_y;                // One iMCU row of luma padded to the block grid
+    int quality;
+    bool abbreviated = false;       // Frames omit DQT/DHT once the tables were sent (see SetAbbreviated)
+    RateControl rate;
+    CodecCounters stats;
+    PoolMeter meter;
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+    tjhandle tj = nullptr;
+    byte* tj_buffer = nullptr;      // Reused output for chunked encodes
+    size_t tj_buffer_size = 0;
+#endif
+    int backend;
 
-    YuvEncoder(const int width, const int height, const int quality, const int bufferSize)
+    YuvEncoder(const int width, const int height, const int quality, const int bufferSize, const int backend = JPEG_BACKEND_LIBJPEG)
     {
     	cinfo.err = jpeg_std_error(&jerr);
 		jpeg_create_compress(&cinfo);
+        pool_meter_install((j_common_ptr)&cinfo, &meter, &stats);
         cinfo.image_width = width;
         cinfo.image_height = height;
         cinfo.input_components = 3;
@@ -124,6 +688,7 @@ public:
         
         jpeg_set_defaults(&cinfo);
         jpeg_set_quality(&cinfo, quality, FALSE);
+        this->quality = quality;
         
         cinfo.raw_data_in = TRUE; // Supply downsampled data
         cinfo.comp_info[0].h_samp_factor = 2;
@@ -133,12 +698,90 @@ public:
         cinfo.comp_info[2].h_samp_factor = 1;
         cinfo.comp_info[2].v_samp_factor = 1;
         //cinfo.dct_method = JDCT_FASTEST;
-        jpeg_memory_dest(&cinfo, nullptr, bufferSize);
+        mem_dest = jpeg_memory_dest(&cinfo, nullptr, bufferSize);
+        this->backend = backend;
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (backend == JPEG_BACKEND_TURBOJPEG) {
+            tj = tj3Init(TJINIT_COMPRESS);
+            if (tj != nullptr) {
+                tj3Set(tj, TJPARAM_QUALITY, quality);
+                tj3Set(tj, TJPARAM_SUBSAMP, TJSAMP_420);
+            }
+        }
+#endif
+    }
+    // False when the requested backend could not be initialized
+    bool IsValid() const
+    {
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        return backend != JPEG_BACKEND_TURBOJPEG || tj != nullptr;
+#else
+        return backend == JPEG_BACKEND_LIBJPEG;
+#endif
     }
-    void SetQuality(int quality)
+    // Quant tables are rebuilt only when the quality actually changes. Rejected (false) in abbreviated
+    // mode: decoders hold the published tables, and a DQT inline in one frame would reach only the
+    // decoder of that frame and stay loaded for the frames after it.
+    bool SetQuality(int quality)
 	{
+        if (quality == this->quality) return true;
+        if (abbreviated) return false;
+        this->quality = quality;
 		jpeg_set_quality(&cinfo, quality, FALSE);
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) tj3Set(tj, TJPARAM_QUALITY, quality);
+#endif
+        return true;
 	}
+    // Abbreviated datastreams: frames carry no DQT/DHT; consumers load them once from WriteTables.
+    // Tables change only with the quality, so every encoder with the same quality shares them.
+    // libjpeg backend only - returns false for TurboJPEG, which always writes full interchange streams.
+    bool SetAbbreviated(bool enabled)
+    {
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) return false;
+#endif
+        abbreviated = enabled;
+        jpeg_suppress_tables(&cinfo, enabled ? TRUE : FALSE);
+        return true;
+    }
+    // Writes a tables-only datastream (SOI, DQT, DHT, EOI) for the current quality
+    ulong WriteTables(byte* dstBuffer, ulong dstBufferSize)
+    {
+        cinfo.dest = &mem_dest->pub;
+        jpeg_memory_dest(&cinfo, dstBuffer, dstBufferSize);
+        jpeg_suppress_tables(&cinfo, FALSE);  // Only unsent tables are written; leaves all marked sent
+        jpeg_write_tables(&cinfo);
+        return mem_dest->data_size;
+    }
+    // Target-size mode: the quality is re-chosen before every frame (targetBytes 0 = fixed quality).
+    // Abbreviated encoders keep their quality, see SetQuality.
+    void SetTargetSize(ulong targetBytes, int minQuality, int maxQuality, int flags)
+    {
+        rate.Configure(targetBytes, minQuality, maxQuality, flags);
+    }
+    int GetQuality() const { return quality; }
+    ulong FrameBytes() const
+    {
+        return yuv_frame_size(YUV_LAYOUT_I420, cinfo.image_width, cinfo.image_height);
+    }
+    void BeginFrame(const byte* y, int yStride)
+    {
+        if (rate.Enabled()) SetQuality(rate.Choose(y, yStride, cinfo.image_width, cinfo.image_height));
+    }
+    ulong EndFrame(ulong size)
+    {
+        if (rate.Enabled() && size != 0) rate.Account(size);
+        return size;
+    }
+    // Emits a restart marker every `rows` MCU rows (0 = none), making the output stripe-decodable
+    void SetRestartRows(int rows)
+    {
+        cinfo.restart_in_rows = rows;
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) tj3Set(tj, TJPARAM_RESTARTROWS, rows);
+#endif
+    }
     // 0 - int
     // 1 - fast
     void SetMode(int mode)
@@ -147,50 +790,234 @@ public:
             cinfo.dct_method = JDCT_ISLOW;
         else 
             cinfo.dct_method = JDCT_FASTEST;
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) tj3Set(tj, TJPARAM_FASTDCT, mode != 0);
+#endif
     }
     ulong Encode(byte* data, byte* dstBuffer, ulong dstBufferSize)
     {
         //CHECK_ALLOCATION();
+        CodecCall call(stats, FrameBytes());
+        BeginFrame(data, cinfo.image_width);
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) {
+            // Compress straight into the caller's buffer; fails instead of reallocating
+            byte* jpegBuf = dstBuffer;
+            size_t jpegSize = dstBufferSize;
+            tj3Set(tj, TJPARAM_NOREALLOC, 1);
+            if (CompressTurbo(data, &jpegBuf, &jpegSize) < 0) return 0;
+            return call.Done(EndFrame((ulong)jpegSize));
+        }
+#endif
         
+        cinfo.dest = &mem_dest->pub;
         jpeg_memory_dest(&cinfo, dstBuffer, dstBufferSize);
-        jpeg_start_compress(&cinfo, TRUE);
-      
-        auto width = cinfo.image_width;
-        auto height = cinfo.image_height;
-
-        // Calculate the sizes of the Y, U, and V planes
-        size_t sizeY = width * height;
-        size_t sizeU = sizeY / 4;
-        //size_t sizeV = sizeU; // Same as sizeU
-
-        // Split yuv420Data into Y, U, and V components
-        byte* Y = data;
-        byte* U = data + sizeY;
-        byte* V = data + sizeY + sizeU;
+        Compress(data);
+        return call.Done(EndFrame(mem_dest->data_size));
+    }
+    // Encodes into chunks obtained from alloc; optionally records them in segments.
+    // Returns total bytes written, or 0 if the allocator ran out of memory.
+    ulong EncodeChunked(byte* data, jpeg_chunk_alloc alloc, void* ctx,
+        JpegSegment* segments, int maxSegments, int* segmentCount)
+    {
+        CodecCall call(stats, FrameBytes());
+        BeginFrame(data, cinfo.image_width);
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) return call.Done(EndFrame(EncodeChunkedTurbo(data, alloc, ctx, segments, maxSegments, segmentCount)));
+#endif
+        jpeg_chunked_dest(&cinfo, &chunk_dest, alloc, ctx, segments, maxSegments);
+        Compress(data);
+        if (segmentCount != nullptr) *segmentCount = chunk_dest.segment_count;
+        return call.Done(EndFrame(chunk_dest.failed ? 0 : chunk_dest.data_size));
+    }
+    void Compress(byte* data)
+    {
+        int width = cinfo.image_width;
+        int cw, ch;
+        yuv_chroma_size(YUV_LAYOUT_I420, width, cinfo.image_height, &cw, &ch);
+        size_t sizeY = (size_t)width * cinfo.image_height;
+        CompressPlanes(data, width, data + sizeY, data + sizeY + (size_t)cw * ch, cw, nullptr);
+    }
+    // Raw 4:2:0 compress from per-plane pointers and strides. With uv set, chroma is NV12-interleaved
+    // (u and v are ignored) and is split into nv12_cb/nv12_cr one iMCU row at a time.
+    // Raw input reads whole DCT blocks: rows below the image are replicated from the last row, and planes
+    // off the block grid are copied into the same scratch rows with their last column replicated, instead
+    // of reading the start of the next row into the edge blocks.
+    void CompressPlanes(const byte* y, int yStride, const byte* u, const byte* v, int uvStride, const byte* uv)
+    {
+        // Abbreviated: the tables were marked sent by SetAbbreviated / WriteTables and never change
+        jpeg_start_compress(&cinfo, abbreviated ? FALSE : TRUE);
+        stats.MarkHeader();
+
+        int width = cinfo.image_width;
+        int height = cinfo.image_height;
+        int chromaWidth = (width + 1) / 2;
+        int chromaHeight = (height + 1) / 2;
+        size_t lumaRow = (size_t)cinfo.comp_info[0].width_in_blocks * DCTSIZE;
+        size_t chromaRow = (size_t)cinfo.comp_info[1].width_in_blocks * DCTSIZE;
+        bool padLuma = lumaRow != (size_t)width;
+        bool padChroma = uv != nullptr || chromaRow != (size_t)chromaWidth;
+        if (padLuma && pad_y.size() < lumaRow * 16) pad_y.assign(lumaRow * 16, 0);
+        if (padChroma) {
+            if (nv12_cb.size() < chromaRow * 8) {
+                nv12_cb.assign(chromaRow * 8, 0);
+                nv12_cr.assign(chromaRow * 8, 0);
+            }
+            nv12_row = chromaRow;
+        }
 
         while (cinfo.next_scanline < cinfo.image_height) {
-            JSAMPROW y[16], cb[8], cr[8];
-            for (int i = 0; i < 16 && cinfo.next_scanline + i < cinfo.image_height; i++) {
-                y[i] = &Y[(cinfo.next_scanline + i) * width];
-                if (i % 2 == 0) {
-                    cb[i / 2] = &U[((cinfo.next_scanline + i) / 2) * (width / 2)];
-                    cr[i / 2] = &V[((cinfo.next_scanline + i) / 2) * (width / 2)];
+            JSAMPROW yr[16], cb[8], cr[8];
+            int row = cinfo.next_scanline;
+            for (int i = 0; i < 16; i++) {
+                const byte* src = y + (size_t)std::min(row + i, height - 1) * yStride;
+                if (padLuma) {
+                    byte* dst = pad_y.data() + i * lumaRow;
+                    memcpy(dst, src, width);
+                    memset(dst + width, src[width - 1], lumaRow - width);
+                    yr[i] = dst;
+                } else {
+                    yr[i] = (JSAMPROW)src;
+                }
+            }
+            for (int i = 0; i < 8; i++) {
+                int c = std::min(row / 2 + i, chromaHeight - 1);
+                if (padChroma) {
+                    byte* dcb = nv12_cb.data() + i * nv12_row;
+                    byte* dcr = nv12_cr.data() + i * nv12_row;
+                    if (uv != nullptr) {
+                        DeinterleaveRow(uv + (size_t)c * uvStride, dcb, dcr, chromaWidth);
+                    } else {
+                        memcpy(dcb, u + (size_t)c * uvStride, chromaWidth);
+                        memcpy(dcr, v + (size_t)c * uvStride, chromaWidth);
+                    }
+                    memset(dcb + chromaWidth, dcb[chromaWidth - 1], nv12_row - chromaWidth);
+                    memset(dcr + chromaWidth, dcr[chromaWidth - 1], nv12_row - chromaWidth);
+                    cb[i] = dcb;
+                    cr[i] = dcr;
+                } else {
+                    cb[i] = (JSAMPROW)(u + (size_t)c * uvStride);
+                    cr[i] = (JSAMPROW)(v + (size_t)c * uvStride);
                 }
             }
-            JSAMPARRAY planes[3] = { y, cb, cr };
-            //{
-                //CHECK_ALLOCATION();
+            JSAMPARRAY planes[3] = { yr, cb, cr };
             jpeg_write_raw_data(&cinfo, planes, 16);
-            //}
         }
-        
+
         jpeg_finish_compress(&cinfo);
-        
-        memory_destination_mgr* dest = (memory_destination_mgr*)cinfo.dest;
-        return dest->data_size;
     }
+    static void DeinterleaveRow(const byte* uv, byte* cb, byte* cr, int count)
+    {
+        int x = 0;
+#if defined(__SSE2__)
+        const __m128i even = _mm_set1_epi16(0x00FF);
+        for (; x + 16 <= count; x += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(uv + 2 * x));
+            __m128i b = _mm_loadu_si128((const __m128i*)(uv + 2 * x + 16));
+            _mm_storeu_si128((__m128i*)(cb + x), _mm_packus_epi16(_mm_and_si128(a, even), _mm_and_si128(b, even)));
+            _mm_storeu_si128((__m128i*)(cr + x), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+        }
+#elif defined(__ARM_NEON)
+        for (; x + 16 <= count; x += 16) {
+            uint8x16x2_t p = vld2q_u8(uv + 2 * x);
+            vst1q_u8(cb + x, p.val[0]);
+            vst1q_u8(cr + x, p.val[1]);
+        }
+#endif
+        for (; x < count; x++) {
+            cb[x] = uv[2 * x];
+            cr[x] = uv[2 * x + 1];
+        }
+    }
+    ulong EncodePlanes(const byte* y, int yStride, const byte* u, const byte* v, int uvStride,
+        byte* dstBuffer, ulong dstBufferSize)
+    {
+        CodecCall call(stats, FrameBytes());
+        BeginFrame(y, yStride);
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) {
+            byte* jpegBuf = dstBuffer;
+            size_t jpegSize = dstBufferSize;
+            const byte* planes[3] = { y, u, v };
+            int strides[3] = { yStride, uvStride, uvStride };
+            tj3Set(tj, TJPARAM_NOREALLOC, 1);
+            if (tj3CompressFromYUVPlanes8(tj, planes, cinfo.image_width, strides, cinfo.image_height, &jpegBuf, &jpegSize) < 0)
+                return 0;
+            return call.Done(EndFrame((ulong)jpegSize));
+        }
+#endif
+        cinfo.dest = &mem_dest->pub;
+        jpeg_memory_dest(&cinfo, dstBuffer, dstBufferSize);
+        CompressPlanes(y, yStride, u, v, uvStride, nullptr);
+        return call.Done(EndFrame(mem_dest->data_size));
+    }
+    // TurboJPEG has no NV12 input, so NV12 always goes through libjpeg raw input
+    ulong EncodeNv12(const byte* y, int yStride, const byte* uv, int uvStride,
+        byte* dstBuffer, ulong dstBufferSize)
+    {
+        CodecCall call(stats, FrameBytes());
+        BeginFrame(y, yStride);
+        cinfo.dest = &mem_dest->pub;
+        jpeg_memory_dest(&cinfo, dstBuffer, dstBufferSize);
+        CompressPlanes(y, yStride, nullptr, nullptr, uvStride, uv);
+        return call.Done(EndFrame(mem_dest->data_size));
+    }
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+    int CompressTurbo(byte* data, byte** jpegBuf, size_t* jpegSize)
+    {
+        int width = cinfo.image_width;
+        int height = cinfo.image_height;
+        int cw, ch;
+        yuv_chroma_size(YUV_LAYOUT_I420, width, height, &cw, &ch);
+        size_t sizeY = (size_t)width * height;
+        const byte* planes[3] = { data, data + sizeY, data + sizeY + (size_t)cw * ch };
+        int strides[3] = { width, cw, cw };
+        return tj3CompressFromYUVPlanes8(tj, planes, width, strides, height, jpegBuf, jpegSize);
+    }
+
+    // TurboJPEG has no pluggable destination: compress into a reusable buffer, then copy out.
+    ulong EncodeChunkedTurbo(byte* data, jpeg_chunk_alloc alloc, void* ctx,
+        JpegSegment* segments, int maxSegments, int* segmentCount)
+    {
+        size_t jpegSize = tj_buffer_size;
+        tj3Set(tj, TJPARAM_NOREALLOC, 0);
+        if (CompressTurbo(data, &tj_buffer, &jpegSize) < 0) {
+            if (segmentCount != nullptr) *segmentCount = 0;
+            return 0;
+        }
+        if (jpegSize > tj_buffer_size) tj_buffer_size = jpegSize;
+
+        int count = 0;
+        size_t copied = 0;
+        ulong committed = 0;
+        while (copied < jpegSize) {
+            ulong chunkSize = 0;
+            byte* chunk = alloc(ctx, committed, &chunkSize);
+            if (chunk == nullptr || chunkSize == 0) {
+                if (segmentCount != nullptr) *segmentCount = count;
+                return 0;
+            }
+            size_t n = jpegSize - copied < chunkSize ? jpegSize - copied : chunkSize;
+            memcpy(chunk, tj_buffer + copied, n);
+            if (segments != nullptr && count < maxSegments) {
+                segments[count].data = chunk;
+                segments[count].size = n;
+            }
+            count++;
+            copied += n;
+            committed = n;
+        }
+        alloc(ctx, committed, nullptr);
+        if (segmentCount != nullptr) *segmentCount = count;
+        return (ulong)jpegSize;
+    }
+#endif
     ~YuvEncoder()
     {
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) tj3Destroy(tj);
+        if (tj_buffer) tj3Free(tj_buffer);
+#endif
         jpeg_destroy_compress(&cinfo);
     }
 };
@@ -201,6 +1028,9 @@ typedef struct {
     struct jpeg_source_mgr pub;
     const byte* buffer;
     ulong buffer_size;
+    const JpegSegment* segments;    // Scatter-list input, see jpeg_segment_src
+    int segment_count;
+    int segment_index;              // Next segment to hand to libjpeg
 } memory_source_mgr;
 
 void init_source(j_decompress_ptr cinfo) {
@@ -245,130 +1075,457 @@ void jpeg_memory_src(j_decompress_ptr cinfo, const byte* buffer, ulong size) {
     src->pub.bytes_in_buffer = size;
 }
 
+// Scatter-list source: fill_input_buffer hands the segments to libjpeg one at a time, so input
+// split across buffers (pipe segments) decodes without being copied together first
+static boolean segment_fill_input_buffer(j_decompress_ptr cinfo) {
+    memory_source_mgr* src = (memory_source_mgr*)cinfo->src;
+    while (src->segment_index < src->segment_count) {
+        const JpegSegment* segment = &src->segments[src->segment_index++];
+        if (segment->size == 0) continue;
+        src->pub.next_input_byte = segment->data;
+        src->pub.bytes_in_buffer = segment->size;
+        return TRUE;
+    }
+
+    // Out of data: a fake EOI, as libjpeg's own sources do, ends a truncated frame instead of stalling.
+    // The warning it raises is how the segment decodes tell a truncated frame from a whole one.
+    WARNMS(cinfo, JWRN_JPEG_EOF);
+    static const JOCTET fake_eoi[2] = { 0xFF, JPEG_EOI };
+    src->pub.next_input_byte = fake_eoi;
+    src->pub.bytes_in_buffer = 2;
+    return TRUE;
+}
+
+static void segment_skip_input_data(j_decompress_ptr cinfo, long num_bytes) {
+    memory_source_mgr* src = (memory_source_mgr*)cinfo->src;
+    if (num_bytes <= 0) return;
+    while (num_bytes > (long)src->pub.bytes_in_buffer) {
+        num_bytes -= (long)src->pub.bytes_in_buffer;
+        segment_fill_input_buffer(cinfo);
+    }
+    src->pub.next_input_byte += num_bytes;
+    src->pub.bytes_in_buffer -= num_bytes;
+}
+
+// Segments must stay valid until the decode finishes; zero-length segments are skipped
+void jpeg_segment_src(j_decompress_ptr cinfo, const JpegSegment* segments, int count) {
+    jpeg_memory_src(cinfo, nullptr, 0);
+
+    memory_source_mgr* src = (memory_source_mgr*)cinfo->src;
+    src->pub.fill_input_buffer = segment_fill_input_buffer;
+    src->pub.skip_input_data = segment_skip_input_data;
+    src->segments = segments;
+    src->segment_count = count;
+    src->segment_index = 0;
+}
+
 // Decoder result structure
 typedef struct {
     int width;
     int height;
     int components;
     int colorSpace;
+    int stride;         // Row stride in bytes of the first plane; set by crop and packed (BGRA/RGBA) decodes
+    int layout;         // YUV_LAYOUT_* written by planar YUV decodes; the JPEG's own sampling from header probes
 } DecodeInfo;
 
-// Pooled I420 Decoder - reuses jpeg_decompress_struct across calls
-class I420Decoder {
+// DC change analysis result, see I420Decoder::AnalyzeDc
+typedef struct {
+    int width;          // DC map size: one sample per 8x8 luma block
+    int height;
+    int compared;       // 0 when there was no reference map of this size (first frame, size change, reset)
+    int changedBlocks;  // Blocks whose mean luma moved by more than the threshold
+    int maxDifference;  // Largest block change, 0-255
+    ulong sumDifference; // Sum of absolute block changes
+} DcChangeInfo;
+
+#define DC_KEEP_REFERENCE 1     // Compare against the reference map without replacing it
+
+// Layout matching the sampling factors, -1 for grayscale or sampling none of them expresses
+static int sampling_layout(const jpeg_component_info* comps, int count) {
+    if (count != 3) return -1;
+    for (int ci = 1; ci < 3; ci++) {
+        if (comps[ci].h_samp_factor != 1 || comps[ci].v_samp_factor != 1) return -1;
+    }
+    int h = comps[0].h_samp_factor, v = comps[0].v_samp_factor;
+    if (h == 2 && v == 2) return YUV_LAYOUT_I420;
+    if (h == 2 && v == 1) return YUV_LAYOUT_I422;
+    if (h == 1 && v == 1) return YUV_LAYOUT_I444;
+    return -1;
+}
+
+static int jpeg_native_layout(j_decompress_ptr cinfo) {
+    return sampling_layout(cinfo->comp_info, cinfo->num_components);
+}
+
+// DCT-domain downscale: the IDCT emits 1/scale of each dimension (rounded up), which is
+// much cheaper than decoding full size and resizing afterwards
+static bool IsScaleSupported(int scaleDenom) {
+    return scaleDenom == 1 || scaleDenom == 2 || scaleDenom == 4 || scaleDenom == 8;
+}
+
+// Scaled block sizes - libjpeg 7+ tracks horizontal and vertical IDCT sizes separately
+#if JPEG_LIB_VERSION >= 70
+#define MIN_DCT_H_SCALED(cinfo) ((cinfo)->min_DCT_h_scaled_size)
+#define MIN_DCT_V_SCALED(cinfo) ((cinfo)->min_DCT_v_scaled_size)
+#define COMP_DCT_H_SCALED(comp) ((comp)->DCT_h_scaled_size)
+#define COMP_DCT_V_SCALED(comp) ((comp)->DCT_v_scaled_size)
+#else
+#define MIN_DCT_H_SCALED(cinfo) ((cinfo)->min_DCT_scaled_size)
+#define MIN_DCT_V_SCALED(cinfo) ((cinfo)->min_DCT_scaled_size)
+#define COMP_DCT_H_SCALED(comp) ((comp)->DCT_scaled_size)
+#define COMP_DCT_V_SCALED(comp) ((comp)->DCT_scaled_size)
+#endif
+
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+// Call after tj3DecompressHeader; yields the scaled output size. Scale 1 resets a previous factor.
+static bool tj_set_scale(tjhandle tj, int scaleDenom, int* width, int* height) {
+    tjscalingfactor sf = { 1, scaleDenom };
+    if (tj3SetScalingFactor(tj, sf) < 0) return false;
+    *width = TJSCALED(tj3Get(tj, TJPARAM_JPEGWIDTH), sf);
+    *height = TJSCALED(tj3Get(tj, TJPARAM_JPEGHEIGHT), sf);
+    return true;
+}
+#endif
+
+// Fixed group of native worker threads for fork-join loops.
+// Run(count, job) hands indices 0..count-1 out to the workers (the calling thread is worker 0)
+// and returns when all are done. One loop runs at a time per group; concurrent callers are serialized.
+// Without thread support the calling thread runs every index.
+class WorkerGroup {
 public:
-    struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    int max_width;
-    int max_height;
-    bool initialized;
+    typedef void (*Job)(void* ctx, int worker, int index);
 
-    I420Decoder(int maxWidth, int maxHeight)
-        : max_width(maxWidth), max_height(maxHeight), initialized(false)
+    explicit WorkerGroup(int threads)
     {
-        cinfo.err = jpeg_std_error(&jerr);
-        jpeg_create_decompress(&cinfo);
-        initialized = true;
+        if (threads < 1) threads = 1;
+#ifdef LIBJPEGWRAP_HAS_THREADS
+        size = threads;
+        // Worker 0 is the calling thread
+        for (int i = 1; i < threads; i++) {
+            workers.emplace_back(&WorkerGroup::WorkerLoop, this, i);
+        }
+#endif
     }
 
-    ~I420Decoder()
+    ~WorkerGroup()
     {
-        if (initialized) {
-            jpeg_destroy_decompress(&cinfo);
-            initialized = false;
+#ifdef LIBJPEGWRAP_HAS_THREADS
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            stopping = true;
         }
+        work_ready.notify_all();
+        for (auto& worker : workers) worker.join();
+#endif
     }
 
-    ulong DecodeI420(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info)
+    int Size() const { return size; }
+
+    void Run(int count, Job job, void* ctx)
     {
-        // Set up memory source
-        if (cinfo.src == nullptr) {
-            cinfo.src = (struct jpeg_source_mgr*)
-                (*cinfo.mem->alloc_small)((j_common_ptr)&cinfo, JPOOL_PERMANENT,
-                    sizeof(memory_source_mgr));
+        if (count <= 0) return;
+#ifdef LIBJPEGWRAP_HAS_THREADS
+        std::lock_guard<std::mutex> runLock(run_mutex);
+        Loop loop = { job, ctx, count, {0} };
+
+        int helpers = (int)workers.size();
+        if (helpers > count - 1) helpers = count - 1;
+        if (helpers > 0) {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            current = &loop;
+            loop_helpers = helpers;
+            active_helpers = helpers;
+            generation++;
         }
+        if (helpers > 0) work_ready.notify_all();
 
-        memory_source_mgr* src = (memory_source_mgr*)cinfo.src;
-        src->pub.init_source = init_source;
-        src->pub.fill_input_buffer = fill_input_buffer;
-        src->pub.skip_input_data = skip_input_data;
-        src->pub.resync_to_restart = jpeg_resync_to_restart;
-        src->pub.term_source = term_source;
-        src->buffer = jpegData;
-        src->buffer_size = jpegSize;
-        src->pub.next_input_byte = jpegData;
-        src->pub.bytes_in_buffer = jpegSize;
+        Drain(loop, 0);
 
-        if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
-            return 0;
+        if (helpers > 0) {
+            std::unique_lock<std::mutex> lock(state_mutex);
+            work_done.wait(lock, [this] { return active_helpers == 0; });
+            current = nullptr;
         }
+#else
+        for (int i = 0; i < count; i++) job(ctx, 0, i);
+#endif
+    }
 
-        // Request raw YUV output
-        cinfo.raw_data_out = TRUE;
-        cinfo.out_color_space = JCS_YCbCr;
+private:
+    int size = 1;
+
+#ifdef LIBJPEGWRAP_HAS_THREADS
+    struct Loop {
+        Job job;
+        void* ctx;
+        int count;
+        std::atomic<int> next;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex run_mutex;
+    std::mutex state_mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    Loop* current = nullptr;
+    int loop_helpers = 0;           // Helpers taking part in the current loop
+    int active_helpers = 0;         // Helpers still running the current loop
+    unsigned long generation = 0;
+    bool stopping = false;
+
+    static void Drain(Loop& loop, int worker)
+    {
+        for (int i = loop.next++; i < loop.count; i = loop.next++) {
+            loop.job(loop.ctx, worker, i);
+        }
+    }
 
-        jpeg_start_decompress(&cinfo);
+    void WorkerLoop(int index)
+    {
+        unsigned long seen = 0;
+        for (;;) {
+            Loop* loop;
+            {
+                std::unique_lock<std::mutex> lock(state_mutex);
+                work_ready.wait(lock, [&] { return stopping || (generation != seen && active_helpers > 0); });
+                if (stopping) return;
+                seen = generation;
+                // Only as many helpers as the loop needs take part
+                if (index > loop_helpers) continue;
+                loop = current;
+            }
 
-        int width = cinfo.output_width;
-        int height = cinfo.output_height;
+            Drain(*loop, index);
 
-        info->width = width;
-        info->height = height;
-        info->components = 3;
-        info->colorSpace = cinfo.out_color_space;
+            {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                if (--active_helpers == 0) work_done.notify_one();
+            }
+        }
+    }
+#endif
+};
 
-        // I420 size
-        ulong sizeY = width * height;
-        ulong sizeU = sizeY / 4;
-        ulong sizeV = sizeU;
-        ulong totalSize = sizeY + sizeU + sizeV;
+// Output formats for striped decode (match DecoderSet / HdrFusedDecoder formats)
+#define DECODE_FORMAT_I420 0
+#define DECODE_FORMAT_GRAY 1
 
-        if (totalSize > outputSize) {
+class RestartStripes;
+
+// Pooled I420 Decoder - reuses jpeg_decompress_struct across calls
+class I420Decoder {
+public:
+    struct jpeg_decompress_struct cinfo;
+    jump_error_mgr jerr;    // Armed by each public entry point; a failed decode returns 0
+    int max_width;
+    int max_height;
+    bool initialized;
+    int backend;
+    RestartStripes* stripes = nullptr;  // Optional intra-frame parallel decode, see SetStripeThreads
+    CodecCounters stats;
+    PoolMeter meter;
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+    tjhandle tj = nullptr;
+#endif
+
+    I420Decoder(int maxWidth, int maxHeight, int backend = JPEG_BACKEND_LIBJPEG)
+        : max_width(maxWidth), max_height(maxHeight), initialized(false), backend(backend)
+    {
+        cinfo.err = jump_error(&jerr);
+        jpeg_create_decompress(&cinfo);
+        pool_meter_install((j_common_ptr)&cinfo, &meter, &stats);
+        initialized = true;
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (backend == JPEG_BACKEND_TURBOJPEG) tj = tj3Init(TJINIT_DECOMPRESS);
+#endif
+    }
+
+    // False when the requested backend could not be initialized
+    bool IsValid() const
+    {
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        return backend != JPEG_BACKEND_TURBOJPEG || tj != nullptr;
+#else
+        return backend == JPEG_BACKEND_LIBJPEG;
+#endif
+    }
+
+    ~I420Decoder();
+
+    // threads > 1 decodes JPEGs with DRI restart markers as horizontal stripes on that many threads.
+    // JPEGs that cannot be split (no DRI, progressive, restarts not on MCU-row boundaries) decode serially.
+    void SetStripeThreads(int threads);
+
+    // scaleDenom 2, 4 or 8 decodes straight to 1/scale size in the DCT domain; info reports the scaled size
+    ulong DecodeI420(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info,
+        int scaleDenom = 1)
+    {
+        return DecodeYuv(jpegData, jpegSize, output, outputSize, info, YUV_LAYOUT_I420, scaleDenom);
+    }
+
+    // Planar decode to a YUV_LAYOUT_*: chroma is kept at the JPEG's resolution where the layout matches,
+    // otherwise box-filtered down to it inside the raw-data loop (4:4:4 -> I420, say). Layouts finer than
+    // the JPEG's sampling fail, as do CMYK and RGB JPEGs; grayscale gets neutral chroma. info->layout
+    // reports the layout written.
+    ulong DecodeYuv(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info,
+        int layout, int scaleDenom = 1)
+    {
+        CodecCall call(stats, jpegSize);
+        if (!IsScaleSupported(scaleDenom) || layout < YUV_LAYOUT_I420 || layout > YUV_LAYOUT_NATIVE) return 0;
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_decompress(&cinfo); return 0; }
+        ulong striped;
+        // Stripes only split 4:2:0 frames, which is also what NATIVE resolves to for them
+        if (stripes && scaleDenom == 1 && (layout == YUV_LAYOUT_I420 || layout == YUV_LAYOUT_NATIVE) &&
+            TryDecodeStriped(DECODE_FORMAT_I420, jpegData, jpegSize, output, outputSize, info, &striped)) {
+            return call.Done(striped);
+        }
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) return call.Done(Checked(DecodeYuvTurbo(jpegData, jpegSize, output, outputSize, info, layout, scaleDenom)));
+#endif
+        SetSource(jpegData, jpegSize);
+        return call.Done(Checked(DecodeYuvFromSource(output, outputSize, info, layout, scaleDenom)));
+    }
+
+    // Loads DQT/DHT from a tables-only datastream so abbreviated frames can be decoded.
+    // libjpeg path only; call after SetStripeThreads so stripe decoders get the tables too.
+    bool LoadTables(const byte* tables, ulong size);
+
+    // Header probe on the pooled decompress object; avoids a create/destroy per GetJpegImageInfo
+    int ReadInfo(const byte* jpegData, ulong jpegSize, DecodeInfo* info)
+    {
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_decompress(&cinfo); return 0; }
+        SetSource(jpegData, jpegSize);
+        if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK || jerr.failed) {
             jpeg_abort_decompress(&cinfo);
             return 0;
         }
 
-        byte* Y = output;
-        byte* U = output + sizeY;
-        byte* V = output + sizeY + sizeU;
+        info->width = cinfo.image_width;
+        info->height = cinfo.image_height;
+        info->components = cinfo.num_components;
+        info->colorSpace = cinfo.jpeg_color_space;
+        info->layout = jpeg_native_layout(&cinfo);
 
-        JSAMPROW y_rows[16];
-        JSAMPROW u_rows[8];
-        JSAMPROW v_rows[8];
-        JSAMPARRAY planes[3] = { y_rows, u_rows, v_rows };
+        jpeg_abort_decompress(&cinfo);
+        return 1;
+    }
 
-        int y_stride = width;
-        int uv_stride = width / 2;
+    // Decodes into caller-provided planes (rows of yStride / uvStride bytes). Used for stripes,
+    // which land at a row offset inside the full frame. Returns Y + U + V bytes written, 0 on error.
+    ulong DecodeI420Region(const byte* jpegData, ulong jpegSize, byte* Y, byte* U, byte* V,
+        int yStride, int uvStride, DecodeInfo* info)
+    {
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) {
+            if (tj3DecompressHeader(tj, jpegData, jpegSize) < 0) return 0;
+            if (tj3Get(tj, TJPARAM_SUBSAMP) != TJSAMP_420) return 0;
+            int width = tj3Get(tj, TJPARAM_JPEGWIDTH);
+            int height = tj3Get(tj, TJPARAM_JPEGHEIGHT);
+            byte* planes[3] = { Y, U, V };
+            int strides[3] = { yStride, uvStride, uvStride };
+            if (tj3DecompressToYUVPlanes8(tj, jpegData, jpegSize, planes, strides) < 0) return 0;
+            info->width = width;
+            info->height = height;
+            info->components = 3;
+            info->colorSpace = JCS_YCbCr;
+            info->layout = YUV_LAYOUT_I420;
+            return yuv_frame_size(YUV_LAYOUT_I420, width, height);
+        }
+#endif
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_decompress(&cinfo); return 0; }
+        SetSource(jpegData, jpegSize);
+        int layout = YUV_LAYOUT_I420;
+        if (!StartRaw(info, &layout, 1)) return 0;
+        if (!ReadRawPlanar(Y, U, V, yStride, uvStride, layout)) {
+            jpeg_abort_decompress(&cinfo);
+            return 0;
+        }
+        return Checked(yuv_frame_size(layout, info->width, info->height));
+    }
 
-        while (cinfo.output_scanline < cinfo.output_height) {
-            for (int i = 0; i < 16; i++) {
-                int y_line = cinfo.output_scanline + i;
-                if (y_line < height) {
-                    y_rows[i] = Y + y_line * y_stride;
-                } else {
-                    y_rows[i] = Y + (height - 1) * y_stride;
-                }
+    // Gray counterpart of DecodeI420Region: rows of rowStride bytes starting at output
+    ulong DecodeGrayRegion(const byte* jpegData, ulong jpegSize, byte* output, int rowStride, DecodeInfo* info)
+    {
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) {
+            if (tj3DecompressHeader(tj, jpegData, jpegSize) < 0) return 0;
+            int width = tj3Get(tj, TJPARAM_JPEGWIDTH);
+            int height = tj3Get(tj, TJPARAM_JPEGHEIGHT);
+            if (tj3Decompress8(tj, jpegData, jpegSize, output, rowStride, TJPF_GRAY) < 0) return 0;
+            info->width = width;
+            info->height = height;
+            info->components = 1;
+            info->colorSpace = JCS_GRAYSCALE;
+            return (ulong)width * height;
+        }
+#endif
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_decompress(&cinfo); return 0; }
+        SetSource(jpegData, jpegSize);
+        if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+            jpeg_abort_decompress(&cinfo);
+            return 0;
+        }
 
-                if (i < 8) {
-                    int uv_line = (cinfo.output_scanline / 2) + i;
-                    if (uv_line < height / 2) {
-                        u_rows[i] = U + uv_line * uv_stride;
-                        v_rows[i] = V + uv_line * uv_stride;
-                    } else {
-                        u_rows[i] = U + (height / 2 - 1) * uv_stride;
-                        v_rows[i] = V + (height / 2 - 1) * uv_stride;
-                    }
-                }
-            }
+        cinfo.out_color_space = JCS_GRAYSCALE;
+        cinfo.raw_data_out = FALSE;
+
+        jpeg_start_decompress(&cinfo);
+
+        info->width = cinfo.output_width;
+        info->height = cinfo.output_height;
+        info->components = cinfo.output_components;
+        info->colorSpace = cinfo.out_color_space;
 
-            jpeg_read_raw_data(&cinfo, planes, 16);
+        while (cinfo.output_scanline < cinfo.output_height) {
+            byte* rowPtr = output + cinfo.output_scanline * (ulong)rowStride;
+            if (jpeg_read_scanlines(&cinfo, &rowPtr, 1) == 0) {
+                jpeg_abort_decompress(&cinfo);
+                return 0;
+            }
         }
 
         jpeg_finish_decompress(&cinfo);
+        return Checked((ulong)info->width * info->height);
+    }
+
+private:
+    // Emscripten builds never take JPEG_CATCH: a libjpeg error there only sets jerr.failed
+    ulong Checked(ulong written) const
+    {
+        return jerr.failed ? 0 : written;
+    }
 
+    // Raw planar decode of whatever source is installed
+    ulong DecodeYuvFromSource(byte* output, ulong outputSize, DecodeInfo* info, int layout, int scaleDenom)
+    {
+        if (!StartRaw(info, &layout, scaleDenom)) return 0;
+
+        int width = cinfo.output_width;
+        int height = cinfo.output_height;
+        int cw, ch;
+        yuv_chroma_size(layout, width, height, &cw, &ch);
+
+        ulong sizeY = (ulong)width * height;
+        ulong sizeC = (ulong)cw * ch;
+        ulong totalSize = sizeY + 2 * sizeC;
+
+        if (totalSize > outputSize ||
+            !ReadRawPlanar(output, output + sizeY, output + sizeY + sizeC, width, cw, layout)) {
+            jpeg_abort_decompress(&cinfo);
+            return 0;
+        }
         return totalSize;
     }
 
-    ulong DecodeGray(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info)
+    bool TryDecodeStriped(int format, const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize,
+        DecodeInfo* info, ulong* result);
+
+    void SetSource(const byte* jpegData, ulong jpegSize)
     {
         // Set up memory source
         if (cinfo.src == nullptr) {
@@ -387,142 +1544,1978 @@ public:
         src->buffer_size = jpegSize;
         src->pub.next_input_byte = jpegData;
         src->pub.bytes_in_buffer = jpegSize;
+    }
 
+    // Reads the header and starts raw output; resolves *layout (NATIVE to the JPEG's sampling) and fills info.
+    // Only YCbCr and grayscale JPEGs have planar YUV samples to hand out.
+    bool StartRaw(DecodeInfo* info, int* layout, int scaleDenom)
+    {
         if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
-            return 0;
+            jpeg_abort_decompress(&cinfo);
+            return false;
+        }
+        bool gray = cinfo.num_components == 1 && cinfo.jpeg_color_space == JCS_GRAYSCALE;
+        if (!gray && (cinfo.num_components != 3 || cinfo.jpeg_color_space != JCS_YCbCr)) {
+            jpeg_abort_decompress(&cinfo);
+            return false;
+        }
+        if (*layout == YUV_LAYOUT_NATIVE) {
+            int native = jpeg_native_layout(&cinfo);
+            *layout = native < 0 ? YUV_LAYOUT_I420 : native;
         }
 
-        // Request grayscale output
-        cinfo.out_color_space = JCS_GRAYSCALE;
-        cinfo.raw_data_out = FALSE;
+        // Request raw output in the JPEG's own color space, no conversion
+        cinfo.raw_data_out = TRUE;
+        cinfo.out_color_space = cinfo.jpeg_color_space;
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = scaleDenom;
 
         jpeg_start_decompress(&cinfo);
+        stats.MarkHeader();
 
         info->width = cinfo.output_width;
         info->height = cinfo.output_height;
-        info->components = cinfo.output_components;
-        info->colorSpace = cinfo.out_color_space;
-
-        ulong rowStride = cinfo.output_width * cinfo.output_components;
-        ulong totalSize = rowStride * cinfo.output_height;
-
-        if (totalSize > outputSize) {
-            jpeg_abort_decompress(&cinfo);
-            return 0;
-        }
+        info->components = 3;
+        info->colorSpace = JCS_YCbCr;
+        info->layout = *layout;
+        return true;
+    }
 
-        while (cinfo.output_scanline < cinfo.output_height) {
-            byte* rowPtr = output + cinfo.output_scanline * rowStride;
-            jpeg_read_scanlines(&cinfo, &rowPtr, 1);
+    // Raw-data loop after StartRaw, one iMCU row per call; finishes decompression. A component whose
+    // decoded rows are exactly as wide as its plane (no block padding, same resolution) is written in
+    // place, with rows past the image sent to a discard row. Every other component - padded right edge,
+    // odd sizes, chroma finer than the layout, the larger chroma IDCTs of scaled decodes - lands in
+    // scratch rows and is copied or box-filtered down. False on sampling the layout cannot express,
+    // which is chroma coarser than the layout (that would need upsampling).
+    bool ReadRawPlanar(byte* Y, byte* U, byte* V, int y_stride, int uv_stride, int layout)
+    {
+        int width = cinfo.output_width;
+        int height = cinfo.output_height;
+        int cw, ch;
+        yuv_chroma_size(layout, width, height, &cw, &ch);
+        int components = cinfo.num_components;
+
+        int lines = cinfo.max_v_samp_factor * MIN_DCT_V_SCALED(&cinfo);
+        int lumaH = cinfo.max_h_samp_factor * MIN_DCT_H_SCALED(&cinfo);
+        // I420 chroma rows pair up luma rows, so odd iMCU heights (1/8 scale without vertical
+        // subsampling) are read two at a time
+        int group = layout == YUV_LAYOUT_I420 && lines % 2 ? 2 : 1;
+
+        byte* dst[3] = { Y, U, V };
+        int dstStride[3] = { y_stride, uv_stride, uv_stride };
+        int planeW[3] = { width, cw, cw };
+        int planeH[3] = { height, ch, ch };
+        int rows[3], strides[3], xstep[3], ystep[3];
+        bool direct[3];
+        ulong offsets[3];
+        ulong total = 0;
+        int discardWidth = 0;
+        for (int ci = 0; ci < components; ci++) {
+            jpeg_component_info* comp = &cinfo.comp_info[ci];
+            int compH = comp->h_samp_factor * COMP_DCT_H_SCALED(comp);
+            int compV = comp->v_samp_factor * COMP_DCT_V_SCALED(comp);
+            rows[ci] = compV;
+            if (compV * group > 32 || lumaH % compH != 0 || lines % compV != 0) return false;
+
+            // Component samples per plane sample: luma must come out at full size, chroma at the layout's
+            int targetX = ci == 0 || layout == YUV_LAYOUT_I444 ? 1 : 2;
+            int targetY = ci == 0 || layout != YUV_LAYOUT_I420 ? 1 : 2;
+            int h = lumaH / compH, v = lines / compV;
+            if (targetX % h != 0 || targetY % v != 0) return false;
+            xstep[ci] = targetX / h;
+            ystep[ci] = targetY / v;
+            if ((compV * group) % ystep[ci] != 0) return false;
+
+            int decodedWidth = comp->width_in_blocks * COMP_DCT_H_SCALED(comp);
+            direct[ci] = xstep[ci] == 1 && ystep[ci] == 1 && decodedWidth == planeW[ci];
+            if (direct[ci]) {
+                strides[ci] = 0;
+                offsets[ci] = 0;
+                discardWidth = std::max(discardWidth, decodedWidth);
+                continue;
+            }
+            // Whole blocks are written, plus up to one MCU of padding
+            strides[ci] = (comp->width_in_blocks + comp->h_samp_factor) * COMP_DCT_H_SCALED(comp);
+            offsets[ci] = total;
+            total += (ulong)strides[ci] * compV * group;
         }
+        ulong discard = total;
+        total += discardWidth;
+        if (scaled_rows.size() < total) scaled_rows.resize(total);
 
-        jpeg_finish_decompress(&cinfo);
-
-        return totalSize;
-    }
-};
-typedef struct I420Decoder I420Decoder;
+        JSAMPROW y_rows[32];
+        JSAMPROW u_rows[32];
+        JSAMPROW v_rows[32];
+        JSAMPARRAY planes[3] = { y_rows, u_rows, v_rows };
 
-// Custom error handler — sets flag instead of calling exit()
-// CRITICAL for WASM: default jpeg_error_exit calls exit() which kills the entire app.
-// NOTE: setjmp/longjmp is not used because the .NET WASM runtime's linker
-// (-mllvm -wasm-enable-sjlj) is incompatible with Emscripten's JS-based
-// setjmp/longjmp emulation. Flag-based error recovery avoids this issue.
-struct safe_error_mgr {
-    struct jpeg_error_mgr pub;
-    bool has_error;
-};
+        while (cinfo.output_scanline < cinfo.output_height) {
+            int imcu = cinfo.output_scanline / lines;
+            int reads = 0;
+            for (int g = 0; g < group && cinfo.output_scanline < cinfo.output_height; g++, reads++) {
+                for (int ci = 0; ci < components; ci++) {
+                    if (direct[ci]) {
+                        int top = (imcu + g) * rows[ci];
+                        for (int i = 0; i < rows[ci]; i++) {
+                            planes[ci][i] = top + i < planeH[ci]
+                                ? dst[ci] + (ulong)(top + i) * dstStride[ci]
+                                : scaled_rows.data() + discard;
+                        }
+                    } else {
+                        byte* base = scaled_rows.data() + offsets[ci] + (ulong)g * rows[ci] * strides[ci];
+                        for (int i = 0; i < rows[ci]; i++) planes[ci][i] = base + (ulong)i * strides[ci];
+                    }
+                }
+                // Truncated input suspends the memory source: no rows, and none will come
+                if (jpeg_read_raw_data(&cinfo, planes, lines) == 0) return false;
+            }
 
-static void safe_error_exit(j_common_ptr cinfo) {
-    safe_error_mgr* myerr = (safe_error_mgr*)cinfo->err;
-    myerr->has_error = true;
-    // Do NOT call exit() — just set the flag and return.
-    // The caller checks has_error after each libjpeg call.
-}
+            for (int ci = 0; ci < components; ci++) {
+                if (direct[ci]) continue;
+                const byte* src = scaled_rows.data() + offsets[ci];
+                int stride = strides[ci];
+                int xs = xstep[ci], ys = ystep[ci];
+                int top = imcu * rows[ci] / ys;
+                int count = std::min((reads * rows[ci] + ys - 1) / ys, planeH[ci] - top);
+                int w = planeW[ci];
+
+                // Odd sizes box-filter one sample past the image edge (and a short final group only
+                // filled its first read): replicate the last real row and column over the block padding
+                jpeg_component_info* comp = &cinfo.comp_info[ci];
+                int validRows = std::min(reads * rows[ci], (int)comp->downsampled_height - imcu * rows[ci]);
+                int validW = comp->downsampled_width;
+                byte* scratch = scaled_rows.data() + offsets[ci];
+                for (int r = validRows; r < count * ys; r++) {
+                    memcpy(scratch + (ulong)r * stride, scratch + (ulong)(validRows - 1) * stride, stride);
+                }
+                if (w * xs > validW) {
+                    for (int r = 0; r < count * ys; r++) {
+                        byte* row = scratch + (ulong)r * stride;
+                        memset(row + validW, row[validW - 1], w * xs - validW);
+                    }
+                }
+                for (int y = 0; y < count; y++) {
+                    byte* out = dst[ci] + (ulong)(top + y) * dstStride[ci];
+                    const byte* in = src + (ulong)y * ys * stride;
+                    if (xs == 1 && ys == 1) {
+                        memcpy(out, in, w);
+                    } else if (xs == 2 && ys == 2) {
+                        for (int x = 0; x < w; x++) {
+                            out[x] = (byte)((in[2 * x] + in[2 * x + 1] + in[stride + 2 * x] + in[stride + 2 * x + 1] + 2) >> 2);
+                        }
+                    } else {
+                        int area = xs * ys;
+                        for (int x = 0; x < w; x++) {
+                            int sum = 0;
+                            for (int j = 0; j < ys; j++) {
+                                for (int i = 0; i < xs; i++) sum += in[j * stride + x * xs + i];
+                            }
+                            out[x] = (byte)((sum + area / 2) / area);
+                        }
+                    }
+                }
+            }
+        }
 
-// BGRA Decoder — reuses jpeg_decompress_struct, safe error handling
-class BgraDecoder {
-public:
-    struct jpeg_decompress_struct cinfo;
-    safe_error_mgr jerr;
-    int max_width;
-    int max_height;
+        // Grayscale JPEGs: neutral chroma
+        if (components == 1) {
+            for (int y = 0; y < ch; y++) {
+                memset(U + (ulong)y * uv_stride, 128, cw);
+                memset(V + (ulong)y * uv_stride, 128, cw);
+            }
+        }
 
-    BgraDecoder(int maxWidth, int maxHeight)
-        : max_width(maxWidth), max_height(maxHeight)
-    {
-        cinfo.err = jpeg_std_error(&jerr.pub);
-        jerr.pub.error_exit = safe_error_exit;
-        jerr.has_error = false;
-        jpeg_create_decompress(&cinfo);
+        jpeg_finish_decompress(&cinfo);
+        return true;
     }
 
-    ~BgraDecoder() { jpeg_destroy_decompress(&cinfo); }
-
-    ulong DecodeBGRA(const byte* jpegData, ulong jpegSize,
-                     byte* output, ulong outputSize, DecodeInfo* info)
+    std::vector<byte> scaled_rows;  // Per-component iMCU-row scratch for ReadRawPlanar
+    std::vector<byte> crop_row;     // Two widened scanlines for the crop decodes
+    std::vector<byte> dc_map;       // AnalyzeDc: the frame being analyzed
+    std::vector<byte> dc_reference; // AnalyzeDc: the map frames are compared with, dc_width x dc_height
+    int dc_width = 0;
+    int dc_height = 0;
+
+    // Starts a scanline decode limited to the region: columns via jpeg_crop_scanline (widened left to
+    // an iMCU boundary, *dx pixels before x), rows above it via jpeg_skip_scanlines
+    bool StartCrop(const byte* jpegData, ulong jpegSize, J_COLOR_SPACE colorSpace,
+        int x, int y, int width, int height, int* dx)
     {
-        jerr.has_error = false;
-
-        jpeg_memory_src(&cinfo, jpegData, jpegSize);
-        if (jerr.has_error) { jpeg_abort_decompress(&cinfo); return 0; }
+        SetSource(jpegData, jpegSize);
 
-        if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK || jerr.has_error) {
+        if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
             jpeg_abort_decompress(&cinfo);
-            return 0;
+            return false;
+        }
+        if (x < 0 || y < 0 || width <= 0 || height <= 0 ||
+            (JDIMENSION)(x + width) > cinfo.image_width || (JDIMENSION)(y + height) > cinfo.image_height) {
+            jpeg_abort_decompress(&cinfo);
+            return false;
         }
 
-        cinfo.out_color_space = JCS_EXT_BGRA;  // Direct BGRA — libjpeg-turbo extension
+        // Grayscale JPEGs have no chroma to convert; the I420 crop fills it in
+        cinfo.out_color_space = cinfo.num_components == 1 ? JCS_GRAYSCALE : colorSpace;
         cinfo.raw_data_out = FALSE;
+        // Replicating upsampler keeps the original chroma samples, so box-filtering them gives the
+        // raw-data path's I420
+        cinfo.do_fancy_upsampling = FALSE;
 
         jpeg_start_decompress(&cinfo);
-        if (jerr.has_error) { jpeg_abort_decompress(&cinfo); return 0; }
 
-        int width = cinfo.output_width;
-        int height = cinfo.output_height;
-        int rowBytes = width * 4;
-        ulong totalSize = (ulong)rowBytes * height;
+        JDIMENSION cropX = x, cropWidth = width;
+        jpeg_crop_scanline(&cinfo, &cropX, &cropWidth);
+        stats.MarkHeader();
+        if (y > 0) jpeg_skip_scanlines(&cinfo, y);
 
-        info->width = width;
-        info->height = height;
-        info->components = 4;
-        info->colorSpace = cinfo.out_color_space;
+        *dx = x - (int)cropX;
+        if (crop_row.size() < 2 * (ulong)cinfo.output_width * cinfo.output_components) {
+            crop_row.resize(2 * (ulong)cinfo.output_width * cinfo.output_components);
+        }
+        return true;
+    }
 
+public:
+    // Region-of-interest decode: only the rows of the region are decoded and only the iMCU columns it
+    // touches. Rows are info->stride bytes apart: the crop widened to iMCU columns, so each scanline
+    // lands in place and the region starts at output[0]. Needs outputSize >= stride * height.
+    // Always runs on libjpeg - tj3 crops only at iMCU-aligned offsets.
+    ulong DecodeGrayCrop(const byte* jpegData, ulong jpegSize, int x, int y, int width, int height,
+        byte* output, ulong outputSize, DecodeInfo* info)
+    {
+        CodecCall call(stats, jpegSize);
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_decompress(&cinfo); return 0; }
+        int dx;
+        if (!StartCrop(jpegData, jpegSize, JCS_GRAYSCALE, x, y, width, height, &dx)) return 0;
+
+        int stride = cinfo.output_width;  // output_components is 1 for grayscale
+        ulong totalSize = (ulong)stride * height;
         if (totalSize > outputSize) {
             jpeg_abort_decompress(&cinfo);
             return 0;
         }
 
-        // Read scanlines directly into caller's buffer
-        while (cinfo.output_scanline < cinfo.output_height) {
-            byte* rowPtr = output + cinfo.output_scanline * rowBytes;
-            jpeg_read_scanlines(&cinfo, &rowPtr, 1);
-            if (jerr.has_error) { jpeg_abort_decompress(&cinfo); return 0; }
+        // Row r is written dx bytes early, so its margin overlaps the tail of row r - 1 only;
+        // the first row goes through scratch as its margin would fall before the buffer
+        for (int r = 0; r < height; r++) {
+            byte* rowPtr = r == 0 ? crop_row.data() : output + (ulong)r * stride - dx;
+            if (jpeg_read_scanlines(&cinfo, &rowPtr, 1) == 0) {
+                jpeg_abort_decompress(&cinfo);
+                return 0;
+            }
         }
+        memcpy(output, crop_row.data() + dx, stride - dx);
 
-        jpeg_finish_decompress(&cinfo);
-        if (jerr.has_error) {
-            // Struct may be in a dirty state — abort defensively before reuse
-            jpeg_abort_decompress(&cinfo);
-            return 0;
-        }
-        return totalSize;
+        // Rows below the region are never decoded
+        jpeg_abort_decompress(&cinfo);
+
+        info->width = width;
+        info->height = height;
+        info->components = 1;
+        info->colorSpace = JCS_GRAYSCALE;
+        info->stride = stride;
+        return call.Done(Checked(totalSize));
     }
-};
 
-// Decode JPEG to grayscale (for HDR blending)
-// Returns: bytes written to output, or 0 on error
-// Output format: 8-bit grayscale, row-major
-ulong DecodeToGray(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info) {
-    struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
+    // I420 counterpart of DecodeGrayCrop with tightly packed planes (stride = width). The region must
+    // have even offsets and size so it maps onto whole chroma samples. Chroma is box-filtered like
+    // DecodeI420, so a crop matches the same region of a full decode; grayscale gets neutral chroma.
+    ulong DecodeI420Crop(const byte* jpegData, ulong jpegSize, int x, int y, int width, int height,
+        byte* output, ulong outputSize, DecodeInfo* info)
+    {
+        CodecCall call(stats, jpegSize);
+        if ((x | y | width | height) & 1) return 0;
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_decompress(&cinfo); return 0; }
 
-    cinfo.err = jpeg_std_error(&jerr);
-    jpeg_create_decompress(&cinfo);
+        ulong sizeY = (ulong)width * height;
+        ulong sizeU = sizeY / 4;
+        ulong totalSize = sizeY + sizeU + sizeU;
+        if (totalSize > outputSize) return 0;
 
-    jpeg_memory_src(&cinfo, jpegData, jpegSize);
+        int dx;
+        if (!StartCrop(jpegData, jpegSize, JCS_YCbCr, x, y, width, height, &dx)) return 0;
 
-    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+        byte* Y = output;
+        byte* U = output + sizeY;
+        byte* V = output + sizeY + sizeU;
+        int chromaWidth = width / 2;
+        int components = cinfo.output_components;
+        ulong rowBytes = (ulong)cinfo.output_width * components;
+
+        // Rows alternate between the two scratch scanlines, so each odd row can average with the one above
+        for (int r = 0; r < height; r++) {
+            byte* rowPtr = crop_row.data() + (r & 1) * rowBytes;
+            if (jpeg_read_scanlines(&cinfo, &rowPtr, 1) == 0) {
+                jpeg_abort_decompress(&cinfo);
+                return 0;
+            }
+
+            const byte* src = rowPtr + dx * components;
+            byte* yRow = Y + (ulong)r * width;
+            for (int i = 0; i < width; i++) yRow[i] = src[i * components];
+
+            if ((r & 1) && components == 3) {
+                const byte* above = crop_row.data() + dx * 3;
+                byte* uRow = U + (ulong)(r / 2) * chromaWidth;
+                byte* vRow = V + (ulong)(r / 2) * chromaWidth;
+                for (int i = 0; i < chromaWidth; i++) {
+                    const byte* a = above + i * 6;
+                    const byte* b = src + i * 6;
+                    uRow[i] = (byte)((a[1] + a[4] + b[1] + b[4] + 2) >> 2);
+                    vRow[i] = (byte)((a[2] + a[5] + b[2] + b[5] + 2) >> 2);
+                }
+            }
+        }
+        if (components == 1) {
+            memset(U, 128, sizeU);
+            memset(V, 128, sizeU);
+        }
+
+        jpeg_abort_decompress(&cinfo);
+
+        info->width = width;
+        info->height = height;
+        info->components = 3;
+        info->colorSpace = JCS_YCbCr;
+        info->stride = width;
+        info->layout = YUV_LAYOUT_I420;
+        return call.Done(Checked(totalSize));
+    }
+
+    ulong DecodeGray(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info,
+        int scaleDenom = 1)
+    {
+        CodecCall call(stats, jpegSize);
+        if (!IsScaleSupported(scaleDenom)) return 0;
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_decompress(&cinfo); return 0; }
+        ulong striped;
+        if (stripes && scaleDenom == 1 &&
+            TryDecodeStriped(DECODE_FORMAT_GRAY, jpegData, jpegSize, output, outputSize, info, &striped)) {
+            return call.Done(striped);
+        }
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) return call.Done(Checked(DecodeGrayTurbo(jpegData, jpegSize, output, outputSize, info, scaleDenom)));
+#endif
+        SetSource(jpegData, jpegSize);
+        return call.Done(Checked(DecodeGrayFromSource(output, outputSize, info, scaleDenom)));
+    }
+
+    // Change detection from the DC terms of luma only: a 1/8 grayscale decode, where each output sample is
+    // the mean of one 8x8 block, libjpeg skips the AC terms and the chroma IDCT and nothing is upsampled.
+    // The map is compared with the reference kept in this handle - the previous frame's, or a fixed one
+    // with DC_KEEP_REFERENCE - and blocks that moved by more than threshold count as changed. thumbnail,
+    // when not null, receives the map (thumbnailSize >= width * height). Always runs on libjpeg, even on
+    // a TurboJPEG handle. Returns the map size in bytes, 0 on error or when thumbnail is too small.
+    ulong AnalyzeDc(const byte* jpegData, ulong jpegSize, int threshold, int flags, byte* thumbnail, ulong thumbnailSize,
+        DcChangeInfo* info)
+    {
+        CodecCall call(stats, jpegSize);
+        if (threshold < 0) return 0;
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_decompress(&cinfo); return 0; }
+
+        SetSource(jpegData, jpegSize);
+        if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+            jpeg_abort_decompress(&cinfo);
+            return 0;
+        }
+        cinfo.out_color_space = JCS_GRAYSCALE;
+        cinfo.raw_data_out = FALSE;
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = 8;
+        jpeg_start_decompress(&cinfo);
+        stats.MarkHeader();
+
+        int width = cinfo.output_width, height = cinfo.output_height;
+        ulong size = (ulong)width * height;
+        if (thumbnail && thumbnailSize < size) {
+            jpeg_abort_decompress(&cinfo);
+            return 0;
+        }
+        if (dc_map.size() != size) dc_map.resize(size);
+        while (cinfo.output_scanline < cinfo.output_height) {
+            byte* rows[8];
+            for (int i = 0; i < 8; i++)
+                rows[i] = dc_map.data() + (ulong)std::min<int>(cinfo.output_scanline + i, height - 1) * width;
+            // Truncated frames suspend the memory source, after which no rows ever come
+            if (jpeg_read_scanlines(&cinfo, rows, 8) == 0) {
+                jpeg_abort_decompress(&cinfo);
+                return 0;
+            }
+        }
+        jpeg_finish_decompress(&cinfo);
+        if (jerr.failed) return 0;
+
+        info->width = width;
+        info->height = height;
+        info->compared = dc_width == width && dc_height == height;
+        info->changedBlocks = 0;
+        info->maxDifference = 0;
+        info->sumDifference = 0;
+        if (info->compared) {
+            const byte* previous = dc_reference.data();
+            for (ulong i = 0; i < size; i++) {
+                int diff = std::abs((int)dc_map[i] - (int)previous[i]);
+                info->sumDifference += diff;
+                info->maxDifference = std::max(info->maxDifference, diff);
+                info->changedBlocks += diff > threshold;
+            }
+        }
+        if (thumbnail) memcpy(thumbnail, dc_map.data(), size);
+
+        if (!info->compared || !(flags & DC_KEEP_REFERENCE)) {
+            dc_reference.swap(dc_map);
+            dc_width = width;
+            dc_height = height;
+        }
+        return call.Done(size);
+    }
+
+    // Drops the reference map; the next AnalyzeDc starts a new one
+    void ResetDcReference()
+    {
+        dc_width = dc_height = 0;
+    }
+
+    // Scatter-list input such as pipe segments, read in order through fill_input_buffer so a frame
+    // split across buffers is not coalesced first. Several segments always take the serial libjpeg
+    // path, since stripes and TurboJPEG need contiguous data. Segments that end before the EOI, or
+    // any other corrupt-data warning, fail the decode rather than returning a part-grey frame.
+    ulong DecodeI420Segments(const JpegSegment* segments, int count, byte* output, ulong outputSize, DecodeInfo* info)
+    {
+        // A single segment is an ordinary buffer; DecodeI420 does its own accounting and error handling
+        if (count == 1) return DecodeI420(segments[0].data, segments[0].size, output, outputSize, info);
+        CodecCall call(stats, SegmentBytes(segments, count));
+        if (count <= 0) return 0;
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_decompress(&cinfo); return 0; }
+        jpeg_segment_src(&cinfo, segments, count);
+        return call.Done(CheckedSegments(DecodeYuvFromSource(output, outputSize, info, YUV_LAYOUT_I420, 1)));
+    }
+
+    ulong DecodeGraySegments(const JpegSegment* segments, int count, byte* output, ulong outputSize, DecodeInfo* info)
+    {
+        if (count == 1) return DecodeGray(segments[0].data, segments[0].size, output, outputSize, info);
+        CodecCall call(stats, SegmentBytes(segments, count));
+        if (count <= 0) return 0;
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_decompress(&cinfo); return 0; }
+        jpeg_segment_src(&cinfo, segments, count);
+        return call.Done(CheckedSegments(DecodeGrayFromSource(output, outputSize, info, 1)));
+    }
+
+    // libjpeg patches over premature ends and damaged entropy data with warnings (JWRN_JPEG_EOF,
+    // JWRN_HIT_MARKER); the count is reset by each jpeg_read_header
+    ulong CheckedSegments(ulong written) const
+    {
+        return jerr.pub.num_warnings != 0 ? 0 : Checked(written);
+    }
+
+    static ulong SegmentBytes(const JpegSegment* segments, int count)
+    {
+        ulong total = 0;
+        for (int i = 0; i < count; i++) total += segments[i].size;
+        return total;
+    }
+
+    // Scanline grayscale decode of whatever source is installed
+    ulong DecodeGrayFromSource(byte* output, ulong outputSize, DecodeInfo* info, int scaleDenom)
+    {
+        if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+            jpeg_abort_decompress(&cinfo);
+            return 0;
+        }
+
+        // Request grayscale output
+        cinfo.out_color_space = JCS_GRAYSCALE;
+        cinfo.raw_data_out = FALSE;
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = scaleDenom;
+
+        jpeg_start_decompress(&cinfo);
+        stats.MarkHeader();
+
+        info->width = cinfo.output_width;
+        info->height = cinfo.output_height;
+        info->components = cinfo.output_components;
+        info->colorSpace = cinfo.out_color_space;
+
+        ulong rowStride = cinfo.output_width * cinfo.output_components;
+        ulong totalSize = rowStride * cinfo.output_height;
+
+        if (totalSize > outputSize) {
+            jpeg_abort_decompress(&cinfo);
+            return 0;
+        }
+
+        while (cinfo.output_scanline < cinfo.output_height) {
+            byte* rowPtr = output + cinfo.output_scanline * rowStride;
+            if (jpeg_read_scanlines(&cinfo, &rowPtr, 1) == 0) {
+                jpeg_abort_decompress(&cinfo);
+                return 0;
+            }
+        }
+
+        jpeg_finish_decompress(&cinfo);
+
+        return totalSize;
+    }
+
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+    // Planar decode straight into the caller's Y/U/V planes, no row-pointer loop. tj3 emits the JPEG's
+    // own subsampling, so layouts that need re-sampling (and grayscale) take the raw-data path.
+    ulong DecodeYuvTurbo(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info,
+        int layout, int scaleDenom)
+    {
+        if (tj3DecompressHeader(tj, jpegData, jpegSize) < 0) return 0;
+        stats.MarkHeader();
+
+        int subsamp = tj3Get(tj, TJPARAM_SUBSAMP);
+        int native = subsamp == TJSAMP_420 ? YUV_LAYOUT_I420
+            : subsamp == TJSAMP_422 ? YUV_LAYOUT_I422
+            : subsamp == TJSAMP_444 ? YUV_LAYOUT_I444 : -1;
+        int target = layout == YUV_LAYOUT_NATIVE ? native : layout;
+        if (native < 0 || target != native || tj3Get(tj, TJPARAM_COLORSPACE) != TJCS_YCbCr) {
+            SetSource(jpegData, jpegSize);
+            return DecodeYuvFromSource(output, outputSize, info, layout, scaleDenom);
+        }
+
+        int width, height;
+        if (!tj_set_scale(tj, scaleDenom, &width, &height)) return 0;
+
+        info->width = width;
+        info->height = height;
+        info->components = 3;
+        info->colorSpace = JCS_YCbCr;
+        info->layout = target;
+
+        // tj3 planes are ceil-sized like ours: tj3YUVPlaneWidth(1, 101, TJSAMP_420) is 51
+        int cw, ch;
+        yuv_chroma_size(target, width, height, &cw, &ch);
+        ulong sizeY = (ulong)width * height;
+        ulong sizeC = (ulong)cw * ch;
+        ulong totalSize = sizeY + 2 * sizeC;
+
+        if (totalSize > outputSize) return 0;
+
+        byte* planes[3] = { output, output + sizeY, output + sizeY + sizeC };
+        int strides[3] = { width, cw, cw };
+
+        if (tj3DecompressToYUVPlanes8(tj, jpegData, jpegSize, planes, strides) < 0) return 0;
+        return totalSize;
+    }
+
+    ulong DecodeGrayTurbo(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info,
+        int scaleDenom)
+    {
+        if (tj3DecompressHeader(tj, jpegData, jpegSize) < 0) return 0;
+        stats.MarkHeader();
+
+        int width, height;
+        if (!tj_set_scale(tj, scaleDenom, &width, &height)) return 0;
+
+        info->width = width;
+        info->height = height;
+        info->components = 1;
+        info->colorSpace = JCS_GRAYSCALE;
+
+        ulong totalSize = (ulong)width * height;
+        if (totalSize > outputSize) return 0;
+
+        if (tj3Decompress8(tj, jpegData, jpegSize, output, width, TJPF_GRAY) < 0) return 0;
+        return totalSize;
+    }
+#endif
+};
+typedef struct I420Decoder I420Decoder;
+
+// Marker layout of a single-scan sequential JPEG with restart intervals
+struct RestartLayout {
+    int width;
+    int height;
+    int mcu_width;
+    int mcu_height;
+    int restart_interval;       // MCUs per interval (DRI)
+    bool i420;                  // 3 components sampled 2x2 / 1x1 / 1x1
+    ulong height_offset;        // Offset of the 16-bit frame height in the SOF segment
+    ulong scan_start;           // First entropy-coded byte
+    ulong scan_end;             // Offset of EOI
+    std::vector<ulong> markers; // Offsets of the RSTn markers, in stream order
+};
+
+// Indexes the restart markers of a baseline/extended Huffman JPEG. Returns false for anything
+// the stripe decoder cannot split: progressive/lossless/arithmetic, no DRI, DNL, several scans.
+static bool ParseRestartLayout(const byte* d, ulong n, RestartLayout& layout)
+{
+    if (n < 4 || d[0] != 0xFF || d[1] != 0xD8) return false;
+
+    int components = 0;
+    int maxH = 1, maxV = 1;
+    layout.restart_interval = 0;
+    layout.scan_start = 0;
+    layout.height_offset = 0;
+    layout.markers.clear();
+
+    ulong p = 2;
+    while (p + 4 <= n) {
+        if (d[p] != 0xFF) return false;
+        byte marker = d[p + 1];
+        if (marker == 0xFF) { p++; continue; }  // Fill byte
+
+        ulong length = ((ulong)d[p + 2] << 8) | d[p + 3];
+        if (length < 2 || p + 2 + length > n) return false;
+        const byte* seg = d + p + 4;
+
+        if (marker == 0xC0 || marker == 0xC1) {
+            if (length < 8) return false;
+            layout.height_offset = p + 5;
+            layout.height = (seg[1] << 8) | seg[2];
+            layout.width = (seg[3] << 8) | seg[4];
+            components = seg[5];
+            if (components < 1 || length < 8 + 3 * (ulong)components) return false;
+            for (int c = 0; c < components; c++) {
+                int h = seg[7 + 3 * c] >> 4;
+                int v = seg[7 + 3 * c] & 15;
+                if (h > maxH) maxH = h;
+                if (v > maxV) maxV = v;
+            }
+            layout.i420 = components == 3 && seg[7] == 0x22 && seg[10] == 0x11 && seg[13] == 0x11;
+        } else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            return false;  // Progressive, lossless, hierarchical or arithmetic coded
+        } else if (marker == 0xDD) {
+            if (length < 4) return false;
+            layout.restart_interval = (seg[0] << 8) | seg[1];
+        } else if (marker == 0xDA) {
+            // A single interleaved scan carrying every component
+            if (layout.height_offset == 0 || seg[0] != components) return false;
+            layout.scan_start = p + 2 + length;
+            break;
+        }
+        p += 2 + length;
+    }
+
+    if (layout.scan_start == 0 || layout.restart_interval == 0 || layout.height == 0) return false;
+
+    for (ulong q = layout.scan_start; q + 1 < n; q++) {
+        if (d[q] != 0xFF) continue;
+        byte marker = d[q + 1];
+        if (marker == 0x00 || marker == 0xFF) continue;  // Stuffed byte or fill
+        if (marker >= 0xD0 && marker <= 0xD7) {
+            layout.markers.push_back(q);
+            q++;
+            continue;
+        }
+        if (marker != 0xD9) return false;
+        layout.scan_end = q;
+
+        // Non-interleaved (single component) scans code one 8x8 block per MCU
+        layout.mcu_width = components == 1 ? 8 : 8 * maxH;
+        layout.mcu_height = components == 1 ? 8 : 8 * maxV;
+        return true;
+    }
+    return false;
+}
+
+// Intra-frame parallel decode for JPEGs with restart markers.
+// Restart intervals that begin on an MCU row split the frame into horizontal stripes. Each stripe
+// is re-wrapped as a standalone JPEG (original headers, patched height, renumbered RSTn) and
+// decoded on its own thread straight into its rows of the output, so the result is bit-exact
+// with a serial decode.
+class RestartStripes {
+public:
+    RestartStripes(int threads, int maxWidth, int maxHeight, int backend)
+        : group(threads)
+    {
+        for (int i = 0; i < group.Size(); i++) {
+            decoders.push_back(new I420Decoder(maxWidth, maxHeight, backend));
+        }
+        scratch.resize(group.Size());
+    }
+
+    ~RestartStripes()
+    {
+        for (auto* decoder : decoders) delete decoder;
+    }
+
+    int Size() const { return group.Size(); }
+
+    bool LoadTables(const byte* tables, ulong size)
+    {
+        for (auto* decoder : decoders)
+            if (!decoder->LoadTables(tables, size)) return false;
+        return true;
+    }
+
+    // Returns false when the JPEG cannot be split; *result is the decoded size (0 on error) otherwise
+    bool Decode(int format, const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize,
+        DecodeInfo* info, ulong* result)
+    {
+        if (!ParseRestartLayout(jpegData, jpegSize, layout)) return false;
+        if (format == DECODE_FORMAT_I420 && !layout.i420) return false;
+
+        int width = layout.width;
+        int height = layout.height;
+        int mcusPerRow = (width + layout.mcu_width - 1) / layout.mcu_width;
+        int mcuRows = (height + layout.mcu_height - 1) / layout.mcu_height;
+        ulong totalMcus = (ulong)mcusPerRow * mcuRows;
+        ulong interval = (ulong)layout.restart_interval;
+        if (layout.markers.size() != (totalMcus + interval - 1) / interval - 1) return false;
+
+        if (!PlanStripes(mcusPerRow, mcuRows)) return false;
+
+        ulong sizeY = (ulong)width * height;
+        ulong totalSize = format == DECODE_FORMAT_GRAY ? sizeY : yuv_frame_size(YUV_LAYOUT_I420, width, height);
+        *result = 0;
+        if (totalSize > outputSize) return true;
+
+        Job job = { this, format, jpegData, output, width, height, {false} };
+        group.Run((int)stripe_rows.size() - 1, &RestartStripes::DecodeStripe, &job);
+        if (job.failed) return true;
+
+        info->width = width;
+        info->height = height;
+        info->components = format == DECODE_FORMAT_GRAY ? 1 : 3;
+        info->colorSpace = format == DECODE_FORMAT_GRAY ? JCS_GRAYSCALE : JCS_YCbCr;
+        info->layout = YUV_LAYOUT_I420;
+        *result = totalSize;
+        return true;
+    }
+
+private:
+    struct Job {
+        RestartStripes* owner;
+        int format;
+        const byte* jpeg;
+        byte* output;
+        int width;
+        int height;
+        std::atomic<bool> failed;
+    };
+
+    WorkerGroup group;
+    std::vector<I420Decoder*> decoders;
+    std::vector<std::vector<byte>> scratch;  // Per-worker stripe JPEG
+    RestartLayout layout;
+    std::vector<int> stripe_rows;            // MCU row where each stripe starts, plus mcuRows
+
+    // Picks up to Size() stripes at MCU rows that start a restart interval, as even as the DRI allows
+    bool PlanStripes(int mcusPerRow, int mcuRows)
+    {
+        ulong interval = (ulong)layout.restart_interval;
+        int stripes = group.Size();
+        if (stripes > mcuRows) stripes = mcuRows;
+
+        stripe_rows.clear();
+        stripe_rows.push_back(0);
+        for (int s = 1; s < stripes; s++) {
+            int target = (int)((long long)mcuRows * s / stripes);
+            int row = target;
+            while (row < mcuRows && ((ulong)row * mcusPerRow) % interval != 0) row++;
+            if (row >= mcuRows) break;
+            if (row > stripe_rows.back()) stripe_rows.push_back(row);
+        }
+        stripe_rows.push_back(mcuRows);
+        return stripe_rows.size() > 2;
+    }
+
+    // Copies header + this stripe's intervals into a standalone JPEG
+    static void BuildStripe(const RestartLayout& layout, const byte* jpeg, int mcusPerRow,
+        int firstRow, int endRow, int stripeHeight, std::vector<byte>& out)
+    {
+        ulong interval = (ulong)layout.restart_interval;
+        ulong firstInterval = (ulong)firstRow * mcusPerRow / interval;
+        ulong endMcu = (ulong)endRow * mcusPerRow;
+        ulong endInterval = (endMcu + interval - 1) / interval;
+
+        // Entropy data of interval k starts after marker k-1 (interval 0 at scan start)
+        ulong begin = firstInterval == 0 ? layout.scan_start : layout.markers[firstInterval - 1] + 2;
+        ulong end = endInterval - 1 < layout.markers.size() ? layout.markers[endInterval - 1] : layout.scan_end;
+
+        out.clear();
+        out.insert(out.end(), jpeg, jpeg + layout.scan_start);
+        out[layout.height_offset] = (byte)(stripeHeight >> 8);
+        out[layout.height_offset + 1] = (byte)stripeHeight;
+
+        // Restart numbering must begin at RST0 within the stripe
+        ulong from = begin;
+        for (ulong k = firstInterval; k + 1 < endInterval; k++) {
+            ulong marker = layout.markers[k];
+            out.insert(out.end(), jpeg + from, jpeg + marker);
+            out.push_back(0xFF);
+            out.push_back((byte)(0xD0 + ((k - firstInterval) & 7)));
+            from = marker + 2;
+        }
+        out.insert(out.end(), jpeg + from, jpeg + end);
+        out.push_back(0xFF);
+        out.push_back(0xD9);
+    }
+
+    static void DecodeStripe(void* ctx, int worker, int index)
+    {
+        Job& job = *(Job*)ctx;
+        RestartStripes& self = *job.owner;
+        const RestartLayout& layout = self.layout;
+        int mcusPerRow = (job.width + layout.mcu_width - 1) / layout.mcu_width;
+        int firstRow = self.stripe_rows[index];
+        int endRow = self.stripe_rows[index + 1];
+        int y0 = firstRow * layout.mcu_height;
+        int y1 = endRow * layout.mcu_height;
+        if (y1 > job.height) y1 = job.height;
+
+        std::vector<byte>& buffer = self.scratch[worker];
+        BuildStripe(layout, job.jpeg, mcusPerRow, firstRow, endRow, y1 - y0, buffer);
+
+        I420Decoder* decoder = self.decoders[worker];
+        DecodeInfo info;
+        ulong written;
+        if (job.format == DECODE_FORMAT_GRAY) {
+            written = decoder->DecodeGrayRegion(buffer.data(), buffer.size(),
+                job.output + (ulong)y0 * job.width, job.width, &info);
+        } else {
+            // 4:2:0 MCU rows are 16 luma rows, so y0 is even. The region decode keeps a partial
+            // last MCU's padding in scratch, so no row spills into a neighbouring stripe.
+            int uvStride, chromaHeight;
+            yuv_chroma_size(YUV_LAYOUT_I420, job.width, job.height, &uvStride, &chromaHeight);
+            ulong sizeY = (ulong)job.width * job.height;
+            ulong sizeU = (ulong)uvStride * chromaHeight;
+            written = decoder->DecodeI420Region(buffer.data(), buffer.size(),
+                job.output + (ulong)y0 * job.width,
+                job.output + sizeY + (ulong)(y0 / 2) * uvStride,
+                job.output + sizeY + sizeU + (ulong)(y0 / 2) * uvStride,
+                job.width, uvStride, &info);
+        }
+        if (written == 0 || info.width != job.width || info.height != y1 - y0) job.failed = true;
+    }
+};
+
+I420Decoder::~I420Decoder()
+{
+    delete stripes;
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+    if (tj) tj3Destroy(tj);
+#endif
+    if (initialized) {
+        jpeg_destroy_decompress(&cinfo);
+        initialized = false;
+    }
+}
+
+bool I420Decoder::LoadTables(const byte* tables, ulong size)
+{
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+    if (tj) return false;  // tj3Decompress8 only accepts interchange streams
+#endif
+    jerr.failed = false;
+    if (JPEG_CATCH(jerr)) { jpeg_abort_decompress(&cinfo); return false; }
+    SetSource(tables, size);
+    if (jpeg_read_header(&cinfo, FALSE) != JPEG_HEADER_TABLES_ONLY || jerr.failed) {
+        jpeg_abort_decompress(&cinfo);
+        return false;
+    }
+    return stripes == nullptr || stripes->LoadTables(tables, size);
+}
+
+void I420Decoder::SetStripeThreads(int threads)
+{
+    delete stripes;
+    stripes = threads > 1 ? new RestartStripes(threads, max_width, max_height, backend) : nullptr;
+}
+
+bool I420Decoder::TryDecodeStriped(int format, const byte* jpegData, ulong jpegSize, byte* output,
+    ulong outputSize, DecodeInfo* info, ulong* result)
+{
+    return stripes->Decode(format, jpegData, jpegSize, output, outputSize, info, result);
+}
+
+// Fixed set of I420Decoders driven by native worker threads.
+// DecodeBatch fans N JPEGs out over the workers (the calling thread takes part) and
+// returns when all are done, so a whole HDR window costs one interop transition.
+// One batch runs at a time per set; concurrent callers are serialized.
+class DecoderSet {
+public:
+    enum Format { FormatI420 = 0, FormatGray = 1 };
+
+    explicit DecoderSet(int threads, int maxWidth, int maxHeight, int backend = JPEG_BACKEND_LIBJPEG)
+        : group(threads)
+    {
+        for (int i = 0; i < group.Size(); i++) {
+            decoders.push_back(new I420Decoder(maxWidth, maxHeight, backend));
+        }
+    }
+
+    ~DecoderSet()
+    {
+        for (auto* decoder : decoders) delete decoder;
+    }
+
+    bool IsValid() const
+    {
+        for (auto* decoder : decoders) {
+            if (!decoder->IsValid()) return false;
+        }
+        return true;
+    }
+
+    int Size() const { return group.Size(); }
+
+    int GetStats(CodecStats* stats) const
+    {
+        std::vector<const CodecCounters*> counters;
+        for (auto* decoder : decoders) counters.push_back(&decoder->stats);
+        return codec_stats_snapshot(counters.data(), (int)counters.size(), stats);
+    }
+
+    // Returns the number of successfully decoded images; per-image sizes go to results (0 = failed)
+    int DecodeBatch(Format format, const byte** jpegs, const ulong* sizes, byte** outputs,
+        const ulong* outputSizes, DecodeInfo* infos, ulong* results, int count)
+    {
+        if (count <= 0) return 0;
+        Batch batch = { this, format, jpegs, sizes, outputs, outputSizes, infos, results, {0} };
+        group.Run(count, &DecoderSet::RunOne, &batch);
+        return batch.succeeded.load();
+    }
+
+private:
+    struct Batch {
+        DecoderSet* set;
+        Format format;
+        const byte** jpegs;
+        const ulong* sizes;
+        byte** outputs;
+        const ulong* outputSizes;
+        DecodeInfo* infos;
+        ulong* results;
+        std::atomic<int> succeeded;
+    };
+
+    WorkerGroup group;
+    std::vector<I420Decoder*> decoders;
+
+    static void RunOne(void* ctx, int worker, int i)
+    {
+        Batch& batch = *(Batch*)ctx;
+        I420Decoder* decoder = batch.set->decoders[worker];
+        ulong result = batch.format == FormatGray
+            ? decoder->DecodeGray(batch.jpegs[i], batch.sizes[i], batch.outputs[i], batch.outputSizes[i], &batch.infos[i])
+            : decoder->DecodeI420(batch.jpegs[i], batch.sizes[i], batch.outputs[i], batch.outputSizes[i], &batch.infos[i]);
+        batch.results[i] = result;
+        if (result != 0) batch.succeeded++;
+    }
+};
+
+// HDR blend modes understood by HdrFusedDecoder (match HdrBlendMode Average/Weighted)
+#define HDR_BLEND_AVERAGE 0
+#define HDR_BLEND_WEIGHTED 1
+#define HDR_MAX_FRAMES 10
+
+// Per-byte blend of N rows, bit-exact with HdrBlend / MjpegHdrEngine:
+//   Average:  (sum + N/2) / N
+//   Weighted: lum = sum / N; min(255, sum_f(p_f * w[lum*N + f]) >> 8)
+template <int N>
+static void hdr_blend_row(int mode, const byte* const* src, byte* dst, int length, const byte* weights) {
+    if (mode == HDR_BLEND_AVERAGE) {
+        for (int x = 0; x < length; x++) {
+            unsigned sum = 0;
+            for (int f = 0; f < N; f++) sum += src[f][x];
+            dst[x] = (byte)((sum + N / 2) / N);
+        }
+    } else {
+        for (int x = 0; x < length; x++) {
+            unsigned sum = 0;
+            for (int f = 0; f < N; f++) sum += src[f][x];
+            const byte* w = weights + (sum / N) * N;
+            unsigned acc = 0;
+            for (int f = 0; f < N; f++) acc += (unsigned)src[f][x] * w[f];
+            acc >>= 8;
+            dst[x] = (byte)(acc > 255 ? 255 : acc);
+        }
+    }
+}
+
+static void hdr_blend_row(int count, int mode, const byte* const* src, byte* dst, int length, const byte* weights) {
+    switch (count) {
+    case 2: hdr_blend_row<2>(mode, src, dst, length, weights); break;
+    case 3: hdr_blend_row<3>(mode, src, dst, length, weights); break;
+    case 4: hdr_blend_row<4>(mode, src, dst, length, weights); break;
+    case 5: hdr_blend_row<5>(mode, src, dst, length, weights); break;
+    case 6: hdr_blend_row<6>(mode, src, dst, length, weights); break;
+    case 7: hdr_blend_row<7>(mode, src, dst, length, weights); break;
+    case 8: hdr_blend_row<8>(mode, src, dst, length, weights); break;
+    case 9: hdr_blend_row<9>(mode, src, dst, length, weights); break;
+    case 10: hdr_blend_row<10>(mode, src, dst, length, weights); break;
+    }
+}
+
+// Fused decode + HDR blend: N decompressors run in lock-step one MCU row at a time,
+// and each band is blended into the output while still in cache. Only the blended
+// Gray8/I420 image is written; no per-frame full-size buffers are needed.
+class HdrFusedDecoder {
+public:
+    enum Format { FormatI420 = 0, FormatGray = 1 };
+
+    HdrFusedDecoder(int maxWidth, int maxHeight)
+        : max_width(maxWidth), max_height(maxHeight), slot_count(0)
+    {
+    }
+
+    ~HdrFusedDecoder()
+    {
+        for (int i = 0; i < slot_count; i++) jpeg_destroy_decompress(&slots[i].cinfo);
+    }
+
+    // weights: HdrWeights table (256 * count entries), required for HDR_BLEND_WEIGHTED
+    // Returns bytes written to output, or 0 on error (size/sampling mismatch, buffer too small)
+    ulong DecodeBlend(Format format, int mode, const byte** jpegs, const ulong* sizes, int count,
+        const byte* weights, byte* output, ulong outputSize, DecodeInfo* info)
+    {
+        ulong bytesIn = 0;
+        for (int i = 0; i < count; i++) bytesIn += sizes[i];
+        CodecCall call(stats, bytesIn);
+
+        if (count < 2 || count > HDR_MAX_FRAMES) return 0;
+        if (mode == HDR_BLEND_WEIGHTED && weights == nullptr) return 0;
+        EnsureSlots(count);
+
+        // A corrupt frame anywhere in the window fails the whole blend
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { Abort(count); return 0; }
+
+        for (int i = 0; i < count; i++) {
+            if (!Start(slots[i], format, jpegs[i], sizes[i])) { Abort(i + 1); return 0; }
+        }
+        stats.MarkHeader();
+
+        j_decompress_ptr first = &slots[0].cinfo;
+        int width = first->output_width;
+        int height = first->output_height;
+        for (int i = 1; i < count; i++) {
+            if ((int)slots[i].cinfo.output_width != width || (int)slots[i].cinfo.output_height != height) {
+                Abort(count);
+                return 0;
+            }
+        }
+
+        info->width = width;
+        info->height = height;
+        info->components = format == FormatGray ? 1 : 3;
+        info->colorSpace = first->out_color_space;
+        info->layout = YUV_LAYOUT_I420;
+
+        ulong totalSize = format == FormatGray
+            ? (ulong)width * height
+            : yuv_frame_size(YUV_LAYOUT_I420, width, height);
+        if (totalSize > outputSize) { Abort(count); return 0; }
+
+        ulong written = format == FormatGray
+            ? BlendGray(count, mode, weights, output, width, height)
+            : BlendI420(count, mode, weights, output, width, height);
+
+        for (int i = 0; i < count; i++) jpeg_finish_decompress(&slots[i].cinfo);
+        return call.Done(written != 0 && !jerr.failed ? totalSize : 0);
+    }
+
+    // All slots report into one set of counters; the peak pool size covers the slots together
+    CodecCounters stats;
+
+private:
+    struct Slot {
+        struct jpeg_decompress_struct cinfo;
+        PoolMeter meter;
+        std::vector<byte> band;
+        int stride[3];
+    };
+
+    int max_width;
+    int max_height;
+    int slot_count;
+    Slot slots[HDR_MAX_FRAMES];
+    jump_error_mgr jerr;        // Shared by the slots, which are only driven together
+
+    void EnsureSlots(int count)
+    {
+        for (; slot_count < count; slot_count++) {
+            Slot& slot = slots[slot_count];
+            slot.cinfo.err = jump_error(&jerr);
+            jpeg_create_decompress(&slot.cinfo);
+            pool_meter_install((j_common_ptr)&slot.cinfo, &slot.meter, &stats);
+        }
+    }
+
+    void Abort(int count)
+    {
+        for (int i = 0; i < count; i++) jpeg_abort_decompress(&slots[i].cinfo);
+    }
+
+    static bool IsI420Sampling(j_decompress_ptr cinfo)
+    {
+        return cinfo->num_components == 3 &&
+            cinfo->comp_info[0].h_samp_factor == 2 && cinfo->comp_info[0].v_samp_factor == 2 &&
+            cinfo->comp_info[1].h_samp_factor == 1 && cinfo->comp_info[1].v_samp_factor == 1 &&
+            cinfo->comp_info[2].h_samp_factor == 1 && cinfo->comp_info[2].v_samp_factor == 1;
+    }
+
+    bool Start(Slot& slot, Format format, const byte* jpeg, ulong size)
+    {
+        j_decompress_ptr cinfo = &slot.cinfo;
+        jpeg_memory_src(cinfo, jpeg, size);
+        if (jpeg_read_header(cinfo, TRUE) != JPEG_HEADER_OK || jerr.failed) return false;
+
+        if (format == FormatGray) {
+            cinfo->out_color_space = JCS_GRAYSCALE;
+            cinfo->raw_data_out = FALSE;
+        } else {
+            if (!IsI420Sampling(cinfo)) return false;
+            cinfo->out_color_space = JCS_YCbCr;
+            cinfo->raw_data_out = TRUE;
+        }
+
+        jpeg_start_decompress(cinfo);
+        if (jerr.failed) return false;
+
+        if (format == FormatGray) {
+            // Band of 16 scanlines at output width
+            slot.stride[0] = cinfo->output_width;
+            slot.band.resize((size_t)slot.stride[0] * 16);
+        } else {
+            // Raw reads fill whole MCU-aligned rows: 16 luma + 8 + 8 chroma rows
+            slot.stride[0] = cinfo->comp_info[0].width_in_blocks * DCTSIZE;
+            slot.stride[1] = cinfo->comp_info[1].width_in_blocks * DCTSIZE;
+            slot.stride[2] = cinfo->comp_info[2].width_in_blocks * DCTSIZE;
+            slot.band.resize((size_t)slot.stride[0] * 16 + (size_t)(slot.stride[1] + slot.stride[2]) * 8);
+        }
+        return true;
+    }
+
+    ulong BlendI420(int count, int mode, const byte* weights, byte* output, int width, int height)
+    {
+        int uvWidth, uvHeight;
+        yuv_chroma_size(YUV_LAYOUT_I420, width, height, &uvWidth, &uvHeight);
+        byte* Y = output;
+        byte* U = output + (size_t)width * height;
+        byte* V = U + (size_t)uvWidth * uvHeight;
+
+        const byte* rows[HDR_MAX_FRAMES];
+        for (int top = 0; top < height; top += 16) {
+            for (int i = 0; i < count; i++) {
+                Slot& slot = slots[i];
+                byte* band = slot.band.data();
+                JSAMPROW y_rows[16];
+                JSAMPROW u_rows[8];
+                JSAMPROW v_rows[8];
+                for (int r = 0; r < 16; r++) y_rows[r] = band + (size_t)r * slot.stride[0];
+                byte* u = band + (size_t)16 * slot.stride[0];
+                byte* v = u + (size_t)8 * slot.stride[1];
+                for (int r = 0; r < 8; r++) {
+                    u_rows[r] = u + (size_t)r * slot.stride[1];
+                    v_rows[r] = v + (size_t)r * slot.stride[2];
+                }
+                JSAMPARRAY planes[3] = { y_rows, u_rows, v_rows };
+                if (jpeg_read_raw_data(&slot.cinfo, planes, 16) == 0 || jerr.failed) { Abort(count); return 0; }
+            }
+
+            for (int r = 0; r < 16 && top + r < height; r++) {
+                for (int i = 0; i < count; i++) rows[i] = slots[i].band.data() + (size_t)r * slots[i].stride[0];
+                hdr_blend_row(count, mode, rows, Y + (size_t)(top + r) * width, width, weights);
+            }
+            for (int r = 0; r < 8 && top / 2 + r < uvHeight; r++) {
+                for (int i = 0; i < count; i++) {
+                    rows[i] = slots[i].band.data() + (size_t)16 * slots[i].stride[0] + (size_t)r * slots[i].stride[1];
+                }
+                hdr_blend_row(count, mode, rows, U + (size_t)(top / 2 + r) * uvWidth, uvWidth, weights);
+                for (int i = 0; i < count; i++) {
+                    rows[i] = slots[i].band.data() + (size_t)16 * slots[i].stride[0] + (size_t)8 * slots[i].stride[1]
+                        + (size_t)r * slots[i].stride[2];
+                }
+                hdr_blend_row(count, mode, rows, V + (size_t)(top / 2 + r) * uvWidth, uvWidth, weights);
+            }
+        }
+        return 1;
+    }
+
+    ulong BlendGray(int count, int mode, const byte* weights, byte* output, int width, int height)
+    {
+        const byte* rows[HDR_MAX_FRAMES];
+        for (int top = 0; top < height; top += 16) {
+            int lines = height - top < 16 ? height - top : 16;
+            for (int i = 0; i < count; i++) {
+                Slot& slot = slots[i];
+                while ((int)slot.cinfo.output_scanline < top + lines) {
+                    JSAMPROW row = slot.band.data() + (size_t)(slot.cinfo.output_scanline - top) * slot.stride[0];
+                    if (jpeg_read_scanlines(&slot.cinfo, &row, 1) == 0 || jerr.failed) { Abort(count); return 0; }
+                }
+            }
+            for (int r = 0; r < lines; r++) {
+                for (int i = 0; i < count; i++) rows[i] = slots[i].band.data() + (size_t)r * slots[i].stride[0];
+                hdr_blend_row(count, mode, rows, output + (size_t)(top + r) * width, width, weights);
+            }
+        }
+        return 1;
+    }
+};
+
+// Custom error handler — sets flag instead of calling exit()
+// CRITICAL for WASM: default jpeg_error_exit calls exit() which kills the entire app.
+// NOTE: setjmp/longjmp is not used because the .NET WASM runtime's linker
+// (-mllvm -wasm-enable-sjlj) is incompatible with Emscripten's JS-based
+// setjmp/longjmp emulation. Flag-based error recovery avoids this issue.
+struct safe_error_mgr {
+    struct jpeg_error_mgr pub;
+    bool has_error;
+};
+
+static void safe_error_exit(j_common_ptr cinfo) {
+    safe_error_mgr* myerr = (safe_error_mgr*)cinfo->err;
+    myerr->has_error = true;
+    // Do NOT call exit() — just set the flag and return.
+    // The caller checks has_error after each libjpeg call.
+}
+
+// Packed 32-bit output orders for the BGRA decoder and the I420 converter
+#define PIXEL_ORDER_BGRA 0
+#define PIXEL_ORDER_RGBA 1
+
+// YCbCr -> RGB (JFIF full-range BT.601, what libjpeg itself applies), Q13 coefficients.
+// Each term is computed at twice its value from the chroma offset scaled by 16 - one 16-bit
+// high-half multiply per term in SIMD - then rounded; scalar tails use the same integer steps,
+// so SIMD and scalar columns agree bit for bit. Within 1 of libjpeg's own conversion.
+#define YCC_KR 11485   // 1.402
+#define YCC_KGB 2819   // 0.344136
+#define YCC_KGR 5850   // 0.714136
+#define YCC_KB 14516   // 1.772
+
+static inline byte clamp_byte(int v) {
+    return (byte)(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+// One output row. u/v hold cw samples (cw 0 = no chroma, neutral); pixels past 2 * cw reuse the last sample.
+static void I420RowToPacked(const byte* y, const byte* u, const byte* v, int width, int cw, byte* out, int order)
+{
+    int x = 0;
+    int simdEnd = std::min(width, 2 * cw);
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i kr = _mm_set1_epi16(YCC_KR);
+    const __m128i kgb = _mm_set1_epi16(YCC_KGB);
+    const __m128i kgr = _mm_set1_epi16(YCC_KGR);
+    const __m128i kb = _mm_set1_epi16(YCC_KB);
+    const __m128i alpha = _mm_set1_epi8((char)0xFF);
+    for (; x + 16 <= simdEnd; x += 16) {
+        __m128i cb = _mm_slli_epi16(_mm_sub_epi16(
+            _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(u + x / 2)), zero), bias), 4);
+        __m128i cr = _mm_slli_epi16(_mm_sub_epi16(
+            _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(v + x / 2)), zero), bias), 4);
+        __m128i rt = _mm_srai_epi16(_mm_add_epi16(_mm_mulhi_epi16(cr, kr), one), 1);
+        __m128i gt = _mm_srai_epi16(_mm_add_epi16(
+            _mm_add_epi16(_mm_mulhi_epi16(cb, kgb), _mm_mulhi_epi16(cr, kgr)), one), 1);
+        __m128i bt = _mm_srai_epi16(_mm_add_epi16(_mm_mulhi_epi16(cb, kb), one), 1);
+
+        // Each chroma term covers two neighbouring pixels
+        __m128i yv = _mm_loadu_si128((const __m128i*)(y + x));
+        __m128i ylo = _mm_unpacklo_epi8(yv, zero);
+        __m128i yhi = _mm_unpackhi_epi8(yv, zero);
+        __m128i r = _mm_packus_epi16(_mm_add_epi16(ylo, _mm_unpacklo_epi16(rt, rt)),
+                                     _mm_add_epi16(yhi, _mm_unpackhi_epi16(rt, rt)));
+        __m128i g = _mm_packus_epi16(_mm_sub_epi16(ylo, _mm_unpacklo_epi16(gt, gt)),
+                                     _mm_sub_epi16(yhi, _mm_unpackhi_epi16(gt, gt)));
+        __m128i b = _mm_packus_epi16(_mm_add_epi16(ylo, _mm_unpacklo_epi16(bt, bt)),
+                                     _mm_add_epi16(yhi, _mm_unpackhi_epi16(bt, bt)));
+        if (order == PIXEL_ORDER_RGBA) std::swap(r, b);
+
+        __m128i bg_lo = _mm_unpacklo_epi8(b, g);
+        __m128i bg_hi = _mm_unpackhi_epi8(b, g);
+        __m128i ra_lo = _mm_unpacklo_epi8(r, alpha);
+        __m128i ra_hi = _mm_unpackhi_epi8(r, alpha);
+        __m128i* dst = (__m128i*)(out + (size_t)x * 4);
+        _mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(bg_lo, ra_lo));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(bg_lo, ra_lo));
+        _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(bg_hi, ra_hi));
+        _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(bg_hi, ra_hi));
+    }
+#elif defined(__ARM_NEON)
+    const int16x8_t bias = vdupq_n_s16(128);
+    const int16x8_t one = vdupq_n_s16(1);
+    const int16x8_t kr = vdupq_n_s16(YCC_KR);
+    const int16x8_t kgb = vdupq_n_s16(YCC_KGB);
+    const int16x8_t kgr = vdupq_n_s16(YCC_KGR);
+    const int16x8_t kb = vdupq_n_s16(YCC_KB);
+    for (; x + 16 <= simdEnd; x += 16) {
+        // vqdmulh doubles the product, so a shift of 3 matches the SSE2 shift of 4
+        int16x8_t cb = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + x / 2))), bias), 3);
+        int16x8_t cr = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + x / 2))), bias), 3);
+        int16x8_t rt = vshrq_n_s16(vaddq_s16(vqdmulhq_s16(cr, kr), one), 1);
+        int16x8_t gt = vshrq_n_s16(vaddq_s16(vaddq_s16(vqdmulhq_s16(cb, kgb), vqdmulhq_s16(cr, kgr)), one), 1);
+        int16x8_t bt = vshrq_n_s16(vaddq_s16(vqdmulhq_s16(cb, kb), one), 1);
+
+        uint8x16_t yv = vld1q_u8(y + x);
+        int16x8_t ylo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(yv)));
+        int16x8_t yhi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(yv)));
+        int16x8x2_t rz = vzipq_s16(rt, rt);
+        int16x8x2_t gz = vzipq_s16(gt, gt);
+        int16x8x2_t bz = vzipq_s16(bt, bt);
+        uint8x16_t r = vcombine_u8(vqmovun_s16(vaddq_s16(ylo, rz.val[0])), vqmovun_s16(vaddq_s16(yhi, rz.val[1])));
+        uint8x16_t g = vcombine_u8(vqmovun_s16(vsubq_s16(ylo, gz.val[0])), vqmovun_s16(vsubq_s16(yhi, gz.val[1])));
+        uint8x16_t b = vcombine_u8(vqmovun_s16(vaddq_s16(ylo, bz.val[0])), vqmovun_s16(vaddq_s16(yhi, bz.val[1])));
+
+        uint8x16x4_t px;
+        px.val[0] = order == PIXEL_ORDER_RGBA ? r : b;
+        px.val[1] = g;
+        px.val[2] = order == PIXEL_ORDER_RGBA ? b : r;
+        px.val[3] = vdupq_n_u8(0xFF);
+        vst4q_u8(out + (size_t)x * 4, px);
+    }
+#endif
+    for (; x < width; x++) {
+        int cb = 0, cr = 0;
+        if (cw > 0) {
+            int c = std::min(x / 2, cw - 1);
+            cb = (u[c] - 128) * 16;
+            cr = (v[c] - 128) * 16;
+        }
+        int rt = (((cr * YCC_KR) >> 16) + 1) >> 1;
+        int gt = (((cb * YCC_KGB) >> 16) + ((cr * YCC_KGR) >> 16) + 1) >> 1;
+        int bt = (((cb * YCC_KB) >> 16) + 1) >> 1;
+        int luma = y[x];
+        byte* px = out + (size_t)x * 4;
+        px[order == PIXEL_ORDER_RGBA ? 0 : 2] = clamp_byte(luma + rt);
+        px[1] = clamp_byte(luma - gt);
+        px[order == PIXEL_ORDER_RGBA ? 2 : 0] = clamp_byte(luma + bt);
+        px[3] = 0xFF;
+    }
+}
+
+// I420 planes -> packed BGRA/RGBA rows outStride bytes apart, e.g. straight into a bitmap.
+// Chroma planes hold (width+1)/2 x (height+1)/2 samples, as the decoders emit them, so an odd
+// last column / row has its own chroma sample. Returns outStride * height, 0 on bad arguments.
+ulong ConvertI420ToPacked(const byte* y, int yStride, const byte* u, const byte* v, int uvStride,
+    int width, int height, byte* output, int outStride, int order)
+{
+    if (width <= 0 || height <= 0 || yStride < width || outStride < width * 4) return 0;
+    if (order != PIXEL_ORDER_BGRA && order != PIXEL_ORDER_RGBA) return 0;
+
+    int cw, ch;
+    yuv_chroma_size(YUV_LAYOUT_I420, width, height, &cw, &ch);
+    for (int row = 0; row < height; row++) {
+        const byte* urow = nullptr;
+        const byte* vrow = nullptr;
+        if (cw > 0 && ch > 0) {
+            int crow = std::min(row / 2, ch - 1);
+            urow = u + (size_t)crow * uvStride;
+            vrow = v + (size_t)crow * uvStride;
+        }
+        I420RowToPacked(y + (size_t)row * yStride, urow, vrow, width, urow ? cw : 0,
+            output + (size_t)row * outStride, order);
+    }
+    return (ulong)outStride * height;
+}
+
+// BGRA Decoder — reuses jpeg_decompress_struct, safe error handling
+class BgraDecoder {
+public:
+    struct jpeg_decompress_struct cinfo;
+    safe_error_mgr jerr;
+    int max_width;
+    int max_height;
+    int backend;
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+    tjhandle tj = nullptr;
+#endif
+
+    BgraDecoder(int maxWidth, int maxHeight, int backend = JPEG_BACKEND_LIBJPEG)
+        : max_width(maxWidth), max_height(maxHeight), backend(backend)
+    {
+        cinfo.err = jpeg_std_error(&jerr.pub);
+        jerr.pub.error_exit = safe_error_exit;
+        jerr.has_error = false;
+        jpeg_create_decompress(&cinfo);
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (backend == JPEG_BACKEND_TURBOJPEG) tj = tj3Init(TJINIT_DECOMPRESS);
+#endif
+    }
+
+    ~BgraDecoder()
+    {
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) tj3Destroy(tj);
+#endif
+        jpeg_destroy_decompress(&cinfo);
+    }
+
+    // False when the requested backend could not be initialized
+    bool IsValid() const
+    {
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        return backend != JPEG_BACKEND_TURBOJPEG || tj != nullptr;
+#else
+        return backend == JPEG_BACKEND_LIBJPEG;
+#endif
+    }
+
+    // scaleDenom 2, 4 or 8 decodes straight to 1/scale size in the DCT domain; info reports the scaled size
+    ulong DecodeBGRA(const byte* jpegData, ulong jpegSize,
+                     byte* output, ulong outputSize, DecodeInfo* info, int scaleDenom = 1)
+    {
+        return DecodePacked(jpegData, jpegSize, output, outputSize, info, scaleDenom, PIXEL_ORDER_BGRA, 0);
+    }
+
+    // BGRA or RGBA rows stride bytes apart (0 = packed), so the decode lands directly in a bitmap or
+    // texture buffer with padded rows. Needs outputSize >= stride * height; returns that, 0 on error.
+    ulong DecodePacked(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info,
+                       int scaleDenom, int order, int stride)
+    {
+        if (!IsScaleSupported(scaleDenom) || stride < 0) return 0;
+        if (order != PIXEL_ORDER_BGRA && order != PIXEL_ORDER_RGBA) return 0;
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+        if (tj) return DecodePackedTurbo(jpegData, jpegSize, output, outputSize, info, scaleDenom, order, stride);
+#endif
+        jerr.has_error = false;
+
+        jpeg_memory_src(&cinfo, jpegData, jpegSize);
+        if (jerr.has_error) { jpeg_abort_decompress(&cinfo); return 0; }
+
+        if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK || jerr.has_error) {
+            jpeg_abort_decompress(&cinfo);
+            return 0;
+        }
+
+        // Direct BGRA / RGBA — libjpeg-turbo extensions
+        cinfo.out_color_space = order == PIXEL_ORDER_RGBA ? JCS_EXT_RGBA : JCS_EXT_BGRA;
+        cinfo.raw_data_out = FALSE;
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = scaleDenom;
+
+        jpeg_start_decompress(&cinfo);
+        if (jerr.has_error) { jpeg_abort_decompress(&cinfo); return 0; }
+
+        int width = cinfo.output_width;
+        int height = cinfo.output_height;
+        int rowBytes = stride ? stride : width * 4;
+        ulong totalSize = (ulong)rowBytes * height;
+
+        info->width = width;
+        info->height = height;
+        info->components = 4;
+        info->colorSpace = cinfo.out_color_space;
+        info->stride = rowBytes;
+
+        if (rowBytes < width * 4 || totalSize > outputSize) {
+            jpeg_abort_decompress(&cinfo);
+            return 0;
+        }
+
+        // Read scanlines directly into caller's buffer
+        while (cinfo.output_scanline < cinfo.output_height) {
+            byte* rowPtr = output + cinfo.output_scanline * rowBytes;
+            jpeg_read_scanlines(&cinfo, &rowPtr, 1);
+            if (jerr.has_error) { jpeg_abort_decompress(&cinfo); return 0; }
+        }
+
+        jpeg_finish_decompress(&cinfo);
+        if (jerr.has_error) {
+            // Struct may be in a dirty state — abort defensively before reuse
+            jpeg_abort_decompress(&cinfo);
+            return 0;
+        }
+        return totalSize;
+    }
+
+#ifdef LIBJPEGWRAP_WITH_TURBOJPEG
+    // TurboJPEG reports errors through return codes, so no error manager is involved
+    ulong DecodePackedTurbo(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize,
+                            DecodeInfo* info, int scaleDenom, int order, int stride)
+    {
+        if (tj3DecompressHeader(tj, jpegData, jpegSize) < 0) return 0;
+
+        int width, height;
+        if (!tj_set_scale(tj, scaleDenom, &width, &height)) return 0;
+        int rowBytes = stride ? stride : width * 4;
+        ulong totalSize = (ulong)rowBytes * height;
+
+        info->width = width;
+        info->height = height;
+        info->components = 4;
+        info->colorSpace = order == PIXEL_ORDER_RGBA ? JCS_EXT_RGBA : JCS_EXT_BGRA;
+        info->stride = rowBytes;
+
+        if (rowBytes < width * 4 || totalSize > outputSize) return 0;
+
+        int pixelFormat = order == PIXEL_ORDER_RGBA ? TJPF_RGBA : TJPF_BGRA;
+        if (tj3Decompress8(tj, jpegData, jpegSize, output, rowBytes, pixelFormat) < 0) return 0;
+        return totalSize;
+    }
+#endif
+};
+
+// One decode queued on a BgraWorkerPool; the buffers must stay valid until its result is polled
+typedef struct {
+    uint64_t id;
+    const byte* jpegData;
+    ulong jpegSize;
+    byte* output;
+    ulong outputSize;
+    int scaleDenom;
+    int order;
+    int stride;
+} DecodeJob;
+
+// Finished BgraWorkerPool job; written is 0 when the decode failed
+typedef struct {
+    uint64_t id;
+    ulong written;
+    DecodeInfo info;
+} DecodeJobResult;
+
+// Packed (BGRA/RGBA) decode on native worker threads for callers that must never block, such as
+// the browser main thread under Emscripten pthreads. Submit queues a job and returns at once; Poll
+// collects finished jobs in completion order. At most capacity jobs are in flight, finished but
+// unpolled ones included, so a full pool rejects Submit instead of waiting.
+// Without thread support Submit decodes inline and Poll hands the result back.
+class BgraWorkerPool {
+public:
+    BgraWorkerPool(int threads, int maxWidth, int maxHeight, int capacity)
+    {
+        if (threads < 1) threads = 1;
+#ifndef LIBJPEGWRAP_HAS_THREADS
+        threads = 1;
+#endif
+        if (capacity < threads) capacity = threads;
+        this->capacity = capacity;
+        queue.resize(capacity);
+        done.reserve(capacity);
+        for (int i = 0; i < threads; i++) {
+            decoders.push_back(new BgraDecoder(maxWidth, maxHeight));
+        }
+#ifdef LIBJPEGWRAP_HAS_THREADS
+        for (int i = 0; i < threads; i++) {
+            workers.emplace_back(&BgraWorkerPool::WorkerLoop, this, i);
+        }
+#endif
+    }
+
+    // Queued jobs are still decoded; the caller must keep their buffers alive until this returns
+    ~BgraWorkerPool()
+    {
+#ifdef LIBJPEGWRAP_HAS_THREADS
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            stopping = true;
+        }
+        work_ready.notify_all();
+        for (auto& worker : workers) worker.join();
+#endif
+        for (auto* decoder : decoders) delete decoder;
+    }
+
+    // 1 when queued, 0 when capacity jobs are already in flight
+    int Submit(const DecodeJob& job)
+    {
+#ifdef LIBJPEGWRAP_HAS_THREADS
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            if (in_flight == capacity) return 0;
+            queue[(head + queued) % capacity] = job;
+            queued++;
+            in_flight++;
+        }
+        work_ready.notify_one();
+#else
+        if (in_flight == capacity) return 0;
+        in_flight++;
+        done.push_back(Run(decoders[0], job));
+#endif
+        return 1;
+    }
+
+    // Copies up to max finished jobs into results and returns how many; never waits for a decode
+    int Poll(DecodeJobResult* results, int max)
+    {
+#ifdef LIBJPEGWRAP_HAS_THREADS
+        std::lock_guard<std::mutex> lock(state_mutex);
+#endif
+        int count = (int)done.size();
+        if (count > max) count = max;
+        if (count <= 0) return 0;
+        std::copy(done.begin(), done.begin() + count, results);
+        done.erase(done.begin(), done.begin() + count);
+        in_flight -= count;
+        return count;
+    }
+
+private:
+    std::vector<BgraDecoder*> decoders;
+    std::vector<DecodeJob> queue;           // Ring of queued jobs, capacity slots
+    std::vector<DecodeJobResult> done;      // Finished jobs awaiting Poll
+    int capacity = 1;
+    int head = 0;
+    int queued = 0;
+    int in_flight = 0;
+
+    static DecodeJobResult Run(BgraDecoder* decoder, const DecodeJob& job)
+    {
+        DecodeJobResult result;
+        memset(&result, 0, sizeof(result));
+        result.id = job.id;
+        result.written = decoder->DecodePacked(job.jpegData, job.jpegSize, job.output, job.outputSize,
+            &result.info, job.scaleDenom, job.order, job.stride);
+        return result;
+    }
+
+#ifdef LIBJPEGWRAP_HAS_THREADS
+    std::vector<std::thread> workers;
+    std::mutex state_mutex;
+    std::condition_variable work_ready;
+    bool stopping = false;
+
+    void WorkerLoop(int index)
+    {
+        for (;;) {
+            DecodeJob job;
+            {
+                std::unique_lock<std::mutex> lock(state_mutex);
+                work_ready.wait(lock, [this] { return stopping || queued > 0; });
+                if (queued == 0) return;
+                job = queue[head];
+                head = (head + 1) % capacity;
+                queued--;
+            }
+
+            DecodeJobResult result = Run(decoders[index], job);
+
+            std::lock_guard<std::mutex> lock(state_mutex);
+            done.push_back(result);
+        }
+    }
+#endif
+};
+
+// Streaming decoder — decodes a frame while it is still arriving. Feed hands over each received
+// segment; libjpeg decodes as far as the bytes go, and when the source runs dry fill_input_buffer
+// returns FALSE so the call suspends (libjpeg's suspending data source). The next Feed resumes from
+// the saved position. Only the unconsumed tail of the input is kept between calls.
+#define STREAM_NEED_MORE 0
+#define STREAM_DONE 1
+#define STREAM_ERROR -1
+
+class StreamingDecoder {
+public:
+    struct Source {
+        struct jpeg_source_mgr pub;
+        StreamingDecoder* owner;
+    };
+
+    enum Stage { IDLE, HEADER, START, DATA, FINISH, DONE, FAILED };
+
+    struct jpeg_decompress_struct cinfo;
+    jump_error_mgr jerr;
+    Source src;
+    int max_width;
+    int max_height;
+    std::vector<byte> pending;      // Fed bytes libjpeg has not consumed; next_input_byte points here
+    ulong skip = 0;                 // Bytes skip_input_data asked for beyond what was fed
+    Stage stage = IDLE;
+    int format = DECODE_FORMAT_I420;
+    byte* output = nullptr;
+    ulong output_size = 0;
+    ulong frame_size = 0;
+    bool raw = false;
+    std::vector<byte> pair_rows;    // Scanline path: two YCbCr rows, averaged into one chroma row
+    std::vector<byte> raw_rows;     // Raw path: one iMCU row per component for rows that miss the planes
+    int raw_strides[3] = {};
+    ulong raw_offsets[3] = {};
+
+    StreamingDecoder(int maxWidth, int maxHeight)
+        : max_width(maxWidth), max_height(maxHeight)
+    {
+        cinfo.err = jump_error(&jerr);
+        jpeg_create_decompress(&cinfo);
+
+        src.owner = this;
+        src.pub.init_source = init_source;
+        src.pub.fill_input_buffer = FillInput;
+        src.pub.skip_input_data = SkipInput;
+        src.pub.resync_to_restart = jpeg_resync_to_restart;
+        src.pub.term_source = term_source;
+        src.pub.next_input_byte = nullptr;
+        src.pub.bytes_in_buffer = 0;
+        cinfo.src = &src.pub;
+    }
+
+    ~StreamingDecoder()
+    {
+        jpeg_destroy_decompress(&cinfo);
+    }
+
+    // Starts a new frame decoding into output (I420 or Gray8). The buffer must stay valid until
+    // Feed reports STREAM_DONE or STREAM_ERROR, or the next Begin.
+    bool Begin(int fmt, byte* out, ulong outSize)
+    {
+        if (fmt != DECODE_FORMAT_I420 && fmt != DECODE_FORMAT_GRAY) return false;
+        jpeg_abort_decompress(&cinfo);
+        jerr.failed = false;
+        pending.clear();
+        skip = 0;
+        src.pub.next_input_byte = nullptr;
+        src.pub.bytes_in_buffer = 0;
+        format = fmt;
+        output = out;
+        output_size = outSize;
+        stage = HEADER;
+        return true;
+    }
+
+    // Appends data and decodes as far as it goes. last marks the end of the frame, which must then
+    // complete. Returns STREAM_NEED_MORE, STREAM_DONE (info and written filled) or STREAM_ERROR.
+    int Feed(const byte* data, ulong size, bool last, DecodeInfo* info, ulong* written)
+    {
+        if (stage == IDLE || stage == FAILED) return STREAM_ERROR;
+        if (stage != DONE) {
+            // Drop what libjpeg consumed; the rest is usually a partial MCU
+            size_t consumed = pending.size() - src.pub.bytes_in_buffer;
+            pending.erase(pending.begin(), pending.begin() + consumed);
+
+            ulong skipped = skip < size ? skip : size;
+            skip -= skipped;
+            pending.insert(pending.end(), data + skipped, data + size);
+            src.pub.next_input_byte = pending.data();
+            src.pub.bytes_in_buffer = pending.size();
+
+            Step();
+            if (stage == FAILED) return STREAM_ERROR;
+            if (stage != DONE) {
+                if (!last) return STREAM_NEED_MORE;
+                jpeg_abort_decompress(&cinfo);  // Truncated frame
+                stage = FAILED;
+                return STREAM_ERROR;
+            }
+        }
+
+        info->width = cinfo.output_width;
+        info->height = cinfo.output_height;
+        info->components = format == DECODE_FORMAT_GRAY ? 1 : 3;
+        info->colorSpace = format == DECODE_FORMAT_GRAY ? JCS_GRAYSCALE : JCS_YCbCr;
+        info->layout = format == DECODE_FORMAT_GRAY ? -1 : YUV_LAYOUT_I420;
+        *written = frame_size;
+        return STREAM_DONE;
+    }
+
+private:
+    static boolean FillInput(j_decompress_ptr)
+    {
+        return FALSE;  // Suspend until the next Feed
+    }
+
+    static void SkipInput(j_decompress_ptr cinfo, long num_bytes)
+    {
+        Source* src = (Source*)cinfo->src;
+        if (num_bytes <= 0) return;
+        if ((ulong)num_bytes > src->pub.bytes_in_buffer) {
+            src->owner->skip += num_bytes - src->pub.bytes_in_buffer;
+            src->pub.next_input_byte += src->pub.bytes_in_buffer;
+            src->pub.bytes_in_buffer = 0;
+        } else {
+            src->pub.next_input_byte += num_bytes;
+            src->pub.bytes_in_buffer -= num_bytes;
+        }
+    }
+
+    void Fail()
+    {
+        jpeg_abort_decompress(&cinfo);
+        stage = FAILED;
+    }
+
+    // Runs the decompress state machine until the input is exhausted or the frame is done.
+    // Each libjpeg call either completes its step or suspends and is simply repeated next time.
+    void Step()
+    {
+        // Corrupt data anywhere below lands here instead of decoding on with broken state
+        if (JPEG_CATCH(jerr)) { Fail(); return; }
+        while (true) {
+            switch (stage) {
+            case HEADER: {
+                int r = jpeg_read_header(&cinfo, TRUE);
+                if (jerr.failed || (r != JPEG_SUSPENDED && r != JPEG_HEADER_OK)) { Fail(); return; }
+                if (r == JPEG_SUSPENDED) return;
+                if (!Configure()) { Fail(); return; }
+                stage = START;
+                break;
+            }
+            case START: {
+                boolean started = jpeg_start_decompress(&cinfo);
+                if (jerr.failed) { Fail(); return; }
+                if (!started) return;
+                stage = DATA;
+                break;
+            }
+            case DATA:
+                if (!(raw ? ReadRaw() : ReadScanlines())) return;
+                stage = FINISH;
+                break;
+            case FINISH: {
+                boolean finished = jpeg_finish_decompress(&cinfo);
+                if (jerr.failed) { Fail(); return; }
+                if (!finished) return;
+                stage = DONE;
+                return;
+            }
+            default:
+                return;
+            }
+        }
+    }
+
+    // Picks the output path once the header is known; false when the frame cannot be decoded here
+    bool Configure()
+    {
+        int width = cinfo.image_width;
+        int height = cinfo.image_height;
+        if (width > max_width || height > max_height) return false;
+
+        int cw, ch;
+        yuv_chroma_size(YUV_LAYOUT_I420, width, height, &cw, &ch);
+        ulong sizeY = (ulong)width * height;
+        ulong sizeUV = (ulong)cw * ch;
+        frame_size = format == DECODE_FORMAT_GRAY ? sizeY : sizeY + 2 * sizeUV;
+        if (frame_size > output_size) return false;
+
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = 1;
+        bool gray = format == DECODE_FORMAT_GRAY || cinfo.num_components == 1;
+
+        // Raw 4:2:0 lands in the planes, like I420Decoder; other sampling takes scanlines
+        raw = !gray && cinfo.jpeg_color_space == JCS_YCbCr && cinfo.num_components == 3 &&
+            cinfo.comp_info[0].h_samp_factor == 2 && cinfo.comp_info[0].v_samp_factor == 2 &&
+            cinfo.comp_info[1].h_samp_factor == 1 && cinfo.comp_info[1].v_samp_factor == 1 &&
+            cinfo.comp_info[2].h_samp_factor == 1 && cinfo.comp_info[2].v_samp_factor == 1;
+
+        cinfo.raw_data_out = raw ? TRUE : FALSE;
+        cinfo.out_color_space = gray ? JCS_GRAYSCALE : JCS_YCbCr;
+        // Replicated chroma averages 2x2 to the same I420 samples the raw-data decodes produce
+        cinfo.do_fancy_upsampling = FALSE;
+
+        if (raw) {
+            // Whole blocks are written, plus up to one MCU of padding (see ReadRawPlanar)
+            ulong total = 0;
+            for (int ci = 0; ci < 3; ci++) {
+                jpeg_component_info* comp = &cinfo.comp_info[ci];
+                raw_strides[ci] = (comp->width_in_blocks + comp->h_samp_factor) * DCTSIZE;
+                raw_offsets[ci] = total;
+                total += (ulong)raw_strides[ci] * comp->v_samp_factor * DCTSIZE;
+            }
+            if (raw_rows.size() < total) raw_rows.resize(total);
+        }
+
+        // Gray source into I420: neutral chroma up front, the scanlines fill luma
+        if (format == DECODE_FORMAT_I420 && gray)
+            memset(output + sizeY, 128, 2 * sizeUV);
+        if (!raw && !gray)
+            pair_rows.resize((ulong)width * 3 * 2);
+        return true;
+    }
+
+    // 16 luma / 8 chroma rows per call; false when suspended or failed. On the 16-pixel MCU grid
+    // libjpeg's rows are exactly as wide as the planes and are written in place; rows past the
+    // image and every row of other widths go to raw_rows, and their visible part is copied out.
+    bool ReadRaw()
+    {
+        int width = cinfo.output_width;
+        int height = cinfo.output_height;
+        int cw, ch;
+        yuv_chroma_size(YUV_LAYOUT_I420, width, height, &cw, &ch);
+        byte* dst[3] = { output, output + (ulong)width * height, output + (ulong)width * height + (ulong)cw * ch };
+        int planeW[3] = { width, cw, cw };
+        int planeH[3] = { height, ch, ch };
+        int rows[3] = { 16, 8, 8 };
+        bool direct = width % 16 == 0;
+
+        JSAMPROW y_rows[16];
+        JSAMPROW u_rows[8];
+        JSAMPROW v_rows[8];
+        JSAMPARRAY planes[3] = { y_rows, u_rows, v_rows };
+
+        while (cinfo.output_scanline < cinfo.output_height) {
+            int row = cinfo.output_scanline;
+            for (int ci = 0; ci < 3; ci++) {
+                int top = ci == 0 ? row : row / 2;
+                for (int i = 0; i < rows[ci]; i++) {
+                    planes[ci][i] = direct && top + i < planeH[ci]
+                        ? dst[ci] + (ulong)(top + i) * planeW[ci]
+                        : raw_rows.data() + raw_offsets[ci] + (ulong)i * raw_strides[ci];
+                }
+            }
+
+            JDIMENSION lines = jpeg_read_raw_data(&cinfo, planes, 16);
+            if (jerr.failed) { Fail(); return false; }
+            if (lines == 0) return false;
+            if (direct) continue;
+
+            for (int ci = 0; ci < 3; ci++) {
+                int top = ci == 0 ? row : row / 2;
+                int count = std::min(rows[ci], planeH[ci] - top);
+                for (int i = 0; i < count; i++)
+                    memcpy(dst[ci] + (ulong)(top + i) * planeW[ci], planes[ci][i], planeW[ci]);
+            }
+        }
+        return true;
+    }
+
+    // One scanline per call. YCbCr rows are split into luma and averaged 2x2 into I420 chroma;
+    // the first row of each pair waits in pair_rows across suspensions. An odd last row or column
+    // pairs with itself.
+    bool ReadScanlines()
+    {
+        int width = cinfo.output_width;
+        int height = cinfo.output_height;
+        bool gray = cinfo.out_color_space == JCS_GRAYSCALE;
+        int cw, ch;
+        yuv_chroma_size(YUV_LAYOUT_I420, width, height, &cw, &ch);
+        byte* U = output + (ulong)width * height;
+        byte* V = U + (ulong)cw * ch;
+
+        while (cinfo.output_scanline < cinfo.output_height) {
+            int row = cinfo.output_scanline;
+            byte* dst = gray ? output + (ulong)row * width : pair_rows.data() + (ulong)(row & 1) * width * 3;
+
+            JDIMENSION lines = jpeg_read_scanlines(&cinfo, &dst, 1);
+            if (jerr.failed) { Fail(); return false; }
+            if (lines == 0) return false;
+            if (gray) continue;
+
+            byte* Y = output + (ulong)row * width;
+            for (int x = 0; x < width; x++) Y[x] = dst[x * 3];
+
+            if ((row & 1) || row == height - 1) {
+                const byte* a = pair_rows.data();
+                const byte* b = (row & 1) ? a + (ulong)width * 3 : a;
+                byte* u = U + (ulong)(row / 2) * cw;
+                byte* v = V + (ulong)(row / 2) * cw;
+                for (int x = 0; x < cw; x++) {
+                    int p = x * 6;
+                    int q = 2 * x + 1 < width ? p + 3 : p;
+                    u[x] = (byte)((a[p + 1] + a[q + 1] + b[p + 1] + b[q + 1] + 2) >> 2);
+                    v[x] = (byte)((a[p + 2] + a[q + 2] + b[p + 2] + b[q + 2] + 2) >> 2);
+                }
+            }
+        }
+        return true;
+    }
+};
+
+// Decode JPEG to grayscale (for HDR blending)
+// Returns: bytes written to output, or 0 on error
+// Output format: 8-bit grayscale, row-major
+ulong DecodeToGray(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info) {
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+
+    jpeg_memory_src(&cinfo, jpegData, jpegSize);
+
+    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
         jpeg_destroy_decompress(&cinfo);
         return 0;
     }
@@ -546,143 +3539,838 @@ ulong DecodeToGray(const byte* jpegData, ulong jpegSize, byte* output, ulong out
         return 0;
     }
 
-    while (cinfo.output_scanline < cinfo.output_height) {
-        byte* rowPtr = output + cinfo.output_scanline * rowStride;
-        jpeg_read_scanlines(&cinfo, &rowPtr, 1);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        byte* rowPtr = output + cinfo.output_scanline * rowStride;
+        jpeg_read_scanlines(&cinfo, &rowPtr, 1);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+
+    return totalSize;
+}
+
+// Decode JPEG to I420 (YUV 4:2:0 planar) for HDR blending with color
+// Returns: bytes written to output, or 0 on error
+// Output format: Y plane (width*height), U and V planes ((width+1)/2 * (height+1)/2 each)
+ulong DecodeToI420(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info) {
+    // One-shot decoder: the same raw-data loop as the pooled one, so any sampling and size works
+    I420Decoder decoder(0, 0);
+    return decoder.DecodeI420(jpegData, jpegSize, output, outputSize, info);
+}
+
+// Encode grayscale (Gray8) to JPEG
+// Returns: bytes written to output, or 0 on error
+static void CompressGray8(j_compress_ptr cinfo, const byte* grayData, int width, int height, int quality) {
+    cinfo->image_width = width;
+    cinfo->image_height = height;
+    cinfo->input_components = 1;
+    cinfo->in_color_space = JCS_GRAYSCALE;
+
+    jpeg_set_defaults(cinfo);
+    jpeg_set_quality(cinfo, quality, TRUE);
+
+    jpeg_start_compress(cinfo, TRUE);
+
+    JSAMPROW row_pointer[1];
+    int row_stride = width;
+
+    while (cinfo->next_scanline < cinfo->image_height) {
+        row_pointer[0] = (JSAMPROW)&grayData[cinfo->next_scanline * row_stride];
+        jpeg_write_scanlines(cinfo, row_pointer, 1);
+    }
+
+    jpeg_finish_compress(cinfo);
+}
+
+ulong EncodeGray8(const byte* grayData, int width, int height, int quality, byte* output, ulong outputSize) {
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+
+    // Set up memory destination
+    memory_destination_mgr* dest = jpeg_memory_dest(&cinfo, output, outputSize);
+
+    CompressGray8(&cinfo, grayData, width, height, quality);
+
+    ulong dataSize = dest->data_size;
+    jpeg_destroy_compress(&cinfo);
+
+    return dataSize;
+}
+
+// Encode grayscale (Gray8) to JPEG into chunks obtained from alloc
+// Returns: total bytes written, or 0 if the allocator ran out of memory
+ulong EncodeGray8Chunked(const byte* grayData, int width, int height, int quality,
+    jpeg_chunk_alloc alloc, void* ctx, JpegSegment* segments, int maxSegments, int* segmentCount) {
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    chunked_destination_mgr dest;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+
+    jpeg_chunked_dest(&cinfo, &dest, alloc, ctx, segments, maxSegments);
+
+    CompressGray8(&cinfo, grayData, width, height, quality);
+
+    jpeg_destroy_compress(&cinfo);
+
+    if (segmentCount != nullptr) *segmentCount = dest.segment_count;
+    return dest.failed ? 0 : dest.data_size;
+}
+
+// Reusable Gray8 encoder: the compress object and its tables are set up once and kept across
+// frames, so steady-state encodes skip jpeg_create_compress / jpeg_set_defaults.
+// Quant tables are rebuilt only when the quality changes.
+class GrayEncoder {
+public:
+    struct jpeg_compress_struct cinfo;
+    jump_error_mgr jerr;    // Armed by Encode / EncodeChunked; a failed encode returns 0
+    memory_destination_mgr* mem_dest;
+    chunked_destination_mgr chunk_dest;
+    int quality;
+    CodecCounters stats;
+    PoolMeter meter;
+
+    explicit GrayEncoder(int quality) : quality(quality)
+    {
+        cinfo.err = jump_error(&jerr);
+        jpeg_create_compress(&cinfo);
+        pool_meter_install((j_common_ptr)&cinfo, &meter, &stats);
+        cinfo.input_components = 1;
+        cinfo.in_color_space = JCS_GRAYSCALE;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+        mem_dest = jpeg_memory_dest(&cinfo, nullptr, 0);
+    }
+    ulong Encode(const byte* grayData, int width, int height, int quality, byte* output, ulong outputSize)
+    {
+        CodecCall call(stats, (ulong)width * height);
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_compress(&cinfo); return 0; }
+        cinfo.dest = &mem_dest->pub;
+        jpeg_memory_dest(&cinfo, output, outputSize);
+        Compress(grayData, width, height, quality);
+        return call.Done(jerr.failed ? 0 : mem_dest->data_size);
+    }
+    ulong EncodeChunked(const byte* grayData, int width, int height, int quality,
+        jpeg_chunk_alloc alloc, void* ctx, JpegSegment* segments, int maxSegments, int* segmentCount)
+    {
+        CodecCall call(stats, (ulong)width * height);
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { jpeg_abort_compress(&cinfo); return 0; }
+        jpeg_chunked_dest(&cinfo, &chunk_dest, alloc, ctx, segments, maxSegments);
+        Compress(grayData, width, height, quality);
+        if (segmentCount != nullptr) *segmentCount = chunk_dest.segment_count;
+        return call.Done(chunk_dest.failed || jerr.failed ? 0 : chunk_dest.data_size);
+    }
+    ~GrayEncoder()
+    {
+        jpeg_destroy_compress(&cinfo);
+    }
+
+private:
+    void Compress(const byte* grayData, int width, int height, int quality)
+    {
+        if (quality != this->quality) {
+            jpeg_set_quality(&cinfo, quality, TRUE);
+            this->quality = quality;
+        }
+        cinfo.image_width = width;
+        cinfo.image_height = height;
+
+        jpeg_start_compress(&cinfo, TRUE);
+        stats.MarkHeader();
+
+        JSAMPROW rows[16];
+        while (cinfo.next_scanline < cinfo.image_height) {
+            int count = std::min(16, (int)(cinfo.image_height - cinfo.next_scanline));
+            for (int i = 0; i < count; i++)
+                rows[i] = (JSAMPROW)&grayData[(size_t)(cinfo.next_scanline + i) * width];
+            jpeg_write_scanlines(&cinfo, rows, count);
+        }
+
+        jpeg_finish_compress(&cinfo);
+    }
+};
+
+// Lossless DCT-domain transforms, numbered like TurboJPEG's TJXOP_*
+#define TRANSFORM_NONE 0
+#define TRANSFORM_FLIP_H 1
+#define TRANSFORM_FLIP_V 2
+#define TRANSFORM_TRANSPOSE 3       // Mirror across the main diagonal
+#define TRANSFORM_TRANSVERSE 4      // Mirror across the anti-diagonal
+#define TRANSFORM_ROT90 5           // Clockwise
+#define TRANSFORM_ROT180 6
+#define TRANSFORM_ROT270 7
+
+#define TRANSFORM_STRIP_MARKERS 1   // Drop APPn and COM segments; libjpeg still writes its own JFIF header
+
+// Destination over a caller buffer that never suspends: once the buffer is full the rest of the
+// stream goes to a scratch block and is dropped, and the result reports the overflow
+typedef struct {
+    struct jpeg_destination_mgr pub;
+    byte* buffer;
+    ulong buffer_size;
+    ulong data_size;
+    bool overflow;
+    JOCTET spill[4096];
+} bounded_destination_mgr;
+
+static void bounded_init_destination(j_compress_ptr cinfo) {
+    bounded_destination_mgr* dest = (bounded_destination_mgr*)cinfo->dest;
+    dest->pub.next_output_byte = dest->buffer;
+    dest->pub.free_in_buffer = dest->buffer_size;
+    dest->data_size = 0;
+    dest->overflow = false;
+}
+
+static boolean bounded_empty_output_buffer(j_compress_ptr cinfo) {
+    bounded_destination_mgr* dest = (bounded_destination_mgr*)cinfo->dest;
+    dest->overflow = true;
+    dest->pub.next_output_byte = dest->spill;
+    dest->pub.free_in_buffer = sizeof(dest->spill);
+    return TRUE;
+}
+
+static void bounded_term_destination(j_compress_ptr cinfo) {
+    bounded_destination_mgr* dest = (bounded_destination_mgr*)cinfo->dest;
+    if (!dest->overflow) dest->data_size = dest->buffer_size - dest->pub.free_in_buffer;
+}
+
+// Lossless transcoder: jpeg_read_coefficients -> coefficient blocks moved, mirrored and transposed ->
+// jpeg_write_coefficients. Nothing goes through the IDCT, so rotating, mirroring and cropping cost an
+// entropy decode and encode and lose nothing. Like jpegtran -trim, partial MCUs on an edge that a
+// mirror would move inside the image are dropped (unless no whole MCU is left on that axis, in which
+// case the blocks stay where they are), and crop offsets snap down to the output MCU grid.
+// Transposing operations swap the sampling factors (4:2:2 comes out as 4:4:0).
+class JpegTransformer {
+public:
+    struct jpeg_decompress_struct src;
+    struct jpeg_compress_struct dst;
+    jump_error_mgr jerr;  // Shared by src and dst: a failure in either aborts both
+    bounded_destination_mgr dest;
+    CodecCounters stats;
+    PoolMeter src_meter;
+    PoolMeter dst_meter;
+
+    JpegTransformer()
+    {
+        src.err = jump_error(&jerr);
+        jpeg_create_decompress(&src);
+        pool_meter_install((j_common_ptr)&src, &src_meter, &stats);
+        dst.err = &jerr.pub;
+        jpeg_create_compress(&dst);
+        pool_meter_install((j_common_ptr)&dst, &dst_meter, &stats);
+
+        dest.pub.init_destination = bounded_init_destination;
+        dest.pub.empty_output_buffer = bounded_empty_output_buffer;
+        dest.pub.term_destination = bounded_term_destination;
+    }
+    ~JpegTransformer()
+    {
+        jpeg_destroy_compress(&dst);
+        jpeg_destroy_decompress(&src);
+    }
+
+    // op: TRANSFORM_*. The crop is in output (transformed) pixels; a width or height of 0 runs to the edge.
+    // quality 1-100 requantizes to the standard tables at that quality, never finer than the source's;
+    // 0 keeps the source tables. Huffman tables are always optimized and progressive sources stay progressive.
+    // Restart intervals that cover whole MCU rows stay whole MCU rows.
+    // Returns the bytes written, 0 on error or when output is too small.
+    ulong Transform(const byte* jpegData, ulong jpegSize, int op, int cropX, int cropY, int cropWidth, int cropHeight,
+        int quality, int flags, byte* output, ulong outputSize, DecodeInfo* info)
+    {
+        CodecCall call(stats, jpegSize);
+        if (op < TRANSFORM_NONE || op > TRANSFORM_ROT270 || quality < 0 || quality > 100 || cropX < 0 || cropY < 0)
+            return 0;
+
+        jerr.failed = false;
+        if (JPEG_CATCH(jerr)) { Abort(); return 0; }
+        jpeg_memory_src(&src, jpegData, jpegSize);
+        unsigned int markerLimit = (flags & TRANSFORM_STRIP_MARKERS) ? 0 : 0xFFFF;
+        jpeg_save_markers(&src, JPEG_COM, markerLimit);
+        for (int m = 0; m < 16; m++) jpeg_save_markers(&src, JPEG_APP0 + m, markerLimit);
+        if (jpeg_read_header(&src, TRUE) != JPEG_HEADER_OK || jerr.failed) {
+            Abort();
+            return 0;
+        }
+        stats.MarkHeader();
+
+        // Output block (x, y) reads source block (y, x) when transposed, then mirrors the source axes
+        bool transpose = op == TRANSFORM_TRANSPOSE || op == TRANSFORM_TRANSVERSE || op == TRANSFORM_ROT90 || op == TRANSFORM_ROT270;
+        bool mirrorX = op == TRANSFORM_FLIP_H || op == TRANSFORM_TRANSVERSE || op == TRANSFORM_ROT180 || op == TRANSFORM_ROT270;
+        bool mirrorY = op == TRANSFORM_FLIP_V || op == TRANSFORM_TRANSVERSE || op == TRANSFORM_ROT90 || op == TRANSFORM_ROT180;
+
+        int mcuWidth = src.max_h_samp_factor * DCTSIZE, mcuHeight = src.max_v_samp_factor * DCTSIZE;
+        int srcWidth = (int)src.image_width, srcHeight = (int)src.image_height;
+        if (mirrorX && srcWidth >= mcuWidth) srcWidth -= srcWidth % mcuWidth;
+        if (mirrorY && srcHeight >= mcuHeight) srcHeight -= srcHeight % mcuHeight;
+        int fullWidth = transpose ? srcHeight : srcWidth, fullHeight = transpose ? srcWidth : srcHeight;
+        int outMcuWidth = transpose ? mcuHeight : mcuWidth, outMcuHeight = transpose ? mcuWidth : mcuHeight;
+        int x0 = cropX - cropX % outMcuWidth, y0 = cropY - cropY % outMcuHeight;
+        if (x0 >= fullWidth || y0 >= fullHeight) {
+            jpeg_abort_decompress(&src);
+            return 0;
+        }
+        int width = cropWidth > 0 ? std::min(cropWidth + cropX - x0, fullWidth - x0) : fullWidth - x0;
+        int height = cropHeight > 0 ? std::min(cropHeight + cropY - y0, fullHeight - y0) : fullHeight - y0;
+
+        // No block moves: the compressor reads the source arrays as they are, cut off at the new size
+        bool copy = op != TRANSFORM_NONE || x0 != 0 || y0 != 0 || quality > 0;
+        jvirt_barray_ptr outCoefs[MAX_COMPONENTS];
+        if (copy) {
+            // Requested before jpeg_read_coefficients realizes the image pool
+            int outMaxH = transpose ? src.max_v_samp_factor : src.max_h_samp_factor;
+            int outMaxV = transpose ? src.max_h_samp_factor : src.max_v_samp_factor;
+            for (int ci = 0; ci < src.num_components; ci++) {
+                const jpeg_component_info* comp = &src.comp_info[ci];
+                int h = transpose ? comp->v_samp_factor : comp->h_samp_factor;
+                int v = transpose ? comp->h_samp_factor : comp->v_samp_factor;
+                out_cols[ci] = RoundUp(CeilDiv(width * h, outMaxH * DCTSIZE), h);
+                out_rows[ci] = RoundUp(CeilDiv(height * v, outMaxV * DCTSIZE), v);
+                outCoefs[ci] = (*src.mem->request_virt_barray)((j_common_ptr)&src, JPOOL_IMAGE, TRUE,
+                    out_cols[ci], out_rows[ci], v);
+            }
+        }
+
+        jvirt_barray_ptr* srcCoefs = jpeg_read_coefficients(&src);
+        if (srcCoefs == nullptr || jerr.failed) {
+            Abort();
+            return 0;
+        }
+
+        jpeg_copy_critical_parameters(&src, &dst);
+        dst.image_width = width;
+        dst.image_height = height;
+        dst.optimize_coding = TRUE;
+        if (src.progressive_mode) jpeg_simple_progression(&dst);
+        if (src.restart_interval > 0) {
+            // Stripe decode splits at restarts on MCU-row boundaries; keep them there in the new geometry
+            unsigned int mcusPerRow = (src.image_width + mcuWidth - 1) / mcuWidth;
+            if (src.restart_interval % mcusPerRow == 0) dst.restart_in_rows = (int)(src.restart_interval / mcusPerRow);
+            else dst.restart_interval = src.restart_interval;
+        }
+
+        // Source tables at output coefficient positions
+        UINT16 srcQuant[NUM_QUANT_TBLS][DCTSIZE2] = {};
+        for (int n = 0; n < NUM_QUANT_TBLS; n++) {
+            JQUANT_TBL* table = dst.quant_tbl_ptrs[n];
+            if (table == nullptr) continue;
+            for (int k = 0; k < DCTSIZE2; k++)
+                srcQuant[n][k] = table->quantval[transpose ? (k % DCTSIZE) * DCTSIZE + k / DCTSIZE : k];
+            memcpy(table->quantval, srcQuant[n], sizeof(srcQuant[n]));
+        }
+        if (quality > 0) {
+            jpeg_set_quality(&dst, quality, TRUE);
+            for (int n = 0; n < NUM_QUANT_TBLS; n++) {
+                JQUANT_TBL* table = dst.quant_tbl_ptrs[n];
+                if (table == nullptr) continue;
+                for (int k = 0; k < DCTSIZE2; k++) table->quantval[k] = std::max(table->quantval[k], srcQuant[n][k]);
+            }
+        }
+        if (transpose) {
+            for (int ci = 0; ci < dst.num_components; ci++)
+                std::swap(dst.comp_info[ci].h_samp_factor, dst.comp_info[ci].v_samp_factor);
+        }
+
+        if (copy) {
+            for (int ci = 0; ci < src.num_components; ci++) {
+                const jpeg_component_info* comp = &src.comp_info[ci];
+                int q = dst.comp_info[ci].quant_tbl_no;
+                CopyComponent(ci, srcCoefs[ci], outCoefs[ci], transpose, mirrorX, mirrorY,
+                    srcWidth / mcuWidth * comp->h_samp_factor, srcHeight / mcuHeight * comp->v_samp_factor,
+                    x0 / outMcuWidth * dst.comp_info[ci].h_samp_factor, y0 / outMcuHeight * dst.comp_info[ci].v_samp_factor,
+                    srcQuant[q], quality > 0 ? dst.quant_tbl_ptrs[q]->quantval : nullptr);
+            }
+        }
+
+        dest.buffer = output;
+        dest.buffer_size = outputSize;
+        dst.dest = &dest.pub;
+        jpeg_write_coefficients(&dst, copy ? outCoefs : srcCoefs);
+        for (jpeg_saved_marker_ptr m = src.marker_list; m != nullptr; m = m->next) {
+            // libjpeg writes these itself from the new parameters
+            if (dst.write_JFIF_header && m->marker == JPEG_APP0 && m->data_length >= 5 && memcmp(m->data, "JFIF", 5) == 0)
+                continue;
+            if (dst.write_Adobe_marker && m->marker == JPEG_APP0 + 14 && m->data_length >= 5 && memcmp(m->data, "Adobe", 5) == 0)
+                continue;
+            jpeg_write_marker(&dst, m->marker, m->data, m->data_length);
+        }
+        jpeg_finish_compress(&dst);
+        jpeg_finish_decompress(&src);
+
+        if (dest.overflow || jerr.failed) {
+            Abort();
+            return 0;
+        }
+        if (info) {
+            info->width = width;
+            info->height = height;
+            info->components = dst.num_components;
+            info->colorSpace = dst.jpeg_color_space;
+            info->stride = 0;
+            info->layout = sampling_layout(dst.comp_info, dst.num_components);
+        }
+        return call.Done(dest.data_size);
+    }
+
+private:
+    JDIMENSION out_cols[MAX_COMPONENTS];
+    JDIMENSION out_rows[MAX_COMPONENTS];
+
+    static JDIMENSION CeilDiv(long a, long b) { return (JDIMENSION)((a + b - 1) / b); }
+    static JDIMENSION RoundUp(JDIMENSION a, int b) { return (a + b - 1) / b * b; }
+
+    void Abort()
+    {
+        jpeg_abort_compress(&dst);
+        jpeg_abort_decompress(&src);
     }
 
-    jpeg_finish_decompress(&cinfo);
-    jpeg_destroy_decompress(&cinfo);
+    // keptCols/keptRows: source blocks in whole MCUs of the trimmed image. A mirrored axis reverses them;
+    // blocks past them (a partial MCU that could not be trimmed) are copied in place.
+    // offsetX/offsetY: crop offset in output blocks. newQuant null keeps the coefficients' quantization.
+    void CopyComponent(int ci, jvirt_barray_ptr from, jvirt_barray_ptr to, bool transpose, bool mirrorX, bool mirrorY,
+        int keptCols, int keptRows, int offsetX, int offsetY, const UINT16* srcQuant, const UINT16* newQuant)
+    {
+        const jpeg_component_info* comp = &src.comp_info[ci];
+        int srcCols = (int)RoundUp(comp->width_in_blocks, comp->h_samp_factor);
+        int srcRows = (int)RoundUp(comp->height_in_blocks, comp->v_samp_factor);
+
+        // Per output coefficient: where it comes from and whether a mirror flips its sign
+        // (odd horizontal frequencies flip under a horizontal mirror, odd vertical ones under a vertical one)
+        int index[DCTSIZE2];
+        bool oddX[DCTSIZE2], oddY[DCTSIZE2];
+        for (int v = 0; v < DCTSIZE; v++) {
+            for (int u = 0; u < DCTSIZE; u++) {
+                int sv = transpose ? u : v, su = transpose ? v : u;
+                index[v * DCTSIZE + u] = sv * DCTSIZE + su;
+                oddX[v * DCTSIZE + u] = su & 1;
+                oddY[v * DCTSIZE + u] = sv & 1;
+            }
+        }
 
-    return totalSize;
-}
+        for (JDIMENSION by = 0; by < out_rows[ci]; by++) {
+            JBLOCKROW outRow = (*src.mem->access_virt_barray)((j_common_ptr)&src, to, by, 1, TRUE)[0];
+            JBLOCKROW srcRow = nullptr;
+            int cachedRow = -1;
+            for (JDIMENSION bx = 0; bx < out_cols[ci]; bx++) {
+                int tx = (int)bx + offsetX, ty = (int)by + offsetY;
+                int sx = transpose ? ty : tx, sy = transpose ? tx : ty;
+                bool flipX = mirrorX && sx < keptCols, flipY = mirrorY && sy < keptRows;
+                if (flipX) sx = keptCols - 1 - sx;
+                if (flipY) sy = keptRows - 1 - sy;
+                if (sx < 0 || sx >= srcCols || sy < 0 || sy >= srcRows) continue;  // Stays zero (pre-zeroed)
+
+                if (sy != cachedRow) {
+                    srcRow = (*src.mem->access_virt_barray)((j_common_ptr)&src, from, sy, 1, FALSE)[0];
+                    cachedRow = sy;
+                }
+                const JCOEF* in = srcRow[sx];
+                JCOEF* out = outRow[bx];
+                for (int k = 0; k < DCTSIZE2; k++) {
+                    int c = (flipX && oddX[k]) != (flipY && oddY[k]) ? -in[index[k]] : in[index[k]];
+                    if (newQuant && newQuant[k] != srcQuant[k]) {
+                        // Round half away from zero to the coarser step
+                        long scaled = (long)c * srcQuant[k];
+                        long half = newQuant[k] / 2;
+                        c = (int)(scaled >= 0 ? (scaled + half) / newQuant[k] : -((half - scaled) / newQuant[k]));
+                    }
+                    out[k] = (JCOEF)c;
+                }
+            }
+        }
+    }
+};
 
-// Decode JPEG to I420 (YUV 4:2:0 planar) for HDR blending with color
-// Returns: bytes written to output, or 0 on error
-// Output format: Y plane (width*height), U plane (width*height/4), V plane (width*height/4)
-ulong DecodeToI420(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info) {
-    struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
+#ifdef LIBJPEGWRAP_WITH_V4L2
+// ---------------------------------------------------------------------------------------------------
+// V4L2 memory-to-memory hardware JPEG decode (Jetson nvv4l2, Rockchip, i.MX8 mxc-jpeg and other
+// multi-planar M2M drivers). One open file descriptor is one decode context, so pooled handles decode
+// concurrently. Frames the engine cannot take fail with 0 and the caller decodes them with libjpeg.
 
-    cinfo.err = jpeg_std_error(&jerr);
-    jpeg_create_decompress(&cinfo);
+#define V4L2_DECODE_TIMEOUT_MS 1000
 
-    jpeg_memory_src(&cinfo, jpegData, jpegSize);
+static int v4l2_xioctl(int fd, unsigned long request, void* arg)
+{
+    int r;
+    do r = ioctl(fd, request, arg); while (r < 0 && errno == EINTR);
+    return r;
+}
 
-    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
-        jpeg_destroy_decompress(&cinfo);
-        return 0;
+// JPEG pixel format of a multi-planar M2M device's OUTPUT (bitstream) queue, 0 when it has none
+static unsigned int v4l2_jpeg_format(int fd)
+{
+    v4l2_capability cap = {};
+    if (v4l2_xioctl(fd, VIDIOC_QUERYCAP, &cap) < 0) return 0;
+    unsigned int caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_M2M_MPLANE) || !(caps & V4L2_CAP_STREAMING)) return 0;
+
+    v4l2_fmtdesc desc = {};
+    desc.type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    for (desc.index = 0; v4l2_xioctl(fd, VIDIOC_ENUM_FMT, &desc) == 0; desc.index++) {
+        if (desc.pixelformat == V4L2_PIX_FMT_JPEG || desc.pixelformat == V4L2_PIX_FMT_MJPEG) return desc.pixelformat;
     }
+    return 0;
+}
 
-    // Request raw YUV output (planar, subsampled)
-    cinfo.raw_data_out = TRUE;
-    cinfo.out_color_space = JCS_YCbCr;
+// First /dev/videoN that decodes JPEG; false when there is none
+static bool v4l2_find_jpeg_decoder(char* path, int pathSize)
+{
+    for (int n = 0; n < 64; n++) {
+        char candidate[32];
+        snprintf(candidate, sizeof(candidate), "/dev/video%d", n);
+        int fd = open(candidate, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) continue;
+        bool found = v4l2_jpeg_format(fd) != 0;
+        close(fd);
+        if (found && (int)strlen(candidate) < pathSize) {
+            strcpy(path, candidate);
+            return true;
+        }
+    }
+    return false;
+}
 
-    jpeg_start_decompress(&cinfo);
+class V4l2Decoder {
+public:
+    CodecCounters stats;
 
-    int width = cinfo.output_width;
-    int height = cinfo.output_height;
+    V4l2Decoder(const char* device, int maxWidth, int maxHeight)
+        : max_width(maxWidth), max_height(maxHeight)
+    {
+        probe.err = jump_error(&probe_err);
+        jpeg_create_decompress(&probe);
 
-    info->width = width;
-    info->height = height;
-    info->components = 3;
-    info->colorSpace = cinfo.out_color_space;
+        char found[32];
+        if (device == nullptr || *device == 0) {
+            if (!v4l2_find_jpeg_decoder(found, sizeof(found))) return;
+            device = found;
+        }
+        fd = open(device, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) return;
+        jpeg_format = v4l2_jpeg_format(fd);
+        if (jpeg_format == 0) {
+            close(fd);
+            fd = -1;
+            return;
+        }
 
-    // I420 size: Y (width*height) + U (width*height/4) + V (width*height/4)
-    ulong sizeY = width * height;
-    ulong sizeU = sizeY / 4;
-    ulong sizeV = sizeU;
-    ulong totalSize = sizeY + sizeU + sizeV;
+        // Stateful drivers announce the decoded geometry (alignment, padding) with this event
+        v4l2_event_subscription sub = {};
+        sub.type = V4L2_EVENT_SOURCE_CHANGE;
+        v4l2_xioctl(fd, VIDIOC_SUBSCRIBE_EVENT, &sub);
+    }
 
-    if (totalSize > outputSize) {
-        jpeg_abort_decompress(&cinfo);
-        jpeg_destroy_decompress(&cinfo);
-        return 0;
+    ~V4l2Decoder()
+    {
+        Stop();
+        if (fd >= 0) close(fd);
+        jpeg_destroy_decompress(&probe);
     }
 
-    byte* Y = output;
-    byte* U = output + sizeY;
-    byte* V = output + sizeY + sizeU;
+    // False when no JPEG-capable M2M device could be opened
+    bool IsValid() const { return fd >= 0; }
 
-    // Read raw data in MCU rows (typically 16 lines for Y, 8 for U/V with 4:2:0)
-    JSAMPROW y_rows[16];
-    JSAMPROW u_rows[8];
-    JSAMPROW v_rows[8];
-    JSAMPARRAY planes[3] = { y_rows, u_rows, v_rows };
+    // format: DECODE_FORMAT_I420 or DECODE_FORMAT_GRAY, tightly packed as the libjpeg decoder writes them.
+    // Only baseline 8-bit 4:2:0 JPEGs, and grayscale ones decoded to Gray8, are sent to the engine. Every other
+    // frame, and any the driver rejects or does not finish within V4L2_DECODE_TIMEOUT_MS, returns 0.
+    ulong Decode(const byte* jpegData, ulong jpegSize, int format, byte* output, ulong outputSize, DecodeInfo* info)
+    {
+        CodecCall call(stats, jpegSize);
+        if (fd < 0 || (format != DECODE_FORMAT_I420 && format != DECODE_FORMAT_GRAY)) return 0;
+
+        probe_err.failed = false;
+        if (JPEG_CATCH(probe_err)) { jpeg_abort_decompress(&probe); return 0; }
+        jpeg_memory_src(&probe, jpegData, jpegSize);
+        if (jpeg_read_header(&probe, TRUE) != JPEG_HEADER_OK || probe_err.failed) {
+            jpeg_abort_decompress(&probe);
+            return 0;
+        }
+        int width = probe.image_width, height = probe.image_height;
+        bool gray = probe.num_components == 1;
+        bool supported = !probe.progressive_mode && probe.data_precision == 8 &&
+            (gray ? format == DECODE_FORMAT_GRAY :
+                probe.jpeg_color_space == JCS_YCbCr && sampling_layout(probe.comp_info, probe.num_components) == YUV_LAYOUT_I420);
+        jpeg_abort_decompress(&probe);
+        stats.MarkHeader();
+
+        ulong size = format == DECODE_FORMAT_GRAY ? (ulong)width * height : yuv_frame_size(YUV_LAYOUT_I420, width, height);
+        if (!supported || width > max_width || height > max_height || size > outputSize) return 0;
+        if ((width != configured_width || height != configured_height) && !Configure(width, height)) return 0;
+        if (jpegSize > bitstream.length[0]) return 0;
+
+        memcpy(bitstream.data[0], jpegData, jpegSize);
+        v4l2_plane inPlane = {};
+        inPlane.bytesused = (unsigned int)jpegSize;
+        inPlane.length = (unsigned int)bitstream.length[0];
+        if (!Queue(V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE, &inPlane, 1) || !QueueCapture()) {
+            Stop();
+            return 0;
+        }
 
-    int y_stride = width;
-    int uv_stride = width / 2;
+        v4l2_plane outPlanes[VIDEO_MAX_PLANES] = {};
+        v4l2_buffer done = {};
+        if (!WaitCapture(outPlanes, &done)) {
+            Stop();  // STREAMOFF takes both buffers back from the driver
+            return 0;
+        }
+        v4l2_plane reclaimed = {};
+        if (!Dequeue(V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE, &reclaimed, 1, nullptr)) {
+            Stop();
+            return 0;
+        }
+        if (done.flags & V4L2_BUF_FLAG_ERROR) return 0;
 
-    while (cinfo.output_scanline < cinfo.output_height) {
-        int lines_to_read = cinfo.output_height - cinfo.output_scanline;
-        if (lines_to_read > 16) lines_to_read = 16;
+        CopyOut(outPlanes, width, height, format, output);
+        info->width = width;
+        info->height = height;
+        info->components = format == DECODE_FORMAT_GRAY ? 1 : 3;
+        info->colorSpace = format == DECODE_FORMAT_GRAY ? JCS_GRAYSCALE : JCS_YCbCr;
+        info->stride = width;
+        info->layout = format == DECODE_FORMAT_GRAY ? -1 : YUV_LAYOUT_I420;
+        return call.Done(size);
+    }
 
-        for (int i = 0; i < 16; i++) {
-            int y_line = cinfo.output_scanline + i;
-            if (y_line < height) {
-                y_rows[i] = Y + y_line * y_stride;
-            } else {
-                y_rows[i] = Y + (height - 1) * y_stride; // Pad with last line
-            }
+private:
+    struct Mapping {
+        void* data[VIDEO_MAX_PLANES];
+        size_t length[VIDEO_MAX_PLANES];
+        int planes;
+    };
 
-            if (i < 8) {
-                int uv_line = (cinfo.output_scanline / 2) + i;
-                if (uv_line < height / 2) {
-                    u_rows[i] = U + uv_line * uv_stride;
-                    v_rows[i] = V + uv_line * uv_stride;
-                } else {
-                    u_rows[i] = U + (height / 2 - 1) * uv_stride;
-                    v_rows[i] = V + (height / 2 - 1) * uv_stride;
-                }
-            }
+    int fd = -1;
+    int max_width;
+    int max_height;
+    unsigned int jpeg_format = 0;   // V4L2_PIX_FMT_JPEG or _MJPEG, as the OUTPUT queue lists it
+    int configured_width = 0;       // Geometry the queues stream at, 0 when stopped
+    int configured_height = 0;
+    Mapping bitstream = {};         // OUTPUT queue buffer (JPEG in)
+    Mapping picture = {};           // CAPTURE queue buffer (YUV out)
+    v4l2_format capture = {};       // Negotiated CAPTURE format: strides and padded height
+    struct jpeg_decompress_struct probe;
+    jump_error_mgr probe_err;       // Corrupt headers are rejected (0), so the pool falls back to the CPU
+
+    bool Configure(int width, int height)
+    {
+        Stop();
+
+        v4l2_format fmt = {};
+        fmt.type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+        fmt.fmt.pix_mp.width = width;
+        fmt.fmt.pix_mp.height = height;
+        fmt.fmt.pix_mp.pixelformat = jpeg_format;
+        fmt.fmt.pix_mp.num_planes = 1;
+        // Room for any frame of the size the pool is configured for, not just this one
+        fmt.fmt.pix_mp.plane_fmt[0].sizeimage = (unsigned int)yuv_frame_size(YUV_LAYOUT_I420, max_width, max_height);
+        if (v4l2_xioctl(fd, VIDIOC_S_FMT, &fmt) < 0) return false;
+        if (!SetCaptureFormat(width, height)) return false;
+
+        if (!Allocate(V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE, &bitstream) ||
+            !Allocate(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE, &picture) ||
+            !StreamOn(V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE) || !StreamOn(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)) {
+            Stop();
+            return false;
         }
+        configured_width = width;
+        configured_height = height;
+        return true;
+    }
 
-        jpeg_read_raw_data(&cinfo, planes, 16);
+    // Planar or semi-planar 4:2:0, whichever the driver offers first
+    bool SetCaptureFormat(int width, int height)
+    {
+        static const unsigned int formats[] = { V4L2_PIX_FMT_YUV420M, V4L2_PIX_FMT_YUV420, V4L2_PIX_FMT_NV12M, V4L2_PIX_FMT_NV12 };
+        for (unsigned int pixelformat : formats) {
+            capture = {};
+            capture.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+            capture.fmt.pix_mp.width = width;
+            capture.fmt.pix_mp.height = height;
+            capture.fmt.pix_mp.pixelformat = pixelformat;
+            if (v4l2_xioctl(fd, VIDIOC_S_FMT, &capture) == 0 && CaptureUsable(width, height)) return true;
+        }
+        return false;
     }
 
-    jpeg_finish_decompress(&cinfo);
-    jpeg_destroy_decompress(&cinfo);
+    bool CaptureUsable(int width, int height) const
+    {
+        const v4l2_pix_format_mplane& pix = capture.fmt.pix_mp;
+        int expected = pix.pixelformat == V4L2_PIX_FMT_YUV420M ? 3 : pix.pixelformat == V4L2_PIX_FMT_NV12M ? 2 :
+            pix.pixelformat == V4L2_PIX_FMT_YUV420 || pix.pixelformat == V4L2_PIX_FMT_NV12 ? 1 : 0;
+        return expected != 0 && pix.num_planes == expected && (int)pix.width >= width && (int)pix.height >= height &&
+            (int)pix.plane_fmt[0].bytesperline >= width;
+    }
 
-    return totalSize;
-}
+    bool Allocate(unsigned int type, Mapping* mapping)
+    {
+        v4l2_requestbuffers req = {};
+        req.count = 1;
+        req.type = type;
+        req.memory = V4L2_MEMORY_MMAP;
+        if (v4l2_xioctl(fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 1) return false;
+
+        v4l2_plane planes[VIDEO_MAX_PLANES] = {};
+        v4l2_buffer buf = {};
+        buf.type = type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = 0;
+        buf.m.planes = planes;
+        buf.length = VIDEO_MAX_PLANES;
+        if (v4l2_xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) return false;
+
+        for (unsigned int p = 0; p < buf.length; p++) {
+            void* data = mmap(nullptr, planes[p].length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, planes[p].m.mem_offset);
+            if (data == MAP_FAILED) return false;
+            mapping->data[p] = data;
+            mapping->length[p] = planes[p].length;
+            mapping->planes = p + 1;
+        }
+        return true;
+    }
 
-// Encode grayscale (Gray8) to JPEG
-// Returns: bytes written to output, or 0 on error
-ulong EncodeGray8(const byte* grayData, int width, int height, int quality, byte* output, ulong outputSize) {
-    struct jpeg_compress_struct cinfo;
-    struct jpeg_error_mgr jerr;
+    void Release(unsigned int type, Mapping* mapping)
+    {
+        for (int p = 0; p < mapping->planes; p++) munmap(mapping->data[p], mapping->length[p]);
+        *mapping = {};
+        v4l2_requestbuffers req = {};
+        req.type = type;
+        req.memory = V4L2_MEMORY_MMAP;
+        v4l2_xioctl(fd, VIDIOC_REQBUFS, &req);
+    }
 
-    cinfo.err = jpeg_std_error(&jerr);
-    jpeg_create_compress(&cinfo);
+    bool StreamOn(unsigned int type)
+    {
+        int t = (int)type;
+        return v4l2_xioctl(fd, VIDIOC_STREAMON, &t) == 0;
+    }
 
-    // Set up memory destination
-    memory_destination_mgr* dest = jpeg_memory_dest(&cinfo, output, outputSize);
+    void StreamOff(unsigned int type)
+    {
+        int t = (int)type;
+        v4l2_xioctl(fd, VIDIOC_STREAMOFF, &t);
+    }
 
-    cinfo.image_width = width;
-    cinfo.image_height = height;
-    cinfo.input_components = 1;
-    cinfo.in_color_space = JCS_GRAYSCALE;
+    void Stop()
+    {
+        if (fd < 0) return;
+        StreamOff(V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE);
+        StreamOff(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE);
+        Release(V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE, &bitstream);
+        Release(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE, &picture);
+        configured_width = configured_height = 0;
+    }
 
-    jpeg_set_defaults(&cinfo);
-    jpeg_set_quality(&cinfo, quality, TRUE);
+    bool Queue(unsigned int type, v4l2_plane* planes, int count)
+    {
+        v4l2_buffer buf = {};
+        buf.type = type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = 0;
+        buf.m.planes = planes;
+        buf.length = count;
+        return v4l2_xioctl(fd, VIDIOC_QBUF, &buf) == 0;
+    }
 
-    jpeg_start_compress(&cinfo, TRUE);
+    bool QueueCapture()
+    {
+        v4l2_plane planes[VIDEO_MAX_PLANES] = {};
+        for (int p = 0; p < picture.planes; p++) planes[p].length = (unsigned int)picture.length[p];
+        return Queue(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE, planes, picture.planes);
+    }
 
-    JSAMPROW row_pointer[1];
-    int row_stride = width;
+    bool Dequeue(unsigned int type, v4l2_plane* planes, int count, v4l2_buffer* result)
+    {
+        v4l2_buffer buf = {};
+        buf.type = type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.m.planes = planes;
+        buf.length = count;
+        if (v4l2_xioctl(fd, VIDIOC_DQBUF, &buf) < 0) return false;
+        if (result) *result = buf;
+        return true;
+    }
 
-    while (cinfo.next_scanline < cinfo.image_height) {
-        row_pointer[0] = (JSAMPROW)&grayData[cinfo.next_scanline * row_stride];
-        jpeg_write_scanlines(&cinfo, row_pointer, 1);
+    // Waits for the decoded picture. A source-change event means the driver wants CAPTURE buffers of the
+    // geometry it parsed from the header: they are reallocated and queued again, and the wait goes on.
+    bool WaitCapture(v4l2_plane* planes, v4l2_buffer* done)
+    {
+        for (int changes = 0; changes < 2;) {
+            pollfd p = { fd, POLLIN | POLLPRI, 0 };
+            if (poll(&p, 1, V4L2_DECODE_TIMEOUT_MS) <= 0) return false;
+            if (p.revents & POLLPRI) {
+                v4l2_event event = {};
+                if (v4l2_xioctl(fd, VIDIOC_DQEVENT, &event) < 0) return false;
+                if (event.type != V4L2_EVENT_SOURCE_CHANGE) continue;
+                changes++;
+                if (!ReallocateCapture()) return false;
+                continue;
+            }
+            if (p.revents & POLLIN) return Dequeue(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE, planes, picture.planes, done);
+            return false;
+        }
+        return false;
     }
 
-    jpeg_finish_compress(&cinfo);
+    bool ReallocateCapture()
+    {
+        StreamOff(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE);
+        Release(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE, &picture);
+        capture = {};
+        capture.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+        if (v4l2_xioctl(fd, VIDIOC_G_FMT, &capture) < 0 || !CaptureUsable(configured_width, configured_height)) return false;
+        return Allocate(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE, &picture) &&
+            StreamOn(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) && QueueCapture();
+    }
 
-    ulong dataSize = dest->data_size;
-    jpeg_destroy_compress(&cinfo);
+    // Driver planes (padded strides, aligned height) to tightly packed I420 or Gray8
+    void CopyOut(const v4l2_plane* planes, int width, int height, int format, byte* output) const
+    {
+        const v4l2_pix_format_mplane& pix = capture.fmt.pix_mp;
+        int stride = pix.plane_fmt[0].bytesperline;
+        const byte* y = (const byte*)picture.data[0] + planes[0].data_offset;
+        for (int row = 0; row < height; row++) memcpy(output + (ulong)row * width, y + (ulong)row * stride, width);
+        if (format == DECODE_FORMAT_GRAY) return;
+
+        int cw, ch;
+        yuv_chroma_size(YUV_LAYOUT_I420, width, height, &cw, &ch);
+        byte* U = output + (ulong)width * height;
+        byte* V = U + (ulong)cw * ch;
+        bool semiPlanar = pix.pixelformat == V4L2_PIX_FMT_NV12M || pix.pixelformat == V4L2_PIX_FMT_NV12;
+        const byte* u;
+        const byte* v = nullptr;
+        int chromaStride;
+        if (pix.num_planes > 1) {
+            u = (const byte*)picture.data[1] + planes[1].data_offset;
+            chromaStride = pix.plane_fmt[1].bytesperline;
+            if (!semiPlanar) v = (const byte*)picture.data[2] + planes[2].data_offset;
+        } else {
+            // Contiguous layouts: chroma follows the padded luma plane, at half the luma stride for I420
+            u = y + (ulong)stride * pix.height;
+            chromaStride = semiPlanar ? stride : stride / 2;
+            if (!semiPlanar) v = u + (ulong)chromaStride * ((pix.height + 1) / 2);
+        }
 
-    return dataSize;
-}
+        for (int row = 0; row < ch; row++) {
+            const byte* uRow = u + (ulong)row * chromaStride;
+            if (semiPlanar) {
+                for (int x = 0; x < cw; x++) {
+                    U[(ulong)row * cw + x] = uRow[2 * x];
+                    V[(ulong)row * cw + x] = uRow[2 * x + 1];
+                }
+            } else {
+                memcpy(U + (ulong)row * cw, uRow, cw);
+                memcpy(V + (ulong)row * cw, v + (ulong)row * chromaStride, cw);
+            }
+        }
+    }
+};
+#else
+class V4l2Decoder;
+#endif
 
 // Get JPEG dimensions without full decode
 int GetJpegInfo(const byte* jpegData, ulong jpegSize, DecodeInfo* info) {
@@ -703,6 +4391,7 @@ int GetJpegInfo(const byte* jpegData, ulong jpegSize, DecodeInfo* info) {
     info->height = cinfo.image_height;
     info->components = cinfo.num_components;
     info->colorSpace = cinfo.jpeg_color_space;
+    info->layout = jpeg_native_layout(&cinfo);
 
     jpeg_destroy_decompress(&cinfo);
     return 1;
@@ -713,15 +4402,64 @@ extern "C" {
         YuvEncoder* enc = new YuvEncoder(width, height, quality, size);
 		return enc;
     }
+    // Returns nullptr when the backend is not compiled in or fails to initialize
+    EXPORT YuvEncoder* CreateWithBackend(int width, int height, int quality, ulong size, int backend) {
+        if (!IsBackendSupported(backend)) return nullptr;
+        YuvEncoder* enc = new YuvEncoder(width, height, quality, size, backend);
+        if (!enc->IsValid()) { delete enc; return nullptr; }
+        return enc;
+    }
+    EXPORT int IsBackendAvailable(int backend) {
+        return IsBackendSupported(backend) ? 1 : 0;
+    }
     EXPORT ulong Encode(YuvEncoder* encoder, byte* data, byte* dstBuffer, ulong dstBufferSize) {
         return encoder->Encode(data, dstBuffer, dstBufferSize);
     }
-    EXPORT void SetQuality(YuvEncoder* encoder, int quality) {
-        encoder->SetQuality(quality);
+    // enabled != 0: omit tables from frames. Returns 0 when the encoder's backend cannot do it.
+    EXPORT int SetAbbreviated(YuvEncoder* encoder, int enabled) {
+        return encoder->SetAbbreviated(enabled != 0) ? 1 : 0;
+    }
+    // Target bytes per frame (0 = off); flags: RATE_FEEDBACK | RATE_COMPLEXITY
+    EXPORT void SetTargetSize(YuvEncoder* encoder, ulong targetBytes, int minQuality, int maxQuality, int flags) {
+        encoder->SetTargetSize(targetBytes, minQuality, maxQuality, flags);
+    }
+    // Quality used for the last frame (the fixed quality when rate control is off)
+    EXPORT int GetQuality(YuvEncoder* encoder) {
+        return encoder->GetQuality();
+    }
+    // Tables-only datastream for decoders of abbreviated frames; at most ~600 bytes for 4:2:0
+    EXPORT ulong WriteTables(YuvEncoder* encoder, byte* dstBuffer, ulong dstBufferSize) {
+        return encoder->WriteTables(dstBuffer, dstBufferSize);
+    }
+    // I420 from separate planes with row strides (uvStride applies to both chroma planes)
+    EXPORT ulong EncodePlanes(YuvEncoder* encoder, const byte* y, int yStride, const byte* u, const byte* v, int uvStride,
+        byte* dstBuffer, ulong dstBufferSize) {
+        return encoder->EncodePlanes(y, yStride, u, v, uvStride, dstBuffer, dstBufferSize);
+    }
+    // NV12 (Y plane + interleaved CbCr plane) with row strides; chroma is split per MCU row
+    EXPORT ulong EncodeNv12(YuvEncoder* encoder, const byte* y, int yStride, const byte* uv, int uvStride,
+        byte* dstBuffer, ulong dstBufferSize) {
+        return encoder->EncodeNv12(y, yStride, uv, uvStride, dstBuffer, dstBufferSize);
+    }
+    EXPORT ulong EncodeChunked(YuvEncoder* encoder, byte* data, jpeg_chunk_alloc alloc, void* ctx,
+        JpegSegment* segments, int maxSegments, int* segmentCount) {
+        return encoder->EncodeChunked(data, alloc, ctx, segments, maxSegments, segmentCount);
+    }
+    // Returns 0 when the encoder writes abbreviated frames, whose tables are fixed
+    EXPORT int SetQuality(YuvEncoder* encoder, int quality) {
+        return encoder->SetQuality(quality) ? 1 : 0;
     }
     EXPORT void SetMode(YuvEncoder* encoder, int mode) {
         encoder->SetMode(mode);
     }
+    EXPORT void SetRestartRows(YuvEncoder* encoder, int rows) {
+        encoder->SetRestartRows(rows);
+    }
+
+    EXPORT int GetEncoderStats(YuvEncoder* encoder, CodecStats* stats) {
+        const CodecCounters* counters = &encoder->stats;
+        return codec_stats_snapshot(&counters, 1, stats);
+    }
 
     EXPORT void Close(YuvEncoder* encoder)
 	{
@@ -741,6 +4479,35 @@ extern "C" {
         return EncodeGray8(grayData, width, height, quality, output, outputSize);
     }
 
+    EXPORT ulong EncodeGray8ToJpegChunked(const byte* grayData, int width, int height, int quality,
+        jpeg_chunk_alloc alloc, void* ctx, JpegSegment* segments, int maxSegments, int* segmentCount) {
+        return EncodeGray8Chunked(grayData, width, height, quality, alloc, ctx, segments, maxSegments, segmentCount);
+    }
+
+    // Pooled Gray8 encoder; the quality argument of each call overrides the one given here
+    EXPORT GrayEncoder* CreateGrayEncoder(int quality) {
+        return new GrayEncoder(quality);
+    }
+
+    EXPORT int GetGrayEncoderStats(GrayEncoder* encoder, CodecStats* stats) {
+        const CodecCounters* counters = &encoder->stats;
+        return codec_stats_snapshot(&counters, 1, stats);
+    }
+
+    EXPORT void CloseGrayEncoder(GrayEncoder* encoder) {
+        delete encoder;
+    }
+
+    EXPORT ulong GrayEncoderEncode(GrayEncoder* encoder, const byte* grayData, int width, int height, int quality,
+        byte* output, ulong outputSize) {
+        return encoder->Encode(grayData, width, height, quality, output, outputSize);
+    }
+
+    EXPORT ulong GrayEncoderEncodeChunked(GrayEncoder* encoder, const byte* grayData, int width, int height, int quality,
+        jpeg_chunk_alloc alloc, void* ctx, JpegSegment* segments, int maxSegments, int* segmentCount) {
+        return encoder->EncodeChunked(grayData, width, height, quality, alloc, ctx, segments, maxSegments, segmentCount);
+    }
+
     EXPORT ulong DecodeJpegToI420(const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info) {
         return DecodeToI420(jpegData, jpegSize, output, outputSize, info);
     }
@@ -750,6 +4517,22 @@ extern "C" {
         return new I420Decoder(maxWidth, maxHeight);
     }
 
+    // Returns nullptr when the backend is not compiled in or fails to initialize
+    EXPORT I420Decoder* CreateDecoderWithBackend(int maxWidth, int maxHeight, int backend) {
+        if (!IsBackendSupported(backend)) return nullptr;
+        I420Decoder* decoder = new I420Decoder(maxWidth, maxHeight, backend);
+        if (!decoder->IsValid()) { delete decoder; return nullptr; }
+        return decoder;
+    }
+
+    EXPORT int DecoderLoadTables(I420Decoder* decoder, const byte* tables, ulong size) {
+        return decoder->LoadTables(tables, size) ? 1 : 0;
+    }
+
+    EXPORT int DecoderGetImageInfo(I420Decoder* decoder, const byte* jpegData, ulong jpegSize, DecodeInfo* info) {
+        return decoder->ReadInfo(jpegData, jpegSize, info);
+    }
+
     EXPORT ulong DecoderDecodeI420(I420Decoder* decoder, const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info) {
         return decoder->DecodeI420(jpegData, jpegSize, output, outputSize, info);
     }
@@ -758,15 +4541,131 @@ extern "C" {
         return decoder->DecodeGray(jpegData, jpegSize, output, outputSize, info);
     }
 
+    // Scatter-list input (e.g. pipe segments) decoded without coalescing; segments are read in order
+    EXPORT ulong DecoderDecodeI420Segments(I420Decoder* decoder, const JpegSegment* segments, int count,
+        byte* output, ulong outputSize, DecodeInfo* info) {
+        return decoder->DecodeI420Segments(segments, count, output, outputSize, info);
+    }
+
+    EXPORT ulong DecoderDecodeGraySegments(I420Decoder* decoder, const JpegSegment* segments, int count,
+        byte* output, ulong outputSize, DecodeInfo* info) {
+        return decoder->DecodeGraySegments(segments, count, output, outputSize, info);
+    }
+
+    // scaleDenom: 1, 2, 4 or 8 - DCT-domain downscale, info reports the scaled size
+    EXPORT ulong DecoderDecodeI420Scaled(I420Decoder* decoder, const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info, int scaleDenom) {
+        return decoder->DecodeI420(jpegData, jpegSize, output, outputSize, info, scaleDenom);
+    }
+
+    // layout: YUV_LAYOUT_I420 / I422 / I444, or NATIVE for the JPEG's own sampling; info->layout reports it
+    EXPORT ulong DecoderDecodeYuv(I420Decoder* decoder, const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info, int layout, int scaleDenom) {
+        return decoder->DecodeYuv(jpegData, jpegSize, output, outputSize, info, layout, scaleDenom);
+    }
+
+    EXPORT ulong DecoderDecodeGrayScaled(I420Decoder* decoder, const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info, int scaleDenom) {
+        return decoder->DecodeGray(jpegData, jpegSize, output, outputSize, info, scaleDenom);
+    }
+
+    // DC-only change detection against the handle's reference map; flags: DC_KEEP_REFERENCE.
+    // thumbnail may be null; returns the map size in bytes (info->width x info->height), 0 on error
+    EXPORT ulong DecoderAnalyzeDc(I420Decoder* decoder, const byte* jpegData, ulong jpegSize, int threshold, int flags, byte* thumbnail, ulong thumbnailSize, DcChangeInfo* info) {
+        return decoder->AnalyzeDc(jpegData, jpegSize, threshold, flags, thumbnail, thumbnailSize, info);
+    }
+
+    EXPORT void DecoderResetDcReference(I420Decoder* decoder) {
+        decoder->ResetDcReference();
+    }
+
+    // Region-of-interest decode; info->stride reports the row stride of the output
+    EXPORT ulong DecoderDecodeI420Crop(I420Decoder* decoder, const byte* jpegData, ulong jpegSize, int x, int y, int width, int height, byte* output, ulong outputSize, DecodeInfo* info) {
+        return decoder->DecodeI420Crop(jpegData, jpegSize, x, y, width, height, output, outputSize, info);
+    }
+
+    EXPORT ulong DecoderDecodeGrayCrop(I420Decoder* decoder, const byte* jpegData, ulong jpegSize, int x, int y, int width, int height, byte* output, ulong outputSize, DecodeInfo* info) {
+        return decoder->DecodeGrayCrop(jpegData, jpegSize, x, y, width, height, output, outputSize, info);
+    }
+
+    // Per-handle counters, see CodecStats; returns 0 when built without LIBJPEGWRAP_WITH_STATS
+    EXPORT int GetDecoderStats(I420Decoder* decoder, CodecStats* stats) {
+        const CodecCounters* counters = &decoder->stats;
+        return codec_stats_snapshot(&counters, 1, stats);
+    }
+
     EXPORT void CloseDecoder(I420Decoder* decoder) {
         delete decoder;
     }
 
+    // threads > 1 enables restart-marker stripe decode on that many native threads; 1 disables it
+    EXPORT void DecoderSetStripeThreads(I420Decoder* decoder, int threads) {
+        decoder->SetStripeThreads(threads);
+    }
+
+    // Decoder set functions (batch decode on native worker threads)
+    EXPORT DecoderSet* CreateDecoderSet(int threads, int maxWidth, int maxHeight, int backend) {
+        if (!IsBackendSupported(backend)) return nullptr;
+        DecoderSet* set = new DecoderSet(threads, maxWidth, maxHeight, backend);
+        if (!set->IsValid()) { delete set; return nullptr; }
+        return set;
+    }
+
+    EXPORT int DecoderSetSize(DecoderSet* set) {
+        return set->Size();
+    }
+
+    EXPORT int DecoderDecodeBatch(DecoderSet* set, const byte** jpegs, const ulong* sizes, byte** outputs,
+        const ulong* outputSizes, DecodeInfo* infos, ulong* results, int count) {
+        return set->DecodeBatch(DecoderSet::FormatI420, jpegs, sizes, outputs, outputSizes, infos, results, count);
+    }
+
+    EXPORT int DecoderDecodeGrayBatch(DecoderSet* set, const byte** jpegs, const ulong* sizes, byte** outputs,
+        const ulong* outputSizes, DecodeInfo* infos, ulong* results, int count) {
+        return set->DecodeBatch(DecoderSet::FormatGray, jpegs, sizes, outputs, outputSizes, infos, results, count);
+    }
+
+    // Sum over the set's decoders; each image of a batch counts as one call
+    EXPORT int GetDecoderSetStats(DecoderSet* set, CodecStats* stats) {
+        return set->GetStats(stats);
+    }
+
+    EXPORT void CloseDecoderSet(DecoderSet* set) {
+        delete set;
+    }
+
+    // Fused decode + HDR blend functions
+    EXPORT HdrFusedDecoder* CreateHdrFusedDecoder(int maxWidth, int maxHeight) {
+        return new HdrFusedDecoder(maxWidth, maxHeight);
+    }
+
+    // format: 0 = I420, 1 = Gray8; mode: 0 = Average, 1 = Weighted
+    EXPORT ulong HdrFusedDecodeBlend(HdrFusedDecoder* decoder, int format, int mode,
+        const byte** jpegs, const ulong* sizes, int count, const byte* weights,
+        byte* output, ulong outputSize, DecodeInfo* info) {
+        return decoder->DecodeBlend((HdrFusedDecoder::Format)format, mode, jpegs, sizes, count,
+            weights, output, outputSize, info);
+    }
+
+    // One call per blended window
+    EXPORT int GetHdrFusedDecoderStats(HdrFusedDecoder* decoder, CodecStats* stats) {
+        const CodecCounters* counters = &decoder->stats;
+        return codec_stats_snapshot(&counters, 1, stats);
+    }
+
+    EXPORT void CloseHdrFusedDecoder(HdrFusedDecoder* decoder) {
+        delete decoder;
+    }
+
     // BGRA decoder functions (safe error handling for WASM)
     EXPORT BgraDecoder* CreateBgraDecoder(int maxWidth, int maxHeight) {
         return new BgraDecoder(maxWidth, maxHeight);
     }
 
+    EXPORT BgraDecoder* CreateBgraDecoderWithBackend(int maxWidth, int maxHeight, int backend) {
+        if (!IsBackendSupported(backend)) return nullptr;
+        BgraDecoder* decoder = new BgraDecoder(maxWidth, maxHeight, backend);
+        if (!decoder->IsValid()) { delete decoder; return nullptr; }
+        return decoder;
+    }
+
     EXPORT void CloseBgraDecoder(BgraDecoder* decoder) {
         delete decoder;
     }
@@ -776,4 +4675,140 @@ extern "C" {
         byte* output, ulong outputSize, DecodeInfo* info) {
         return decoder->DecodeBGRA(jpegData, jpegSize, output, outputSize, info);
     }
+
+    EXPORT ulong DecoderDecodeBGRAScaled(BgraDecoder* decoder,
+        const byte* jpegData, ulong jpegSize,
+        byte* output, ulong outputSize, DecodeInfo* info, int scaleDenom) {
+        return decoder->DecodeBGRA(jpegData, jpegSize, output, outputSize, info, scaleDenom);
+    }
+
+    // order: PIXEL_ORDER_BGRA or PIXEL_ORDER_RGBA; stride: destination row bytes, 0 = width * 4
+    EXPORT ulong DecoderDecodePacked(BgraDecoder* decoder,
+        const byte* jpegData, ulong jpegSize,
+        byte* output, ulong outputSize, DecodeInfo* info, int scaleDenom, int order, int stride) {
+        return decoder->DecodePacked(jpegData, jpegSize, output, outputSize, info, scaleDenom, order, stride);
+    }
+
+    // I420 planes to BGRA/RGBA rows outStride bytes apart; returns outStride * height, 0 on bad arguments
+    EXPORT ulong ConvertI420ToBGRA(const byte* y, int yStride, const byte* u, const byte* v, int uvStride,
+        int width, int height, byte* output, int outStride, int order) {
+        return ConvertI420ToPacked(y, yStride, u, v, uvStride, width, height, output, outStride, order);
+    }
+
+    // Native worker decode, see BgraWorkerPool. capacity bounds jobs in flight, unpolled results included
+    EXPORT BgraWorkerPool* CreateBgraWorkerPool(int threads, int maxWidth, int maxHeight, int capacity) {
+        return new BgraWorkerPool(threads, maxWidth, maxHeight, capacity);
+    }
+
+    // order/stride as DecoderDecodePacked; returns 1 when queued, 0 when the pool is full
+    EXPORT int BgraWorkerSubmit(BgraWorkerPool* pool, uint64_t id,
+        const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, int scaleDenom, int order, int stride) {
+        DecodeJob job = { id, jpegData, jpegSize, output, outputSize, scaleDenom, order, stride };
+        return pool->Submit(job);
+    }
+
+    // Non-blocking: copies up to max finished jobs into results, returns the count
+    EXPORT int BgraWorkerPoll(BgraWorkerPool* pool, DecodeJobResult* results, int max) {
+        return pool->Poll(results, max);
+    }
+
+    EXPORT void CloseBgraWorkerPool(BgraWorkerPool* pool) {
+        delete pool;
+    }
+
+    // Streaming decoder: feed a frame segment by segment as it arrives, see StreamingDecoder
+    EXPORT StreamingDecoder* CreateStreamingDecoder(int maxWidth, int maxHeight) {
+        return new StreamingDecoder(maxWidth, maxHeight);
+    }
+
+    EXPORT void CloseStreamingDecoder(StreamingDecoder* decoder) {
+        delete decoder;
+    }
+
+    // format: DECODE_FORMAT_I420 or DECODE_FORMAT_GRAY. Returns 0 on an unknown format.
+    EXPORT int StreamingDecoderBegin(StreamingDecoder* decoder, int format, byte* output, ulong outputSize) {
+        return decoder->Begin(format, output, outputSize) ? 1 : 0;
+    }
+
+    // Returns STREAM_NEED_MORE, STREAM_DONE or STREAM_ERROR; info and written are set on STREAM_DONE
+    EXPORT int StreamingDecoderFeed(StreamingDecoder* decoder, const byte* data, ulong size, int last,
+        DecodeInfo* info, ulong* written) {
+        return decoder->Feed(data, size, last != 0, info, written);
+    }
+
+    // Lossless DCT-domain transcoder, see JpegTransformer
+    EXPORT JpegTransformer* CreateTransformer() {
+        return new JpegTransformer();
+    }
+
+    EXPORT int GetTransformerStats(JpegTransformer* transformer, CodecStats* stats) {
+        const CodecCounters* counters = &transformer->stats;
+        return codec_stats_snapshot(&counters, 1, stats);
+    }
+
+    EXPORT void CloseTransformer(JpegTransformer* transformer) {
+        delete transformer;
+    }
+
+    // op: TRANSFORM_*; crop in output pixels (width/height 0 = to the edge); quality 0 keeps the tables;
+    // flags: TRANSFORM_STRIP_MARKERS. info (optional) receives the output image.
+    EXPORT ulong TransformerTransform(JpegTransformer* transformer, const byte* jpegData, ulong jpegSize,
+        int op, int cropX, int cropY, int cropWidth, int cropHeight, int quality, int flags,
+        byte* output, ulong outputSize, DecodeInfo* info) {
+        return transformer->Transform(jpegData, jpegSize, op, cropX, cropY, cropWidth, cropHeight, quality, flags,
+            output, outputSize, info);
+    }
+
+    // V4L2 M2M hardware decoder. device: /dev/videoN, or null to use the first JPEG-capable one.
+    // Returns nullptr when the backend is not compiled in or no device can be opened.
+    EXPORT V4l2Decoder* CreateV4l2Decoder(const char* device, int maxWidth, int maxHeight) {
+#ifdef LIBJPEGWRAP_WITH_V4L2
+        V4l2Decoder* decoder = new V4l2Decoder(device, maxWidth, maxHeight);
+        if (!decoder->IsValid()) { delete decoder; return nullptr; }
+        return decoder;
+#else
+        (void)device; (void)maxWidth; (void)maxHeight;
+        return nullptr;
+#endif
+    }
+
+    // Returns 1 and the device path when a JPEG-capable M2M device exists
+    EXPORT int FindV4l2Decoder(char* path, int pathSize) {
+#ifdef LIBJPEGWRAP_WITH_V4L2
+        return v4l2_find_jpeg_decoder(path, pathSize) ? 1 : 0;
+#else
+        (void)path; (void)pathSize;
+        return 0;
+#endif
+    }
+
+    // format: DECODE_FORMAT_I420 or DECODE_FORMAT_GRAY. Returns 0 for frames the engine does not take;
+    // decode those with DecoderDecodeI420 / DecoderDecodeGray.
+    EXPORT ulong V4l2DecoderDecode(V4l2Decoder* decoder, const byte* jpegData, ulong jpegSize, int format,
+        byte* output, ulong outputSize, DecodeInfo* info) {
+#ifdef LIBJPEGWRAP_WITH_V4L2
+        return decoder->Decode(jpegData, jpegSize, format, output, outputSize, info);
+#else
+        (void)decoder; (void)jpegData; (void)jpegSize; (void)format; (void)output; (void)outputSize; (void)info;
+        return 0;
+#endif
+    }
+
+    EXPORT int GetV4l2DecoderStats(V4l2Decoder* decoder, CodecStats* stats) {
+#ifdef LIBJPEGWRAP_WITH_V4L2
+        const CodecCounters* counters = &decoder->stats;
+        return codec_stats_snapshot(&counters, 1, stats);
+#else
+        (void)decoder; (void)stats;
+        return 0;
+#endif
+    }
+
+    EXPORT void CloseV4l2Decoder(V4l2Decoder* decoder) {
+#ifdef LIBJPEGWRAP_WITH_V4L2
+        delete decoder;
+#else
+        (void)decoder;
+#endif
+    }
 }
\ No newline at end of file
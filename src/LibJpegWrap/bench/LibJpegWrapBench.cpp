@@ -0,0 +1,823 @@
+// LibJpegWrapBench.cpp : native benchmark of the LibJpegWrap exports.
+//
+// Runs every encode/decode export against a JPEG corpus and reports throughput (MP/s), p50/p99 latency
+// and scaling from 1 to N threads, per backend. Without --corpus a synthetic camera-like corpus is
+// generated: 720p, 1080p and 2160p at 4:2:0, 4:2:2 and 4:4:4, with and without restart markers.
+//
+//   LibJpegWrapBench [--corpus DIR] [--iterations N] [--threads N] [--backend libjpeg|turbojpeg|all]
+//                    [--filter TEXT] [--csv FILE]
+//
+// Cases that are threaded inside the library (stripe decode, DecoderSet, BgraWorkerPool) run one caller
+// and pass the thread count to the handle; all others run one handle per caller thread.
+
+#include <cstdio>
+#include <jpeglib.h>
+#include <setjmp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef unsigned char byte;
+typedef unsigned long ulong;
+
+// Mirrors of the LibJpegWrap.cpp structures; handles are opaque here
+typedef struct {
+    int width;
+    int height;
+    int components;
+    int colorSpace;
+    int stride;
+    int layout;
+} DecodeInfo;
+
+typedef struct {
+    byte* data;
+    ulong size;
+} JpegSegment;
+
+typedef struct {
+    int width;
+    int height;
+    int compared;
+    int changedBlocks;
+    int maxDifference;
+    ulong sumDifference;
+} DcChangeInfo;
+
+typedef struct {
+    uint64_t id;
+    ulong written;
+    DecodeInfo info;
+} DecodeJobResult;
+
+typedef byte* (*jpeg_chunk_alloc)(void* ctx, ulong committed, ulong* chunkSize);
+
+extern "C" {
+    int IsBackendAvailable(int backend);
+
+    void* CreateWithBackend(int width, int height, int quality, ulong size, int backend);
+    ulong Encode(void* encoder, byte* data, byte* dstBuffer, ulong dstBufferSize);
+    ulong EncodeNv12(void* encoder, const byte* y, int yStride, const byte* uv, int uvStride, byte* dstBuffer, ulong dstBufferSize);
+    ulong EncodeChunked(void* encoder, byte* data, jpeg_chunk_alloc alloc, void* ctx,
+        JpegSegment* segments, int maxSegments, int* segmentCount);
+    void Close(void* encoder);
+
+    void* CreateGrayEncoder(int quality);
+    ulong GrayEncoderEncode(void* encoder, const byte* grayData, int width, int height, int quality, byte* output, ulong outputSize);
+    void CloseGrayEncoder(void* encoder);
+
+    void* CreateDecoderWithBackend(int maxWidth, int maxHeight, int backend);
+    int DecoderGetImageInfo(void* decoder, const byte* jpegData, ulong jpegSize, DecodeInfo* info);
+    ulong DecoderDecodeI420(void* decoder, const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info);
+    ulong DecoderDecodeGray(void* decoder, const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info);
+    ulong DecoderDecodeI420Segments(void* decoder, const JpegSegment* segments, int count, byte* output, ulong outputSize, DecodeInfo* info);
+    ulong DecoderDecodeI420Scaled(void* decoder, const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize, DecodeInfo* info, int scaleDenom);
+    ulong DecoderDecodeI420Crop(void* decoder, const byte* jpegData, ulong jpegSize, int x, int y, int width, int height,
+        byte* output, ulong outputSize, DecodeInfo* info);
+    ulong DecoderAnalyzeDc(void* decoder, const byte* jpegData, ulong jpegSize, int threshold, int flags,
+        byte* thumbnail, ulong thumbnailSize, DcChangeInfo* info);
+    void DecoderSetStripeThreads(void* decoder, int threads);
+    void CloseDecoder(void* decoder);
+
+    void* CreateDecoderSet(int threads, int maxWidth, int maxHeight, int backend);
+    int DecoderDecodeBatch(void* set, const byte** jpegs, const ulong* sizes, byte** outputs,
+        const ulong* outputSizes, DecodeInfo* infos, ulong* results, int count);
+    void CloseDecoderSet(void* set);
+
+    void* CreateHdrFusedDecoder(int maxWidth, int maxHeight);
+    ulong HdrFusedDecodeBlend(void* decoder, int format, int mode, const byte** jpegs, const ulong* sizes, int count,
+        const byte* weights, byte* output, ulong outputSize, DecodeInfo* info);
+    void CloseHdrFusedDecoder(void* decoder);
+
+    void* CreateBgraDecoderWithBackend(int maxWidth, int maxHeight, int backend);
+    ulong DecoderDecodePacked(void* decoder, const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize,
+        DecodeInfo* info, int scaleDenom, int order, int stride);
+    void CloseBgraDecoder(void* decoder);
+    ulong ConvertI420ToBGRA(const byte* y, int yStride, const byte* u, const byte* v, int uvStride,
+        int width, int height, byte* output, int outStride, int order);
+
+    void* CreateBgraWorkerPool(int threads, int maxWidth, int maxHeight, int capacity);
+    int BgraWorkerSubmit(void* pool, uint64_t id, const byte* jpegData, ulong jpegSize, byte* output, ulong outputSize,
+        int scaleDenom, int order, int stride);
+    int BgraWorkerPoll(void* pool, DecodeJobResult* results, int max);
+    void CloseBgraWorkerPool(void* pool);
+
+    void* CreateStreamingDecoder(int maxWidth, int maxHeight);
+    int StreamingDecoderBegin(void* decoder, int format, byte* output, ulong outputSize);
+    int StreamingDecoderFeed(void* decoder, const byte* data, ulong size, int last, DecodeInfo* info, ulong* written);
+    void CloseStreamingDecoder(void* decoder);
+}
+
+#define BACKEND_LIBJPEG 0
+#define BACKEND_TURBOJPEG 1
+#define STREAM_DONE 1
+#define JPEG_QUALITY 85
+#define SEGMENT_SIZE 4096       // PipeReader-sized pieces for the scatter-list decode
+#define STREAM_CHUNK 16384      // Network-sized pieces for the streaming decode
+#define HDR_WINDOW 3
+
+static const char* BackendName(int backend) { return backend == BACKEND_TURBOJPEG ? "turbojpeg" : "libjpeg"; }
+
+// ---------------------------------------------------------------------------------------------------
+// Corpus
+
+struct Image {
+    std::string name;
+    std::vector<byte> jpeg;
+    int width = 0;
+    int height = 0;
+    std::string sampling;       // "4:2:0", "4:2:2", "4:4:4", "gray" or "h1v1/h2v1..." for anything else
+    unsigned restartInterval = 0;
+
+    bool EvenSize() const { return width % 2 == 0 && height % 2 == 0; }
+    ulong I420Size() const { return (ulong)width * height + 2ul * ((width + 1) / 2) * ((height + 1) / 2); }
+};
+
+struct probe_error_mgr {
+    struct jpeg_error_mgr pub;
+    jmp_buf jump;
+};
+
+static void probe_error_exit(j_common_ptr cinfo) {
+    longjmp(((probe_error_mgr*)cinfo->err)->jump, 1);
+}
+
+// Reads the sampling factors and restart interval straight from the headers
+static bool ProbeImage(Image& image) {
+    jpeg_decompress_struct cinfo;
+    probe_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = probe_error_exit;
+    bool ok = true;
+    jpeg_create_decompress(&cinfo);
+    if (setjmp(jerr.jump)) {
+        ok = false;
+    } else {
+        jpeg_mem_src(&cinfo, image.jpeg.data(), (unsigned long)image.jpeg.size());
+        jpeg_read_header(&cinfo, TRUE);
+        image.width = (int)cinfo.image_width;
+        image.height = (int)cinfo.image_height;
+        image.restartInterval = cinfo.restart_interval;
+        if (cinfo.num_components == 1) {
+            image.sampling = "gray";
+        } else {
+            int h = cinfo.comp_info[0].h_samp_factor, v = cinfo.comp_info[0].v_samp_factor;
+            if (h == 2 && v == 2) image.sampling = "4:2:0";
+            else if (h == 2 && v == 1) image.sampling = "4:2:2";
+            else if (h == 1 && v == 1) image.sampling = "4:4:4";
+            else image.sampling = "h" + std::to_string(h) + "v" + std::to_string(v);
+        }
+    }
+    jpeg_destroy_decompress(&cinfo);
+    return ok;
+}
+
+static std::vector<Image> LoadCorpus(const std::string& dir) {
+    std::vector<Image> images;
+    std::vector<std::filesystem::path> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        if (entry.is_regular_file() && (ext == ".jpg" || ext == ".jpeg")) paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    for (const auto& path : paths) {
+        Image image;
+        image.name = path.filename().string();
+        std::ifstream file(path, std::ios::binary);
+        image.jpeg.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (!ProbeImage(image)) {
+            fprintf(stderr, "skipping %s: not a readable JPEG\n", image.name.c_str());
+            continue;
+        }
+        images.push_back(std::move(image));
+    }
+    return images;
+}
+
+// Camera-like content: smooth gradients and a few hard edges under sensor noise, so the entropy
+// coder sees realistic coefficient statistics instead of a flat gradient
+static std::vector<byte> SyntheticRgb(int width, int height, unsigned seed) {
+    std::vector<byte> rgb((size_t)width * height * 3);
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 6.0f);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float fx = (float)x / width, fy = (float)y / height;
+            bool tile = ((x / 96) + (y / 64)) % 5 == 0;
+            float base[3] = { 40 + 160 * fx, 60 + 120 * fy, 180 - 140 * fx * fy };
+            byte* px = &rgb[((size_t)y * width + x) * 3];
+            for (int c = 0; c < 3; c++) {
+                float v = base[c] + (tile ? 50.0f : 0.0f) + noise(rng);
+                px[c] = (byte)std::clamp(v, 0.0f, 255.0f);
+            }
+        }
+    }
+    return rgb;
+}
+
+static std::vector<byte> CompressRgb(const std::vector<byte>& rgb, int width, int height, int hSamp, int vSamp, int restartRows) {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&cinfo, &buffer, &size);
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, JPEG_QUALITY, TRUE);
+    cinfo.comp_info[0].h_samp_factor = hSamp;
+    cinfo.comp_info[0].v_samp_factor = vSamp;
+    cinfo.restart_in_rows = restartRows;
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = (JSAMPROW)&rgb[(size_t)cinfo.next_scanline * width * 3];
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    std::vector<byte> jpeg(buffer, buffer + size);
+    free(buffer);
+    return jpeg;
+}
+
+static std::vector<Image> SyntheticCorpus() {
+    static const struct { int width, height; const char* label; } sizes[] = {
+        { 1280, 720, "720p" }, { 1920, 1080, "1080p" }, { 3840, 2160, "2160p" }
+    };
+    static const struct { int h, v; } samplings[] = { { 2, 2 }, { 2, 1 }, { 1, 1 } };
+
+    std::vector<Image> images;
+    for (const auto& size : sizes) {
+        std::vector<byte> rgb = SyntheticRgb(size.width, size.height, (unsigned)size.width);
+        for (const auto& s : samplings) {
+            for (int restartRows : { 0, 1 }) {
+                Image image;
+                image.jpeg = CompressRgb(rgb, size.width, size.height, s.h, s.v, restartRows);
+                ProbeImage(image);
+                image.name = std::string("synthetic-") + size.label + "-" + image.sampling + (restartRows ? "-dri" : "");
+                images.push_back(std::move(image));
+            }
+        }
+    }
+    return images;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Cases
+
+// One benchmark case bound to one image. Setup creates the handles (false = not applicable);
+// Run performs one timed call and returns 0 on failure.
+class Bench {
+public:
+    virtual ~Bench() {}
+    virtual bool Setup(const Image& image, int backend, int threads) = 0;
+    virtual ulong Run() = 0;
+    // Frames processed by one Run, for the throughput figure
+    virtual int FramesPerRun() const { return 1; }
+};
+
+struct CaseInfo {
+    const char* name;
+    bool internalThreads;       // Threads are passed to one handle instead of one handle per caller
+    bool turboCapable;          // Has a TurboJPEG implementation; otherwise runs on libjpeg only
+    std::function<std::unique_ptr<Bench>()> create;
+};
+
+static ulong DecodeToI420(const Image& image, std::vector<byte>& i420) {
+    void* decoder = CreateDecoderWithBackend(image.width, image.height, BACKEND_LIBJPEG);
+    i420.resize(image.I420Size());
+    DecodeInfo info;
+    ulong written = DecoderDecodeI420(decoder, image.jpeg.data(), image.jpeg.size(), i420.data(), i420.size(), &info);
+    CloseDecoder(decoder);
+    return written;
+}
+
+class DecoderBench : public Bench {
+public:
+    ~DecoderBench() override { if (decoder) CloseDecoder(decoder); }
+    bool Setup(const Image& image, int backend, int) override {
+        img = &image;
+        decoder = CreateDecoderWithBackend(image.width, image.height, backend);
+        output.resize((size_t)image.width * image.height * 3);
+        return decoder != nullptr;
+    }
+protected:
+    const Image* img = nullptr;
+    void* decoder = nullptr;
+    std::vector<byte> output;
+    DecodeInfo info;
+};
+
+class HeaderBench : public DecoderBench {
+public:
+    ulong Run() override { return (ulong)DecoderGetImageInfo(decoder, img->jpeg.data(), img->jpeg.size(), &info); }
+};
+
+class I420Bench : public DecoderBench {
+public:
+    ulong Run() override { return DecoderDecodeI420(decoder, img->jpeg.data(), img->jpeg.size(), output.data(), output.size(), &info); }
+};
+
+class GrayBench : public DecoderBench {
+public:
+    ulong Run() override { return DecoderDecodeGray(decoder, img->jpeg.data(), img->jpeg.size(), output.data(), output.size(), &info); }
+};
+
+class ScaledBench : public DecoderBench {
+public:
+    explicit ScaledBench(int denom) : denom(denom) {}
+    ulong Run() override {
+        return DecoderDecodeI420Scaled(decoder, img->jpeg.data(), img->jpeg.size(), output.data(), output.size(), &info, denom);
+    }
+private:
+    int denom;
+};
+
+// DC-only change detection; the same frame every run, so each call compares against a reference
+class DcBench : public DecoderBench {
+public:
+    ulong Run() override {
+        DcChangeInfo change;
+        return DecoderAnalyzeDc(decoder, img->jpeg.data(), img->jpeg.size(), 8, 0, nullptr, 0, &change);
+    }
+};
+
+// Centre quarter of the frame, on even coordinates as I420 crops require
+class CropBench : public DecoderBench {
+public:
+    ulong Run() override {
+        int x = (img->width / 4) & ~1, y = (img->height / 4) & ~1;
+        return DecoderDecodeI420Crop(decoder, img->jpeg.data(), img->jpeg.size(), x, y, img->width / 2 & ~1, img->height / 2 & ~1,
+            output.data(), output.size(), &info);
+    }
+};
+
+class SegmentsBench : public DecoderBench {
+public:
+    bool Setup(const Image& image, int backend, int threads) override {
+        if (!DecoderBench::Setup(image, backend, threads)) return false;
+        for (size_t off = 0; off < image.jpeg.size(); off += SEGMENT_SIZE)
+            segments.push_back({ const_cast<byte*>(image.jpeg.data()) + off, (ulong)std::min<size_t>(SEGMENT_SIZE, image.jpeg.size() - off) });
+        return true;
+    }
+    ulong Run() override {
+        return DecoderDecodeI420Segments(decoder, segments.data(), (int)segments.size(), output.data(), output.size(), &info);
+    }
+private:
+    std::vector<JpegSegment> segments;
+};
+
+// Restart-marker stripes on the decoder's own threads; only meaningful for DRI images
+class StripesBench : public I420Bench {
+public:
+    bool Setup(const Image& image, int backend, int threads) override {
+        if (image.restartInterval == 0 || !I420Bench::Setup(image, backend, threads)) return false;
+        DecoderSetStripeThreads(decoder, threads);
+        return true;
+    }
+};
+
+class PackedBench : public Bench {
+public:
+    ~PackedBench() override { if (decoder) CloseBgraDecoder(decoder); }
+    bool Setup(const Image& image, int backend, int) override {
+        img = &image;
+        decoder = CreateBgraDecoderWithBackend(image.width, image.height, backend);
+        output.resize((size_t)image.width * image.height * 4);
+        return decoder != nullptr;
+    }
+    ulong Run() override {
+        return DecoderDecodePacked(decoder, img->jpeg.data(), img->jpeg.size(), output.data(), output.size(), &info, 1, 0, 0);
+    }
+private:
+    const Image* img = nullptr;
+    void* decoder = nullptr;
+    std::vector<byte> output;
+    DecodeInfo info;
+};
+
+class StreamingBench : public Bench {
+public:
+    ~StreamingBench() override { if (decoder) CloseStreamingDecoder(decoder); }
+    bool Setup(const Image& image, int, int) override {
+        img = &image;
+        decoder = CreateStreamingDecoder(image.width, image.height);
+        output.resize((size_t)image.width * image.height * 3);
+        return decoder != nullptr;
+    }
+    ulong Run() override {
+        if (!StreamingDecoderBegin(decoder, 0, output.data(), output.size())) return 0;
+        DecodeInfo info;
+        ulong written = 0;
+        for (size_t off = 0; off < img->jpeg.size(); off += STREAM_CHUNK) {
+            size_t n = std::min<size_t>(STREAM_CHUNK, img->jpeg.size() - off);
+            int last = off + n == img->jpeg.size();
+            int status = StreamingDecoderFeed(decoder, img->jpeg.data() + off, n, last, &info, &written);
+            if (status == STREAM_DONE) return written;
+            if (status < 0) return 0;
+        }
+        return 0;
+    }
+private:
+    const Image* img = nullptr;
+    void* decoder = nullptr;
+    std::vector<byte> output;
+};
+
+// One batch of `threads` frames on a DecoderSet of `threads` workers
+class BatchBench : public Bench {
+public:
+    ~BatchBench() override { if (set) CloseDecoderSet(set); }
+    bool Setup(const Image& image, int backend, int threads) override {
+        set = CreateDecoderSet(threads, image.width, image.height, backend);
+        count = threads;
+        buffers.assign(count, std::vector<byte>(image.I420Size()));
+        for (int i = 0; i < count; i++) {
+            jpegs.push_back(image.jpeg.data());
+            sizes.push_back(image.jpeg.size());
+            outputs.push_back(buffers[i].data());
+            outputSizes.push_back(buffers[i].size());
+        }
+        infos.resize(count);
+        results.resize(count);
+        return set != nullptr;
+    }
+    ulong Run() override {
+        return DecoderDecodeBatch(set, jpegs.data(), sizes.data(), outputs.data(), outputSizes.data(),
+            infos.data(), results.data(), count) == count ? results[0] : 0;
+    }
+    int FramesPerRun() const override { return count; }
+private:
+    void* set = nullptr;
+    int count = 0;
+    std::vector<std::vector<byte>> buffers;
+    std::vector<const byte*> jpegs;
+    std::vector<ulong> sizes;
+    std::vector<byte*> outputs;
+    std::vector<ulong> outputSizes;
+    std::vector<DecodeInfo> infos;
+    std::vector<ulong> results;
+};
+
+// `threads` * 2 packed decodes queued at once, so workers never starve between polls
+class WorkerPoolBench : public Bench {
+public:
+    ~WorkerPoolBench() override { if (pool) CloseBgraWorkerPool(pool); }
+    bool Setup(const Image& image, int, int threads) override {
+        img = &image;
+        jobs = threads * 2;
+        pool = CreateBgraWorkerPool(threads, image.width, image.height, jobs);
+        buffers.assign(jobs, std::vector<byte>((size_t)image.width * image.height * 4));
+        return pool != nullptr;
+    }
+    ulong Run() override {
+        for (int i = 0; i < jobs; i++)
+            if (!BgraWorkerSubmit(pool, (uint64_t)i, img->jpeg.data(), img->jpeg.size(), buffers[i].data(), buffers[i].size(), 1, 0, 0))
+                return 0;
+        DecodeJobResult done[16];
+        ulong written = 0;
+        for (int received = 0; received < jobs; ) {
+            int n = BgraWorkerPoll(pool, done, 16);
+            if (n == 0) std::this_thread::yield();
+            for (int i = 0; i < n; i++) {
+                if (done[i].written == 0) return 0;
+                written = done[i].written;
+            }
+            received += n;
+        }
+        return written;
+    }
+    int FramesPerRun() const override { return jobs; }
+private:
+    const Image* img = nullptr;
+    void* pool = nullptr;
+    int jobs = 0;
+    std::vector<std::vector<byte>> buffers;
+};
+
+class FusedBench : public Bench {
+public:
+    ~FusedBench() override { if (decoder) CloseHdrFusedDecoder(decoder); }
+    bool Setup(const Image& image, int, int) override {
+        // The fused I420 path reads 4:2:0 raw data only
+        if (!image.EvenSize() || image.sampling != "4:2:0") return false;
+        decoder = CreateHdrFusedDecoder(image.width, image.height);
+        for (int i = 0; i < HDR_WINDOW; i++) {
+            jpegs[i] = image.jpeg.data();
+            sizes[i] = image.jpeg.size();
+        }
+        output.resize(image.I420Size());
+        return decoder != nullptr;
+    }
+    ulong Run() override {
+        DecodeInfo info;
+        return HdrFusedDecodeBlend(decoder, 0, 0, jpegs, sizes, HDR_WINDOW, nullptr, output.data(), output.size(), &info);
+    }
+    int FramesPerRun() const override { return HDR_WINDOW; }
+private:
+    void* decoder = nullptr;
+    const byte* jpegs[HDR_WINDOW];
+    ulong sizes[HDR_WINDOW];
+    std::vector<byte> output;
+};
+
+// Encoders take the image's own I420 decode as input; odd sizes have no tight I420 layout
+class EncoderBench : public Bench {
+public:
+    ~EncoderBench() override { if (encoder) Close(encoder); }
+    bool Setup(const Image& image, int backend, int) override {
+        if (!image.EvenSize() || DecodeToI420(image, i420) == 0) return false;
+        width = image.width;
+        height = image.height;
+        output.resize(i420.size() * 2);
+        encoder = CreateWithBackend(width, height, JPEG_QUALITY, output.size(), backend);
+        return encoder != nullptr;
+    }
+protected:
+    void* encoder = nullptr;
+    int width = 0, height = 0;
+    std::vector<byte> i420;
+    std::vector<byte> output;
+};
+
+class EncodeBench : public EncoderBench {
+public:
+    ulong Run() override { return Encode(encoder, i420.data(), output.data(), output.size()); }
+};
+
+class EncodeNv12Bench : public EncoderBench {
+public:
+    bool Setup(const Image& image, int backend, int threads) override {
+        if (!EncoderBench::Setup(image, backend, threads)) return false;
+        // Interleave the I420 chroma planes into NV12 order once
+        size_t luma = (size_t)width * height, quarter = luma / 4;
+        nv12.assign(i420.begin(), i420.begin() + luma);
+        for (size_t i = 0; i < quarter; i++) {
+            nv12.push_back(i420[luma + i]);
+            nv12.push_back(i420[luma + quarter + i]);
+        }
+        return true;
+    }
+    ulong Run() override {
+        return EncodeNv12(encoder, nv12.data(), width, nv12.data() + (size_t)width * height, width, output.data(), output.size());
+    }
+private:
+    std::vector<byte> nv12;
+};
+
+class EncodeChunkedBench : public EncoderBench {
+public:
+    // Hands out consecutive 64 KB pieces of the output buffer, like a pooled IBufferWriter
+    static byte* Alloc(void* ctx, ulong committed, ulong* chunkSize) {
+        auto* self = (EncodeChunkedBench*)ctx;
+        self->used += committed;
+        if (!chunkSize || self->used + 65536 > self->output.size()) return nullptr;
+        *chunkSize = 65536;
+        return self->output.data() + self->used;
+    }
+    ulong Run() override {
+        JpegSegment segments[256];
+        int count = 0;
+        used = 0;
+        return EncodeChunked(encoder, i420.data(), &EncodeChunkedBench::Alloc, this, segments, 256, &count);
+    }
+private:
+    size_t used = 0;
+};
+
+class GrayEncodeBench : public Bench {
+public:
+    ~GrayEncodeBench() override { if (encoder) CloseGrayEncoder(encoder); }
+    bool Setup(const Image& image, int, int) override {
+        if (!image.EvenSize() || DecodeToI420(image, i420) == 0) return false;
+        width = image.width;
+        height = image.height;
+        output.resize((size_t)width * height * 2);
+        encoder = CreateGrayEncoder(JPEG_QUALITY);
+        return encoder != nullptr;
+    }
+    ulong Run() override { return GrayEncoderEncode(encoder, i420.data(), width, height, JPEG_QUALITY, output.data(), output.size()); }
+private:
+    void* encoder = nullptr;
+    int width = 0, height = 0;
+    std::vector<byte> i420;
+    std::vector<byte> output;
+};
+
+class ConvertBench : public Bench {
+public:
+    bool Setup(const Image& image, int, int) override {
+        if (!image.EvenSize() || DecodeToI420(image, i420) == 0) return false;
+        width = image.width;
+        height = image.height;
+        output.resize((size_t)width * height * 4);
+        return true;
+    }
+    ulong Run() override {
+        const byte* y = i420.data();
+        const byte* u = y + (size_t)width * height;
+        const byte* v = u + (size_t)width * height / 4;
+        return ConvertI420ToBGRA(y, width, u, v, width / 2, width, height, output.data(), width * 4, 0);
+    }
+private:
+    int width = 0, height = 0;
+    std::vector<byte> i420;
+    std::vector<byte> output;
+};
+
+template <typename T, typename... Args>
+static std::function<std::unique_ptr<Bench>()> Make(Args... args) {
+    return [=]() { return std::unique_ptr<Bench>(new T(args...)); };
+}
+
+static const std::vector<CaseInfo>& Cases() {
+    static const std::vector<CaseInfo> cases = {
+        { "decode.header",      false, false, Make<HeaderBench>() },
+        { "decode.i420",        false, true,  Make<I420Bench>() },
+        { "decode.gray",        false, true,  Make<GrayBench>() },
+        { "decode.i420.half",   false, true,  Make<ScaledBench>(2) },
+        { "decode.i420.eighth", false, true,  Make<ScaledBench>(8) },
+        { "decode.dc",          false, false, Make<DcBench>() },
+        { "decode.i420.crop",   false, false, Make<CropBench>() },
+        { "decode.i420.segments", false, true, Make<SegmentsBench>() },
+        { "decode.i420.stripes", true, false, Make<StripesBench>() },
+        { "decode.streaming",   false, false, Make<StreamingBench>() },
+        { "decode.bgra",        false, true,  Make<PackedBench>() },
+        { "decode.batch",       true,  true,  Make<BatchBench>() },
+        { "decode.bgra.workers", true, false, Make<WorkerPoolBench>() },
+        { "hdr.fused",          false, false, Make<FusedBench>() },
+        { "encode.i420",        false, true,  Make<EncodeBench>() },
+        { "encode.nv12",        false, true,  Make<EncodeNv12Bench>() },
+        { "encode.chunked",     false, false, Make<EncodeChunkedBench>() },
+        { "encode.gray",        false, false, Make<GrayEncodeBench>() },
+        { "convert.i420_bgra",  false, false, Make<ConvertBench>() },
+    };
+    return cases;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Runner
+
+struct Result {
+    bool ok = false;
+    double megapixelsPerSecond = 0;
+    double p50Ms = 0;
+    double p99Ms = 0;
+};
+
+static double Percentile(std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = (size_t)std::min<double>(sorted.size() - 1, p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+// Runs `iterations` timed calls on each of `callers` threads (after one warm-up call each)
+static Result Measure(const CaseInfo& c, const Image& image, int backend, int threads, int iterations) {
+    int callers = c.internalThreads ? 1 : threads;
+    std::vector<std::unique_ptr<Bench>> benches;
+    for (int i = 0; i < callers; i++) {
+        benches.push_back(c.create());
+        if (!benches.back()->Setup(image, backend, threads)) return Result();
+        if (benches.back()->Run() == 0) {
+            fprintf(stderr, "%s failed on %s (%s)\n", c.name, image.name.c_str(), BackendName(backend));
+            return Result();
+        }
+    }
+
+    std::vector<std::vector<double>> latencies(callers);
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<bool> failed(false);
+    std::chrono::steady_clock::time_point begin;
+    auto worker = [&](int index) {
+        Bench& bench = *benches[index];
+        // The last caller to arrive starts the clock, so thread start-up is not timed
+        if (++ready == callers) {
+            begin = std::chrono::steady_clock::now();
+            go = true;
+        }
+        while (!go.load()) std::this_thread::yield();
+        latencies[index].reserve(iterations);
+        for (int i = 0; i < iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+            if (bench.Run() == 0) failed = true;
+            latencies[index].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < callers; i++) workers.emplace_back(worker, i);
+    worker(0);
+    for (auto& t : workers) t.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (failed) return Result();
+
+    std::vector<double> all;
+    for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+
+    Result result;
+    result.ok = true;
+    double frames = (double)callers * iterations * benches[0]->FramesPerRun();
+    result.megapixelsPerSecond = frames * image.width * image.height / 1e6 / seconds;
+    result.p50Ms = Percentile(all, 0.50);
+    result.p99Ms = Percentile(all, 0.99);
+    return result;
+}
+
+static void Usage() {
+    fprintf(stderr,
+        "usage: LibJpegWrapBench [--corpus DIR] [--iterations N] [--threads N]\n"
+        "                        [--backend libjpeg|turbojpeg|all] [--filter TEXT] [--csv FILE]\n");
+}
+
+int main(int argc, char** argv) {
+    std::string corpus, filter, csvPath, backendArg = "all";
+    int iterations = 20;
+    int maxThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) { Usage(); return 1; }
+        if (arg == "--corpus") corpus = argv[++i];
+        else if (arg == "--iterations") iterations = std::max(1, atoi(argv[++i]));
+        else if (arg == "--threads") maxThreads = std::max(1, atoi(argv[++i]));
+        else if (arg == "--backend") backendArg = argv[++i];
+        else if (arg == "--filter") filter = argv[++i];
+        else if (arg == "--csv") csvPath = argv[++i];
+        else { Usage(); return 1; }
+    }
+
+    std::vector<int> backends;
+    if (backendArg == "libjpeg" || backendArg == "all") backends.push_back(BACKEND_LIBJPEG);
+    if ((backendArg == "turbojpeg" || backendArg == "all") && IsBackendAvailable(BACKEND_TURBOJPEG)) backends.push_back(BACKEND_TURBOJPEG);
+    if (backends.empty()) {
+        fprintf(stderr, "backend %s is not available in this build\n", backendArg.c_str());
+        return 1;
+    }
+
+    std::vector<Image> images = corpus.empty() ? SyntheticCorpus() : LoadCorpus(corpus);
+    if (images.empty()) {
+        fprintf(stderr, "no JPEG files in %s\n", corpus.c_str());
+        return 1;
+    }
+
+    // 1, 2, 4, ... up to and including maxThreads
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    FILE* csv = csvPath.empty() ? nullptr : fopen(csvPath.c_str(), "w");
+    if (csv) fprintf(csv, "case,backend,image,width,height,sampling,restart,threads,mp_per_s,p50_ms,p99_ms,scaling\n");
+
+    printf("%-22s %-10s %-34s %-7s %4s %4s %10s %9s %9s %8s\n",
+        "case", "backend", "image", "sampl", "dri", "thr", "MP/s", "p50 ms", "p99 ms", "scaling");
+    for (const Image& image : images) {
+        for (const CaseInfo& c : Cases()) {
+            if (!filter.empty() && std::string(c.name).find(filter) == std::string::npos &&
+                image.name.find(filter) == std::string::npos) continue;
+            for (int backend : backends) {
+                if (backend != BACKEND_LIBJPEG && !c.turboCapable) continue;
+                double single = 0;
+                for (int threads : threadCounts) {
+                    Result r = Measure(c, image, backend, threads, iterations);
+                    if (!r.ok) break;
+                    if (threads == 1) single = r.megapixelsPerSecond;
+                    double scaling = single > 0 ? r.megapixelsPerSecond / single : 0;
+                    printf("%-22s %-10s %-34s %-7s %4u %4d %10.1f %9.3f %9.3f %7.2fx\n", c.name, BackendName(backend),
+                        image.name.c_str(), image.sampling.c_str(), image.restartInterval, threads,
+                        r.megapixelsPerSecond, r.p50Ms, r.p99Ms, scaling);
+                    if (csv)
+                        fprintf(csv, "%s,%s,%s,%d,%d,%s,%u,%d,%.2f,%.4f,%.4f,%.3f\n", c.name, BackendName(backend),
+                            image.name.c_str(), image.width, image.height, image.sampling.c_str(), image.restartInterval,
+                            threads, r.megapixelsPerSecond, r.p50Ms, r.p99Ms, scaling);
+                }
+                fflush(stdout);
+            }
+        }
+    }
+
+    if (csv) fclose(csv);
+    return 0;
+}
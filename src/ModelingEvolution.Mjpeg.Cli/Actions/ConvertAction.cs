@@ -1,7 +1,9 @@
 using System.Buffers;
 using System.CommandLine;
 using System.Diagnostics;
+using System.Runtime.InteropServices;
 using System.Text.Json;
+using System.Threading.Tasks.Dataflow;
 using Emgu.CV;
 using Emgu.CV.CvEnum;
 using ModelingEvolution.Mjpeg.Cli.Commands;
@@ -9,12 +11,11 @@ using ModelingEvolution.Mjpeg.Cli.Commands;
 namespace ModelingEvolution.Mjpeg.Cli.Actions;
 
 /// <summary>
-/// Executes the 'convert' command - converts MJPEG recording to MP4.
+/// Executes the 'convert' command - converts MJPEG recording to MP4, or transcodes it losslessly to MJPEG.
 /// </summary>
 public static class ConvertAction
 {
     private const int DefaultFps = 25;
-    private const int HdrJpegQuality = 100; // Lossless intermediate for HDR
 
     public static int Execute(ParseResult parseResult)
     {
@@ -24,10 +25,20 @@ public static class ConvertAction
         var hdrAlgorithm = parseResult.GetValue(ConvertCommand.HdrAlgorithmOption) ?? "avg";
         var fps = parseResult.GetValue(ConvertCommand.FpsOption);
         var codec = parseResult.GetValue(ConvertCommand.CodecOption) ?? "mp4v";
+        var workers = parseResult.GetValue(ConvertCommand.WorkersOption);
+        var transformName = parseResult.GetValue(ConvertCommand.TransformOption) ?? "none";
+        var crop = parseResult.GetValue(ConvertCommand.CropOption);
+        var stripMarkers = parseResult.GetValue(ConvertCommand.StripMarkersOption);
+
+        if (!TryParseTransform(transformName, crop, stripMarkers, out var transform, out var error))
+        {
+            Console.Error.WriteLine(error);
+            return 1;
+        }
 
         try
         {
-            return ExecuteCoreAsync(inputPath, outputFile, hdrWindow, hdrAlgorithm, fps, codec).GetAwaiter().GetResult();
+            return ExecuteCoreAsync(inputPath, outputFile, hdrWindow, hdrAlgorithm, fps, codec, workers, transform).GetAwaiter().GetResult();
         }
         catch (Exception ex)
         {
@@ -42,7 +53,9 @@ public static class ConvertAction
         int? hdrWindow,
         string hdrAlgorithm,
         int fps,
-        string codec)
+        string codec,
+        int workers,
+        JpegTransformOptions? transform)
     {
         if (!inputPath.Exists)
         {
@@ -91,7 +104,7 @@ public static class ConvertAction
         }
         else
         {
-            Console.Error.WriteLine("No index file found, scanning MJPEG for frame boundaries...");
+            Console.Error.WriteLine("No index file found, using frame index sidecar (scanning MJPEG if needed)...");
             (index, detectedFormat) = await MjpegScanner.ScanFileAsync(dataPath, fps);
 
             if (index.Count == 0)
@@ -113,11 +126,22 @@ public static class ConvertAction
         }
 
         var (width, height, components) = GetJpegInfo(firstBuffer);
+        var lossless = outputFile.Extension.Equals(".mjpeg", StringComparison.OrdinalIgnoreCase);
 
         Console.Error.WriteLine($"Dimensions: {width}x{height}");
+        if (transform is { } options)
+        {
+            // All frames share the first one's geometry, so it gives the transformed size
+            using var probe = new JpegCodecPool(width, height);
+            var transformed = new byte[MaxTransformSize(firstBuffer.Length)];
+            var length = probe.Transform(firstBuffer, transformed, options);
+            (width, height, _) = GetJpegInfo(transformed.AsSpan(0, length));
+            Console.Error.WriteLine($"Transform: {options.Transform}{(options.Crop is { } c ? $", crop {c.Width}x{c.Height}+{c.X}+{c.Y}" : "")} -> {width}x{height}");
+        }
         Console.Error.WriteLine($"Format: {detectedFormat} (components={components})");
         Console.Error.WriteLine($"Output: {outputFile.FullName}");
-        Console.Error.WriteLine($"Codec: {codec}, FPS: {fps}");
+        if (!lossless)
+            Console.Error.WriteLine($"Codec: {codec}, FPS: {fps}");
 
         // Validate HDR
         if (hdrWindow.HasValue && (hdrWindow.Value < 2 || hdrWindow.Value > 10))
@@ -126,15 +150,33 @@ public static class ConvertAction
             return 1;
         }
 
+        if (hdrWindow.HasValue && lossless)
+        {
+            Console.Error.WriteLine("HDR blending produces new pixels; write an MP4 or drop --hdr-window for a lossless transcode.");
+            return 1;
+        }
+
+        if (workers < 1)
+        {
+            Console.Error.WriteLine("Workers must be at least 1.");
+            return 1;
+        }
+
+        Console.Error.WriteLine($"Workers: {workers}");
+
         var sw = Stopwatch.StartNew();
 
-        if (hdrWindow.HasValue)
+        if (lossless)
         {
-            await ConvertWithHdrAsync(dataPath, index, outputFile.FullName, width, height, detectedFormat, hdrWindow.Value, hdrAlgorithm, fps, codec);
+            await ConvertLosslessAsync(dataPath, index, outputFile.FullName, width, height, transform ?? default, workers);
+        }
+        else if (hdrWindow.HasValue)
+        {
+            await ConvertWithHdrAsync(dataPath, index, outputFile.FullName, width, height, detectedFormat, hdrWindow.Value, hdrAlgorithm, fps, codec, workers, transform);
         }
         else
         {
-            await ConvertRawAsync(dataPath, index, outputFile.FullName, width, height, detectedFormat, fps, codec);
+            await ConvertRawAsync(dataPath, index, outputFile.FullName, width, height, detectedFormat, fps, codec, workers, transform);
         }
 
         sw.Stop();
@@ -152,7 +194,9 @@ public static class ConvertAction
         int hdrWindow,
         string algorithm,
         int fps,
-        string codec)
+        string codec,
+        int workers,
+        JpegTransformOptions? transform)
     {
         Console.Error.WriteLine($"HDR: window={hdrWindow}, algorithm={algorithm}");
 
@@ -161,98 +205,337 @@ public static class ConvertAction
             "weighted" => HdrBlendMode.Weighted,
             _ => HdrBlendMode.Average
         };
+        var weights = blendMode == HdrBlendMode.Weighted ? HdrWeights.CreateEqual(hdrWindow) : null;
 
         var rawFrameCount = index.Count;
         var logicalFrameCount = rawFrameCount / hdrWindow;
 
         Console.Error.WriteLine($"Raw frames: {rawFrameCount}, Output frames: {logicalFrameCount}");
 
-        using var reader = new RecordingFrameReader(dataPath, index);
-        using var engine = new MjpegHdrEngine(reader.ReadFrameAsync, width, height, quality: HdrJpegQuality)
+        // Fused decode + blend straight to raw pixels; no intermediate JPEG per HDR frame
+        using var pool = new JpegCodecPool(width, height);
+        using var writer = OpenVideoWriter(outputPath, codec, fps, width, height, pixelFormat);
+
+        var frameSize = FrameSize(width, height, pixelFormat);
+        var written = await RunPipelineAsync(dataPath, index, logicalFrameCount, hdrWindow, workers, jpegs =>
         {
-            PixelFormat = pixelFormat,
-            HdrFrameWindowCount = hdrWindow,
-            HdrMode = blendMode,
-            Weights = blendMode == HdrBlendMode.Weighted ? HdrWeights.CreateEqual(hdrWindow) : null
-        };
+            if (transform is { } options)
+                TransformFrames(pool, jpegs, options);
 
-        // Determine output color mode
-        var isColor = pixelFormat != PixelFormat.Gray8;
+            var jpegData = new ReadOnlyMemory<byte>[jpegs.Length];
+            for (int i = 0; i < jpegs.Length; i++)
+                jpegData[i] = jpegs[i].Memory;
 
-        using var writer = new VideoWriter(
-            outputPath,
-            VideoWriter.Fourcc(codec[0], codec[1], codec[2], codec[3]),
-            fps,
-            new System.Drawing.Size(width, height),
-            isColor);
+            var buffer = ArrayPool<byte>.Shared.Rent(frameSize);
+            try
+            {
+                var header = pool.DecodeBlend(pixelFormat, blendMode, jpegData, weights, buffer);
+                return ToMat(buffer, header);
+            }
+            finally
+            {
+                ArrayPool<byte>.Shared.Return(buffer);
+            }
+        }, mat => WriteFrame(writer, mat));
 
-        if (!writer.IsOpened)
-        {
-            throw new InvalidOperationException($"Failed to open video writer for: {outputPath}");
-        }
+        Console.Error.WriteLine($"Converted {written} HDR frames to MP4.");
+    }
+
+    private static async Task ConvertRawAsync(
+        string dataPath,
+        SortedList<ulong, FrameIndex> index,
+        string outputPath,
+        int width, int height,
+        PixelFormat pixelFormat,
+        int fps,
+        string codec,
+        int workers,
+        JpegTransformOptions? transform)
+    {
+        using var pool = new JpegCodecPool(width, height);
+        using var writer = OpenVideoWriter(outputPath, codec, fps, width, height, pixelFormat);
 
-        for (int logicalFrame = 0; logicalFrame < logicalFrameCount; logicalFrame++)
+        var frameSize = FrameSize(width, height, pixelFormat);
+        var written = await RunPipelineAsync(dataPath, index, index.Count, 1, workers, jpegs =>
         {
-            var rawFrameIndex = (ulong)((logicalFrame + 1) * hdrWindow - 1);
+            if (transform is { } options)
+                TransformFrames(pool, jpegs, options);
 
-            using var result = await engine.GetAsync(rawFrameIndex);
+            var buffer = ArrayPool<byte>.Shared.Rent(frameSize);
+            var decoder = pool.RentDecoder();
+            try
+            {
+                var header = pixelFormat == PixelFormat.Gray8
+                    ? pool.DecodeGray(decoder, jpegs[0].Memory, buffer)
+                    : pool.DecodeI420(decoder, jpegs[0].Memory, buffer);
+                return ToMat(buffer, header);
+            }
+            finally
+            {
+                pool.ReturnDecoder(decoder);
+                ArrayPool<byte>.Shared.Return(buffer);
+            }
+        }, mat => WriteFrame(writer, mat));
 
-            // Decode JPEG to Mat
-            using var mat = new Mat();
-            CvInvoke.Imdecode(result.Data.ToArray(), isColor ? ImreadModes.AnyColor : ImreadModes.Grayscale, mat);
+        Console.Error.WriteLine($"Converted {written} frames to MP4.");
+    }
 
-            writer.Write(mat);
+    /// <summary>
+    /// Transcodes every frame in the DCT domain into a new MJPEG recording with a matching .json index.
+    /// Frames are never decoded, so nothing is lost unless the transform crops or trims.
+    /// </summary>
+    private static async Task ConvertLosslessAsync(
+        string dataPath,
+        SortedList<ulong, FrameIndex> index,
+        string outputPath,
+        int width, int height,
+        JpegTransformOptions transform,
+        int workers)
+    {
+        using var pool = new JpegCodecPool(width, height);
+        await using var output = File.Create(outputPath);
+
+        var outputIndex = new SortedList<ulong, FrameIndex>(index.Count);
+        ulong offset = 0;
+        var written = await RunPipelineAsync(dataPath, index, index.Count, 1, workers,
+            jpegs => TransformFrame(pool, jpegs[0], transform),
+            jpeg =>
+            {
+                using (jpeg)
+                {
+                    var source = index.Values[outputIndex.Count];
+                    output.Write(jpeg.Memory.Span);
+                    outputIndex.Add(index.Keys[outputIndex.Count], source with { Start = offset, Size = (ulong)jpeg.Memory.Length });
+                    offset += (ulong)jpeg.Memory.Length;
+                }
+            });
+
+        var indexPath = Path.ChangeExtension(outputPath, ".json");
+        await File.WriteAllTextAsync(indexPath, JsonSerializer.Serialize(new RecordingMetadata { Index = outputIndex }));
+
+        Console.Error.WriteLine($"Transcoded {written} frames ({offset / 1024} KB), index: {indexPath}");
+    }
 
-            if ((logicalFrame + 1) % 100 == 0)
-                Console.Error.WriteLine($"Processed {logicalFrame + 1} frames...");
+    // Output buffer for one transformed frame: optimized Huffman tables, re-emitted headers and markers
+    private static int MaxTransformSize(int jpegLength) => jpegLength + jpegLength / 8 + 4096;
+
+    private static IMemoryOwner<byte> TransformFrame(JpegCodecPool pool, IMemoryOwner<byte> jpeg, in JpegTransformOptions options)
+    {
+        var source = jpeg.Memory;
+        var buffer = ArrayPool<byte>.Shared.Rent(MaxTransformSize(source.Length));
+        try
+        {
+            return new PooledArrayOwner(buffer, pool.Transform(source, buffer, options));
         }
+        catch
+        {
+            ArrayPool<byte>.Shared.Return(buffer);
+            throw;
+        }
+    }
 
-        Console.Error.WriteLine($"Converted {logicalFrameCount} HDR frames to MP4.");
+    // Replaces each frame by its transformed copy; the pipeline disposes whatever the array holds afterwards
+    private static void TransformFrames(JpegCodecPool pool, IMemoryOwner<byte>[] jpegs, in JpegTransformOptions options)
+    {
+        for (int i = 0; i < jpegs.Length; i++)
+        {
+            var transformed = TransformFrame(pool, jpegs[i], options);
+            jpegs[i].Dispose();
+            jpegs[i] = transformed;
+        }
     }
 
-    private static async Task ConvertRawAsync(
+    private static void WriteFrame(VideoWriter writer, Mat mat)
+    {
+        using (mat)
+            writer.Write(mat);
+    }
+
+    /// <summary>
+    /// Bounded read → parallel decode → ordered write. The reader stalls once every worker has
+    /// a backlog, so memory stays flat regardless of recording length. Output frame n is built from
+    /// raw frames n * framesPerOutput .. (n + 1) * framesPerOutput - 1, newest first like MjpegHdrEngine.
+    /// </summary>
+    private static async Task<int> RunPipelineAsync<T>(
         string dataPath,
         SortedList<ulong, FrameIndex> index,
-        string outputPath,
-        int width, int height,
-        PixelFormat pixelFormat,
-        int fps,
-        string codec)
+        int outputFrameCount,
+        int framesPerOutput,
+        int workers,
+        Func<IMemoryOwner<byte>[], T> decode,
+        Action<T> write)
     {
-        var isColor = pixelFormat != PixelFormat.Gray8;
+        using var reader = new RecordingFrameReader(dataPath, index);
 
-        using var writer = new VideoWriter(
+        var decodeBlock = new TransformBlock<IMemoryOwner<byte>[], T>(jpegs =>
+        {
+            try
+            {
+                return decode(jpegs);
+            }
+            finally
+            {
+                foreach (var jpeg in jpegs)
+                    jpeg.Dispose();
+            }
+        }, new ExecutionDataflowBlockOptions
+        {
+            MaxDegreeOfParallelism = workers,
+            BoundedCapacity = workers * 2,
+            EnsureOrdered = true
+        });
+
+        int written = 0;
+        var writeBlock = new ActionBlock<T>(frame =>
+        {
+            write(frame);
+
+            written++;
+            if (written % 100 == 0)
+                Console.Error.WriteLine($"Processed {written} frames...");
+        }, new ExecutionDataflowBlockOptions { BoundedCapacity = workers * 2 });
+
+        decodeBlock.LinkTo(writeBlock, new DataflowLinkOptions { PropagateCompletion = true });
+
+        // A failed writer must also release a reader blocked on a full decode queue
+        _ = writeBlock.Completion.ContinueWith(t => ((IDataflowBlock)decodeBlock).Fault(t.Exception!),
+            TaskContinuationOptions.OnlyOnFaulted);
+
+        try
+        {
+            for (int frame = 0; frame < outputFrameCount; frame++)
+            {
+                var newest = (ulong)((frame + 1) * framesPerOutput - 1);
+                var jpegs = new IMemoryOwner<byte>[framesPerOutput];
+                for (int i = 0; i < framesPerOutput; i++)
+                    jpegs[i] = await reader.ReadFrameAsync(newest - (ulong)i);
+
+                if (!await decodeBlock.SendAsync(jpegs))
+                {
+                    foreach (var jpeg in jpegs)
+                        jpeg.Dispose();
+                    break;
+                }
+            }
+        }
+        finally
+        {
+            decodeBlock.Complete();
+        }
+
+        // Surfaces the original exception of whichever stage failed first
+        await decodeBlock.Completion;
+        await writeBlock.Completion;
+        return written;
+    }
+
+    private static VideoWriter OpenVideoWriter(string outputPath, string codec, int fps, int width, int height, PixelFormat pixelFormat)
+    {
+        var writer = new VideoWriter(
             outputPath,
             VideoWriter.Fourcc(codec[0], codec[1], codec[2], codec[3]),
             fps,
             new System.Drawing.Size(width, height),
-            isColor);
+            pixelFormat != PixelFormat.Gray8);
 
         if (!writer.IsOpened)
         {
+            writer.Dispose();
             throw new InvalidOperationException($"Failed to open video writer for: {outputPath}");
         }
 
-        await using var fileStream = File.OpenRead(dataPath);
-        var frameIndex = 0;
+        return writer;
+    }
+
+    private static int FrameSize(int width, int height, PixelFormat pixelFormat) =>
+        FrameHeader.Create(width, height, pixelFormat).Length;
+
+    /// <summary>
+    /// Wraps decoded Gray8/I420 pixels as an OpenCV frame for VideoWriter (BGR for color output).
+    /// </summary>
+    private static Mat ToMat(byte[] buffer, in FrameHeader header)
+    {
+        if (header.Format == PixelFormat.Gray8)
+            return CopyToMat(buffer, header.Height, header.Width, 1, header.Stride, null);
+
+        // Odd sizes carry (W + 1) / 2 x (H + 1) / 2 chroma planes, which OpenCV's I420 layout cannot describe
+        int stride = header.Width * 4;
+        var bgra = ArrayPool<byte>.Shared.Rent(stride * header.Height);
+        try
+        {
+            YuvConverter.I420ToBgra(header, buffer.AsSpan(0, header.Length), bgra, PixelFormat.Bgra32, stride);
+            return CopyToMat(bgra, header.Height, header.Width, 4, stride, ColorConversion.Bgra2Bgr);
+        }
+        finally
+        {
+            ArrayPool<byte>.Shared.Return(bgra);
+        }
+    }
+
+    // Copies pinned 8-bit pixels into a Mat of its own, converting them when a conversion is given
+    private static Mat CopyToMat(byte[] pixels, int rows, int cols, int channels, int step, ColorConversion? conversion)
+    {
+        var handle = GCHandle.Alloc(pixels, GCHandleType.Pinned);
+        try
+        {
+            using var view = new Mat(rows, cols, DepthType.Cv8U, channels, handle.AddrOfPinnedObject(), step);
+            if (conversion == null)
+                return view.Clone();
 
-        foreach (var (sequence, frame) in index)
+            var converted = new Mat();
+            CvInvoke.CvtColor(view, converted, conversion.Value);
+            return converted;
+        }
+        finally
         {
-            var buffer = new byte[frame.Size];
-            fileStream.Seek((long)frame.Start, SeekOrigin.Begin);
-            await fileStream.ReadExactlyAsync(buffer);
+            handle.Free();
+        }
+    }
 
-            using var mat = new Mat();
-            CvInvoke.Imdecode(buffer, isColor ? ImreadModes.AnyColor : ImreadModes.Grayscale, mat);
+    /// <summary>
+    /// Parses --transform/--crop/--strip-markers; null options when none of them asks for a transcode.
+    /// </summary>
+    private static bool TryParseTransform(string name, string? crop, bool stripMarkers,
+        out JpegTransformOptions? options, out string? error)
+    {
+        options = null;
+        error = null;
 
-            writer.Write(mat);
+        JpegTransform transform;
+        switch (name.ToLowerInvariant())
+        {
+            case "none": transform = JpegTransform.None; break;
+            case "rot90": transform = JpegTransform.Rotate90; break;
+            case "rot180": transform = JpegTransform.Rotate180; break;
+            case "rot270": transform = JpegTransform.Rotate270; break;
+            case "hflip": transform = JpegTransform.FlipHorizontal; break;
+            case "vflip": transform = JpegTransform.FlipVertical; break;
+            case "transpose": transform = JpegTransform.Transpose; break;
+            case "transverse": transform = JpegTransform.Transverse; break;
+            default:
+                error = $"Unknown transform: {name}. Use none, rot90, rot180, rot270, hflip, vflip, transpose or transverse.";
+                return false;
+        }
 
-            frameIndex++;
-            if (frameIndex % 100 == 0)
-                Console.Error.WriteLine($"Processed {frameIndex} frames...");
+        CropRegion? region = null;
+        if (crop != null)
+        {
+            // WxH+X+Y, as jpegtran -crop
+            var parts = crop.Split('x', '+');
+            if (parts.Length != 4
+                || !int.TryParse(parts[0], out var w) || !int.TryParse(parts[1], out var h)
+                || !int.TryParse(parts[2], out var x) || !int.TryParse(parts[3], out var y)
+                || w <= 0 || h <= 0 || x < 0 || y < 0)
+            {
+                error = $"Invalid crop: {crop}. Expected WxH+X+Y, e.g. 1280x720+320+176.";
+                return false;
+            }
+            region = new CropRegion(x, y, w, h);
         }
 
-        Console.Error.WriteLine($"Converted {frameIndex} frames to MP4.");
+        if (transform != JpegTransform.None || region != null || stripMarkers)
+            options = new JpegTransformOptions(transform, region, StripMarkers: stripMarkers);
+        return true;
     }
 
     private static async Task<PixelFormat> DetectFormatFromFirstFrameAsync(string dataPath, SortedList<ulong, FrameIndex> index)
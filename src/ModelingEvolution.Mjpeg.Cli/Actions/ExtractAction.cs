@@ -77,7 +77,7 @@ public static class ExtractAction
         else
         {
             // Fallback: scan MJPEG for frame boundaries
-            Console.Error.WriteLine("No index file found, scanning MJPEG for frame boundaries...");
+            Console.Error.WriteLine("No index file found, using frame index sidecar (scanning MJPEG if needed)...");
 
             var (index, format) = await MjpegScanner.ScanFileAsync(dataPath, DefaultFps);
 
@@ -241,7 +241,8 @@ public static class ExtractAction
             PixelFormat = pixelFormat,
             HdrFrameWindowCount = hdrWindow,
             HdrMode = blendMode,
-            Weights = blendMode == HdrBlendMode.Weighted ? HdrWeights.CreateEqual(hdrWindow) : null
+            Weights = blendMode == HdrBlendMode.Weighted ? HdrWeights.CreateEqual(hdrWindow) : null,
+            FusedDecodeBlend = true
         };
 
         for (int logicalFrame = 0; logicalFrame < logicalFrameCount; logicalFrame++)
@@ -3,7 +3,7 @@ using System.CommandLine;
 namespace ModelingEvolution.Mjpeg.Cli.Commands;
 
 /// <summary>
-/// Defines the 'convert' subcommand for converting MJPEG recordings to MP4.
+/// Defines the 'convert' subcommand for converting MJPEG recordings to MP4, or losslessly to another MJPEG recording.
 /// </summary>
 public static class ConvertCommand
 {
@@ -14,7 +14,7 @@ public static class ConvertCommand
 
     public static readonly Option<FileInfo> OutputFileOption = new("--output")
     {
-        Description = "Output MP4 file path",
+        Description = "Output MP4 file path, or a .mjpeg file for a lossless transcode (written with a .json index next to it)",
         Required = true
     };
 
@@ -41,16 +41,42 @@ public static class ConvertCommand
         DefaultValueFactory = _ => "mp4v"
     };
 
+    public static readonly Option<int> WorkersOption = new("--workers")
+    {
+        Description = "Parallel decode/blend workers. Default: processor count",
+        DefaultValueFactory = _ => Environment.ProcessorCount
+    };
+
+    public static readonly Option<string> TransformOption = new("--transform")
+    {
+        Description = "Lossless DCT-domain transform of every frame: none, rot90, rot180, rot270, hflip, vflip, transpose, transverse. Default: none",
+        DefaultValueFactory = _ => "none"
+    };
+
+    public static readonly Option<string?> CropOption = new("--crop")
+    {
+        Description = "Lossless crop WxH+X+Y of the transformed frame; X and Y snap down to the MCU grid (16 px for 4:2:0)"
+    };
+
+    public static readonly Option<bool> StripMarkersOption = new("--strip-markers")
+    {
+        Description = "Drop APPn (EXIF, ICC, ...) and COM segments from transcoded frames"
+    };
+
     public static Command Create(Func<ParseResult, int> handler)
     {
-        var command = new Command("convert", "Convert MJPEG recording to MP4 video")
+        var command = new Command("convert", "Convert MJPEG recording to MP4 video or transcode it losslessly")
         {
             InputPathArgument,
             OutputFileOption,
             HdrWindowOption,
             HdrAlgorithmOption,
             FpsOption,
-            CodecOption
+            CodecOption,
+            WorkersOption,
+            TransformOption,
+            CropOption,
+            StripMarkersOption
         };
 
         command.SetAction(handler);
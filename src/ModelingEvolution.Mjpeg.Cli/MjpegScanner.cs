@@ -2,72 +2,18 @@ using System.Runtime.CompilerServices;
 
 namespace ModelingEvolution.Mjpeg.Cli;
 
-/// <summary>
-/// Represents detected JPEG markers during MJPEG stream decoding.
-/// </summary>
-internal enum JpegMarker
-{
-    None,
-    Start,  // SOI (0xFF 0xD8)
-    End     // EOI (0xFF 0xD9)
-}
-
 /// <summary>
 /// Information about a detected JPEG frame within an MJPEG stream.
 /// </summary>
 internal readonly record struct FrameInfo(long StartOffset, long Size, ulong FrameIndex);
 
-/// <summary>
-/// State machine decoder for detecting JPEG frame boundaries in MJPEG streams.
-/// </summary>
-internal sealed class MjpegDecoder
-{
-    private Func<byte, JpegMarker?> _state;
-
-    public MjpegDecoder() => _state = DetectStart_1;
-
-    private JpegMarker? DetectStart_1(byte b)
-    {
-        if (b == 0xFF) _state = DetectStart_2;
-        return null;
-    }
-
-    private JpegMarker? DetectStart_2(byte b)
-    {
-        if (b == 0xD8)
-        {
-            _state = DetectEnd_1;
-            return JpegMarker.Start;
-        }
-        _state = DetectStart_1;
-        return null;
-    }
-
-    private JpegMarker? DetectEnd_1(byte b)
-    {
-        if (b == 0xFF) _state = DetectEnd_2;
-        return null;
-    }
-
-    private JpegMarker? DetectEnd_2(byte b)
-    {
-        if (b == 0xD9)
-        {
-            _state = DetectStart_1;
-            return JpegMarker.End;
-        }
-        _state = DetectEnd_1;
-        return null;
-    }
-
-    public JpegMarker Decode(byte b) => _state(b) ?? JpegMarker.None;
-}
-
 /// <summary>
 /// Scans MJPEG streams to extract frame boundary information.
 /// </summary>
 internal static class MjpegScanner
 {
+    private const int ScanBufferSize = 1024 * 1024;
+
     /// <summary>
     /// Scans a stream and yields frame information for each detected JPEG frame.
     /// </summary>
@@ -76,11 +22,9 @@ internal static class MjpegScanner
         int bufferSize = 64 * 1024,
         [EnumeratorCancellation] CancellationToken cancellationToken = default)
     {
-        var decoder = new MjpegDecoder();
+        var scanner = new FrameBoundaryScanner();
         var buffer = new byte[bufferSize];
-        long position = 0;
-        long frameStart = -1;
-        ulong frameIndex = 0;
+        var frames = new List<ModelingEvolution.Mjpeg.FrameInfo>();
 
         while (true)
         {
@@ -89,45 +33,68 @@ internal static class MjpegScanner
             var bytesRead = await stream.ReadAsync(buffer, cancellationToken);
             if (bytesRead == 0) break;
 
-            for (var i = 0; i < bytesRead; i++)
-            {
-                var absolutePosition = position + i;
-                var marker = decoder.Decode(buffer[i]);
-
-                switch (marker)
-                {
-                    case JpegMarker.Start when frameStart < 0:
-                        frameStart = absolutePosition - 1; // -1 for 2-byte SOI marker
-                        break;
-
-                    case JpegMarker.End when frameStart >= 0:
-                        var frameSize = absolutePosition - frameStart + 1;
-                        yield return new FrameInfo(frameStart, frameSize, frameIndex);
-                        frameIndex++;
-                        frameStart = -1;
-                        break;
-                }
-            }
-
-            position += bytesRead;
+            scanner.Scan(buffer.AsSpan(0, bytesRead), frames);
+            foreach (var frame in frames)
+                yield return new FrameInfo(frame.StartOffset, frame.Size, frame.FrameIndex);
+            frames.Clear();
         }
     }
 
     /// <summary>
-    /// Scans an MJPEG file and builds a frame index with format detection.
+    /// Builds a frame index for an MJPEG file with format detection.
+    /// Uses the file's <see cref="MjpegFrameIndex"/> sidecar, creating or extending it as needed,
+    /// and falls back to a plain scan when the sidecar cannot be written.
     /// </summary>
     public static async Task<(SortedList<ulong, FrameIndex> Index, PixelFormat Format)> ScanFileAsync(
         string filePath,
         int assumedFps = 25,
         CancellationToken ct = default)
+    {
+        MjpegFrameIndex frameIndex;
+        try
+        {
+            frameIndex = await MjpegFrameIndex.BuildAsync(filePath, cancellationToken: ct);
+        }
+        catch (Exception ex) when (ex is IOException or UnauthorizedAccessException)
+        {
+            return await ScanWithoutSidecarAsync(filePath, assumedFps, ct);
+        }
+
+        using (frameIndex)
+        {
+            var index = new SortedList<ulong, FrameIndex>(frameIndex.Count);
+            var frameIntervalMicroseconds = (ulong)(1_000_000 / assumedFps);
+
+            for (int i = 0; i < frameIndex.Count; i++)
+            {
+                var frame = frameIndex[i];
+                index.Add(frame.FrameIndex, new FrameIndex
+                {
+                    Start = (ulong)frame.StartOffset,
+                    Size = (ulong)frame.Size,
+                    RelativeTimestampMicroseconds = frame.FrameIndex * frameIntervalMicroseconds
+                });
+            }
+
+            var format = frameIndex.Subsampling == ChromaSubsampling.Gray ? PixelFormat.Gray8 : PixelFormat.I420;
+            return (index, format);
+        }
+    }
+
+    private static async Task<(SortedList<ulong, FrameIndex> Index, PixelFormat Format)> ScanWithoutSidecarAsync(
+        string filePath,
+        int assumedFps,
+        CancellationToken ct)
     {
         var index = new SortedList<ulong, FrameIndex>();
         var format = PixelFormat.I420; // Default
         var frameIntervalMicroseconds = (ulong)(1_000_000 / assumedFps);
 
-        await using var stream = File.OpenRead(filePath);
+        // The scanner keeps up with sequential disk reads, so read in large blocks without FileStream buffering
+        await using var stream = new FileStream(filePath, FileMode.Open, FileAccess.Read, FileShare.Read,
+            bufferSize: 0, FileOptions.SequentialScan);
 
-        await foreach (var frame in ScanAsync(stream, cancellationToken: ct))
+        await foreach (var frame in ScanAsync(stream, ScanBufferSize, ct))
         {
             // Detect format from first frame
             if (frame.FrameIndex == 0)
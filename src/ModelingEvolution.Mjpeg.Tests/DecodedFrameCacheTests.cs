@@ -0,0 +1,86 @@
+using FluentAssertions;
+using Xunit;
+
+namespace ModelingEvolution.Mjpeg.Tests;
+
+public class DecodedFrameCacheTests
+{
+    private static DecodedFrameHandle CreateFrame(byte value, int length = 6)
+    {
+        var frame = DecodedFrameHandle.Rent(new FrameHeader(2, 2, 2, PixelFormat.I420, length));
+        frame.AsFrameImage().GetWritableData().Span.Fill(value);
+        return frame;
+    }
+
+    [Fact]
+    public void TryGet_AfterAdd_ShouldReturnFrame()
+    {
+        using var cache = new DecodedFrameCache(1024);
+        using var frame = CreateFrame(7);
+
+        cache.Add(1, PixelFormat.I420, frame).Should().BeTrue();
+
+        cache.TryGet(1, PixelFormat.I420, out var cached).Should().BeTrue();
+        using (cached)
+        {
+            cached.Data.ToArray().Should().AllBeEquivalentTo((byte)7);
+        }
+        cache.TryGet(1, PixelFormat.Gray8, out _).Should().BeFalse();
+        cache.Hits.Should().Be(1);
+        cache.Misses.Should().Be(1);
+    }
+
+    [Fact]
+    public void Add_OverBudget_ShouldEvictLeastRecentlyUsed()
+    {
+        using var cache = new DecodedFrameCache(12);
+        using var a = CreateFrame(1);
+        using var b = CreateFrame(2);
+        using var c = CreateFrame(3);
+
+        cache.Add(1, PixelFormat.I420, a);
+        cache.Add(2, PixelFormat.I420, b);
+
+        // Touch frame 1 so frame 2 becomes the eviction candidate
+        cache.TryGet(1, PixelFormat.I420, out var touched).Should().BeTrue();
+        touched.Dispose();
+
+        cache.Add(3, PixelFormat.I420, c);
+
+        cache.Count.Should().Be(2);
+        cache.SizeBytes.Should().Be(12);
+        cache.TryGet(2, PixelFormat.I420, out _).Should().BeFalse();
+        cache.TryGet(1, PixelFormat.I420, out var first).Should().BeTrue();
+        first.Dispose();
+    }
+
+    [Fact]
+    public void Evict_WhileBorrowed_ShouldKeepDataAlive()
+    {
+        using var cache = new DecodedFrameCache(6);
+        var frame = CreateFrame(9);
+        cache.Add(1, PixelFormat.I420, frame);
+        frame.Dispose();
+
+        cache.TryGet(1, PixelFormat.I420, out var borrowed).Should().BeTrue();
+        using var other = CreateFrame(4);
+        cache.Add(2, PixelFormat.I420, other);
+
+        // Evicted from the cache but the borrowed reference still holds the buffer
+        borrowed.TryAddRef().Should().BeTrue();
+        borrowed.Dispose();
+        borrowed.Data.ToArray().Should().AllBeEquivalentTo((byte)9);
+        borrowed.Dispose();
+    }
+
+    [Fact]
+    public void Add_FrameLargerThanBudget_ShouldNotCache()
+    {
+        using var cache = new DecodedFrameCache(4);
+        using var frame = CreateFrame(1);
+
+        cache.Add(1, PixelFormat.I420, frame).Should().BeFalse();
+
+        cache.Count.Should().Be(0);
+    }
+}
@@ -83,6 +83,21 @@ public class FrameHeaderTests
         bpp.Should().Be(expectedBpp);
     }
 
+    [Theory]
+    [InlineData(PixelFormat.I420, 640, 480, 640 * 480 + 2 * 320 * 240)]
+    [InlineData(PixelFormat.I420, 101, 77, 101 * 77 + 2 * 51 * 39)]
+    [InlineData(PixelFormat.I422, 101, 77, 101 * 77 + 2 * 51 * 77)]
+    [InlineData(PixelFormat.I444, 101, 77, 101 * 77 * 3)]
+    [InlineData(PixelFormat.Nv12, 101, 77, 101 * 77 + 2 * 51 * 39)]
+    public void Create_PlanarYuv_ShouldRoundChromaPlanesUp(PixelFormat format, int width, int height, int expectedLength)
+    {
+        var header = FrameHeader.Create(width, height, format);
+
+        header.Stride.Should().Be(width);
+        header.Length.Should().Be(expectedLength);
+        header.IsValid.Should().BeTrue();
+    }
+
     [Fact]
     public void FrameHeader_Equality_ShouldWork()
     {
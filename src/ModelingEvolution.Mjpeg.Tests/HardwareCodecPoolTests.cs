@@ -0,0 +1,91 @@
+using FluentAssertions;
+using Xunit;
+
+namespace ModelingEvolution.Mjpeg.Tests;
+
+/// <summary>
+/// Tests for HardwareCodecPool. Build machines have no V4L2 JPEG engine, so these cover the libjpeg fallback;
+/// on a device the headers still match and the counters move to the hardware side.
+/// </summary>
+public class HardwareCodecPoolTests
+{
+    private const int Width = 64;
+    private const int Height = 48;
+
+    private static byte[] EncodeNoiseI420(JpegCodecPool pool, int seed)
+    {
+        var frameData = new byte[Width * Height * 3 / 2];
+        new Random(seed).NextBytes(frameData);
+
+        var encoder = pool.RentEncoder();
+        try
+        {
+            var output = new byte[frameData.Length * 2];
+            int length = pool.EncodeI420(encoder, frameData, output);
+            return output.AsSpan(0, length).ToArray();
+        }
+        finally
+        {
+            pool.ReturnEncoder(encoder);
+        }
+    }
+
+    [Fact]
+    public void DecodeI420_ShouldMatchCpuPool()
+    {
+        using var cpu = new JpegCodecPool(Width, Height);
+        using var pool = new HardwareCodecPool(Width, Height, devicePath: HardwareCodecPool.IsAvailable() ? null : "/dev/null");
+        var jpeg = EncodeNoiseI420(cpu, 1);
+
+        var expected = new byte[Width * Height * 3 / 2];
+        var actual = new byte[expected.Length];
+        var cpuDecoder = cpu.RentDecoder();
+        var decoder = pool.RentDecoder();
+        try
+        {
+            var expectedHeader = cpu.DecodeI420(cpuDecoder, jpeg, expected);
+            var header = pool.DecodeI420(decoder, jpeg, actual);
+
+            header.Should().Be(expectedHeader);
+            if (!pool.IsHardwareAccelerated)
+                actual.Should().Equal(expected);
+        }
+        finally
+        {
+            cpu.ReturnDecoder(cpuDecoder);
+            pool.ReturnDecoder(decoder);
+        }
+
+        (pool.HardwareDecodes + pool.FallbackDecodes).Should().Be(1);
+    }
+
+    [Fact]
+    public void WithoutDevice_ShouldDecodeEverythingOnCpu()
+    {
+        using var pool = new HardwareCodecPool(Width, Height, devicePath: "/dev/null");
+        pool.IsHardwareAccelerated.Should().BeFalse();
+
+        const int count = 3;
+        var jpegs = new ReadOnlyMemory<byte>[count];
+        var outputs = new Memory<byte>[count];
+        for (int i = 0; i < count; i++)
+        {
+            jpegs[i] = EncodeNoiseI420(pool.Fallback, i);
+            outputs[i] = new byte[Width * Height];
+        }
+        var headers = new FrameHeader[count];
+
+        pool.DecodeBatch(PixelFormat.Gray8, jpegs, outputs, headers);
+
+        headers.Should().AllSatisfy(h => h.Should().Be(new FrameHeader(Width, Height, Width, PixelFormat.Gray8, Width * Height)));
+        pool.FallbackDecodes.Should().Be(count);
+        pool.HardwareDecodes.Should().Be(0);
+    }
+
+    [Fact]
+    public void NegativeMaxHandles_ShouldThrow()
+    {
+        var act = () => new HardwareCodecPool(Width, Height, maxHandles: -1);
+        act.Should().Throw<ArgumentOutOfRangeException>();
+    }
+}
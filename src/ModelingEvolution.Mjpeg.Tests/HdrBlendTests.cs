@@ -418,4 +418,115 @@ public class HdrBlendTests
     }
 
     #endregion
+
+    #region Vector Kernel Tests - bit-exact with the scalar reference formulas
+
+    // 1000 leaves a 16-byte and a scalar tail after the 32-byte blocks
+    private const int OddLength = 1000 + 16 + 7;
+
+    private static FrameImage RandomFrame(int seed)
+    {
+        var data = new byte[OddLength];
+        new Random(seed).NextBytes(data);
+        return new FrameImage(new FrameHeader(OddLength, 1, OddLength, PixelFormat.Gray8, OddLength), data);
+    }
+
+    [Fact]
+    public void Average_TwoFrames_Vectorized_ShouldMatchReference()
+    {
+        var a = RandomFrame(1);
+        var b = RandomFrame(2);
+        var output = new byte[OddLength];
+
+        _blend.Average(a, b, output);
+
+        for (int i = 0; i < OddLength; i++)
+            output[i].Should().Be((byte)((a.Data.Span[i] + b.Data.Span[i] + 1) >> 1));
+    }
+
+    [Fact]
+    public void Average_ThreeFrames_Vectorized_ShouldMatchReferenceForAllSums()
+    {
+        // Cover every sum 0..765 so the multiply-shift division by 3 is checked exhaustively
+        var a = new byte[OddLength];
+        var b = new byte[OddLength];
+        var c = new byte[OddLength];
+        for (int i = 0; i < OddLength; i++)
+        {
+            int sum = i % 766;
+            a[i] = (byte)Math.Min(sum, 255);
+            b[i] = (byte)Math.Min(sum - a[i], 255);
+            c[i] = (byte)(sum - a[i] - b[i]);
+        }
+        var header = new FrameHeader(OddLength, 1, OddLength, PixelFormat.Gray8, OddLength);
+        var output = new byte[OddLength];
+
+        _blend.Average(new FrameImage(header, a), new FrameImage(header, b), new FrameImage(header, c), output);
+
+        for (int i = 0; i < OddLength; i++)
+            output[i].Should().Be((byte)((a[i] + b[i] + c[i] + 1) / 3));
+    }
+
+    [Fact]
+    public void Weighted_TwoFrames_Vectorized_ShouldMatchReference()
+    {
+        var a = RandomFrame(3);
+        var b = RandomFrame(4);
+        var weights = new byte[512];
+        new Random(5).NextBytes(weights);
+        var hdrWeights = new HdrWeights(weights, 2, 1);
+        var output = new byte[OddLength];
+
+        _blend.Weighted(a, b, hdrWeights, output);
+
+        for (int i = 0; i < OddLength; i++)
+        {
+            int p0 = a.Data.Span[i], p1 = b.Data.Span[i];
+            int wb = (p0 + p1) & ~1;
+            int expected = Math.Min((p0 * weights[wb] + p1 * weights[wb + 1]) >> 8, 255);
+            output[i].Should().Be((byte)expected);
+        }
+    }
+
+    [Fact]
+    public void Weighted_ThreeFrames_Vectorized_ShouldMatchReference()
+    {
+        var a = RandomFrame(6);
+        var b = RandomFrame(7);
+        var c = RandomFrame(8);
+        var weights = new byte[768];
+        new Random(9).NextBytes(weights);
+        var hdrWeights = new HdrWeights(weights, 3, 1);
+        var output = new byte[OddLength];
+
+        _blend.Weighted(a, b, c, hdrWeights, output);
+
+        for (int i = 0; i < OddLength; i++)
+        {
+            int p0 = a.Data.Span[i], p1 = b.Data.Span[i], p2 = c.Data.Span[i];
+            int lum = (p0 + p1 + p2) / 3;
+            int sum = p0 * weights[lum * 3] + p1 * weights[lum * 3 + 1] + p2 * weights[lum * 3 + 2];
+            output[i].Should().Be((byte)Math.Min(sum >> 8, 255));
+        }
+    }
+
+    [Fact]
+    public void GrayToRgb_Vectorized_ShouldInterleaveAllPixels()
+    {
+        var r = RandomFrame(10);
+        var g = RandomFrame(11);
+        var b = RandomFrame(12);
+        var output = new byte[OddLength * 3];
+
+        _blend.GrayToRgb(r, g, b, output);
+
+        for (int i = 0; i < OddLength; i++)
+        {
+            output[i * 3].Should().Be(r.Data.Span[i]);
+            output[i * 3 + 1].Should().Be(g.Data.Span[i]);
+            output[i * 3 + 2].Should().Be(b.Data.Span[i]);
+        }
+    }
+
+    #endregion
 }
@@ -0,0 +1,1031 @@
+using System.Buffers;
+using FluentAssertions;
+using Xunit;
+
+namespace ModelingEvolution.Mjpeg.Tests;
+
+/// <summary>
+/// Tests for JpegCodecPool that require the native LibJpegWrap library.
+/// </summary>
+public class JpegCodecPoolTests
+{
+    private static byte[] EncodeNoiseI420(JpegCodecPool pool, int width, int height, int seed)
+    {
+        var frameData = new byte[width * height * 3 / 2];
+        new Random(seed).NextBytes(frameData);
+
+        var encoder = pool.RentEncoder();
+        try
+        {
+            var output = new byte[frameData.Length * 2];
+            int length = pool.EncodeI420(encoder, frameData, output);
+            return output.AsSpan(0, length).ToArray();
+        }
+        finally
+        {
+            pool.ReturnEncoder(encoder);
+        }
+    }
+
+    [Fact]
+    public void DecodeBatch_I420_ShouldMatchSingleDecodes()
+    {
+        const int width = 64;
+        const int height = 48;
+        const int count = 5;
+        using var pool = new JpegCodecPool(width, height);
+
+        var jpegs = new ReadOnlyMemory<byte>[count];
+        var outputs = new Memory<byte>[count];
+        for (int i = 0; i < count; i++)
+        {
+            jpegs[i] = EncodeNoiseI420(pool, width, height, i);
+            outputs[i] = new byte[width * height * 3 / 2];
+        }
+        var headers = new FrameHeader[count];
+
+        pool.DecodeBatch(PixelFormat.I420, jpegs, outputs, headers);
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            for (int i = 0; i < count; i++)
+            {
+                var expected = new byte[width * height * 3 / 2];
+                var expectedHeader = pool.DecodeI420(decoder, jpegs[i], expected);
+
+                headers[i].Should().Be(expectedHeader);
+                outputs[i].ToArray().Should().Equal(expected);
+            }
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    private static FrameImage[] DecodeAll(JpegCodecPool pool, ReadOnlyMemory<byte>[] jpegs, int width, int height)
+    {
+        var outputs = new Memory<byte>[jpegs.Length];
+        for (int i = 0; i < jpegs.Length; i++)
+            outputs[i] = new byte[width * height * 3 / 2];
+        var headers = new FrameHeader[jpegs.Length];
+
+        pool.DecodeBatch(PixelFormat.I420, jpegs, outputs, headers);
+
+        var frames = new FrameImage[jpegs.Length];
+        for (int i = 0; i < jpegs.Length; i++)
+            frames[i] = new FrameImage(headers[i], outputs[i]);
+        return frames;
+    }
+
+    [Fact]
+    public void DecodeBlend_Average_ShouldMatchDecodeThenBlend()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+        var jpegs = new ReadOnlyMemory<byte>[3];
+        for (int i = 0; i < jpegs.Length; i++)
+            jpegs[i] = EncodeNoiseI420(pool, width, height, i);
+
+        var frames = DecodeAll(pool, jpegs, width, height);
+        var expected = new byte[width * height * 3 / 2];
+        new HdrBlend().Average(frames[0], frames[1], frames[2], expected);
+
+        var actual = new byte[expected.Length];
+        var header = pool.DecodeBlend(PixelFormat.I420, HdrBlendMode.Average, jpegs, null, actual);
+
+        header.Should().Be(frames[0].Header);
+        actual.Should().Equal(expected);
+    }
+
+    [Fact]
+    public void DecodeBlend_Weighted_ShouldMatchDecodeThenBlend()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+        var jpegs = new ReadOnlyMemory<byte>[2];
+        for (int i = 0; i < jpegs.Length; i++)
+            jpegs[i] = EncodeNoiseI420(pool, width, height, i + 10);
+        var weights = HdrWeights.CreateLinear2Frame();
+
+        var frames = DecodeAll(pool, jpegs, width, height);
+        var expected = new byte[width * height * 3 / 2];
+        new HdrBlend().Weighted(frames[0], frames[1], weights, expected);
+
+        var actual = new byte[expected.Length];
+        pool.DecodeBlend(PixelFormat.I420, HdrBlendMode.Weighted, jpegs, weights, actual);
+
+        actual.Should().Equal(expected);
+    }
+
+    [Fact]
+    public void DecodeI420_StripeThreads_ShouldMatchSerialDecode()
+    {
+        const int width = 128;
+        const int height = 72;
+        using var serialPool = new JpegCodecPool(width, height, restartRows: 1);
+        using var stripedPool = new JpegCodecPool(width, height, stripeThreads: 3, restartRows: 1);
+        var jpeg = EncodeNoiseI420(serialPool, width, height, 42);
+
+        var expected = new byte[width * height * 3 / 2];
+        var actual = new byte[expected.Length];
+
+        var serial = serialPool.RentDecoder();
+        var striped = stripedPool.RentDecoder();
+        try
+        {
+            var expectedHeader = serialPool.DecodeI420(serial, jpeg, expected);
+            var actualHeader = stripedPool.DecodeI420(striped, jpeg, actual);
+
+            actualHeader.Should().Be(expectedHeader);
+            actual.Should().Equal(expected);
+        }
+        finally
+        {
+            serialPool.ReturnDecoder(serial);
+            stripedPool.ReturnDecoder(striped);
+        }
+    }
+
+    [Fact]
+    public void DecodeI420_Scaled_ShouldDecodeAtReducedSize()
+    {
+        const int width = 128;
+        const int height = 72;
+        using var pool = new JpegCodecPool(width, height);
+        var jpeg = EncodeNoiseI420(pool, width, height, 7);
+
+        int scaledWidth = DecodeScale.Quarter.Apply(width);
+        int scaledHeight = DecodeScale.Quarter.Apply(height);
+        var i420 = new byte[scaledWidth * scaledHeight * 3 / 2];
+        var gray = new byte[scaledWidth * scaledHeight];
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            var header = pool.DecodeI420(decoder, jpeg, i420, DecodeScale.Quarter);
+            var grayHeader = pool.DecodeGray(decoder, jpeg, gray, DecodeScale.Quarter);
+
+            header.Width.Should().Be(32);
+            header.Height.Should().Be(18);
+            header.Format.Should().Be(PixelFormat.I420);
+            header.Length.Should().Be(i420.Length);
+            grayHeader.Width.Should().Be(32);
+            grayHeader.Height.Should().Be(18);
+
+            // Both paths run the same scaled luma IDCT
+            i420.AsSpan(0, gray.Length).ToArray().Should().Equal(gray);
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    // 17x9 colour gradients from libjpeg with 2x1 and 1x1 luma sampling; EncodeI420 only writes 4:2:0
+    private static readonly byte[] Jpeg422 = Convert.FromBase64String(
+        "/9j/2wBDAAMCAgMCAgMDAwMEAwMEBQgFBQQEBQoHBwYIDAoMDAsKCwsNDhIQDQ4RDgsLEBYQERMUFRUVDA8XGBYUGBIUFRT/2wBD" +
+        "AQMEBAUEBQkFBQkUDQsNFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBT/wAARCAAJABED" +
+        "ASEAAhEBAxEB/8QAFgABAQEAAAAAAAAAAAAAAAAABgAH/8QAHRAAAgEEAwAAAAAAAAAAAAAAAAWiCBgkMkFCZP/EABgBAQADAQAA" +
+        "AAAAAAAAAAAAAAgEBgcJ/8QAHREAAQIHAAAAAAAAAAAAAAAAAAYHFiIzQ1Figf/aAAwDAQACEQMRAD8AypNTTrixHiamnXFiXV21" +
+        "VUmySmvWtObAhto8kSA3FWwxY12NpTdR2m4N0du505Wthb4ISA6MY//Z");
+
+    private static readonly byte[] Jpeg444 = Convert.FromBase64String(
+        "/9j/2wBDAAMCAgMCAgMDAwMEAwMEBQgFBQQEBQoHBwYIDAoMDAsKCwsNDhIQDQ4RDgsLEBYQERMUFRUVDA8XGBYUGBIUFRT/2wBD" +
+        "AQMEBAUEBQkFBQkUDQsNFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBT/wAARCAAJABED" +
+        "AREAAhEBAxEB/8QAFQABAQAAAAAAAAAAAAAAAAAABgf/xAAdEAACAQQDAAAAAAAAAAAAAAAABaIIGCQyQUJk/8QAFgEBAQEAAAAA" +
+        "AAAAAAAAAAAACAcJ/8QAGhEAAgMBAQAAAAAAAAAAAAAAAAYiMkIWYv/aAAwDAQACEQMRAD8AlSamnXFiKBuarSJYrutZDxNTTrix" +
+        "BS3NVpC6V3WshDbR5IkG6r0WjtfRaU3Ub7doxQV8jtNwCpu0LpXyISDlpP/Z");
+
+    [Theory]
+    [InlineData(false, PixelFormat.I422)]
+    [InlineData(true, PixelFormat.I444)]
+    public void DecodeYuv_ShouldKeepNativeChromaAndDownsampleToI420(bool full, PixelFormat expected)
+    {
+        const int width = 17;
+        const int height = 9;
+        var jpeg = full ? Jpeg444 : Jpeg422;
+        using var pool = new JpegCodecPool(width, height);
+        var native = new byte[FrameHeader.Create(width, height, PixelFormat.I444).Length];
+        var i420 = new byte[FrameHeader.Create(width, height, PixelFormat.I420).Length + 16];
+        i420.AsSpan().Fill(0xEE);
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            var nativeHeader = pool.DecodeYuv(decoder, jpeg, native);
+            var i420Header = pool.DecodeYuv(decoder, jpeg, i420, PixelFormat.I420);
+
+            nativeHeader.Format.Should().Be(expected);
+            nativeHeader.Length.Should().Be(FrameHeader.Create(width, height, expected).Length);
+            i420Header.Format.Should().Be(PixelFormat.I420);
+            i420Header.Length.Should().Be(width * height + 2 * 9 * 5);
+            i420.AsSpan(i420Header.Length).ToArray().Should().AllBeEquivalentTo((byte)0xEE);
+
+            // Same luma; I420 chroma is the box filter of the native planes, odd edges replicated
+            i420.AsSpan(0, width * height).ToArray().Should().Equal(native.AsSpan(0, width * height).ToArray());
+            int nativeWidth = expected.GetChromaWidth(width);
+            int nativeHeight = expected.GetChromaHeight(height);
+            int xs = nativeWidth == 9 ? 1 : 2;
+            for (int plane = 0; plane < 2; plane++)
+            {
+                int src = width * height + plane * nativeWidth * nativeHeight;
+                int dst = width * height + plane * 9 * 5;
+                for (int y = 0; y < 5; y++)
+                for (int x = 0; x < 9; x++)
+                {
+                    int sum = 0;
+                    for (int j = 0; j < 2; j++)
+                    for (int i = 0; i < xs; i++)
+                        sum += native[src + Math.Min(2 * y + j, nativeHeight - 1) * nativeWidth + Math.Min(x * xs + i, nativeWidth - 1)];
+                    i420[dst + y * 9 + x].Should().Be((byte)((sum + xs) / (2 * xs)), $"plane {plane} at ({x}, {y})");
+                }
+            }
+
+            // Finer chroma than the JPEG carries would need upsampling
+            var act = () => pool.DecodeYuv(decoder, jpeg, native, PixelFormat.I444);
+            if (!full)
+                act.Should().Throw<InvalidOperationException>();
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    [Fact]
+    public void DecodeI420_OddSize_ShouldRoundChromaPlanesUp()
+    {
+        const int width = 101;
+        const int height = 77;
+        const int chromaSize = 51 * 39;
+        using var pool = new JpegCodecPool(width, height);
+        var header = FrameHeader.Create(width, height, PixelFormat.I420);
+        var frame = new byte[header.Length];
+        frame.AsSpan(0, width * height).Fill(100);
+        frame.AsSpan(width * height, chromaSize).Fill(90);
+        frame.AsSpan(width * height + chromaSize, chromaSize).Fill(170);
+
+        var encoder = pool.RentEncoder();
+        var jpeg = new byte[header.Length * 2];
+        int jpegLength;
+        try
+        {
+            jpegLength = pool.EncodeI420(encoder, frame, jpeg);
+        }
+        finally
+        {
+            pool.ReturnEncoder(encoder);
+        }
+
+        var output = new byte[header.Length + 16];
+        output.AsSpan().Fill(0xEE);
+        var decoder = pool.RentDecoder();
+        try
+        {
+            var decoded = pool.DecodeI420(decoder, jpeg.AsMemory(0, jpegLength), output);
+
+            decoded.Should().Be(header);
+            output.AsSpan(header.Length).ToArray().Should().AllBeEquivalentTo((byte)0xEE);
+            // The last chroma row and column are real samples, not left over from the next plane
+            output[width * height + chromaSize - 1].Should().BeInRange((byte)88, (byte)92);
+            output[header.Length - 1].Should().BeInRange((byte)168, (byte)172);
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    [Fact]
+    public void DecodeGray_Crop_ShouldMatchRegionOfFullDecode()
+    {
+        const int width = 128;
+        const int height = 72;
+        using var pool = new JpegCodecPool(width, height);
+        var jpeg = EncodeNoiseI420(pool, width, height, 11);
+        var region = new CropRegion(21, 13, 35, 27);
+
+        var full = new byte[width * height];
+        var cropped = new byte[(region.Width + 16) * region.Height];
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            pool.DecodeGray(decoder, jpeg, full);
+            var header = pool.DecodeGray(decoder, jpeg, cropped, region);
+
+            header.Width.Should().Be(region.Width);
+            header.Height.Should().Be(region.Height);
+            header.Stride.Should().BeGreaterThanOrEqualTo(region.Width);
+            header.IsValid.Should().BeTrue();
+            for (int y = 0; y < region.Height; y++)
+            {
+                cropped.AsSpan(y * header.Stride, region.Width).ToArray().Should()
+                    .Equal(full.AsSpan((region.Y + y) * width + region.X, region.Width).ToArray(), $"row {y}");
+            }
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    [Fact]
+    public void DecodeI420_Crop_ShouldMatchRegionOfFullDecode()
+    {
+        const int width = 128;
+        const int height = 72;
+        using var pool = new JpegCodecPool(width, height);
+        var jpeg = EncodeNoiseI420(pool, width, height, 12);
+        var region = new CropRegion(18, 10, 40, 24);
+
+        var full = new byte[width * height * 3 / 2];
+        var cropped = new byte[region.Width * region.Height * 3 / 2];
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            pool.DecodeI420(decoder, jpeg, full);
+            var header = pool.DecodeI420(decoder, jpeg, cropped, region);
+
+            header.Should().Be(new FrameHeader(40, 24, 40, PixelFormat.I420, cropped.Length));
+            for (int y = 0; y < region.Height; y++)
+            {
+                cropped.AsSpan(y * region.Width, region.Width).ToArray().Should()
+                    .Equal(full.AsSpan((region.Y + y) * width + region.X, region.Width).ToArray(), $"Y row {y}");
+            }
+
+            int uvWidth = region.Width / 2;
+            int fullU = width * height;
+            int cropU = region.Width * region.Height;
+            for (int y = 0; y < region.Height / 2; y++)
+            {
+                cropped.AsSpan(cropU + y * uvWidth, uvWidth).ToArray().Should()
+                    .Equal(full.AsSpan(fullU + (region.Y / 2 + y) * (width / 2) + region.X / 2, uvWidth).ToArray(), $"U row {y}");
+            }
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    [Theory]
+    [InlineData(false)]
+    [InlineData(true)]
+    public void DecodeI420_CropOfFullChromaJpeg_ShouldMatchRegionOfFullDecode(bool full)
+    {
+        const int width = 17;
+        const int height = 9;
+        using var pool = new JpegCodecPool(width, height);
+        var jpeg = full ? Jpeg444 : Jpeg422;
+        var region = new CropRegion(2, 2, 14, 6);
+
+        var whole = new byte[FrameHeader.Create(width, height, PixelFormat.I420).Length];
+        var cropped = new byte[region.Width * region.Height * 3 / 2];
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            pool.DecodeI420(decoder, jpeg, whole);
+            pool.DecodeI420(decoder, jpeg, cropped, region);
+
+            // Both box-filter the JPEG's chroma down to 4:2:0
+            int uvWidth = region.Width / 2;
+            int uvHeight = region.Height / 2;
+            int fullUvWidth = (width + 1) / 2;
+            int fullUvHeight = (height + 1) / 2;
+            for (int plane = 0; plane < 3; plane++)
+            {
+                int rows = plane == 0 ? region.Height : uvHeight;
+                int cols = plane == 0 ? region.Width : uvWidth;
+                int fullStride = plane == 0 ? width : fullUvWidth;
+                int cropBase = plane == 0 ? 0 : region.Width * region.Height + (plane - 1) * uvWidth * uvHeight;
+                int fullBase = plane == 0 ? 0 : width * height + (plane - 1) * fullUvWidth * fullUvHeight;
+                int x0 = plane == 0 ? region.X : region.X / 2;
+                int y0 = plane == 0 ? region.Y : region.Y / 2;
+                for (int y = 0; y < rows; y++)
+                {
+                    cropped.AsSpan(cropBase + y * cols, cols).ToArray().Should()
+                        .Equal(whole.AsSpan(fullBase + (y0 + y) * fullStride + x0, cols).ToArray(), $"plane {plane} row {y}");
+                }
+            }
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    [Fact]
+    public void DecodeI420_CropOfGrayscaleJpeg_ShouldFillNeutralChroma()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+        var gray = new byte[width * height];
+        new Random(13).NextBytes(gray);
+        var encoded = new byte[gray.Length * 2];
+        var jpeg = encoded.AsSpan(0, pool.EncodeGray8(width, height, gray, encoded)).ToArray();
+        var region = new CropRegion(10, 6, 32, 20);
+
+        var full = new byte[width * height];
+        var cropped = new byte[region.Width * region.Height * 3 / 2];
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            pool.DecodeGray(decoder, jpeg, full);
+            var header = pool.DecodeI420(decoder, jpeg, cropped, region);
+
+            header.Should().Be(new FrameHeader(32, 20, 32, PixelFormat.I420, cropped.Length));
+            for (int y = 0; y < region.Height; y++)
+            {
+                cropped.AsSpan(y * region.Width, region.Width).ToArray().Should()
+                    .Equal(full.AsSpan((region.Y + y) * width + region.X, region.Width).ToArray(), $"Y row {y}");
+            }
+            cropped.AsSpan(region.Width * region.Height).ToArray().Should().AllBeEquivalentTo((byte)128);
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    [Fact]
+    public void DecodeI420_CropWithOddOffset_ShouldThrow()
+    {
+        using var pool = new JpegCodecPool(64, 64);
+
+        var act = () => pool.DecodeI420(0, new byte[4], new byte[64], new CropRegion(1, 0, 8, 8));
+
+        act.Should().Throw<ArgumentException>();
+    }
+
+    [Fact]
+    public void DecodeBatch_MismatchedBuffers_ShouldThrow()
+    {
+        using var pool = new JpegCodecPool(64, 64);
+
+        var act = () => pool.DecodeBatch(PixelFormat.I420, new ReadOnlyMemory<byte>[2], new Memory<byte>[1], new FrameHeader[2]);
+
+        act.Should().Throw<ArgumentException>();
+    }
+
+    [Fact]
+    public void EncodeNv12AndStridedPlanes_ShouldMatchTightI420Encode()
+    {
+        const int width = 64;
+        const int height = 48;
+        const int stride = width + 32;
+        using var pool = new JpegCodecPool(width, height);
+
+        var i420 = new byte[width * height * 3 / 2];
+        new Random(5).NextBytes(i420);
+        int chromaSize = width * height / 4;
+
+        // Same pixels as padded planes and as NV12 with interleaved chroma
+        var y = new byte[stride * height];
+        var u = new byte[stride / 2 * height / 2];
+        var v = new byte[stride / 2 * height / 2];
+        var uv = new byte[stride * height / 2];
+        for (int row = 0; row < height; row++)
+            i420.AsSpan(row * width, width).CopyTo(y.AsSpan(row * stride));
+        for (int row = 0; row < height / 2; row++)
+        {
+            for (int col = 0; col < width / 2; col++)
+            {
+                byte cb = i420[width * height + row * width / 2 + col];
+                byte cr = i420[width * height + chromaSize + row * width / 2 + col];
+                u[row * stride / 2 + col] = cb;
+                v[row * stride / 2 + col] = cr;
+                uv[row * stride + 2 * col] = cb;
+                uv[row * stride + 2 * col + 1] = cr;
+            }
+        }
+
+        var encoder = pool.RentEncoder();
+        try
+        {
+            var expected = new byte[i420.Length * 2];
+            int expectedLength = pool.EncodeI420(encoder, i420, expected);
+
+            var planes = new byte[i420.Length * 2];
+            int planesLength = pool.EncodePlanes(encoder, y, stride, u, v, stride / 2, planes);
+
+            var nv12 = new byte[i420.Length * 2];
+            int nv12Length = pool.EncodeNv12(encoder, y, stride, uv, stride, nv12);
+
+            var frame = new FrameImage(new FrameHeader(width, height, stride, PixelFormat.Nv12, y.Length + uv.Length), [.. y, .. uv]);
+            var fromFrame = new byte[i420.Length * 2];
+            int fromFrameLength = pool.Encode(encoder, frame, fromFrame);
+
+            planes.AsSpan(0, planesLength).ToArray().Should().Equal(expected.AsSpan(0, expectedLength).ToArray());
+            nv12.AsSpan(0, nv12Length).ToArray().Should().Equal(expected.AsSpan(0, expectedLength).ToArray());
+            fromFrame.AsSpan(0, fromFrameLength).ToArray().Should().Equal(expected.AsSpan(0, expectedLength).ToArray());
+        }
+        finally
+        {
+            pool.ReturnEncoder(encoder);
+        }
+    }
+
+    [Fact]
+    public void EncodeGray8_Repeated_ShouldReusePooledEncoderAndMatch()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+
+        var gray = new byte[width * height];
+        new Random(11).NextBytes(gray);
+
+        var first = new byte[gray.Length * 2];
+        int firstLength = pool.EncodeGray8(width, height, gray, first);
+        var writer = new ArrayBufferWriter<byte>();
+        int chunkedLength = pool.EncodeGray8(width, height, gray, writer);
+        var second = new byte[gray.Length * 2];
+        int secondLength = pool.EncodeGray8(width, height, gray, second);
+
+        second.AsSpan(0, secondLength).ToArray().Should().Equal(first.AsSpan(0, firstLength).ToArray());
+        writer.WrittenSpan.ToArray().Should().Equal(first.AsSpan(0, firstLength).ToArray());
+        chunkedLength.Should().Be(firstLength);
+
+        var info = pool.GetImageInfo(first.AsMemory(0, firstLength));
+        info.Width.Should().Be(width);
+        info.Height.Should().Be(height);
+    }
+
+    [Fact]
+    public void GetImageInfo_CorruptHeader_ShouldThrowAndKeepDecoderUsable()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+        var jpeg = EncodeNoiseI420(pool, width, height, 9);
+        var corrupt = jpeg.ToArray();
+        int sof = corrupt.AsSpan().IndexOf(new byte[] { 0xFF, 0xC0 });
+        corrupt.AsSpan(sof + 5, 2).Clear();   // Zero image height: a fatal libjpeg error
+
+        var act = () => pool.GetImageInfo(corrupt);
+
+        act.Should().Throw<InvalidOperationException>();
+        pool.GetImageInfo(jpeg).Width.Should().Be(width);
+    }
+
+    [Fact]
+    public void AbbreviatedStreams_ShouldOmitTablesAndDecodeAfterLoadTables()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var fullPool = new JpegCodecPool(width, height);
+        using var abbreviatedPool = new JpegCodecPool(width, height, abbreviatedStreams: true);
+
+        var full = EncodeNoiseI420(fullPool, width, height, seed: 5);
+        var abbreviated = EncodeNoiseI420(abbreviatedPool, width, height, seed: 5);
+        var tables = abbreviatedPool.Tables;
+
+        static bool HasMarker(ReadOnlySpan<byte> jpeg, byte marker) =>
+            jpeg.IndexOf(new byte[] { 0xFF, marker }) >= 0;
+
+        HasMarker(abbreviated, 0xDB).Should().BeFalse();
+        HasMarker(abbreviated, 0xC4).Should().BeFalse();
+        HasMarker(tables.Span, 0xDB).Should().BeTrue();
+        abbreviated.Length.Should().BeLessThan(full.Length);
+
+        var expected = new byte[width * height * 3 / 2];
+        var decoder = fullPool.RentDecoder();
+        try
+        {
+            fullPool.DecodeI420(decoder, full, expected);
+        }
+        finally
+        {
+            fullPool.ReturnDecoder(decoder);
+        }
+
+        // A receiver that has never seen these tables gets them from the tables-only stream
+        using var receiver = new JpegCodecPool(width, height);
+        var fresh = receiver.RentDecoder();
+        try
+        {
+            receiver.LoadTables(fresh, tables);
+            var actual = new byte[expected.Length];
+            receiver.DecodeI420(fresh, abbreviated, actual);
+            actual.Should().Equal(expected);
+        }
+        finally
+        {
+            receiver.ReturnDecoder(fresh);
+        }
+
+        // Decoders of an abbreviated pool come with the tables preloaded
+        var own = abbreviatedPool.RentDecoder();
+        try
+        {
+            var actual = new byte[expected.Length];
+            abbreviatedPool.DecodeI420(own, abbreviated, actual);
+            actual.Should().Equal(expected);
+        }
+        finally
+        {
+            abbreviatedPool.ReturnDecoder(own);
+        }
+    }
+
+    [Fact]
+    public void AbbreviatedStreams_WithRateControl_ShouldThrow()
+    {
+        var act = () => new JpegCodecPool(64, 48, abbreviatedStreams: true, rateControl: new RateControl(6000));
+        act.Should().Throw<NotSupportedException>();
+    }
+
+    [Fact]
+    public void RateControl_ShouldConvergeToTargetAndRaiseQualityForSimpleFrames()
+    {
+        const int width = 128;
+        const int height = 96;
+        const int target = 6000;
+        using var pool = new JpegCodecPool(width, height, rateControl: new RateControl(target));
+
+        var noise = new byte[width * height * 3 / 2];
+        new Random(1).NextBytes(noise);
+        var gradient = new byte[noise.Length];
+        for (int i = 0; i < gradient.Length; i++)
+            gradient[i] = (byte)(i % width + i / width % 64);
+
+        var encoder = pool.RentEncoder();
+        try
+        {
+            var output = new byte[noise.Length * 2];
+            int length = 0;
+            for (int i = 0; i < 8; i++)
+                length = pool.EncodeI420(encoder, noise, output);
+            int noiseQuality = pool.GetQuality(encoder);
+
+            length.Should().BeInRange(target * 9 / 10, target * 11 / 10);
+            noiseQuality.Should().BeLessThan(pool.Quality);
+
+            length = pool.EncodeI420(encoder, gradient, output);
+            length.Should().BeLessThanOrEqualTo(target);
+            pool.GetQuality(encoder).Should().BeGreaterThan(noiseQuality);
+        }
+        finally
+        {
+            pool.ReturnEncoder(encoder);
+        }
+    }
+
+    [Fact]
+    public async Task MaxHandles_ShouldMakeRentersWaitAndTrimIdleHandles()
+    {
+        using var pool = new JpegCodecPool(64, 48, maxHandles: 1, idleTimeout: Timeout.InfiniteTimeSpan);
+
+        var decoder = pool.RentDecoder();
+        var pending = pool.RentDecoderAsync();
+        pending.IsCompleted.Should().BeFalse();
+        pool.LiveDecoders.Should().Be(1);
+
+        pool.ReturnDecoder(decoder);
+        var reused = await pending;
+        pool.LiveDecoders.Should().Be(1);
+
+        using (var cts = new CancellationTokenSource(TimeSpan.FromMilliseconds(50)))
+        {
+            var act = async () => await pool.RentDecoderAsync(cts.Token);
+            await act.Should().ThrowAsync<OperationCanceledException>();
+        }
+
+        pool.ReturnDecoder(reused);
+        pool.TrimIdle(TimeSpan.Zero).Should().Be(1);
+        pool.LiveDecoders.Should().Be(0);
+    }
+
+    [Fact]
+    public void MaxHandles_ShouldCapLiveHandlesAcrossCores()
+    {
+        const int maxHandles = 2;
+        using var pool = new JpegCodecPool(64, 48, maxHandles: maxHandles, idleTimeout: Timeout.InfiniteTimeSpan);
+
+        int peak = 0;
+        Parallel.For(0, 2000, new ParallelOptions { MaxDegreeOfParallelism = Environment.ProcessorCount * 2 }, _ =>
+        {
+            var decoder = pool.RentDecoder();
+            int live = pool.LiveDecoders;
+            int seen;
+            while ((seen = Volatile.Read(ref peak)) < live && Interlocked.CompareExchange(ref peak, live, seen) != seen) { }
+            Thread.Yield();
+            pool.ReturnDecoder(decoder);
+        });
+
+        peak.Should().BeLessThanOrEqualTo(maxHandles);
+        pool.LiveDecoders.Should().BeLessThanOrEqualTo(maxHandles);
+    }
+
+    [Fact]
+    public void CodecStats_ShouldCountCallsBytesAndErrorsAcrossTrim()
+    {
+        const int width = 64;
+        const int height = 48;
+        const int frames = 3;
+        using var pool = new JpegCodecPool(width, height, idleTimeout: Timeout.InfiniteTimeSpan);
+
+        long jpegBytes = 0;
+        var jpegs = new byte[frames][];
+        for (int i = 0; i < frames; i++)
+        {
+            jpegs[i] = EncodeNoiseI420(pool, width, height, i);
+            jpegBytes += jpegs[i].Length;
+        }
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            var output = new byte[width * height * 3 / 2];
+            foreach (var jpeg in jpegs)
+                pool.DecodeI420(decoder, jpeg, output);
+
+            var act = () => pool.DecodeI420(decoder, new byte[] { 0xFF, 0xD8, 0x00 }, output);
+            act.Should().Throw<InvalidOperationException>();
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+
+        // Counters of trimmed handles must survive the close
+        pool.TrimIdle(TimeSpan.Zero);
+
+        var encoders = pool.EncoderStats;
+        encoders.Calls.Should().Be(frames);
+        encoders.Errors.Should().Be(0);
+        encoders.BytesIn.Should().Be((long)frames * width * height * 3 / 2);
+        encoders.BytesOut.Should().Be(jpegBytes);
+
+        var decoders = pool.DecoderStats;
+        decoders.Calls.Should().Be(frames + 1);
+        decoders.Errors.Should().Be(1);
+        decoders.BytesIn.Should().Be(jpegBytes);
+        decoders.BytesOut.Should().Be((long)frames * width * height * 3 / 2);
+        (decoders.HeaderTime + decoders.CodingTime).Should().BePositive();
+        decoders.PeakPoolBytes.Should().BePositive();
+    }
+
+    private static byte[] Transform(JpegCodecPool pool, byte[] jpeg, in JpegTransformOptions options)
+    {
+        var output = new byte[jpeg.Length * 2];
+        int length = pool.Transform(jpeg, output, options);
+        return output.AsSpan(0, length).ToArray();
+    }
+
+    [Fact]
+    public void Transform_Rotate90_ShouldSwapDimensionsAndRoundTripLosslessly()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+        var jpeg = EncodeNoiseI420(pool, width, height, 5);
+
+        var rotated = Transform(pool, jpeg, new JpegTransformOptions(JpegTransform.Rotate90));
+        var info = pool.GetImageInfo(rotated);
+        info.Width.Should().Be(height);
+        info.Height.Should().Be(width);
+
+        // Four quarter turns put every coefficient back where it was
+        var back = rotated;
+        for (int i = 0; i < 3; i++)
+            back = Transform(pool, back, new JpegTransformOptions(JpegTransform.Rotate90));
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            var expected = new byte[width * height * 3 / 2];
+            var actual = new byte[expected.Length];
+            pool.DecodeI420(decoder, jpeg, expected);
+            pool.DecodeI420(decoder, back, actual);
+            actual.Should().Equal(expected);
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    [Fact]
+    public void Transform_Crop_ShouldSnapToMcuGridAndKeepRegionPixels()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+        var jpeg = EncodeNoiseI420(pool, width, height, 6);
+
+        // X snaps down from 20 to the 16-pixel MCU edge and the width grows by the difference
+        var cropped = Transform(pool, jpeg, new JpegTransformOptions(Crop: new CropRegion(20, 16, 24, 16)));
+        var info = pool.GetImageInfo(cropped);
+        info.Width.Should().Be(28);
+        info.Height.Should().Be(16);
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            var full = new byte[width * height];
+            var region = new byte[28 * 16];
+            pool.DecodeGray(decoder, jpeg, full);
+            pool.DecodeGray(decoder, cropped, region);
+            for (int y = 0; y < 16; y++)
+                region.AsSpan(y * 28, 28).ToArray().Should().Equal(full.AsSpan((16 + y) * width + 16, 28).ToArray());
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    [Theory]
+    [InlineData(8, 8)]
+    [InlineData(15, 9)]
+    public void Transform_SmallerThanOneMcu_ShouldKeepTheImage(int width, int height)
+    {
+        using var pool = new JpegCodecPool(width, height);
+        var frameData = new byte[width * height + 2 * ((width + 1) / 2) * ((height + 1) / 2)];
+        new Random(9).NextBytes(frameData);
+        var output = new byte[4096];
+        var encoder = pool.RentEncoder();
+        var jpeg = output.AsSpan(0, pool.EncodeI420(encoder, frameData, output)).ToArray();
+        pool.ReturnEncoder(encoder);
+
+        // No whole 4:2:0 MCU to mirror on either axis, so nothing is trimmed away
+        foreach (var transform in new[] { JpegTransform.FlipHorizontal, JpegTransform.Rotate180, JpegTransform.Rotate90 })
+        {
+            var info = pool.GetImageInfo(Transform(pool, jpeg, new JpegTransformOptions(transform)));
+            info.Width.Should().Be(transform == JpegTransform.Rotate90 ? height : width);
+            info.Height.Should().Be(transform == JpegTransform.Rotate90 ? width : height);
+        }
+    }
+
+    [Fact]
+    public void Transform_CorruptFrame_ShouldThrowAndKeepTheTransformerUsable()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+        var jpeg = EncodeNoiseI420(pool, width, height, 10);
+
+        // Code counts of the first Huffman table adding up past 256 are fatal to libjpeg
+        var corrupt = jpeg.ToArray();
+        int dht = corrupt.AsSpan().IndexOf(new byte[] { 0xFF, 0xC4 });
+        corrupt.AsSpan(dht + 5, 16).Fill(0xFF);
+        var act = () => pool.Transform(corrupt, new byte[jpeg.Length * 2], new JpegTransformOptions(JpegTransform.Rotate180));
+        act.Should().Throw<InvalidOperationException>();
+
+        pool.GetImageInfo(Transform(pool, jpeg, new JpegTransformOptions(JpegTransform.Rotate180))).Width.Should().Be(width);
+    }
+
+    [Fact]
+    public void Transform_Quality_ShouldRequantizeToSmallerOutput()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height, quality: 90);
+        var jpeg = EncodeNoiseI420(pool, width, height, 8);
+
+        var requantized = Transform(pool, jpeg, new JpegTransformOptions(Quality: 30));
+        requantized.Length.Should().BeLessThan(jpeg.Length);
+        pool.GetImageInfo(requantized).Width.Should().Be(width);
+
+        var act = () => pool.Transform(jpeg, new byte[jpeg.Length * 2], new JpegTransformOptions(Quality: 101));
+        act.Should().Throw<ArgumentOutOfRangeException>();
+    }
+
+    [Fact]
+    public void AnalyzeChange_ShouldCountChangedBlocksAgainstReference()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+
+        byte[] EncodeGray(bool square)
+        {
+            var gray = new byte[width * height];
+            Array.Fill(gray, (byte)100);
+            if (square)
+                for (int y = 16; y < 32; y++)
+                    gray.AsSpan(y * width + 16, 16).Fill(200);
+            var output = new byte[gray.Length * 2];
+            return output.AsSpan(0, pool.EncodeGray8(width, height, gray, output)).ToArray();
+        }
+
+        var background = EncodeGray(square: false);
+        var moved = EncodeGray(square: true);
+        var decoder = pool.RentDecoder();
+        try
+        {
+            pool.AnalyzeChange(decoder, background).Compared.Should().BeFalse();
+            pool.AnalyzeChange(decoder, background).Should().Be(new DcChange(8, 6, true, 0, 0, 0));
+
+            // The 16x16 square covers 2x2 blocks; the fixed reference keeps reporting them
+            var thumbnail = new byte[8 * 6];
+            var change = pool.AnalyzeChange(decoder, moved, thumbnail: thumbnail, keepReference: true);
+            change.ChangedBlocks.Should().Be(4);
+            change.MaxDifference.Should().BeInRange(95, 105);
+            ((int)thumbnail[2 * 8 + 2]).Should().BeCloseTo(200, 3);
+            ((int)thumbnail[0]).Should().BeCloseTo(100, 3);
+            pool.AnalyzeChange(decoder, moved).ChangedBlocks.Should().Be(4);
+            pool.AnalyzeChange(decoder, moved).ChangedBlocks.Should().Be(0);
+
+            pool.ResetChangeReference(decoder);
+            pool.AnalyzeChange(decoder, moved).Compared.Should().BeFalse();
+
+            var act = () => pool.AnalyzeChange(decoder, moved, thumbnail: new byte[4]);
+            act.Should().Throw<InvalidOperationException>();
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    private sealed class Segment : ReadOnlySequenceSegment<byte>
+    {
+        public Segment(ReadOnlyMemory<byte> memory, Segment? previous)
+        {
+            Memory = memory;
+            if (previous != null)
+            {
+                RunningIndex = previous.RunningIndex + previous.Memory.Length;
+                previous.Next = this;
+            }
+        }
+    }
+
+    private static ReadOnlySequence<byte> Split(byte[] data, int segmentSize)
+    {
+        // Each segment gets its own array, as pipe segments would
+        var first = new Segment(data.AsSpan(0, Math.Min(segmentSize, data.Length)).ToArray(), null);
+        var last = first;
+        for (int offset = segmentSize; offset < data.Length; offset += segmentSize)
+            last = new Segment(data.AsSpan(offset, Math.Min(segmentSize, data.Length - offset)).ToArray(), last);
+        return new ReadOnlySequence<byte>(first, 0, last, last.Memory.Length);
+    }
+
+    [Theory]
+    [InlineData(1)]
+    [InlineData(333)]
+    public void DecodeSequence_MultiSegment_ShouldMatchContiguousDecode(int segmentSize)
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+        var jpeg = EncodeNoiseI420(pool, width, height, 7);
+        var sequence = Split(jpeg, segmentSize);
+        sequence.IsSingleSegment.Should().BeFalse();
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            var expected = new byte[width * height * 3 / 2];
+            var actual = new byte[expected.Length];
+            pool.DecodeI420(decoder, sequence, actual).Should().Be(pool.DecodeI420(decoder, jpeg, expected));
+            actual.Should().Equal(expected);
+
+            var expectedGray = new byte[width * height];
+            var actualGray = new byte[expectedGray.Length];
+            pool.DecodeGray(decoder, sequence, actualGray).Should().Be(pool.DecodeGray(decoder, jpeg, expectedGray));
+            actualGray.Should().Equal(expectedGray);
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    [Fact]
+    public void DecodeSequence_TruncatedSegments_ShouldThrow()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+        var jpeg = EncodeNoiseI420(pool, width, height, 8);
+        var sequence = Split(jpeg.AsSpan(0, jpeg.Length * 2 / 3).ToArray(), 333);
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            var decodeI420 = () => pool.DecodeI420(decoder, sequence, new byte[width * height * 3 / 2]);
+            var decodeGray = () => pool.DecodeGray(decoder, sequence, new byte[width * height]);
+
+            decodeI420.Should().Throw<InvalidOperationException>();
+            decodeGray.Should().Throw<InvalidOperationException>();
+            // The handle recovers for the next frame
+            pool.DecodeI420(decoder, Split(jpeg, 333), new byte[width * height * 3 / 2]).Width.Should().Be(width);
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+}
@@ -218,4 +218,72 @@ public class JpegCodecTests
         decodedHeader.Height.Should().Be(height);
         decodedHeader.Format.Should().Be(PixelFormat.Gray8);
     }
+
+    [Fact]
+    public void Encode_ToBufferWriter_ShouldGrowAndMatchFixedBuffer()
+    {
+        using var codec = new JpegCodec(new JpegCodecOptions
+        {
+            MaxWidth = 256,
+            MaxHeight = 256,
+            Quality = 95
+        });
+
+        // Noise compresses poorly, forcing the writer to grow past its initial size
+        int width = 256;
+        int height = 256;
+        int totalSize = width * height * 3 / 2;
+        var frameData = new byte[totalSize];
+        new Random(42).NextBytes(frameData);
+
+        var header = new FrameHeader(width, height, width, PixelFormat.I420, totalSize);
+        var frame = new FrameImage(header, frameData);
+
+        var jpegBuffer = new byte[totalSize * 2];
+        var jpegSize = codec.Encode(frame, jpegBuffer);
+
+        using var writer = new PooledBufferWriter(16);
+        var written = codec.Encode(frame, writer);
+
+        written.Should().Be(jpegSize);
+        writer.WrittenCount.Should().Be(jpegSize);
+        writer.WrittenMemory.ToArray().Should().Equal(jpegBuffer.AsSpan(0, jpegSize).ToArray());
+    }
+
+    [Fact]
+    public void Constructor_TurboJpegBackend_ShouldRoundTripOrReportUnsupported()
+    {
+        var options = new JpegCodecOptions { MaxWidth = 64, MaxHeight = 64, Backend = JpegBackend.TurboJpeg };
+
+        JpegCodec codec;
+        try
+        {
+            codec = new JpegCodec(options);
+        }
+        catch (NotSupportedException)
+        {
+            // Native library built without libjpeg-turbo 3
+            return;
+        }
+
+        using (codec)
+        {
+            int width = 64;
+            int height = 64;
+            int totalSize = width * height * 3 / 2;
+            var frameData = new byte[totalSize];
+            for (int i = 0; i < totalSize; i++)
+                frameData[i] = i < width * height ? (byte)(i % 256) : (byte)128;
+
+            var frame = new FrameImage(new FrameHeader(width, height, width, PixelFormat.I420, totalSize), frameData);
+            var jpegBuffer = new byte[totalSize * 2];
+            var jpegSize = codec.Encode(frame, jpegBuffer);
+
+            using var decoded = codec.DecodeI420(jpegBuffer.AsMemory(0, jpegSize));
+
+            decoded.Header.Width.Should().Be(width);
+            decoded.Header.Height.Should().Be(height);
+            decoded.Header.Length.Should().Be(totalSize);
+        }
+    }
 }
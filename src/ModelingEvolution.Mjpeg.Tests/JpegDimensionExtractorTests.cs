@@ -49,6 +49,29 @@ public class JpegDimensionExtractorTests
         height.Should().Be(1080);
     }
 
+    [Theory]
+    [InlineData(0x22, ChromaSubsampling.Yuv420)]
+    [InlineData(0x21, ChromaSubsampling.Yuv422)]
+    [InlineData(0x11, ChromaSubsampling.Yuv444)]
+    [InlineData(0x33, ChromaSubsampling.Unknown)]
+    public void TryExtractInfo_ShouldReportSubsampling(byte lumaSampling, ChromaSubsampling expected)
+    {
+        byte[] jpeg =
+        [
+            0xFF, 0xD8,                         // SOI
+            0xFF, 0xC0, 0x00, 0x11, 0x08,       // SOF0, length 17, precision
+            0x00, 0x20, 0x00, 0x40, 0x03,       // 64x32, 3 components
+            0x01, lumaSampling, 0x00,           // Y
+            0x02, 0x11, 0x01,                   // Cb
+            0x03, 0x11, 0x01,                   // Cr
+            0xFF, 0xD9                          // EOI
+        ];
+
+        JpegDimensionExtractor.TryExtractInfo(jpeg, out var info).Should().BeTrue();
+
+        info.Should().Be(new JpegImageInfo(64, 32, 3, expected));
+    }
+
     [Fact]
     public void Extract_NoSOFMarker_ReturnsZero()
     {
@@ -0,0 +1,120 @@
+using FluentAssertions;
+using Xunit;
+
+namespace ModelingEvolution.Mjpeg.Tests;
+
+public class MjpegFrameIndexTests : IDisposable
+{
+    // SOI, SOF0 64x32 with 4:2:0 sampling, EOI
+    private static readonly byte[] Frame =
+    [
+        0xFF, 0xD8,
+        0xFF, 0xC0, 0x00, 0x11, 0x08, 0x00, 0x20, 0x00, 0x40, 0x03,
+        0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01,
+        0xFF, 0xD9
+    ];
+
+    private readonly string _dir = Directory.CreateTempSubdirectory("mjidx").FullName;
+
+    public void Dispose() => Directory.Delete(_dir, recursive: true);
+
+    [Fact]
+    public void Open_AfterWrite_ShouldRoundTripEntriesAndHeader()
+    {
+        var path = Path.Combine(_dir, "a.mjidx");
+        using (var writer = new MjpegFrameIndexWriter(path))
+        {
+            writer.Append(0, Frame);
+            writer.Append(100, 50);
+            writer.Append(new FrameInfo(200, 25, 0));
+        }
+
+        using var index = MjpegFrameIndex.Open(path);
+
+        index.Count.Should().Be(3);
+        index.Width.Should().Be(64);
+        index.Height.Should().Be(32);
+        index.Subsampling.Should().Be(ChromaSubsampling.Yuv420);
+        index[1].Should().Be(new FrameInfo(100, 50, 1));
+        index[2].Should().Be(new FrameInfo(200, 25, 2));
+        index.EndOffset.Should().Be(225);
+    }
+
+    [Fact]
+    public void FindFrame_ShouldReturnFrameContainingOffset()
+    {
+        var path = Path.Combine(_dir, "b.mjidx");
+        using (var writer = new MjpegFrameIndexWriter(path))
+        {
+            for (int i = 0; i < 1000; i++)
+                writer.Append(10 + i * 100L, 80);
+        }
+
+        using var index = MjpegFrameIndex.Open(path);
+
+        index.FindFrame(5).Should().Be(-1);
+        index.FindFrame(10).Should().Be(0);
+        index.FindFrame(50_050).Should().Be(500);
+        index.FindFrame(50_109).Should().Be(500);
+        index.FindFrame(long.MaxValue).Should().Be(999);
+    }
+
+    [Fact]
+    public void Open_TornTrailingEntry_ShouldBeIgnored()
+    {
+        var path = Path.Combine(_dir, "c.mjidx");
+        using (var writer = new MjpegFrameIndexWriter(path))
+        {
+            writer.Append(0, 10);
+            writer.Append(10, 10);
+        }
+        using (var stream = new FileStream(path, FileMode.Append))
+            stream.Write([1, 2, 3, 4, 5]);
+
+        using (var index = MjpegFrameIndex.Open(path))
+            index.Count.Should().Be(2);
+
+        using (var writer = new MjpegFrameIndexWriter(path, append: true))
+        {
+            writer.Count.Should().Be(2);
+            writer.EndOffset.Should().Be(20);
+            writer.Append(20, 10);
+        }
+
+        using var resumed = MjpegFrameIndex.Open(path);
+        resumed[2].Should().Be(new FrameInfo(20, 10, 2));
+    }
+
+    [Fact]
+    public async Task BuildAsync_GrowingRecording_ShouldIndexIncrementally()
+    {
+        var recording = Path.Combine(_dir, "rec.mjpeg");
+        await File.WriteAllBytesAsync(recording, [.. Frame, .. Frame]);
+
+        using (var index = await MjpegFrameIndex.BuildAsync(recording))
+        {
+            index.Count.Should().Be(2);
+            index.ImageInfo.Should().Be(new JpegImageInfo(64, 32, 3, ChromaSubsampling.Yuv420));
+        }
+
+        await using (var stream = new FileStream(recording, FileMode.Append))
+            await stream.WriteAsync(Frame);
+
+        using var updated = await MjpegFrameIndex.BuildAsync(recording);
+
+        updated.Count.Should().Be(3);
+        updated[2].Should().Be(new FrameInfo(2L * Frame.Length, Frame.Length, 2));
+        File.Exists(MjpegFrameIndex.GetDefaultPath(recording)).Should().BeTrue();
+    }
+
+    [Fact]
+    public void Open_NotAnIndex_ShouldThrow()
+    {
+        var path = Path.Combine(_dir, "bad.mjidx");
+        File.WriteAllBytes(path, new byte[64]);
+
+        var act = () => MjpegFrameIndex.Open(path);
+
+        act.Should().Throw<InvalidDataException>();
+    }
+}
@@ -62,6 +62,65 @@ public class MjpegFrameScannerTests
         frames.Should().BeEmpty();
     }
 
+    // SOI, APP1 whose payload holds an EOI (like an EXIF thumbnail), SOS, entropy data with
+    // stuffed zeros and a restart marker, EOI
+    private static readonly byte[] StructuredFrame =
+    [
+        0xFF, 0xD8,
+        0xFF, 0xE1, 0x00, 0x08, 0xFF, 0xD8, 0x00, 0xFF, 0xD9, 0x00,
+        0xFF, 0xDA, 0x00, 0x02,
+        0x11, 0x22, 0xFF, 0x00, 0x33, 0xFF, 0xD0, 0x44,
+        0xFF, 0xD9
+    ];
+
+    [Fact]
+    public void Scan_SegmentContainingEoi_ShouldNotEndFrame()
+    {
+        var frames = MjpegFrameScanner.Scan(StructuredFrame);
+
+        frames.Should().ContainSingle();
+        frames[0].StartOffset.Should().Be(0);
+        frames[0].Size.Should().Be(StructuredFrame.Length);
+    }
+
+    [Fact]
+    public void Scan_FillBytesBeforeMarkers_ShouldFindFrame()
+    {
+        byte[] data = [0x00, 0xFF, 0xFF, 0xD8, 0x01, 0x02, 0xFF, 0xFF, 0xD9];
+
+        var frames = MjpegFrameScanner.Scan(data);
+
+        frames.Should().ContainSingle();
+        frames[0].StartOffset.Should().Be(2);
+        frames[0].Size.Should().Be(7);
+    }
+
+    [Theory]
+    [InlineData(1)]
+    [InlineData(3)]
+    [InlineData(7)]
+    public async Task ScanAsync_FramesSplitAcrossReads_ShouldMatchScan(int bufferSize)
+    {
+        byte[] data =
+        [
+            .. StructuredFrame,
+            0x00, 0x01,
+            0xFF, 0xD8, 0x00, 0x01, 0x02, 0xFF, 0xD9,
+            .. StructuredFrame
+        ];
+        using var stream = new MemoryStream(data);
+
+        var frames = new List<FrameInfo>();
+        await foreach (var frame in MjpegFrameScanner.ScanAsync(stream, bufferSize))
+        {
+            frames.Add(frame);
+        }
+
+        frames.Should().Equal(MjpegFrameScanner.Scan(data));
+        frames.Should().HaveCount(3);
+        frames[2].StartOffset.Should().Be(StructuredFrame.Length + 9);
+    }
+
     [Fact]
     public async Task ScanAsync_SingleFrame_ReturnsOneFrameInfo()
     {
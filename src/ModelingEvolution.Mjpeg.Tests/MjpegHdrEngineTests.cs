@@ -13,8 +13,12 @@ internal sealed class MockCodecPool : ICodecPool
     public int MaxHeight { get; } = 1080;
     public int Quality { get; } = 85;
 
-    public int DecodeCallCount { get; private set; }
-    public int EncodeCallCount { get; private set; }
+    // Interlocked: streaming decodes and encodes run concurrently
+    private int _decodeCallCount;
+    private int _encodeCallCount;
+
+    public int DecodeCallCount => Volatile.Read(ref _decodeCallCount);
+    public int EncodeCallCount => Volatile.Read(ref _encodeCallCount);
     public int GetImageInfoCallCount { get; private set; }
     public int RentEncoderCallCount { get; private set; }
     public int ReturnEncoderCallCount { get; private set; }
@@ -54,7 +58,7 @@ internal sealed class MockCodecPool : ICodecPool
 
     public FrameHeader DecodeI420(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer)
     {
-        DecodeCallCount++;
+        Interlocked.Increment(ref _decodeCallCount);
         // Return a simple 2x2 I420 frame (Y=4 bytes, U=1 byte, V=1 byte)
         var header = new FrameHeader(2, 2, 2, PixelFormat.I420, 6);
         var span = outputBuffer.Span;
@@ -70,7 +74,7 @@ internal sealed class MockCodecPool : ICodecPool
 
     public FrameHeader DecodeGray(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer)
     {
-        DecodeCallCount++;
+        Interlocked.Increment(ref _decodeCallCount);
         // Return a simple 2x2 Gray8 frame
         var header = new FrameHeader(2, 2, 2, PixelFormat.Gray8, 4);
         var span = outputBuffer.Span;
@@ -81,9 +85,50 @@ internal sealed class MockCodecPool : ICodecPool
         return header;
     }
 
+    public FrameHeader DecodeI420(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, DecodeScale scale)
+        => DecodeI420(decoder, jpegData, outputBuffer);
+
+    public FrameHeader DecodeGray(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, DecodeScale scale)
+        => DecodeGray(decoder, jpegData, outputBuffer);
+
+    public FrameHeader DecodeI420(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, CropRegion region)
+        => DecodeI420(decoder, jpegData, outputBuffer);
+
+    public FrameHeader DecodeGray(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, CropRegion region)
+        => DecodeGray(decoder, jpegData, outputBuffer);
+
+    public int DecodeBatchCallCount { get; private set; }
+
+    public void DecodeBatch(PixelFormat format, ReadOnlySpan<ReadOnlyMemory<byte>> jpegData, ReadOnlySpan<Memory<byte>> outputBuffers, Span<FrameHeader> headers)
+    {
+        DecodeBatchCallCount++;
+        for (int i = 0; i < jpegData.Length; i++)
+        {
+            headers[i] = format == PixelFormat.Gray8
+                ? DecodeGray(0, jpegData[i], outputBuffers[i])
+                : DecodeI420(0, jpegData[i], outputBuffers[i]);
+        }
+    }
+
+    public int DecodeBlendCallCount { get; private set; }
+
+    public FrameHeader DecodeBlend(PixelFormat format, HdrBlendMode mode, ReadOnlySpan<ReadOnlyMemory<byte>> jpegData, HdrWeights? weights, Memory<byte> outputBuffer)
+    {
+        DecodeBlendCallCount++;
+        // Every mock frame decodes to the same pixels, so any blend yields them unchanged
+        FrameHeader header = default;
+        for (int i = 0; i < jpegData.Length; i++)
+        {
+            header = format == PixelFormat.Gray8
+                ? DecodeGray(0, jpegData[i], outputBuffer)
+                : DecodeI420(0, jpegData[i], outputBuffer);
+        }
+        return header;
+    }
+
     public int EncodeI420(nint encoder, ReadOnlyMemory<byte> frameData, Memory<byte> outputBuffer)
     {
-        EncodeCallCount++;
+        Interlocked.Increment(ref _encodeCallCount);
         // Write dummy JPEG data
         var span = outputBuffer.Span;
         span[0] = 0xFF;
@@ -93,7 +138,7 @@ internal sealed class MockCodecPool : ICodecPool
 
     public int EncodeGray8(int width, int height, ReadOnlyMemory<byte> frameData, Memory<byte> outputBuffer)
     {
-        EncodeCallCount++;
+        Interlocked.Increment(ref _encodeCallCount);
         // Write dummy JPEG data
         var span = outputBuffer.Span;
         span[0] = 0xFF;
@@ -101,6 +146,36 @@ internal sealed class MockCodecPool : ICodecPool
         return 2;
     }
 
+    public int EncodePlanes(nint encoder, ReadOnlyMemory<byte> y, int yStride, ReadOnlyMemory<byte> u, ReadOnlyMemory<byte> v, int uvStride, Memory<byte> outputBuffer)
+        => EncodeI420(encoder, y, outputBuffer);
+
+    public int EncodeNv12(nint encoder, ReadOnlyMemory<byte> y, int yStride, ReadOnlyMemory<byte> uv, int uvStride, Memory<byte> outputBuffer)
+        => EncodeI420(encoder, y, outputBuffer);
+
+    public int Encode(nint encoder, in FrameImage frame, Memory<byte> outputBuffer)
+        => EncodeI420(encoder, frame.Data, outputBuffer);
+
+    public int EncodeI420(nint encoder, ReadOnlyMemory<byte> frameData, IBufferWriter<byte> output)
+    {
+        Interlocked.Increment(ref _encodeCallCount);
+        return WriteDummyJpeg(output);
+    }
+
+    public int EncodeGray8(int width, int height, ReadOnlyMemory<byte> frameData, IBufferWriter<byte> output)
+    {
+        Interlocked.Increment(ref _encodeCallCount);
+        return WriteDummyJpeg(output);
+    }
+
+    internal static int WriteDummyJpeg(IBufferWriter<byte> output)
+    {
+        var span = output.GetSpan(2);
+        span[0] = 0xFF;
+        span[1] = 0xD8; // JPEG SOI marker
+        output.Advance(2);
+        return 2;
+    }
+
     public void Dispose()
     {
     }
@@ -192,6 +267,12 @@ internal sealed class MockJpegCodec : IJpegCodec
         return 2;
     }
 
+    public int Encode(in FrameImage frame, IBufferWriter<byte> output)
+    {
+        EncodeCallCount++;
+        return MockCodecPool.WriteDummyJpeg(output);
+    }
+
     public FrameImage Encode(in FrameImage frame)
     {
         EncodeCallCount++;
@@ -493,6 +574,62 @@ public class MjpegHdrEngineTests
         mockPool.DecodeCallCount.Should().Be(3);
     }
 
+    [Fact]
+    public async Task GetAsync_ShouldDecodeWindowInSingleBatch()
+    {
+        var mockPool = new MockCodecPool();
+        using var engine = new MjpegHdrEngine(
+            DummyGetImage,
+            mockPool,
+            new HdrBlend(),
+            MemoryPool<byte>.Shared) { PixelFormat = PixelFormat.I420 };
+        engine.HdrFrameWindowCount = 3;
+
+        using var result = await engine.GetAsync(10);
+
+        mockPool.DecodeBatchCallCount.Should().Be(1);
+    }
+
+    [Fact]
+    public async Task GetAsync_WithFrameCache_SequentialWindowsShouldDecodeEachFrameOnce()
+    {
+        var mockPool = new MockCodecPool();
+        using var cache = DecodedFrameCache.ForFrames(8, 2, 2);
+        using var engine = new MjpegHdrEngine(
+            DummyGetImage,
+            mockPool,
+            new HdrBlend(),
+            MemoryPool<byte>.Shared) { PixelFormat = PixelFormat.I420, FrameCache = cache };
+        engine.HdrFrameWindowCount = 3;
+
+        for (ulong frameId = 10; frameId < 15; frameId++)
+        {
+            using var result = await engine.GetAsync(frameId);
+        }
+
+        // Frames 8..14: 3 for the first window, then 1 new frame per window
+        mockPool.DecodeCallCount.Should().Be(7);
+        cache.Hits.Should().Be(8);
+    }
+
+    [Fact]
+    public async Task GetAsync_FusedDecodeBlend_ShouldDecodeBlendOnce()
+    {
+        var mockPool = new MockCodecPool();
+        using var engine = new MjpegHdrEngine(
+            DummyGetImage,
+            mockPool,
+            new HdrBlend(),
+            MemoryPool<byte>.Shared) { PixelFormat = PixelFormat.I420, FusedDecodeBlend = true };
+        engine.HdrFrameWindowCount = 3;
+
+        using var result = await engine.GetAsync(10);
+
+        mockPool.DecodeBlendCallCount.Should().Be(1);
+        mockPool.DecodeBatchCallCount.Should().Be(0);
+        mockPool.EncodeCallCount.Should().Be(1);
+    }
+
     [Fact]
     public async Task GetAsync_ShouldCallEncodeOnce()
     {
@@ -508,4 +645,119 @@ public class MjpegHdrEngineTests
 
         mockPool.EncodeCallCount.Should().Be(1);
     }
+
+    [Fact]
+    public async Task StreamAsync_ShouldFetchAndDecodeEachFrameOnce()
+    {
+        var fetchedIds = new System.Collections.Concurrent.ConcurrentBag<ulong>();
+
+        Task<IMemoryOwner<byte>> TrackingGetImage(ulong frameId)
+        {
+            fetchedIds.Add(frameId);
+            return Task.FromResult(MemoryPool<byte>.Shared.Rent(100));
+        }
+
+        var mockPool = new MockCodecPool();
+        using var engine = new MjpegHdrEngine(
+            TrackingGetImage,
+            mockPool,
+            new HdrBlend(),
+            MemoryPool<byte>.Shared) { PixelFormat = PixelFormat.I420 };
+        engine.HdrFrameWindowCount = 3;
+
+        int count = 0;
+        await foreach (var frame in engine.StreamAsync(10, 5, prefetch: 3))
+        {
+            frame.Dispose();
+            count++;
+        }
+
+        // Frames 8..14: 3 for the first window, then 1 new frame per window
+        count.Should().Be(5);
+        fetchedIds.Order().Should().Equal(8UL, 9UL, 10UL, 11UL, 12UL, 13UL, 14UL);
+        mockPool.DecodeCallCount.Should().Be(7);
+        mockPool.EncodeCallCount.Should().Be(5);
+    }
+
+    [Fact]
+    public async Task StreamAsync_WithOutOfOrderFetches_ShouldYieldWindowsInOrder()
+    {
+        const int width = 32;
+        const int height = 16;
+        using var pool = new JpegCodecPool(width, height, quality: 95);
+
+        // Frame n is flat gray at 10 * n; later frames arrive first
+        async Task<IMemoryOwner<byte>> GetImage(ulong frameId)
+        {
+            await Task.Delay(TimeSpan.FromMilliseconds((20 - (int)frameId) * 2));
+            var gray = new byte[width * height];
+            Array.Fill(gray, (byte)(frameId * 10));
+            var owner = MemoryPool<byte>.Shared.Rent(4096);
+            int length = pool.EncodeGray8(width, height, gray, owner.Memory);
+            var jpeg = MemoryPool<byte>.Shared.Rent(length);
+            owner.Memory[..length].CopyTo(jpeg.Memory);
+            owner.Dispose();
+            return new SlicedOwner(jpeg, length);
+        }
+
+        using var engine = new MjpegHdrEngine(GetImage, pool, new HdrBlend(), MemoryPool<byte>.Shared)
+        {
+            PixelFormat = PixelFormat.Gray8
+        };
+
+        var levels = new List<int>();
+        var decoded = new byte[width * height];
+        var decoder = pool.RentDecoder();
+        try
+        {
+            await foreach (var frame in engine.StreamAsync(1, 8, prefetch: 4))
+            {
+                using (frame)
+                {
+                    pool.DecodeGray(decoder, frame.Data, decoded);
+                    levels.Add(decoded[0]);
+                }
+            }
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+
+        // Window n averages frames n and n-1: (10n + 10(n-1) + 1) / 2
+        var expected = Enumerable.Range(1, 8).Select(n => (20 * n - 10 + 1) / 2).ToArray();
+        levels.Should().HaveCount(8);
+        for (int i = 0; i < levels.Count; i++)
+            levels[i].Should().BeCloseTo(expected[i], 2);
+    }
+
+    [Fact]
+    public async Task StreamAsync_BreakEarly_ShouldStopFetching()
+    {
+        int fetched = 0;
+
+        Task<IMemoryOwner<byte>> CountingGetImage(ulong frameId)
+        {
+            Interlocked.Increment(ref fetched);
+            return Task.FromResult(MemoryPool<byte>.Shared.Rent(100));
+        }
+
+        using var engine = CreateEngine(CountingGetImage);
+
+        await foreach (var frame in engine.StreamAsync(0, 1000, prefetch: 2))
+        {
+            frame.Dispose();
+            break;
+        }
+
+        // Only the two prefetched windows (frames 0 and 1) were started
+        Volatile.Read(ref fetched).Should().Be(2);
+    }
+
+    private sealed class SlicedOwner(IMemoryOwner<byte> inner, int length) : IMemoryOwner<byte>
+    {
+        public Memory<byte> Memory => inner.Memory[..length];
+
+        public void Dispose() => inner.Dispose();
+    }
 }
@@ -0,0 +1,111 @@
+using FluentAssertions;
+using Xunit;
+
+namespace ModelingEvolution.Mjpeg.Tests;
+
+public class MjpegMappedFrameSourceTests : IDisposable
+{
+    private readonly string _dir = Directory.CreateTempSubdirectory("mjmap").FullName;
+
+    public void Dispose() => Directory.Delete(_dir, recursive: true);
+
+    private static byte[] Frame(byte fill) => [0xFF, 0xD8, fill, fill, fill, 0xFF, 0xD9];
+
+    private async Task<string> WriteRecordingAsync(params byte[][] frames)
+    {
+        var path = Path.Combine(_dir, "rec.mjpeg");
+        await File.WriteAllBytesAsync(path, frames.SelectMany(f => f).ToArray());
+        return path;
+    }
+
+    [Fact]
+    public async Task GetFrame_InReverseOrder_ShouldReturnFrameBytes()
+    {
+        var path = await WriteRecordingAsync(Frame(1), Frame(2), Frame(3));
+        using var source = await MjpegMappedFrameSource.OpenAsync(path);
+
+        source.Count.Should().Be(3);
+        for (int i = source.Count - 1; i >= 0; i--)
+        {
+            using var frame = source.GetFrame((ulong)i);
+            frame.Memory.ToArray().Should().Equal(Frame((byte)(i + 1)));
+            source.GetFrameSpan(i).ToArray().Should().Equal(Frame((byte)(i + 1)));
+        }
+    }
+
+    [Fact]
+    public async Task Dispose_WhileFrameHeld_ShouldKeepFrameReadable()
+    {
+        var path = await WriteRecordingAsync(Frame(7), Frame(8));
+        var source = await MjpegMappedFrameSource.OpenAsync(path);
+
+        var frame = source.GetFrame(1);
+        source.Dispose();
+
+        frame.Memory.ToArray().Should().Equal(Frame(8));
+        frame.Dispose();
+        var act = () => source.GetFrame(0);
+        act.Should().Throw<ObjectDisposedException>();
+    }
+
+    [Fact]
+    public async Task Dispose_Twice_ShouldNotReleaseAnotherFrame()
+    {
+        var path = await WriteRecordingAsync(Frame(4), Frame(5));
+        using var source = await MjpegMappedFrameSource.OpenAsync(path);
+
+        var first = source.GetFrame(0);
+        first.Dispose();
+        using var second = source.GetFrame(1);
+        first.Dispose();
+
+        second.Memory.ToArray().Should().Equal(Frame(5));
+    }
+
+    [Fact]
+    public async Task WriteToFrame_ShouldNotReachRecording()
+    {
+        var path = await WriteRecordingAsync(Frame(6));
+        using var source = await MjpegMappedFrameSource.OpenAsync(path);
+
+        using (var frame = source.GetFrame(0))
+            frame.Memory.Span[2] = 0;
+
+        (await File.ReadAllBytesAsync(path)).Should().Equal(Frame(6));
+    }
+
+    [Fact]
+    public async Task DecodeI420_FromMappedFrame_ShouldMatchCopiedFrame()
+    {
+        const int width = 64;
+        const int height = 48;
+        using var pool = new JpegCodecPool(width, height);
+
+        var pixels = new byte[width * height * 3 / 2];
+        new Random(3).NextBytes(pixels);
+        var encoded = new byte[pixels.Length * 2];
+        var encoder = pool.RentEncoder();
+        int length = pool.EncodeI420(encoder, pixels, encoded);
+        pool.ReturnEncoder(encoder);
+        var jpeg = encoded.AsSpan(0, length).ToArray();
+
+        var path = await WriteRecordingAsync(jpeg, jpeg);
+        using var source = await MjpegMappedFrameSource.OpenAsync(path);
+
+        var decoder = pool.RentDecoder();
+        try
+        {
+            var expected = new byte[pixels.Length];
+            var actual = new byte[pixels.Length];
+            pool.DecodeI420(decoder, jpeg, expected);
+            using var frame = source.GetFrame(1);
+            pool.DecodeI420(decoder, frame.Memory, actual);
+
+            actual.Should().Equal(expected);
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+}
@@ -0,0 +1,123 @@
+using FluentAssertions;
+using Xunit;
+
+namespace ModelingEvolution.Mjpeg.Tests;
+
+public class MjpegProxyWriterTests : IDisposable
+{
+    private const int Width = 320;
+    private const int Height = 240;
+
+    private readonly string _dir = Directory.CreateTempSubdirectory("mjproxy").FullName;
+
+    public void Dispose() => Directory.Delete(_dir, recursive: true);
+
+    private static byte[][] EncodeFrames(int count)
+    {
+        using var pool = new JpegCodecPool(Width, Height);
+        var encoder = pool.RentEncoder();
+        try
+        {
+            var frames = new byte[count][];
+            var pixels = new byte[Width * Height * 3 / 2];
+            var encoded = new byte[pixels.Length * 2];
+            for (int i = 0; i < count; i++)
+            {
+                Array.Fill(pixels, (byte)(40 + i * 30));
+                int length = pool.EncodeI420(encoder, pixels, encoded);
+                frames[i] = encoded.AsSpan(0, length).ToArray();
+            }
+            return frames;
+        }
+        finally
+        {
+            pool.ReturnEncoder(encoder);
+        }
+    }
+
+    private async Task<string> WriteRecordingAsync(byte[][] frames)
+    {
+        var path = Path.Combine(_dir, "rec.mjpeg");
+        await File.WriteAllBytesAsync(path, frames.SelectMany(f => f).ToArray());
+        return path;
+    }
+
+    [Fact]
+    public void GetDefaultPath_ShouldReplaceExtension()
+    {
+        MjpegProxyWriter.GetDefaultPath(Path.Combine("rec", "stream.mjpeg"))
+            .Should().Be(Path.Combine("rec", "stream.proxy.mjpeg"));
+    }
+
+    [Fact]
+    public async Task Append_ShouldWriteEighthSizeFramesWithIndex()
+    {
+        var frames = EncodeFrames(3);
+        var proxyPath = Path.Combine(_dir, "rec.proxy.mjpeg");
+
+        using (var writer = new MjpegProxyWriter(proxyPath))
+        {
+            foreach (var frame in frames)
+                writer.Append(frame);
+            writer.Count.Should().Be(3);
+        }
+
+        using var proxy = await MjpegMappedFrameSource.OpenAsync(proxyPath);
+        proxy.Count.Should().Be(3);
+        for (int i = 0; i < proxy.Count; i++)
+        {
+            JpegDimensionExtractor.TryExtractInfo(proxy.GetFrameSpan(i), out var info).Should().BeTrue();
+            info.Width.Should().Be(Width / 8);
+            info.Height.Should().Be(Height / 8);
+        }
+        new FileInfo(proxyPath).Length.Should().BeLessThan(frames.Sum(f => f.Length));
+    }
+
+    [Fact]
+    public async Task BuildAsync_AfterRecordingGrew_ShouldAppendMissingFrames()
+    {
+        var frames = EncodeFrames(4);
+        var path = await WriteRecordingAsync(frames[..2]);
+
+        using (var first = await MjpegProxyWriter.BuildAsync(path))
+            first.Count.Should().Be(2);
+
+        await File.WriteAllBytesAsync(path, frames.SelectMany(f => f).ToArray());
+        using var index = await MjpegProxyWriter.BuildAsync(path);
+
+        index.Count.Should().Be(4);
+        using var proxy = await MjpegMappedFrameSource.OpenAsync(MjpegProxyWriter.GetDefaultPath(path));
+        using var pool = new JpegCodecPool(Width / 8, Height / 8);
+        var decoder = pool.RentDecoder();
+        try
+        {
+            // Each proxy frame keeps the flat level of the recording frame with the same number
+            var pixels = new byte[Width / 8 * (Height / 8) * 3 / 2];
+            for (int i = 0; i < proxy.Count; i++)
+            {
+                using var frame = proxy.GetFrame((ulong)i);
+                pool.DecodeI420(decoder, frame.Memory, pixels);
+                ((int)pixels[0]).Should().BeCloseTo(40 + i * 30, 3);
+            }
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+    }
+
+    [Fact]
+    public void Append_FrameOfDifferentSize_ShouldThrow()
+    {
+        using var writer = new MjpegProxyWriter(Path.Combine(_dir, "rec.proxy.mjpeg"));
+        writer.Append(EncodeFrames(1)[0]);
+
+        using var pool = new JpegCodecPool(64, 48);
+        var gray = new byte[64 * 48];
+        var encoded = new byte[gray.Length * 2];
+        int length = pool.EncodeGray8(64, 48, gray, encoded);
+
+        var act = () => writer.Append(encoded.AsMemory(0, length));
+        act.Should().Throw<InvalidDataException>();
+    }
+}
@@ -0,0 +1,61 @@
+using FluentAssertions;
+using Xunit;
+
+namespace ModelingEvolution.Mjpeg.Tests;
+
+public class PooledBufferWriterTests
+{
+    [Fact]
+    public void Advance_ShouldExposeWrittenBytes()
+    {
+        using var writer = new PooledBufferWriter();
+
+        var span = writer.GetSpan(3);
+        span[0] = 1;
+        span[1] = 2;
+        span[2] = 3;
+        writer.Advance(3);
+
+        writer.WrittenCount.Should().Be(3);
+        writer.WrittenMemory.ToArray().Should().Equal(1, 2, 3);
+        writer.Memory.Length.Should().Be(3);
+    }
+
+    [Fact]
+    public void GetMemory_BeyondCapacity_ShouldGrowAndPreserveData()
+    {
+        using var writer = new PooledBufferWriter(16);
+        int initialCapacity = writer.Capacity;
+
+        var data = Enumerable.Range(0, initialCapacity).Select(i => (byte)i).ToArray();
+        data.CopyTo(writer.GetSpan(data.Length));
+        writer.Advance(data.Length);
+
+        var more = writer.GetMemory(100);
+
+        more.Length.Should().BeGreaterThanOrEqualTo(100);
+        writer.Capacity.Should().BeGreaterThan(initialCapacity);
+        writer.WrittenMemory.ToArray().Should().Equal(data);
+    }
+
+    [Fact]
+    public void Advance_PastCapacity_ShouldThrow()
+    {
+        using var writer = new PooledBufferWriter();
+
+        var act = () => writer.Advance(writer.Capacity + 1);
+
+        act.Should().Throw<InvalidOperationException>();
+    }
+
+    [Fact]
+    public void AsFrameImageOwner_ShouldSliceToWrittenLength()
+    {
+        var writer = new PooledBufferWriter();
+        MockCodecPool.WriteDummyJpeg(writer);
+
+        using var image = new FrameImage(new FrameHeader(2, 2, 2, PixelFormat.Gray8, writer.WrittenCount), writer);
+
+        image.Data.ToArray().Should().Equal(0xFF, 0xD8);
+    }
+}
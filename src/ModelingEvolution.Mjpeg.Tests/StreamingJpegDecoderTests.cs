@@ -0,0 +1,118 @@
+using FluentAssertions;
+using Xunit;
+
+namespace ModelingEvolution.Mjpeg.Tests;
+
+/// <summary>
+/// Tests for StreamingJpegDecoder that require the native LibJpegWrap library.
+/// </summary>
+public class StreamingJpegDecoderTests
+{
+    private const int Width = 128;
+    private const int Height = 96;
+
+    private static byte[] EncodeGradientI420(JpegCodecPool pool)
+    {
+        var frame = new byte[Width * Height * 3 / 2];
+        for (int y = 0; y < Height; y++)
+            for (int x = 0; x < Width; x++)
+                frame[y * Width + x] = (byte)((x * 2 + y * 3) & 0xFF);
+        frame.AsSpan(Width * Height).Fill(128);
+
+        var encoder = pool.RentEncoder();
+        try
+        {
+            var output = new byte[frame.Length * 2];
+            int length = pool.EncodeI420(encoder, frame, output);
+            return output.AsSpan(0, length).ToArray();
+        }
+        finally
+        {
+            pool.ReturnEncoder(encoder);
+        }
+    }
+
+    [Theory]
+    [InlineData(1)]
+    [InlineData(97)]
+    [InlineData(4096)]
+    public void Feed_InChunks_ShouldMatchBufferedDecode(int chunkSize)
+    {
+        using var pool = new JpegCodecPool(Width, Height);
+        var jpeg = EncodeGradientI420(pool);
+
+        var expected = new byte[Width * Height * 3 / 2];
+        var decoder = pool.RentDecoder();
+        var expectedHeader = pool.DecodeI420(decoder, jpeg, expected);
+        pool.ReturnDecoder(decoder);
+
+        using var streaming = new StreamingJpegDecoder(Width, Height);
+        var output = new byte[expected.Length];
+        streaming.Begin(output);
+
+        var status = StreamingDecodeStatus.NeedMoreData;
+        for (int offset = 0; offset < jpeg.Length; offset += chunkSize)
+        {
+            int length = Math.Min(chunkSize, jpeg.Length - offset);
+            bool last = offset + length == jpeg.Length;
+            status = streaming.Feed(jpeg.AsSpan(offset, length), last);
+            if (!last)
+                status.Should().Be(StreamingDecodeStatus.NeedMoreData);
+        }
+
+        status.Should().Be(StreamingDecodeStatus.Completed);
+        streaming.Header.Should().Be(expectedHeader);
+        output.Should().Equal(expected);
+    }
+
+    [Theory]
+    [InlineData(1920, 1080)]
+    [InlineData(321, 241)]
+    public void Feed_OffMcuGridSize_ShouldMatchBufferedDecode(int width, int height)
+    {
+        using var pool = new JpegCodecPool(width, height);
+        var frame = new byte[FrameHeader.Create(width, height, PixelFormat.I420).Length];
+        new Random(width).NextBytes(frame);
+        var encoded = new byte[frame.Length * 2];
+        var encoder = pool.RentEncoder();
+        var jpeg = encoded.AsSpan(0, pool.EncodeI420(encoder, frame, encoded)).ToArray();
+        pool.ReturnEncoder(encoder);
+
+        var expected = new byte[frame.Length];
+        var decoder = pool.RentDecoder();
+        var expectedHeader = pool.DecodeI420(decoder, jpeg, expected);
+        pool.ReturnDecoder(decoder);
+
+        using var streaming = new StreamingJpegDecoder(width, height);
+        var output = new byte[expected.Length];
+        streaming.Begin(output);
+
+        var status = StreamingDecodeStatus.NeedMoreData;
+        for (int offset = 0; offset < jpeg.Length; offset += 4096)
+        {
+            int length = Math.Min(4096, jpeg.Length - offset);
+            status = streaming.Feed(jpeg.AsSpan(offset, length), offset + length == jpeg.Length);
+        }
+
+        status.Should().Be(StreamingDecodeStatus.Completed);
+        streaming.Header.Should().Be(expectedHeader);
+        output.Should().Equal(expected);
+    }
+
+    [Fact]
+    public void Feed_TruncatedFrame_ShouldFailAndAllowNextFrame()
+    {
+        using var pool = new JpegCodecPool(Width, Height);
+        var jpeg = EncodeGradientI420(pool);
+
+        using var streaming = new StreamingJpegDecoder(Width, Height);
+        var output = new byte[Width * Height * 3 / 2];
+
+        streaming.Begin(output);
+        streaming.Feed(jpeg.AsSpan(0, jpeg.Length / 2), isLast: true).Should().Be(StreamingDecodeStatus.Failed);
+
+        streaming.Begin(output, PixelFormat.Gray8);
+        streaming.Feed(jpeg, isLast: true).Should().Be(StreamingDecodeStatus.Completed);
+        streaming.Header.Should().Be(new FrameHeader(Width, Height, Width, PixelFormat.Gray8, Width * Height));
+    }
+}
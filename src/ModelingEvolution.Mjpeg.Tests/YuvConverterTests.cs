@@ -0,0 +1,73 @@
+using FluentAssertions;
+using Xunit;
+
+namespace ModelingEvolution.Mjpeg.Tests;
+
+/// <summary>
+/// Tests for YuvConverter that require the native LibJpegWrap library.
+/// </summary>
+public class YuvConverterTests
+{
+    // 40 pixels wide exercises both the 16-pixel SIMD blocks and the scalar tail
+    private const int Width = 40;
+    private const int Height = 4;
+
+    private static byte[] SolidI420(byte y, byte u, byte v)
+    {
+        var frame = new byte[Width * Height * 3 / 2];
+        frame.AsSpan(0, Width * Height).Fill(y);
+        frame.AsSpan(Width * Height, Width * Height / 4).Fill(u);
+        frame.AsSpan(Width * Height * 5 / 4).Fill(v);
+        return frame;
+    }
+
+    [Theory]
+    [InlineData(76, 85, 255, 255, 0, 0)]     // Red
+    [InlineData(150, 44, 21, 0, 255, 0)]     // Green
+    [InlineData(29, 255, 107, 0, 0, 255)]    // Blue
+    [InlineData(128, 128, 128, 128, 128, 128)]
+    public void I420ToBgra_SolidColors_ShouldMatchJfifMatrix(byte y, byte u, byte v, int r, int g, int b)
+    {
+        var header = FrameHeader.Create(Width, Height, PixelFormat.I420);
+        var bgra = new byte[Width * Height * 4];
+
+        var result = YuvConverter.I420ToBgra(header, SolidI420(y, u, v), bgra);
+
+        result.Should().Be(new FrameHeader(Width, Height, Width * 4, PixelFormat.Bgra32, bgra.Length));
+        for (int i = 0; i < bgra.Length; i += 4)
+        {
+            bgra[i].Should().BeCloseTo((byte)b, 2);
+            bgra[i + 1].Should().BeCloseTo((byte)g, 2);
+            bgra[i + 2].Should().BeCloseTo((byte)r, 2);
+            bgra[i + 3].Should().Be(255);
+        }
+    }
+
+    [Fact]
+    public void I420ToBgra_RgbaWithStride_ShouldSwapChannelsAndKeepPadding()
+    {
+        const int stride = Width * 4 + 24;
+        var header = FrameHeader.Create(Width, Height, PixelFormat.I420);
+        var i420 = SolidI420(76, 85, 255);
+        var bgra = new byte[Width * Height * 4];
+        var rgba = new byte[stride * Height];
+        rgba.AsSpan().Fill(0xAB);
+
+        YuvConverter.I420ToBgra(header, i420, bgra);
+        var result = YuvConverter.I420ToBgra(header, i420, rgba, PixelFormat.Rgba32, stride);
+
+        result.Stride.Should().Be(stride);
+        for (int row = 0; row < Height; row++)
+        {
+            for (int x = 0; x < Width; x++)
+            {
+                int s = row * Width * 4 + x * 4;
+                int d = row * stride + x * 4;
+                rgba[d].Should().Be(bgra[s + 2]);
+                rgba[d + 1].Should().Be(bgra[s + 1]);
+                rgba[d + 2].Should().Be(bgra[s]);
+            }
+            rgba.AsSpan(row * stride + Width * 4, stride - Width * 4).ToArray().Should().AllBeEquivalentTo((byte)0xAB);
+        }
+    }
+}
@@ -5,6 +5,7 @@ namespace ModelingEvolution.Mjpeg.Wasm.Tests;
 /// <summary>
 /// Fake native decoder for unit testing.
 /// Tracks Create/Close calls and simulates decode by writing a pattern to output.
+/// The worker pool decodes on Submit and hands results back newest first, so completions arrive out of order.
 /// </summary>
 internal sealed class FakeNativeDecoder : INativeDecoder
 {
@@ -12,9 +13,18 @@ internal sealed class FakeNativeDecoder : INativeDecoder
     public ConcurrentBag<nint> CreatedDecoders { get; } = new();
     public ConcurrentBag<nint> ClosedDecoders { get; } = new();
     public ConcurrentBag<nint> DecodeCalledWith { get; } = new();
+    public ConcurrentBag<int> DecodeScales { get; } = new();
+    public ConcurrentBag<(int Order, int Stride)> DecodeLayouts { get; } = new();
+    public ConcurrentBag<nint> CreatedPools { get; } = new();
+    public ConcurrentBag<nint> ClosedPools { get; } = new();
+    public ConcurrentBag<ulong> SubmittedJobs { get; } = new();
     public bool ShouldFailDecode { get; set; }
     public int DecodeDelayMs { get; set; }
 
+    private readonly ConcurrentStack<WasmJpegNative.DecodeJobResult> _completed = new();
+    private int _poolCapacity;
+    private int _inFlight;
+
     public nint CreateDecoder(int maxWidth, int maxHeight)
     {
         var handle = (nint)Interlocked.Increment(ref _nextHandle);
@@ -28,9 +38,11 @@ internal sealed class FakeNativeDecoder : INativeDecoder
     }
 
     public unsafe uint Decode(nint decoder, nint jpegData, uint jpegSize,
-        nint output, uint outputSize, WasmJpegNative.DecodeInfo* info)
+        nint output, uint outputSize, WasmJpegNative.DecodeInfo* info, int scaleDenom, int order, int stride)
     {
         DecodeCalledWith.Add(decoder);
+        DecodeScales.Add(scaleDenom);
+        DecodeLayouts.Add((order, stride));
 
         if (DecodeDelayMs > 0)
             Thread.Sleep(DecodeDelayMs);
@@ -38,13 +50,14 @@ internal sealed class FakeNativeDecoder : INativeDecoder
         if (ShouldFailDecode)
             return 0;
 
-        info->Width = 16;
-        info->Height = 16;
+        int size = 16 / scaleDenom;
+        info->Width = size;
+        info->Height = size;
         info->Components = 4;
         info->ColorSpace = 0;
 
         // Write a recognizable pattern to output (BGRA: blue channel = 0xFF)
-        uint written = Math.Min(outputSize, 16u * 16u * 4u);
+        uint written = Math.Min(outputSize, (uint)(size * size * 4));
         var span = new Span<byte>((void*)output, (int)written);
         for (int i = 0; i < span.Length; i += 4)
         {
@@ -56,4 +69,42 @@ internal sealed class FakeNativeDecoder : INativeDecoder
 
         return written;
     }
+
+    public nint CreateWorkerPool(int threads, int maxWidth, int maxHeight, int capacity)
+    {
+        var handle = (nint)Interlocked.Increment(ref _nextHandle);
+        _poolCapacity = capacity;
+        CreatedPools.Add(handle);
+        return handle;
+    }
+
+    public void CloseWorkerPool(nint pool)
+    {
+        ClosedPools.Add(pool);
+    }
+
+    public unsafe bool Submit(nint pool, ulong id, nint jpegData, uint jpegSize,
+        nint output, uint outputSize, int scaleDenom, int order, int stride)
+    {
+        if (Interlocked.Increment(ref _inFlight) > _poolCapacity)
+        {
+            Interlocked.Decrement(ref _inFlight);
+            return false;
+        }
+
+        SubmittedJobs.Add(id);
+        var result = new WasmJpegNative.DecodeJobResult { Id = id };
+        result.Written = Decode(pool, jpegData, jpegSize, output, outputSize, &result.Info, scaleDenom, order, stride);
+        _completed.Push(result);
+        return true;
+    }
+
+    public unsafe int Poll(nint pool, WasmJpegNative.DecodeJobResult* results, int max)
+    {
+        int count = 0;
+        while (count < max && _completed.TryPop(out var result))
+            results[count++] = result;
+        Interlocked.Add(ref _inFlight, -count);
+        return count;
+    }
 }
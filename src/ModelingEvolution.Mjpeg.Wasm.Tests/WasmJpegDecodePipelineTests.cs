@@ -87,6 +87,86 @@ public class WasmJpegDecodePipelineTests : IDisposable
         result.FrameId.Should().Be(1);
     }
 
+    [Fact]
+    public async Task PushAndRead_ScaledRequest_PassesScaleToNative()
+    {
+        var fake = new FakeNativeDecoder();
+        await using var pipeline = new WasmJpegDecodePipeline(fake, 1920, 1080, workerCount: 1);
+
+        var bitmap = RentBitmap(4, 4);
+        await pipeline.PushAsync(new DecodeRequest(1, FakeJpeg, bitmap, ScaleDenominator: 4));
+
+        using var cts = new CancellationTokenSource(5000);
+        var result = await pipeline.ReadAsync(cts.Token);
+
+        result.Success.Should().BeTrue();
+        fake.DecodeScales.Should().Equal(4);
+    }
+
+    [Fact]
+    public async Task PushAndRead_RgbaPaddedTarget_PassesOrderAndStrideToNative()
+    {
+        var fake = new FakeNativeDecoder();
+        await using var pipeline = new WasmJpegDecodePipeline(fake, 1920, 1080, workerCount: 1);
+
+        // 256-byte aligned rows, as for a WebGL texture upload
+        using var bitmap = new SKBitmap();
+        bitmap.TryAllocPixels(new SKImageInfo(16, 16, SKColorType.Rgba8888, SKAlphaType.Premul), 256)
+            .Should().BeTrue();
+        await pipeline.PushAsync(new DecodeRequest(1, FakeJpeg, bitmap));
+
+        using var cts = new CancellationTokenSource(5000);
+        var result = await pipeline.ReadAsync(cts.Token);
+
+        result.Success.Should().BeTrue();
+        fake.DecodeLayouts.Should().Equal((1, 256));
+    }
+
+    [Fact]
+    public async Task NativeWorkers_PushAndRead_MaintainsOrder()
+    {
+        var fake = new FakeNativeDecoder();
+        await using var pipeline = new WasmJpegDecodePipeline(fake, 1920, 1080, workerCount: 2, nativeWorkers: true);
+
+        pipeline.UsesNativeWorkers.Should().BeTrue();
+        fake.CreatedDecoders.Should().BeEmpty();
+
+        const int frameCount = 8;
+        using var cts = new CancellationTokenSource(10000);
+
+        var producer = Task.Run(async () =>
+        {
+            for (int i = 0; i < frameCount; i++)
+                await pipeline.PushAsync(new DecodeRequest((ulong)i, FakeJpeg, RentBitmap()), cts.Token);
+        });
+
+        // The fake completes jobs newest first; results must still come out in frame order
+        for (ulong i = 0; i < frameCount; i++)
+        {
+            var result = await pipeline.ReadAsync(cts.Token);
+            result.FrameId.Should().Be(i);
+            result.Success.Should().BeTrue();
+        }
+
+        await producer;
+        fake.SubmittedJobs.Count.Should().Be(frameCount);
+    }
+
+    [Fact]
+    public async Task NativeWorkers_DisposeAsync_ClosesWorkerPool()
+    {
+        var fake = new FakeNativeDecoder();
+        var pipeline = new WasmJpegDecodePipeline(fake, 1920, 1080, workerCount: 2, nativeWorkers: true);
+
+        await pipeline.PushAsync(new DecodeRequest(1, FakeJpeg, RentBitmap()));
+        using var cts = new CancellationTokenSource(5000);
+        (await pipeline.ReadAsync(cts.Token)).Success.Should().BeTrue();
+
+        await pipeline.DisposeAsync();
+
+        fake.ClosedPools.Should().BeEquivalentTo(fake.CreatedPools);
+    }
+
     [Fact]
     public async Task Reset_AcceptsNewWork()
     {
@@ -8,8 +8,19 @@ internal interface INativeDecoder
 {
     nint CreateDecoder(int maxWidth, int maxHeight);
     void CloseDecoder(nint decoder);
+
+    // order: 0 = BGRA, 1 = RGBA; stride: destination row bytes (0 = width * 4)
     unsafe uint Decode(nint decoder, nint jpegData, uint jpegSize,
-        nint output, uint outputSize, WasmJpegNative.DecodeInfo* info);
+        nint output, uint outputSize, WasmJpegNative.DecodeInfo* info, int scaleDenom, int order, int stride);
+
+    // Native worker pool: Submit returns false when full, Poll never blocks
+    nint CreateWorkerPool(int threads, int maxWidth, int maxHeight, int capacity);
+    void CloseWorkerPool(nint pool);
+
+    bool Submit(nint pool, ulong id, nint jpegData, uint jpegSize,
+        nint output, uint outputSize, int scaleDenom, int order, int stride);
+
+    unsafe int Poll(nint pool, WasmJpegNative.DecodeJobResult* results, int max);
 }
 
 internal sealed class WasmNativeDecoder : INativeDecoder
@@ -23,6 +34,26 @@ internal sealed class WasmNativeDecoder : INativeDecoder
         => WasmJpegNative.CloseBgraDecoder(decoder);
 
     public unsafe uint Decode(nint decoder, nint jpegData, uint jpegSize,
-        nint output, uint outputSize, WasmJpegNative.DecodeInfo* info)
-        => WasmJpegNative.DecoderDecodeBGRA(decoder, jpegData, jpegSize, output, outputSize, info);
+        nint output, uint outputSize, WasmJpegNative.DecodeInfo* info, int scaleDenom, int order, int stride)
+    {
+        if (order != 0 || stride != 0)
+            return WasmJpegNative.DecoderDecodePacked(decoder, jpegData, jpegSize, output, outputSize, info, scaleDenom, order, stride);
+
+        return scaleDenom == 1
+            ? WasmJpegNative.DecoderDecodeBGRA(decoder, jpegData, jpegSize, output, outputSize, info)
+            : WasmJpegNative.DecoderDecodeBGRAScaled(decoder, jpegData, jpegSize, output, outputSize, info, scaleDenom);
+    }
+
+    public nint CreateWorkerPool(int threads, int maxWidth, int maxHeight, int capacity)
+        => WasmJpegNative.CreateBgraWorkerPool(threads, maxWidth, maxHeight, capacity);
+
+    public void CloseWorkerPool(nint pool)
+        => WasmJpegNative.CloseBgraWorkerPool(pool);
+
+    public bool Submit(nint pool, ulong id, nint jpegData, uint jpegSize,
+        nint output, uint outputSize, int scaleDenom, int order, int stride)
+        => WasmJpegNative.BgraWorkerSubmit(pool, id, jpegData, jpegSize, output, outputSize, scaleDenom, order, stride) != 0;
+
+    public unsafe int Poll(nint pool, WasmJpegNative.DecodeJobResult* results, int max)
+        => WasmJpegNative.BgraWorkerPoll(pool, results, max);
 }
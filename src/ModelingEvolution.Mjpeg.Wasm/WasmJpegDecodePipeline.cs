@@ -1,3 +1,4 @@
+using System.Buffers;
 using System.Collections.Concurrent;
 using System.Diagnostics;
 using System.Threading;
@@ -10,6 +11,9 @@ namespace ModelingEvolution.Mjpeg.Wasm;
 /// Async JPEG decode pipeline with internal multi-threading.
 /// Push input (JPEG bytes + target bitmap), receive decoded bitmaps in frame order.
 /// Uses TPL Dataflow TransformBlock for parallel decode with ordered output.
+/// With <c>nativeWorkers</c> the decodes run on native pthreads (LibJpegWrap BgraWorkerPool) instead of
+/// .NET WASM thread pool threads; the block only submits jobs and awaits their completion, so it never
+/// blocks the calling (browser main) thread.
 /// </summary>
 public sealed class WasmJpegDecodePipeline : IAsyncDisposable
 {
@@ -21,18 +25,37 @@ public sealed class WasmJpegDecodePipeline : IAsyncDisposable
     private readonly int _workerCount;
     private ulong _generation;
 
-    public WasmJpegDecodePipeline(int maxWidth, int maxHeight, int workerCount = 2)
-        : this(WasmNativeDecoder.Instance, maxWidth, maxHeight, workerCount) { }
+    // Native worker mode: pending jobs by id, completed by the poll loop
+    private const int PollBatch = 8;
+    private static readonly TimeSpan PollInterval = TimeSpan.FromMilliseconds(1);
+    private readonly nint _workerPool;
+    private readonly ConcurrentDictionary<ulong, TaskCompletionSource<uint>> _jobs = new();
+    private ulong _nextJobId;
+    private int _polling;
 
-    internal WasmJpegDecodePipeline(INativeDecoder native, int maxWidth, int maxHeight, int workerCount = 2)
+    public WasmJpegDecodePipeline(int maxWidth, int maxHeight, int workerCount = 2, bool nativeWorkers = false)
+        : this(WasmNativeDecoder.Instance, maxWidth, maxHeight, workerCount, nativeWorkers) { }
+
+    internal WasmJpegDecodePipeline(INativeDecoder native, int maxWidth, int maxHeight, int workerCount = 2,
+        bool nativeWorkers = false)
     {
         _native = native;
         _maxWidth = maxWidth;
         _maxHeight = maxHeight;
         _workerCount = workerCount;
 
-        for (int i = 0; i < workerCount; i++)
-            _decoderPool.Enqueue(_native.CreateDecoder(maxWidth, maxHeight));
+        if (nativeWorkers)
+        {
+            // Capacity matches BoundedCapacity; jobs left over from a Reset wait their turn in Submit
+            _workerPool = _native.CreateWorkerPool(workerCount, maxWidth, maxHeight, workerCount * 2);
+            if (_workerPool == 0)
+                throw new InvalidOperationException("Failed to create native decode worker pool");
+        }
+        else
+        {
+            for (int i = 0; i < workerCount; i++)
+                _decoderPool.Enqueue(_native.CreateDecoder(maxWidth, maxHeight));
+        }
 
         _decodeBlock = CreateBlock();
     }
@@ -70,6 +93,11 @@ public sealed class WasmJpegDecodePipeline : IAsyncDisposable
         return _decodeBlock.TryReceive(out result);
     }
 
+    /// <summary>
+    /// True when decodes run on native worker threads.
+    /// </summary>
+    public bool UsesNativeWorkers => _workerPool != 0;
+
     /// <summary>
     /// Number of items waiting in output queue.
     /// </summary>
@@ -88,15 +116,17 @@ public sealed class WasmJpegDecodePipeline : IAsyncDisposable
     private TransformBlock<DecodeRequest, DecodeResult> CreateBlock()
     {
         var gen = Interlocked.Read(ref _generation);
-        return new TransformBlock<DecodeRequest, DecodeResult>(
-            request => Decode(request, gen),
-            new ExecutionDataflowBlockOptions
-            {
-                MaxDegreeOfParallelism = _workerCount,
-                BoundedCapacity = _workerCount * 2,
-                EnsureOrdered = true,
-                SingleProducerConstrained = true
-            });
+        var options = new ExecutionDataflowBlockOptions
+        {
+            MaxDegreeOfParallelism = _workerCount,
+            BoundedCapacity = _workerCount * 2,
+            EnsureOrdered = true,
+            SingleProducerConstrained = true
+        };
+
+        return _workerPool != 0
+            ? new TransformBlock<DecodeRequest, DecodeResult>(request => DecodeOnWorkerAsync(request, gen), options)
+            : new TransformBlock<DecodeRequest, DecodeResult>(request => Decode(request, gen), options);
     }
 
     private readonly ConcurrentDictionary<int, bool> _loggedDecodeThreads = new();
@@ -117,21 +147,25 @@ public sealed class WasmJpegDecodePipeline : IAsyncDisposable
         var sw = Stopwatch.StartNew();
         try
         {
-            var pixels = request.Target.GetPixels();
+            var target = request.Target;
+            var pixels = target.GetPixels();
 
-            Debug.Assert(request.Target.RowBytes == request.Target.Width * 4,
-                $"SKBitmap row stride mismatch: {request.Target.RowBytes} != {request.Target.Width * 4}");
-
-            var bufferSize = (uint)(request.Target.RowBytes * request.Target.Height);
+            // Padded rows (aligned WebGL uploads, some SKBitmap allocations) are written in place
+            int order = PixelOrder(target.ColorType);
+            int stride = target.RowBytes == target.Width * 4 ? 0 : target.RowBytes;
+            var bufferSize = (uint)(target.RowBytes * target.Height);
             var info = new WasmJpegNative.DecodeInfo();
 
-            unsafe
+            if (order >= 0)
             {
-                using var pin = request.JpegData.Pin();
-                var written = _native.Decode(
-                    decoder, (nint)pin.Pointer, (uint)request.JpegData.Length,
-                    pixels, bufferSize, &info);
-                success = written > 0;
+                unsafe
+                {
+                    using var pin = request.JpegData.Pin();
+                    var written = _native.Decode(
+                        decoder, (nint)pin.Pointer, (uint)request.JpegData.Length,
+                        pixels, bufferSize, &info, request.ScaleDenominator, order, stride);
+                    success = written > 0;
+                }
             }
 
             if (success)
@@ -150,6 +184,77 @@ public sealed class WasmJpegDecodePipeline : IAsyncDisposable
         return new DecodeResult(request.FrameId, request.Target, success, sw.ElapsedTicks);
     }
 
+    private async Task<DecodeResult> DecodeOnWorkerAsync(DecodeRequest request, ulong generation)
+    {
+        var target = request.Target;
+        int order = PixelOrder(target.ColorType);
+        if (Interlocked.Read(ref _generation) != generation || order < 0)
+            return new DecodeResult(request.FrameId, target, false);
+
+        var sw = Stopwatch.StartNew();
+        int stride = target.RowBytes == target.Width * 4 ? 0 : target.RowBytes;
+        var bufferSize = (uint)(target.RowBytes * target.Height);
+        var id = Interlocked.Increment(ref _nextJobId);
+        var job = new TaskCompletionSource<uint>(TaskCreationOptions.RunContinuationsAsynchronously);
+        _jobs[id] = job;
+        EnsurePolling();
+
+        // The native worker reads the JPEG and writes the bitmap until its result is polled
+        using var pin = request.JpegData.Pin();
+        while (!_native.Submit(_workerPool, id, Address(pin), (uint)request.JpegData.Length,
+                   target.GetPixels(), bufferSize, request.ScaleDenominator, order, stride))
+            await Task.Delay(PollInterval).ConfigureAwait(false);
+
+        var success = await job.Task.ConfigureAwait(false) > 0;
+        if (success)
+            target.NotifyPixelsChanged();
+
+        sw.Stop();
+        return new DecodeResult(request.FrameId, target, success, sw.ElapsedTicks);
+    }
+
+    private static unsafe nint Address(MemoryHandle pin) => (nint)pin.Pointer;
+
+    private void EnsurePolling()
+    {
+        if (Interlocked.CompareExchange(ref _polling, 1, 0) == 0)
+            _ = PollLoopAsync();
+    }
+
+    // Runs while jobs are pending; a job registered just as the loop exits restarts it
+    private async Task PollLoopAsync()
+    {
+        do
+        {
+            while (!_jobs.IsEmpty)
+            {
+                if (PollCompleted() == 0)
+                    await Task.Delay(PollInterval).ConfigureAwait(false);
+            }
+            Volatile.Write(ref _polling, 0);
+        } while (!_jobs.IsEmpty && Interlocked.CompareExchange(ref _polling, 1, 0) == 0);
+    }
+
+    private unsafe int PollCompleted()
+    {
+        var results = stackalloc WasmJpegNative.DecodeJobResult[PollBatch];
+        int count = _native.Poll(_workerPool, results, PollBatch);
+        for (int i = 0; i < count; i++)
+        {
+            if (_jobs.TryRemove(results[i].Id, out var job))
+                job.TrySetResult(results[i].Written);
+        }
+        return count;
+    }
+
+    // Native output order for a bitmap color type; -1 when it cannot be decoded into directly
+    private static int PixelOrder(SKColorType colorType) => colorType switch
+    {
+        SKColorType.Bgra8888 => 0,
+        SKColorType.Rgba8888 => 1,
+        _ => -1
+    };
+
     public async ValueTask DisposeAsync()
     {
         _decodeBlock.Complete();
@@ -157,13 +262,28 @@ public sealed class WasmJpegDecodePipeline : IAsyncDisposable
 
         while (_decoderPool.TryDequeue(out var decoder))
             _native.CloseDecoder(decoder);
+
+        if (_workerPool != 0)
+        {
+            // Jobs submitted before a Reset may still be running; no worker may touch their buffers
+            // and the poll loop must be gone before the pool is freed
+            while (!_jobs.IsEmpty || Volatile.Read(ref _polling) != 0)
+                await Task.Delay(PollInterval);
+            _native.CloseWorkerPool(_workerPool);
+        }
     }
 }
 
+/// <summary>
+/// A frame to decode into Target. ScaleDenominator 2, 4 or 8 decodes at 1/ScaleDenominator size
+/// in the DCT domain (thumbnails, multi-camera tiles); Target must have the scaled dimensions,
+/// rounded up. Target may be Bgra8888 or Rgba8888, with any RowBytes.
+/// </summary>
 public readonly record struct DecodeRequest(
     ulong FrameId,
     ReadOnlyMemory<byte> JpegData,
-    SKBitmap Target);
+    SKBitmap Target,
+    int ScaleDenominator = 1);
 
 public readonly record struct DecodeResult(
     ulong FrameId,
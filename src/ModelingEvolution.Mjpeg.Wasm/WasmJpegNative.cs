@@ -24,6 +24,49 @@ internal static class WasmJpegNative
         nint output, uint outputSize,
         DecodeInfo* info);
 
+    // scaleDenom: 1, 2, 4 or 8 - DCT-domain downscale, info reports the scaled size
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe uint DecoderDecodeBGRAScaled(
+        nint decoder,
+        nint jpegData, uint jpegSize,
+        nint output, uint outputSize,
+        DecodeInfo* info, int scaleDenom);
+
+    // order: 0 = BGRA, 1 = RGBA; stride: destination row bytes (0 = width * 4)
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe uint DecoderDecodePacked(
+        nint decoder,
+        nint jpegData, uint jpegSize,
+        nint output, uint outputSize,
+        DecodeInfo* info, int scaleDenom, int order, int stride);
+
+    // Native worker threads (BgraWorkerPool); capacity bounds jobs in flight, unpolled results included
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern nint CreateBgraWorkerPool(int threads, int maxWidth, int maxHeight, int capacity);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern void CloseBgraWorkerPool(nint pool);
+
+    // Returns 1 when queued, 0 when the pool is full. Both buffers must stay valid until the job is polled
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int BgraWorkerSubmit(
+        nint pool, ulong id,
+        nint jpegData, uint jpegSize,
+        nint output, uint outputSize,
+        int scaleDenom, int order, int stride);
+
+    // Never blocks: copies up to max finished jobs into results and returns the count
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe int BgraWorkerPoll(nint pool, DecodeJobResult* results, int max);
+
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct DecodeJobResult
+    {
+        public ulong Id;
+        public uint Written;    // 0 when the decode failed
+        public DecodeInfo Info;
+    }
+
     [StructLayout(LayoutKind.Sequential)]
     internal struct DecodeInfo
     {
@@ -31,5 +74,7 @@ internal static class WasmJpegNative
         public int Height;
         public int Components;
         public int ColorSpace;
+        public int Stride;      // Set by crop and packed (BGRA/RGBA) decodes
+        public int Layout;      // Planar YUV layout; unused by the packed decodes here
     }
 }
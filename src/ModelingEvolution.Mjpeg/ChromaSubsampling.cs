@@ -0,0 +1,28 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Chroma subsampling of a JPEG, derived from the SOF component sampling factors.
+/// </summary>
+public enum ChromaSubsampling : byte
+{
+    /// <summary>Sampling factors not recognized or not available.</summary>
+    Unknown = 0,
+
+    /// <summary>Single component (grayscale).</summary>
+    Gray = 1,
+
+    /// <summary>Chroma halved horizontally and vertically.</summary>
+    Yuv420 = 2,
+
+    /// <summary>Chroma halved horizontally.</summary>
+    Yuv422 = 3,
+
+    /// <summary>No chroma subsampling.</summary>
+    Yuv444 = 4,
+
+    /// <summary>Chroma halved vertically.</summary>
+    Yuv440 = 5,
+
+    /// <summary>Chroma quartered horizontally.</summary>
+    Yuv411 = 6
+}
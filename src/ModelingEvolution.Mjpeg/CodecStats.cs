@@ -0,0 +1,34 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Cumulative counters of native codec handles, kept by LibJpegWrap on every call.
+/// </summary>
+/// <remarks>
+/// libjpeg runs entropy decode, IDCT and upsampling (or their encode counterparts) interleaved row by row,
+/// so they are reported together as <see cref="CodingTime"/>. For progressive JPEGs most of the work
+/// happens while the header is processed. Handles on the TurboJPEG backend report no pool memory.
+/// </remarks>
+/// <param name="Calls">Encode or decode calls, failed ones included.</param>
+/// <param name="Errors">Calls that failed.</param>
+/// <param name="BytesIn">Bytes consumed by successful calls (JPEG for decoders, raw frames for encoders).</param>
+/// <param name="BytesOut">Bytes produced by successful calls.</param>
+/// <param name="HeaderTime">Time spent reading headers and setting up the codec.</param>
+/// <param name="CodingTime">Time spent on pixel data after the header.</param>
+/// <param name="PeakPoolBytes">
+/// Largest libjpeg memory pool footprint seen on any single handle; a batch decoder set reports its largest decoder.
+/// </param>
+public readonly record struct CodecStats(long Calls, long Errors, long BytesIn, long BytesOut,
+    TimeSpan HeaderTime, TimeSpan CodingTime, long PeakPoolBytes)
+{
+    /// <summary>
+    /// Sums two snapshots; the peak keeps the larger of the two.
+    /// </summary>
+    public static CodecStats operator +(CodecStats a, CodecStats b) => new(
+        a.Calls + b.Calls,
+        a.Errors + b.Errors,
+        a.BytesIn + b.BytesIn,
+        a.BytesOut + b.BytesOut,
+        a.HeaderTime + b.HeaderTime,
+        a.CodingTime + b.CodingTime,
+        Math.Max(a.PeakPoolBytes, b.PeakPoolBytes));
+}
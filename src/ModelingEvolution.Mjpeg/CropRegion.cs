@@ -0,0 +1,10 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Region of interest for a cropped decode, in pixels of the full-size image.
+/// </summary>
+/// <param name="X">Left edge.</param>
+/// <param name="Y">Top edge.</param>
+/// <param name="Width">Region width.</param>
+/// <param name="Height">Region height.</param>
+public readonly record struct CropRegion(int X, int Y, int Width, int Height);
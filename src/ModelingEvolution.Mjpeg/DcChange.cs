@@ -0,0 +1,23 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Result of <see cref="JpegCodecPool.AnalyzeChange"/>: how far the mean luma of each 8x8 block moved against
+/// the decoder's reference map. One block is one sample of the 1/8 DC map, so a 1920x1080 frame has 240x135.
+/// </summary>
+/// <param name="Width">DC map width, the image width in blocks.</param>
+/// <param name="Height">DC map height, the image height in blocks.</param>
+/// <param name="Compared">False when the decoder had no reference of this size (first frame, size change, reset).</param>
+/// <param name="ChangedBlocks">Blocks whose mean luma moved by more than the threshold.</param>
+/// <param name="MaxDifference">Largest block change, 0-255.</param>
+/// <param name="SumDifference">Sum of absolute block changes.</param>
+public readonly record struct DcChange(int Width, int Height, bool Compared, int ChangedBlocks, int MaxDifference, long SumDifference)
+{
+    /// <summary>Number of blocks in the DC map.</summary>
+    public int Blocks => Width * Height;
+
+    /// <summary>Fraction of blocks that changed, 0-1.</summary>
+    public double ChangedFraction => Blocks == 0 ? 0 : (double)ChangedBlocks / Blocks;
+
+    /// <summary>Mean absolute block change, 0-255.</summary>
+    public double MeanDifference => Blocks == 0 ? 0 : (double)SumDifference / Blocks;
+}
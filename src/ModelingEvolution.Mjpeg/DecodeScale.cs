@@ -0,0 +1,35 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// DCT-domain downscale applied while decoding. The IDCT produces the smaller image directly,
+/// which is several times cheaper than decoding full size and resizing (thumbnails, previews).
+/// </summary>
+public enum DecodeScale
+{
+    /// <summary>Full resolution.</summary>
+    Full = 1,
+
+    /// <summary>1/2 of each dimension.</summary>
+    Half = 2,
+
+    /// <summary>1/4 of each dimension.</summary>
+    Quarter = 4,
+
+    /// <summary>1/8 of each dimension - one sample per 8x8 block.</summary>
+    Eighth = 8
+}
+
+/// <summary>
+/// Extension methods for DecodeScale.
+/// </summary>
+public static class DecodeScaleExtensions
+{
+    /// <summary>
+    /// Gets the decoded size of a dimension. libjpeg rounds scaled dimensions up.
+    /// </summary>
+    public static int Apply(this DecodeScale scale, int dimension)
+    {
+        int denom = (int)scale;
+        return (dimension + denom - 1) / denom;
+    }
+}
@@ -0,0 +1,191 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Bounded LRU cache of decoded frames keyed by (frameId, PixelFormat).
+/// Lets overlapping HDR windows share decodes: during sequential playback each JPEG is decoded once
+/// instead of once per window it falls into. Thread-safe.
+/// </summary>
+/// <remarks>
+/// The cache holds one reference on each stored <see cref="DecodedFrameHandle"/>.
+/// <see cref="TryGet"/> hands out an additional reference that the caller must dispose,
+/// so eviction never frees a frame that is still being blended.
+/// </remarks>
+public sealed class DecodedFrameCache : IDisposable
+{
+    private readonly record struct Key(ulong FrameId, PixelFormat Format);
+
+    private readonly Dictionary<Key, LinkedListNode<(Key Key, DecodedFrameHandle Frame)>> _map = new();
+    private readonly LinkedList<(Key Key, DecodedFrameHandle Frame)> _lru = new();
+    private readonly object _sync = new();
+    private LinkedListNode<(Key Key, DecodedFrameHandle Frame)>? _spareNode;
+    private long _sizeBytes;
+    private long _hits;
+    private long _misses;
+    private bool _disposed;
+
+    /// <summary>
+    /// Memory budget in bytes for cached pixel data.
+    /// </summary>
+    public long CapacityBytes { get; }
+
+    /// <summary>
+    /// Bytes of pixel data currently cached.
+    /// </summary>
+    public long SizeBytes
+    {
+        get { lock (_sync) return _sizeBytes; }
+    }
+
+    /// <summary>
+    /// Number of cached frames.
+    /// </summary>
+    public int Count
+    {
+        get { lock (_sync) return _map.Count; }
+    }
+
+    /// <summary>
+    /// Number of successful lookups.
+    /// </summary>
+    public long Hits => Interlocked.Read(ref _hits);
+
+    /// <summary>
+    /// Number of failed lookups.
+    /// </summary>
+    public long Misses => Interlocked.Read(ref _misses);
+
+    /// <summary>
+    /// Creates a cache with the specified memory budget.
+    /// </summary>
+    /// <param name="capacityBytes">Maximum bytes of decoded pixel data to keep.</param>
+    public DecodedFrameCache(long capacityBytes)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(capacityBytes);
+        CapacityBytes = capacityBytes;
+    }
+
+    /// <summary>
+    /// Creates a cache sized to hold the given number of frames of the given dimensions and format.
+    /// </summary>
+    public static DecodedFrameCache ForFrames(int frameCount, int width, int height, PixelFormat format = PixelFormat.I420)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(frameCount);
+
+        long frameSize = FrameHeader.Create(width, height, format == PixelFormat.Gray8 ? PixelFormat.Gray8 : PixelFormat.I420).Length;
+        return new DecodedFrameCache(frameCount * frameSize);
+    }
+
+    /// <summary>
+    /// Looks up a decoded frame. On success the returned handle carries its own reference; caller must dispose.
+    /// </summary>
+    public bool TryGet(ulong frameId, PixelFormat format, out DecodedFrameHandle frame)
+    {
+        lock (_sync)
+        {
+            ObjectDisposedException.ThrowIf(_disposed, this);
+
+            if (_map.TryGetValue(new Key(frameId, format), out var node) && node.Value.Frame.TryAddRef())
+            {
+                // Move to most-recently-used
+                _lru.Remove(node);
+                _lru.AddFirst(node);
+                frame = node.Value.Frame;
+                _hits++;
+                return true;
+            }
+
+            frame = default;
+            _misses++;
+            return false;
+        }
+    }
+
+    /// <summary>
+    /// Adds a decoded frame. The cache takes its own reference; the caller keeps (and must still dispose) theirs.
+    /// Replaces an existing entry for the same key. Evicts least-recently-used frames to stay within budget.
+    /// Returns false if the frame was not cached (it alone exceeds the budget or was already released).
+    /// </summary>
+    public bool Add(ulong frameId, PixelFormat format, DecodedFrameHandle frame)
+    {
+        long size = frame.Header.Length;
+        if (size > CapacityBytes)
+            return false;
+
+        lock (_sync)
+        {
+            ObjectDisposedException.ThrowIf(_disposed, this);
+
+            if (!frame.TryAddRef())
+                return false;
+
+            var key = new Key(frameId, format);
+            if (_map.TryGetValue(key, out var existing))
+                RemoveNode(existing);
+
+            while (_sizeBytes + size > CapacityBytes && _lru.Last is { } last)
+                RemoveNode(last);
+
+            var node = _spareNode ?? new LinkedListNode<(Key, DecodedFrameHandle)>(default);
+            _spareNode = null;
+            node.Value = (key, frame);
+            _lru.AddFirst(node);
+            _map[key] = node;
+            _sizeBytes += size;
+            return true;
+        }
+    }
+
+    /// <summary>
+    /// Removes a frame from the cache. Returns false if it was not cached.
+    /// </summary>
+    public bool Remove(ulong frameId, PixelFormat format)
+    {
+        lock (_sync)
+        {
+            if (!_map.TryGetValue(new Key(frameId, format), out var node))
+                return false;
+
+            RemoveNode(node);
+            return true;
+        }
+    }
+
+    /// <summary>
+    /// Removes all frames, releasing the cache's references.
+    /// </summary>
+    public void Clear()
+    {
+        lock (_sync)
+        {
+            while (_lru.Last is { } last)
+                RemoveNode(last);
+        }
+    }
+
+    private void RemoveNode(LinkedListNode<(Key Key, DecodedFrameHandle Frame)> node)
+    {
+        var (key, frame) = node.Value;
+        _lru.Remove(node);
+        _map.Remove(key);
+        _sizeBytes -= frame.Header.Length;
+        frame.Dispose();
+
+        // Keep one node around so steady-state add/evict cycles don't allocate
+        node.Value = default;
+        _spareNode = node;
+    }
+
+    /// <summary>
+    /// Releases all cached frames.
+    /// </summary>
+    public void Dispose()
+    {
+        lock (_sync)
+        {
+            if (_disposed) return;
+            while (_lru.Last is { } last)
+                RemoveNode(last);
+            _disposed = true;
+        }
+    }
+}
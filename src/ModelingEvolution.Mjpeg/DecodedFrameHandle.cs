@@ -0,0 +1,114 @@
+using System.Buffers;
+using System.Runtime.CompilerServices;
+
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Ref-counted handle to a decoded frame stored in an ArrayPool buffer.
+/// Buffer layout: [0..8) ulong refCount | [8..8+Header.Length) pixel data.
+/// Same ownership rules as <see cref="JpegFrameHandle"/>.
+/// </summary>
+/// <remarks>
+/// - <see cref="Rent"/> creates a handle with refCount = 1. The caller owns it.
+/// - <see cref="TryAddRef"/> atomically increments refCount if > 0. Returns false if already disposed.
+/// - <see cref="Dispose"/> decrements refCount. Returns buffer to pool when it reaches 0.
+/// - Raw struct copy does NOT increment refCount. Use <see cref="TryAddRef"/>.
+/// </remarks>
+public readonly record struct DecodedFrameHandle : IDisposable
+{
+    private const int HeaderSize = sizeof(ulong);
+
+    private readonly byte[]? _buffer;
+
+    /// <summary>
+    /// Frame metadata describing dimensions and format.
+    /// </summary>
+    public FrameHeader Header { get; }
+
+    /// <summary>
+    /// The decoded pixel data.
+    /// </summary>
+    public ReadOnlyMemory<byte> Data => _buffer != null
+        ? _buffer.AsMemory(HeaderSize, Header.Length)
+        : ReadOnlyMemory<byte>.Empty;
+
+    /// <summary>
+    /// Returns true if this handle has a valid buffer.
+    /// </summary>
+    public bool IsValid => _buffer != null;
+
+    private DecodedFrameHandle(byte[] buffer, FrameHeader header)
+    {
+        _buffer = buffer;
+        Header = header;
+    }
+
+    /// <summary>
+    /// Rents a buffer large enough for the described frame and sets refCount to 1.
+    /// </summary>
+    /// <param name="header">Expected frame header; Length sizes the buffer.</param>
+    /// <returns>A new handle with refCount = 1.</returns>
+    public static DecodedFrameHandle Rent(FrameHeader header)
+    {
+        var buf = ArrayPool<byte>.Shared.Rent(HeaderSize + header.Length);
+        Unsafe.WriteUnaligned(ref buf[0], (ulong)1);
+        return new DecodedFrameHandle(buf, header);
+    }
+
+    /// <summary>
+    /// Writable region for the pixel data. Use during initial decode only.
+    /// </summary>
+    internal Memory<byte> WritableData => _buffer != null
+        ? _buffer.AsMemory(HeaderSize, Header.Length)
+        : Memory<byte>.Empty;
+
+    /// <summary>
+    /// Returns the same buffer (and reference) described by the header produced by the decoder.
+    /// </summary>
+    internal DecodedFrameHandle WithHeader(FrameHeader header)
+    {
+        if (_buffer == null || header.Length > _buffer.Length - HeaderSize)
+            throw new InvalidOperationException($"Decoded frame ({header.Length} bytes) does not fit the rented buffer.");
+
+        return new DecodedFrameHandle(_buffer, header);
+    }
+
+    /// <summary>
+    /// Borrowed FrameImage view of the pixel data. Valid while this handle holds a reference;
+    /// disposing the view does not release it.
+    /// </summary>
+    public FrameImage AsFrameImage()
+    {
+        return new FrameImage(Header, WritableData);
+    }
+
+    /// <summary>
+    /// Attempts to atomically increment the reference count.
+    /// Returns false if the buffer has already been returned to the pool (refCount was 0).
+    /// </summary>
+    public bool TryAddRef()
+    {
+        if (_buffer == null) return false;
+
+        ref ulong rc = ref Unsafe.As<byte, ulong>(ref _buffer[0]);
+        while (true)
+        {
+            ulong current = Volatile.Read(ref rc);
+            if (current == 0) return false;
+            if (Interlocked.CompareExchange(ref rc, current + 1, current) == current)
+                return true;
+        }
+    }
+
+    /// <summary>
+    /// Decrements the reference count. Returns the buffer to ArrayPool when it reaches 0.
+    /// </summary>
+    public void Dispose()
+    {
+        if (_buffer == null) return;
+
+        ref ulong rc = ref Unsafe.As<byte, ulong>(ref _buffer[0]);
+        if (Interlocked.Decrement(ref rc) == 0)
+            ArrayPool<byte>.Shared.Return(_buffer);
+    }
+}
@@ -0,0 +1,176 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Resumable MJPEG frame-boundary scanner. Jumps between 0xFF bytes with vectorized IndexOf, classifies
+/// each marker and skips marker segments by their length, so runs of entropy-coded data cost no per-byte
+/// work and header payloads (e.g. EXIF thumbnails) cannot end a frame early.
+/// Feed consecutive chunks of a stream to <see cref="Scan"/>; frames spanning chunks are reported
+/// when their EOI arrives. Not thread-safe.
+/// </summary>
+public sealed class FrameBoundaryScanner
+{
+    private enum State : byte
+    {
+        Seek,           // Looking for 0xFF outside a frame
+        SeekMarker,     // After 0xFF outside a frame, expecting SOI
+        Segment,        // Inside a frame at a point where a marker segment may start
+        Marker,         // After 0xFF inside a frame
+        LengthHigh,     // Segment length, first byte
+        LengthLow,      // Segment length, second byte
+        Skip,           // Inside a segment payload
+        Entropy         // Inside entropy-coded data or unstructured payload
+    }
+
+    private State _state;
+    private long _position;
+    private long _frameStart = -1;
+    private ulong _frameIndex;
+    private byte _marker;
+    private int _length;
+    private int _skip;
+
+    /// <summary>
+    /// Total bytes scanned so far.
+    /// </summary>
+    public long Position => _position;
+
+    /// <summary>
+    /// Number of complete frames found so far.
+    /// </summary>
+    public ulong FrameCount => _frameIndex;
+
+    /// <summary>
+    /// Scans the next chunk of the stream and appends every frame whose EOI lies in it.
+    /// </summary>
+    /// <param name="chunk">Bytes following the previously scanned chunk.</param>
+    /// <param name="frames">Receives the completed frames, with absolute stream offsets.</param>
+    /// <returns>Number of frames appended.</returns>
+    public int Scan(ReadOnlySpan<byte> chunk, List<FrameInfo> frames)
+    {
+        int found = 0;
+        int i = 0;
+
+        while (i < chunk.Length)
+        {
+            switch (_state)
+            {
+                case State.Seek:
+                case State.Entropy:
+                {
+                    int ff = chunk.Slice(i).IndexOf((byte)0xFF);
+                    if (ff < 0)
+                    {
+                        i = chunk.Length;
+                        break;
+                    }
+                    i += ff + 1;
+                    _state = _state == State.Seek ? State.SeekMarker : State.Marker;
+                    break;
+                }
+
+                case State.SeekMarker:
+                {
+                    byte b = chunk[i];
+                    if (b == 0xD8)
+                    {
+                        _frameStart = _position + i - 1;
+                        _state = State.Segment;
+                    }
+                    else if (b != 0xFF)
+                    {
+                        _state = State.Seek;
+                    }
+                    i++;
+                    break;
+                }
+
+                case State.Segment:
+                    // Anything but a marker here is unstructured data; fall back to searching for 0xFF
+                    if (chunk[i] == 0xFF)
+                    {
+                        _state = State.Marker;
+                        i++;
+                    }
+                    else
+                    {
+                        _state = State.Entropy;
+                    }
+                    break;
+
+                case State.Marker:
+                {
+                    byte b = chunk[i++];
+                    if (b == 0xD9)
+                    {
+                        long end = _position + i;
+                        frames.Add(new FrameInfo(_frameStart, end - _frameStart, _frameIndex++));
+                        found++;
+                        _frameStart = -1;
+                        _state = State.Seek;
+                    }
+                    else if (b == 0xFF)
+                    {
+                        // Fill byte; the marker code follows
+                    }
+                    else if (b == 0x00 || b == 0x01 || b == 0xD8 || (b >= 0xD0 && b <= 0xD7))
+                    {
+                        // Stuffed zero, TEM, nested SOI or restart marker: no length field
+                        _state = State.Entropy;
+                    }
+                    else
+                    {
+                        _marker = b;
+                        _state = State.LengthHigh;
+                    }
+                    break;
+                }
+
+                case State.LengthHigh:
+                    _length = chunk[i++] << 8;
+                    _state = State.LengthLow;
+                    break;
+
+                case State.LengthLow:
+                    _length |= chunk[i++];
+                    if (_length < 2)
+                    {
+                        // Not a real segment; keep searching for markers
+                        _state = State.Entropy;
+                    }
+                    else
+                    {
+                        _skip = _length - 2;
+                        _state = State.Skip;
+                    }
+                    break;
+
+                case State.Skip:
+                {
+                    int n = Math.Min(_skip, chunk.Length - i);
+                    i += n;
+                    _skip -= n;
+                    break;
+                }
+            }
+
+            // A finished segment may be empty, so this runs even when the chunk is exhausted
+            if (_state == State.Skip && _skip == 0)
+                _state = _marker == 0xDA ? State.Entropy : State.Segment;
+        }
+
+        _position += chunk.Length;
+        return found;
+    }
+
+    /// <summary>
+    /// Resets the scanner to the start of a new stream.
+    /// </summary>
+    public void Reset()
+    {
+        _state = State.Seek;
+        _position = 0;
+        _frameStart = -1;
+        _frameIndex = 0;
+        _skip = 0;
+    }
+}
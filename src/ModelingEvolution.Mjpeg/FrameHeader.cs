@@ -26,11 +26,12 @@ public readonly record struct FrameHeader(
         int stride = width * bytesPerPixel;
         int length = stride * height;
 
-        // Adjust for planar YUV formats
-        if (format == PixelFormat.I420 || format == PixelFormat.Nv12 || format == PixelFormat.Nv21)
+        // Adjust for planar YUV formats; stride is the luma row stride
+        if (format.IsPlanarYuv())
         {
-            // Y plane + UV planes (half resolution each)
-            length = width * height + (width * height / 2);
+            // Y plane + two chroma planes, rounded up for odd sizes
+            stride = width;
+            length = width * height + 2 * format.GetChromaWidth(width) * format.GetChromaHeight(height);
         }
 
         return new FrameHeader(width, height, stride, format, length);
@@ -42,7 +43,7 @@ public readonly record struct FrameHeader(
     public bool IsValid =>
         Width > 0 &&
         Height > 0 &&
-        Stride >= Width * Format.GetBytesPerPixel() &&
+        Stride >= (Format.IsPlanarYuv() ? Width : Width * Format.GetBytesPerPixel()) &&
         Length >= Stride * Height;
 }
 
@@ -0,0 +1,364 @@
+using System.Buffers;
+using System.Text;
+
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Codec pool that decodes on a V4L2 memory-to-memory JPEG engine (Jetson, Rockchip, i.MX8) and falls back to
+/// a <see cref="JpegCodecPool"/> for every frame the engine does not take. Output buffers and headers are the
+/// same as the CPU pool's, so it drops in wherever an <see cref="ICodecPool"/> is used.
+/// </summary>
+/// <remarks>
+/// Full-size I420 and Gray8 decodes, single and batched, go to the hardware. Baseline 4:2:0 JPEGs (and
+/// grayscale ones decoded to Gray8) are sent to the engine; progressive, 4:2:2 and 4:4:4 streams, frames
+/// larger than the pool and frames the driver rejects are decoded by libjpeg. Scaled and cropped decodes,
+/// fused HDR blends and all encodes run on the CPU pool. Without a device, or on platforms other than
+/// Linux, every call takes the CPU path. At most <c>maxHandles</c> decode contexts are open on the device;
+/// while all of them are busy, further frames are decoded on the CPU instead of waiting.
+/// </remarks>
+public sealed class HardwareCodecPool : ICodecPool
+{
+    private readonly JpegCodecPool _fallback;
+    private readonly NativeHandlePool? _hardwarePool;
+    private readonly string? _devicePath;
+    private long _hardwareDecodes;
+    private long _fallbackDecodes;
+    private bool _disposed;
+
+    /// <summary>
+    /// Creates a pool that decodes on a V4L2 JPEG engine when one is present.
+    /// </summary>
+    /// <param name="maxWidth">Maximum image width to support.</param>
+    /// <param name="maxHeight">Maximum image height to support.</param>
+    /// <param name="quality">JPEG quality (1-100) of the CPU encoders.</param>
+    /// <param name="devicePath">Decoder device (e.g. <c>/dev/video1</c>); null uses the first JPEG-capable one.</param>
+    /// <param name="maxHandles">Maximum decode contexts open on the device at once (0 = one per processor).</param>
+    public HardwareCodecPool(int maxWidth, int maxHeight, int quality = 85, string? devicePath = null, int maxHandles = 0)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegative(maxHandles);
+
+        _fallback = new JpegCodecPool(maxWidth, maxHeight, quality);
+
+        // Resolved once, so a failed open later never rescans /dev/video*
+        _devicePath = devicePath ?? FindHardwareDecoder();
+        if (_devicePath == null)
+            return;
+
+        // One probe handle decides whether the device is usable at all
+        var probe = TryCreateHardwareDecoder(_devicePath, maxWidth, maxHeight);
+        if (probe != nint.Zero)
+        {
+            JpegTurboNative.CloseV4l2Decoder(probe);
+            _hardwarePool = new NativeHandlePool(CreateHardwareDecoder, JpegTurboNative.CloseV4l2Decoder,
+                maxHandles > 0 ? maxHandles : Environment.ProcessorCount, JpegTurboNative.GetV4l2DecoderStats);
+        }
+    }
+
+    /// <summary>
+    /// Returns true when the native library was built with V4L2 support and a JPEG decoder device can be opened.
+    /// </summary>
+    public static bool IsAvailable(string? devicePath = null)
+    {
+        var decoder = TryCreateHardwareDecoder(devicePath, 64, 64);
+        if (decoder == nint.Zero) return false;
+
+        JpegTurboNative.CloseV4l2Decoder(decoder);
+        return true;
+    }
+
+    /// <summary>
+    /// True when decodes are offloaded to a hardware engine; false when every call runs on the CPU pool.
+    /// </summary>
+    public bool IsHardwareAccelerated => _hardwarePool != null;
+
+    /// <summary>
+    /// CPU pool that handles fallbacks, scaled and cropped decodes and all encodes.
+    /// </summary>
+    public JpegCodecPool Fallback => _fallback;
+
+    /// <summary>
+    /// Frames decoded by the hardware engine.
+    /// </summary>
+    public long HardwareDecodes => Interlocked.Read(ref _hardwareDecodes);
+
+    /// <summary>
+    /// Full-size decodes that ran on the CPU pool because the engine is missing or did not take the frame.
+    /// </summary>
+    public long FallbackDecodes => Interlocked.Read(ref _fallbackDecodes);
+
+    /// <summary>
+    /// Native counters of every hardware decoder this pool has created, including ones already closed.
+    /// </summary>
+    public CodecStats HardwareStats => _hardwarePool?.Stats ?? default;
+
+    /// <inheritdoc/>
+    public int MaxWidth => _fallback.MaxWidth;
+
+    /// <inheritdoc/>
+    public int MaxHeight => _fallback.MaxHeight;
+
+    /// <inheritdoc/>
+    public int Quality => _fallback.Quality;
+
+    /// <summary>
+    /// Rents a CPU encoder from the fallback pool.
+    /// </summary>
+    public nint RentEncoder() => _fallback.RentEncoder();
+
+    /// <summary>
+    /// Returns an encoder to the fallback pool.
+    /// </summary>
+    public void ReturnEncoder(nint encoder) => _fallback.ReturnEncoder(encoder);
+
+    /// <summary>
+    /// Rents a CPU decoder. Full-size decodes with it try the hardware first and use it only as the fallback.
+    /// </summary>
+    public nint RentDecoder() => _fallback.RentDecoder();
+
+    /// <summary>
+    /// Returns a decoder to the fallback pool.
+    /// </summary>
+    public void ReturnDecoder(nint decoder) => _fallback.ReturnDecoder(decoder);
+
+    /// <inheritdoc/>
+    public FrameHeader GetImageInfo(ReadOnlyMemory<byte> jpegData) => _fallback.GetImageInfo(jpegData);
+
+    /// <summary>
+    /// Decodes JPEG to I420 on the hardware engine, or with <paramref name="decoder"/> when the engine cannot.
+    /// </summary>
+    public FrameHeader DecodeI420(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        if (TryDecodeHardware(PixelFormat.I420, jpegData, outputBuffer, out var header))
+            return header;
+
+        Interlocked.Increment(ref _fallbackDecodes);
+        return _fallback.DecodeI420(decoder, jpegData, outputBuffer);
+    }
+
+    /// <summary>
+    /// Decodes JPEG to grayscale on the hardware engine, or with <paramref name="decoder"/> when the engine cannot.
+    /// </summary>
+    public FrameHeader DecodeGray(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        if (TryDecodeHardware(PixelFormat.Gray8, jpegData, outputBuffer, out var header))
+            return header;
+
+        Interlocked.Increment(ref _fallbackDecodes);
+        return _fallback.DecodeGray(decoder, jpegData, outputBuffer);
+    }
+
+    /// <inheritdoc/>
+    public FrameHeader DecodeI420(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, DecodeScale scale) =>
+        scale == DecodeScale.Full
+            ? DecodeI420(decoder, jpegData, outputBuffer)
+            : _fallback.DecodeI420(decoder, jpegData, outputBuffer, scale);
+
+    /// <inheritdoc/>
+    public FrameHeader DecodeGray(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, DecodeScale scale) =>
+        scale == DecodeScale.Full
+            ? DecodeGray(decoder, jpegData, outputBuffer)
+            : _fallback.DecodeGray(decoder, jpegData, outputBuffer, scale);
+
+    /// <inheritdoc/>
+    public FrameHeader DecodeI420(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, CropRegion region) =>
+        _fallback.DecodeI420(decoder, jpegData, outputBuffer, region);
+
+    /// <inheritdoc/>
+    public FrameHeader DecodeGray(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, CropRegion region) =>
+        _fallback.DecodeGray(decoder, jpegData, outputBuffer, region);
+
+    /// <summary>
+    /// Decodes several JPEGs one after another on the hardware engine. Frames the engine does not take are
+    /// collected and decoded by the CPU pool in one batch.
+    /// </summary>
+    public void DecodeBatch(PixelFormat format, ReadOnlySpan<ReadOnlyMemory<byte>> jpegData, ReadOnlySpan<Memory<byte>> outputBuffers, Span<FrameHeader> headers)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        if (_hardwarePool == null)
+        {
+            Interlocked.Add(ref _fallbackDecodes, jpegData.Length);
+            _fallback.DecodeBatch(format, jpegData, outputBuffers, headers);
+            return;
+        }
+
+        if (format != PixelFormat.I420 && format != PixelFormat.Gray8)
+            throw new NotSupportedException($"Only I420 and Gray8 formats are supported. Got: {format}");
+        if (outputBuffers.Length != jpegData.Length || headers.Length < jpegData.Length)
+            throw new ArgumentException("Output buffers and headers must match the number of JPEG images.");
+
+        int[]? rejected = null;
+        int rejectedCount = 0;
+        try
+        {
+            for (int i = 0; i < jpegData.Length; i++)
+            {
+                if (TryDecodeHardware(format, jpegData[i], outputBuffers[i], out headers[i]))
+                    continue;
+
+                rejected ??= ArrayPool<int>.Shared.Rent(jpegData.Length);
+                rejected[rejectedCount++] = i;
+            }
+
+            if (rejectedCount == 0)
+                return;
+
+            Interlocked.Add(ref _fallbackDecodes, rejectedCount);
+            var jpegs = new ReadOnlyMemory<byte>[rejectedCount];
+            var outputs = new Memory<byte>[rejectedCount];
+            var results = new FrameHeader[rejectedCount];
+            for (int i = 0; i < rejectedCount; i++)
+            {
+                jpegs[i] = jpegData[rejected![i]];
+                outputs[i] = outputBuffers[rejected[i]];
+            }
+
+            _fallback.DecodeBatch(format, jpegs, outputs, results);
+            for (int i = 0; i < rejectedCount; i++)
+                headers[rejected![i]] = results[i];
+        }
+        finally
+        {
+            if (rejected != null)
+                ArrayPool<int>.Shared.Return(rejected);
+        }
+    }
+
+    /// <inheritdoc/>
+    public FrameHeader DecodeBlend(PixelFormat format, HdrBlendMode mode, ReadOnlySpan<ReadOnlyMemory<byte>> jpegData,
+        HdrWeights? weights, Memory<byte> outputBuffer) =>
+        _fallback.DecodeBlend(format, mode, jpegData, weights, outputBuffer);
+
+    /// <inheritdoc/>
+    public int EncodeI420(nint encoder, ReadOnlyMemory<byte> frameData, Memory<byte> outputBuffer) =>
+        _fallback.EncodeI420(encoder, frameData, outputBuffer);
+
+    /// <inheritdoc/>
+    public int EncodeGray8(int width, int height, ReadOnlyMemory<byte> frameData, Memory<byte> outputBuffer) =>
+        _fallback.EncodeGray8(width, height, frameData, outputBuffer);
+
+    /// <inheritdoc/>
+    public int EncodePlanes(nint encoder, ReadOnlyMemory<byte> y, int yStride, ReadOnlyMemory<byte> u, ReadOnlyMemory<byte> v,
+        int uvStride, Memory<byte> outputBuffer) =>
+        _fallback.EncodePlanes(encoder, y, yStride, u, v, uvStride, outputBuffer);
+
+    /// <inheritdoc/>
+    public int EncodeNv12(nint encoder, ReadOnlyMemory<byte> y, int yStride, ReadOnlyMemory<byte> uv, int uvStride,
+        Memory<byte> outputBuffer) =>
+        _fallback.EncodeNv12(encoder, y, yStride, uv, uvStride, outputBuffer);
+
+    /// <inheritdoc/>
+    public int Encode(nint encoder, in FrameImage frame, Memory<byte> outputBuffer) =>
+        _fallback.Encode(encoder, frame, outputBuffer);
+
+    /// <inheritdoc/>
+    public int EncodeI420(nint encoder, ReadOnlyMemory<byte> frameData, IBufferWriter<byte> output) =>
+        _fallback.EncodeI420(encoder, frameData, output);
+
+    /// <inheritdoc/>
+    public int EncodeGray8(int width, int height, ReadOnlyMemory<byte> frameData, IBufferWriter<byte> output) =>
+        _fallback.EncodeGray8(width, height, frameData, output);
+
+    private unsafe bool TryDecodeHardware(PixelFormat format, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer,
+        out FrameHeader header)
+    {
+        header = default;
+        if (_hardwarePool == null)
+            return false;
+
+        // Every decode context is busy, or the device refused another one: this frame goes to the CPU
+        nint decoder;
+        try
+        {
+            if (!_hardwarePool.TryRent(out decoder))
+                return false;
+        }
+        catch (InvalidOperationException)
+        {
+            return false;
+        }
+
+        ulong bytesWritten;
+        JpegTurboNative.DecodeInfo info;
+        try
+        {
+            using var inputHandle = jpegData.Pin();
+            using var outputHandle = outputBuffer.Pin();
+            bytesWritten = JpegTurboNative.V4l2DecoderDecode(decoder, (nint)inputHandle.Pointer, (ulong)jpegData.Length,
+                format == PixelFormat.Gray8 ? 1 : 0, (nint)outputHandle.Pointer, (ulong)outputBuffer.Length, out info);
+        }
+        finally
+        {
+            _hardwarePool.Return(decoder);
+        }
+
+        if (bytesWritten == 0)
+            return false;
+
+        Interlocked.Increment(ref _hardwareDecodes);
+        header = format == PixelFormat.Gray8
+            ? new FrameHeader(info.Width, info.Height, info.Width, PixelFormat.Gray8, (int)bytesWritten)
+            : FrameHeader.Create(info.Width, info.Height, PixelFormat.I420);
+        return true;
+    }
+
+    private nint CreateHardwareDecoder()
+    {
+        var decoder = JpegTurboNative.CreateV4l2Decoder(_devicePath, MaxWidth, MaxHeight);
+
+        if (decoder == nint.Zero)
+        {
+            throw new InvalidOperationException("Failed to create V4L2 JPEG decoder. Device may be busy or gone.");
+        }
+
+        return decoder;
+    }
+
+    // Native builds older than the V4L2 exports, or without a device, report no hardware
+    private static unsafe string? FindHardwareDecoder()
+    {
+        Span<byte> path = stackalloc byte[64];
+        try
+        {
+            fixed (byte* p = path)
+            {
+                if (JpegTurboNative.FindV4l2Decoder(p, path.Length) == 0)
+                    return null;
+            }
+        }
+        catch (EntryPointNotFoundException)
+        {
+            return null;
+        }
+
+        return Encoding.ASCII.GetString(path[..path.IndexOf((byte)0)]);
+    }
+
+    private static nint TryCreateHardwareDecoder(string? devicePath, int maxWidth, int maxHeight)
+    {
+        try
+        {
+            return JpegTurboNative.CreateV4l2Decoder(devicePath, maxWidth, maxHeight);
+        }
+        catch (EntryPointNotFoundException)
+        {
+            return nint.Zero;
+        }
+    }
+
+    /// <summary>
+    /// Disposes the hardware decoders and the fallback pool.
+    /// </summary>
+    public void Dispose()
+    {
+        if (_disposed) return;
+        _disposed = true;
+
+        _hardwarePool?.Dispose();
+        _fallback.Dispose();
+    }
+}
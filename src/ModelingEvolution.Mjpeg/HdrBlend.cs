@@ -1,10 +1,16 @@
 using System.Buffers;
 using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+using System.Runtime.Intrinsics;
+using System.Runtime.Intrinsics.Arm;
+using System.Runtime.Intrinsics.X86;
 
 namespace ModelingEvolution.Mjpeg;
 
 /// <summary>
 /// HDR frame blending implementation matching GStreamer gsthdr plugin algorithms.
+/// Kernels use Vector256/Vector128 where the hardware accelerates them and fall back to scalar loops;
+/// vector and scalar paths are bit-exact.
 /// </summary>
 public sealed class HdrBlend : IHdrBlend
 {
@@ -83,8 +89,9 @@ public sealed class HdrBlend : IHdrBlend
     private static void Average2FrameCore(ReadOnlySpan<byte> src0, ReadOnlySpan<byte> src1, Span<byte> output)
     {
         int length = src0.Length;
+        int i = Average2Vector(src0, src1, output);
 
-        for (int i = 0; i < length; i++)
+        for (; i < length; i++)
         {
             int pix0 = src0[i];
             int pix1 = src1[i];
@@ -102,8 +109,9 @@ public sealed class HdrBlend : IHdrBlend
     {
         int length = src0.Length;
         const int N = 3;
+        int i = Average3Vector(src0, src1, src2, output);
 
-        for (int i = 0; i < length; i++)
+        for (; i < length; i++)
         {
             uint sum = (uint)(src0[i] + src1[i] + src2[i]);
             // Division with rounding: (sum + N/2) / N
@@ -157,8 +165,9 @@ public sealed class HdrBlend : IHdrBlend
     private static void Weighted2FrameCore(ReadOnlySpan<byte> src0, ReadOnlySpan<byte> src1, ReadOnlySpan<byte> weights, Span<byte> output)
     {
         int length = src0.Length;
+        int i = WeightedVector(src0, src1, default, 2, weights, output);
 
-        for (int i = 0; i < length; i++)
+        for (; i < length; i++)
         {
             int pix0 = src0[i];
             int pix1 = src1[i];
@@ -195,8 +204,9 @@ public sealed class HdrBlend : IHdrBlend
     {
         int length = src0.Length;
         const int numFrames = 3;
+        int i = WeightedVector(src0, src1, src2, numFrames, weights, output);
 
-        for (int i = 0; i < length; i++)
+        for (; i < length; i++)
         {
             int pix0 = src0[i];
             int pix1 = src1[i];
@@ -255,9 +265,10 @@ public sealed class HdrBlend : IHdrBlend
     private static void GrayToRgbCore(ReadOnlySpan<byte> red, ReadOnlySpan<byte> green, ReadOnlySpan<byte> blue, Span<byte> output)
     {
         int length = red.Length;
-        int outIdx = 0;
+        int i = GrayToRgbVector(red, green, blue, output);
+        int outIdx = i * 3;
 
-        for (int i = 0; i < length; i++)
+        for (; i < length; i++)
         {
             // Interleaved RGB format - 3 bytes per pixel
             output[outIdx++] = red[i];    // R
@@ -268,6 +279,385 @@ public sealed class HdrBlend : IHdrBlend
 
     #endregion
 
+    #region Vector kernels
+
+    // Each kernel processes a whole number of vectors from the start of the buffers and returns the
+    // count handled; the scalar loop of the caller finishes the tail. Lengths are clamped to the
+    // shortest span so the unchecked loads never leave any buffer.
+
+    /// <summary>
+    /// Rounding average per byte: (a + b + 1) >> 1 == (a | b) - ((a ^ b) >> 1), no widening required.
+    /// </summary>
+    [MethodImpl(MethodImplOptions.AggressiveOptimization)]
+    private static int Average2Vector(ReadOnlySpan<byte> src0, ReadOnlySpan<byte> src1, Span<byte> output)
+    {
+        int length = Math.Min(Math.Min(src0.Length, src1.Length), output.Length);
+        ref byte a = ref MemoryMarshal.GetReference(src0);
+        ref byte b = ref MemoryMarshal.GetReference(src1);
+        ref byte d = ref MemoryMarshal.GetReference(output);
+        int i = 0;
+
+        if (Vector256.IsHardwareAccelerated)
+        {
+            for (; i <= length - Vector256<byte>.Count; i += Vector256<byte>.Count)
+            {
+                var va = Vector256.LoadUnsafe(ref a, (nuint)i);
+                var vb = Vector256.LoadUnsafe(ref b, (nuint)i);
+                ((va | vb) - Vector256.ShiftRightLogical(va ^ vb, 1)).StoreUnsafe(ref d, (nuint)i);
+            }
+        }
+
+        if (Vector128.IsHardwareAccelerated)
+        {
+            for (; i <= length - Vector128<byte>.Count; i += Vector128<byte>.Count)
+            {
+                var va = Vector128.LoadUnsafe(ref a, (nuint)i);
+                var vb = Vector128.LoadUnsafe(ref b, (nuint)i);
+                ((va | vb) - Vector128.ShiftRightLogical(va ^ vb, 1)).StoreUnsafe(ref d, (nuint)i);
+            }
+        }
+
+        return i;
+    }
+
+    /// <summary>
+    /// Rounding 3-frame average in 16-bit lanes. The division by 3 is a multiply-shift estimate
+    /// (x * 85) >> 8 plus a remainder correction, exact for every x in [0, 767].
+    /// </summary>
+    [MethodImpl(MethodImplOptions.AggressiveOptimization)]
+    private static int Average3Vector(ReadOnlySpan<byte> src0, ReadOnlySpan<byte> src1, ReadOnlySpan<byte> src2, Span<byte> output)
+    {
+        int length = Math.Min(Math.Min(Math.Min(src0.Length, src1.Length), src2.Length), output.Length);
+        ref byte a = ref MemoryMarshal.GetReference(src0);
+        ref byte b = ref MemoryMarshal.GetReference(src1);
+        ref byte c = ref MemoryMarshal.GetReference(src2);
+        ref byte d = ref MemoryMarshal.GetReference(output);
+        int i = 0;
+
+        if (Vector256.IsHardwareAccelerated)
+        {
+            for (; i <= length - Vector256<byte>.Count; i += Vector256<byte>.Count)
+            {
+                var (a0, a1) = Vector256.Widen(Vector256.LoadUnsafe(ref a, (nuint)i));
+                var (b0, b1) = Vector256.Widen(Vector256.LoadUnsafe(ref b, (nuint)i));
+                var (c0, c1) = Vector256.Widen(Vector256.LoadUnsafe(ref c, (nuint)i));
+                var one = Vector256<ushort>.One;
+                Vector256.Narrow(DivideBy3(a0 + b0 + c0 + one), DivideBy3(a1 + b1 + c1 + one)).StoreUnsafe(ref d, (nuint)i);
+            }
+        }
+
+        if (Vector128.IsHardwareAccelerated)
+        {
+            for (; i <= length - Vector128<byte>.Count; i += Vector128<byte>.Count)
+            {
+                var (a0, a1) = Vector128.Widen(Vector128.LoadUnsafe(ref a, (nuint)i));
+                var (b0, b1) = Vector128.Widen(Vector128.LoadUnsafe(ref b, (nuint)i));
+                var (c0, c1) = Vector128.Widen(Vector128.LoadUnsafe(ref c, (nuint)i));
+                var one = Vector128<ushort>.One;
+                Vector128.Narrow(DivideBy3(a0 + b0 + c0 + one), DivideBy3(a1 + b1 + c1 + one)).StoreUnsafe(ref d, (nuint)i);
+            }
+        }
+
+        return i;
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    private static Vector256<ushort> DivideBy3(Vector256<ushort> x)
+    {
+        var q = Vector256.ShiftRightLogical(x * Vector256.Create((ushort)85), 8);
+        var r = x - q * Vector256.Create((ushort)3);
+        return q + Vector256.ShiftRightLogical(r * Vector256.Create((ushort)11), 5);
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    private static Vector128<ushort> DivideBy3(Vector128<ushort> x)
+    {
+        var q = Vector128.ShiftRightLogical(x * Vector128.Create((ushort)85), 8);
+        var r = x - q * Vector128.Create((ushort)3);
+        return q + Vector128.ShiftRightLogical(r * Vector128.Create((ushort)11), 5);
+    }
+
+    /// <summary>
+    /// 2- or 3-frame weighted blend. The interleaved LUT is split per frame first; lookups use
+    /// AVX2 gathers on x86 and 4-register TBL (a 64-byte table per instruction) on ARM64.
+    /// Other targets use the scalar loop.
+    /// </summary>
+    [MethodImpl(MethodImplOptions.AggressiveOptimization)]
+    private static unsafe int WeightedVector(ReadOnlySpan<byte> src0, ReadOnlySpan<byte> src1, ReadOnlySpan<byte> src2,
+        int numFrames, ReadOnlySpan<byte> weights, Span<byte> output)
+    {
+        bool useAvx2 = Avx2.IsSupported;
+        bool useNeon = AdvSimd.Arm64.IsSupported;
+        if (!useAvx2 && !useNeon)
+            return 0;
+
+        int length = Math.Min(Math.Min(src0.Length, src1.Length), output.Length);
+        if (numFrames == 3)
+            length = Math.Min(length, src2.Length);
+        if (weights.Length < 256 * numFrames)
+            return 0;
+
+        fixed (byte* p0 = src0)
+        fixed (byte* p1 = src1)
+        fixed (byte* p2 = src2)
+        fixed (byte* dst = output)
+        {
+            return useAvx2
+                ? WeightedAvx2(p0, p1, p2, numFrames, weights, dst, length)
+                : WeightedNeon(p0, p1, p2, numFrames, weights, dst, length);
+        }
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveOptimization)]
+    private static unsafe int WeightedAvx2(byte* src0, byte* src1, byte* src2, int numFrames,
+        ReadOnlySpan<byte> weights, byte* output, int length)
+    {
+        // One 32-bit entry per luminance: w0 | w1 << 8 | w2 << 16
+        uint* table = stackalloc uint[256];
+        for (int lum = 0; lum < 256; lum++)
+        {
+            uint entry = 0;
+            for (int f = 0; f < numFrames; f++)
+                entry |= (uint)weights[lum * numFrames + f] << (8 * f);
+            table[lum] = entry;
+        }
+
+        var mask = Vector256.Create(0xFFu);
+        var max = Vector256.Create(255u);
+        int i = 0;
+
+        for (; i <= length - Vector256<byte>.Count; i += Vector256<byte>.Count)
+        {
+            var (a0, a1) = Vector256.Widen(Vector256.Load(src0 + i));
+            var (b0, b1) = Vector256.Widen(Vector256.Load(src1 + i));
+            Vector256<ushort> c0 = default, c1 = default, lum0, lum1;
+            if (numFrames == 3)
+            {
+                (c0, c1) = Vector256.Widen(Vector256.Load(src2 + i));
+                lum0 = DivideBy3(a0 + b0 + c0);
+                lum1 = DivideBy3(a1 + b1 + c1);
+            }
+            else
+            {
+                lum0 = Vector256.ShiftRightLogical(a0 + b0, 1);
+                lum1 = Vector256.ShiftRightLogical(a1 + b1, 1);
+            }
+
+            var r0 = WeightedAvx2Lanes(table, numFrames, lum0, a0, b0, c0, mask, max);
+            var r1 = WeightedAvx2Lanes(table, numFrames, lum1, a1, b1, c1, mask, max);
+            Vector256.Narrow(r0, r1).Store(output + i);
+        }
+
+        return i;
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    private static unsafe Vector256<ushort> WeightedAvx2Lanes(uint* table, int numFrames, Vector256<ushort> lum,
+        Vector256<ushort> a, Vector256<ushort> b, Vector256<ushort> c, Vector256<uint> mask, Vector256<uint> max)
+    {
+        var (lum0, lum1) = Vector256.Widen(lum);
+        var (a0, a1) = Vector256.Widen(a);
+        var (b0, b1) = Vector256.Widen(b);
+        var g0 = Avx2.GatherVector256(table, lum0.AsInt32(), 4);
+        var g1 = Avx2.GatherVector256(table, lum1.AsInt32(), 4);
+
+        var sum0 = a0 * (g0 & mask) + b0 * (Vector256.ShiftRightLogical(g0, 8) & mask);
+        var sum1 = a1 * (g1 & mask) + b1 * (Vector256.ShiftRightLogical(g1, 8) & mask);
+        if (numFrames == 3)
+        {
+            var (c0, c1) = Vector256.Widen(c);
+            sum0 += c0 * Vector256.ShiftRightLogical(g0, 16);
+            sum1 += c1 * Vector256.ShiftRightLogical(g1, 16);
+        }
+
+        return Vector256.Narrow(
+            Vector256.Min(Vector256.ShiftRightLogical(sum0, 8), max),
+            Vector256.Min(Vector256.ShiftRightLogical(sum1, 8), max));
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveOptimization)]
+    private static unsafe int WeightedNeon(byte* src0, byte* src1, byte* src2, int numFrames,
+        ReadOnlySpan<byte> weights, byte* output, int length)
+    {
+        // Per-frame 256-byte tables, addressed as four 64-byte TBL register groups
+        byte* tables = stackalloc byte[256 * 3];
+        for (int lum = 0; lum < 256; lum++)
+        {
+            for (int f = 0; f < numFrames; f++)
+                tables[f * 256 + lum] = weights[lum * numFrames + f];
+        }
+
+        var max = Vector128.Create(255u);
+        int i = 0;
+
+        for (; i <= length - Vector128<byte>.Count; i += Vector128<byte>.Count)
+        {
+            var a = Vector128.Load(src0 + i);
+            var b = Vector128.Load(src1 + i);
+            var c = numFrames == 3 ? Vector128.Load(src2 + i) : default;
+            Vector128<byte> lum;
+            if (numFrames == 3)
+            {
+                var (a0, a1) = Vector128.Widen(a);
+                var (b0, b1) = Vector128.Widen(b);
+                var (c0, c1) = Vector128.Widen(c);
+                lum = Vector128.Narrow(DivideBy3(a0 + b0 + c0), DivideBy3(a1 + b1 + c1));
+            }
+            else
+            {
+                // Floor average: (a & b) + ((a ^ b) >> 1)
+                lum = (a & b) + Vector128.ShiftRightLogical(a ^ b, 1);
+            }
+
+            // Products fit 16 bits; sums of 2-3 products need 32-bit lanes
+            Vector128<uint> s0 = default, s1 = default, s2 = default, s3 = default;
+            AccumulateNeon(tables, lum, a, ref s0, ref s1, ref s2, ref s3);
+            AccumulateNeon(tables + 256, lum, b, ref s0, ref s1, ref s2, ref s3);
+            if (numFrames == 3)
+                AccumulateNeon(tables + 512, lum, c, ref s0, ref s1, ref s2, ref s3);
+
+            Vector128.Narrow(
+                Vector128.Narrow(
+                    Vector128.Min(Vector128.ShiftRightLogical(s0, 8), max),
+                    Vector128.Min(Vector128.ShiftRightLogical(s1, 8), max)),
+                Vector128.Narrow(
+                    Vector128.Min(Vector128.ShiftRightLogical(s2, 8), max),
+                    Vector128.Min(Vector128.ShiftRightLogical(s3, 8), max))).Store(output + i);
+        }
+
+        return i;
+    }
+
+    /// <summary>
+    /// Looks up one frame's weights for 16 luminances and adds pixel * weight into four 32-bit accumulators.
+    /// Indices outside a 64-byte TBL group return 0, so the four group lookups are simply OR-ed.
+    /// </summary>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    private static unsafe void AccumulateNeon(byte* table, Vector128<byte> lum, Vector128<byte> pixels,
+        ref Vector128<uint> s0, ref Vector128<uint> s1, ref Vector128<uint> s2, ref Vector128<uint> s3)
+    {
+        var group = Vector128.Create((byte)64);
+        var w = AdvSimd.Arm64.VectorTableLookup(
+            (Vector128.Load(table), Vector128.Load(table + 16), Vector128.Load(table + 32), Vector128.Load(table + 48)), lum);
+        lum -= group;
+        w |= AdvSimd.Arm64.VectorTableLookup(
+            (Vector128.Load(table + 64), Vector128.Load(table + 80), Vector128.Load(table + 96), Vector128.Load(table + 112)), lum);
+        lum -= group;
+        w |= AdvSimd.Arm64.VectorTableLookup(
+            (Vector128.Load(table + 128), Vector128.Load(table + 144), Vector128.Load(table + 160), Vector128.Load(table + 176)), lum);
+        lum -= group;
+        w |= AdvSimd.Arm64.VectorTableLookup(
+            (Vector128.Load(table + 192), Vector128.Load(table + 208), Vector128.Load(table + 224), Vector128.Load(table + 240)), lum);
+
+        var lo = AdvSimd.MultiplyWideningLower(pixels.GetLower(), w.GetLower());
+        var hi = AdvSimd.MultiplyWideningUpper(pixels, w);
+        var (p0, p1) = Vector128.Widen(lo);
+        var (p2, p3) = Vector128.Widen(hi);
+        s0 += p0;
+        s1 += p1;
+        s2 += p2;
+        s3 += p3;
+    }
+
+    private static readonly Vector128<byte>[] GrayToRgbTbl = CreateGrayToRgbIndices(interleavedTable: true);
+    private static readonly Vector128<byte>[] GrayToRgbShuffle = CreateGrayToRgbIndices(interleavedTable: false);
+
+    /// <summary>
+    /// Builds index vectors for the three 16-byte RGB output blocks of 16 pixels.
+    /// TBL form (ARM64): one index vector per block into the (R, G, B) register triple.
+    /// Shuffle form: one vector per block and channel, 0x80 (out of range) where the block takes another channel.
+    /// </summary>
+    private static Vector128<byte>[] CreateGrayToRgbIndices(bool interleavedTable)
+    {
+        var result = new Vector128<byte>[interleavedTable ? 3 : 9];
+        Span<byte> idx = stackalloc byte[16];
+        for (int block = 0; block < 3; block++)
+        {
+            if (interleavedTable)
+            {
+                for (int m = 0; m < 16; m++)
+                {
+                    int j = block * 16 + m;
+                    idx[m] = (byte)((j % 3) * 16 + j / 3);
+                }
+                result[block] = Vector128.Create((ReadOnlySpan<byte>)idx);
+                continue;
+            }
+
+            for (int channel = 0; channel < 3; channel++)
+            {
+                for (int m = 0; m < 16; m++)
+                {
+                    int j = block * 16 + m;
+                    idx[m] = j % 3 == channel ? (byte)(j / 3) : (byte)0x80;
+                }
+                result[block * 3 + channel] = Vector128.Create((ReadOnlySpan<byte>)idx);
+            }
+        }
+        return result;
+    }
+
+    /// <summary>
+    /// Interleaves 16 pixels per iteration: a 3-register TBL per output block on ARM64,
+    /// otherwise three zeroing shuffles (PSHUFB / WASM swizzle) per block OR-ed together.
+    /// </summary>
+    [MethodImpl(MethodImplOptions.AggressiveOptimization)]
+    private static int GrayToRgbVector(ReadOnlySpan<byte> red, ReadOnlySpan<byte> green, ReadOnlySpan<byte> blue, Span<byte> output)
+    {
+        if (!Vector128.IsHardwareAccelerated)
+            return 0;
+
+        int length = Math.Min(Math.Min(Math.Min(red.Length, green.Length), blue.Length), output.Length / 3);
+        ref byte r = ref MemoryMarshal.GetReference(red);
+        ref byte g = ref MemoryMarshal.GetReference(green);
+        ref byte b = ref MemoryMarshal.GetReference(blue);
+        ref byte d = ref MemoryMarshal.GetReference(output);
+        int i = 0;
+
+        if (AdvSimd.Arm64.IsSupported)
+        {
+            var tbl = GrayToRgbTbl;
+            var i0 = tbl[0];
+            var i1 = tbl[1];
+            var i2 = tbl[2];
+            for (; i <= length - 16; i += 16)
+            {
+                var planes = (Vector128.LoadUnsafe(ref r, (nuint)i), Vector128.LoadUnsafe(ref g, (nuint)i), Vector128.LoadUnsafe(ref b, (nuint)i));
+                nuint o = (nuint)i * 3;
+                AdvSimd.Arm64.VectorTableLookup(planes, i0).StoreUnsafe(ref d, o);
+                AdvSimd.Arm64.VectorTableLookup(planes, i1).StoreUnsafe(ref d, o + 16);
+                AdvSimd.Arm64.VectorTableLookup(planes, i2).StoreUnsafe(ref d, o + 32);
+            }
+            return i;
+        }
+
+        var shuffle = GrayToRgbShuffle;
+        for (; i <= length - 16; i += 16)
+        {
+            var vr = Vector128.LoadUnsafe(ref r, (nuint)i);
+            var vg = Vector128.LoadUnsafe(ref g, (nuint)i);
+            var vb = Vector128.LoadUnsafe(ref b, (nuint)i);
+            nuint o = (nuint)i * 3;
+            for (int block = 0; block < 3; block++)
+            {
+                var idx = block * 3;
+                (ZeroingShuffle(vr, shuffle[idx]) | ZeroingShuffle(vg, shuffle[idx + 1]) | ZeroingShuffle(vb, shuffle[idx + 2]))
+                    .StoreUnsafe(ref d, o + (nuint)(block * 16));
+            }
+        }
+
+        return i;
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    private static Vector128<byte> ZeroingShuffle(Vector128<byte> source, Vector128<byte> indices)
+    {
+        // PSHUFB zeroes lanes whose index has the high bit set; Vector128.Shuffle zeroes any index >= 16
+        return Ssse3.IsSupported ? Ssse3.Shuffle(source, indices) : Vector128.Shuffle(source, indices);
+    }
+
+    #endregion
+
     #region Validation
 
     private static void ValidateFramePair(in FrameImage a, in FrameImage b)
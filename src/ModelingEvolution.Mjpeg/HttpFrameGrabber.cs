@@ -11,6 +11,10 @@ namespace ModelingEvolution.Mjpeg;
 /// parses frame boundaries using PipeReader,
 /// and keeps only the latest frame as a ref-counted <see cref="JpegFrameHandle"/>.
 /// </summary>
+/// <remarks>
+/// With <see cref="EnableStreamingDecode"/> each frame is also decoded while its body is still arriving,
+/// so the decoded frame is ready as soon as the last byte is received.
+/// </remarks>
 public sealed class HttpFrameGrabber : IAsyncDisposable, IDisposable
 {
     private readonly string _host;
@@ -26,6 +30,14 @@ public sealed class HttpFrameGrabber : IAsyncDisposable, IDisposable
     private volatile bool _hasFrame;
     private volatile int _frameCount;
 
+    // Streaming decode; the decoder and the in-progress frame are only touched by the parse loop
+    private StreamingJpegDecoder? _streamDecoder;
+    private FrameHeader _streamCapacity;
+    private DecodedFrameHandle _decoding;
+    private long _fed;
+    private DecodedFrameHandle _latestDecoded;
+    private volatile int _decodedFrameCount;
+
     /// <summary>
     /// Creates a new HttpFrameGrabber from explicit host, port, and path.
     /// </summary>
@@ -59,6 +71,32 @@ public sealed class HttpFrameGrabber : IAsyncDisposable, IDisposable
     /// </summary>
     public int FrameCount => _frameCount;
 
+    /// <summary>
+    /// Number of frames decoded by streaming decode since start.
+    /// </summary>
+    public int DecodedFrameCount => _decodedFrameCount;
+
+    /// <summary>
+    /// Decodes each frame as its body arrives instead of after the whole body is buffered.
+    /// Decoded frames are available from <see cref="TryAcquireLatestDecoded"/>; frames that fail to decode
+    /// (corrupt, larger than the maximum size) are skipped there but still published as JPEG.
+    /// Call before <see cref="StartAsync"/>.
+    /// </summary>
+    /// <param name="maxWidth">Maximum frame width.</param>
+    /// <param name="maxHeight">Maximum frame height.</param>
+    /// <param name="format"><see cref="PixelFormat.I420"/> or <see cref="PixelFormat.Gray8"/>.</param>
+    public void EnableStreamingDecode(int maxWidth, int maxHeight, PixelFormat format = PixelFormat.I420)
+    {
+        if (_tcp != null)
+            throw new InvalidOperationException("Streaming decode must be enabled before starting.");
+        if (format != PixelFormat.I420 && format != PixelFormat.Gray8)
+            throw new NotSupportedException($"Streaming decode supports I420 and Gray8. Got: {format}");
+
+        _streamDecoder?.Dispose();
+        _streamDecoder = new StreamingJpegDecoder(maxWidth, maxHeight);
+        _streamCapacity = FrameHeader.Create(maxWidth, maxHeight, format);
+    }
+
     /// <summary>
     /// Connects via TCP, sends HTTP GET, starts background parse loop.
     /// </summary>
@@ -101,6 +139,21 @@ public sealed class HttpFrameGrabber : IAsyncDisposable, IDisposable
         }
     }
 
+    /// <summary>
+    /// Returns a ref-counted handle to the latest frame decoded by streaming decode.
+    /// Caller must dispose the handle when done.
+    /// Returns null if streaming decode is off, nothing was decoded yet or the frame was just recycled.
+    /// </summary>
+    public DecodedFrameHandle? TryAcquireLatestDecoded()
+    {
+        lock (_frameLock)
+        {
+            var frame = _latestDecoded;
+            if (!frame.IsValid) return null;
+            return frame.TryAddRef() ? frame : null;
+        }
+    }
+
     #region State Machine
 
     private enum State
@@ -266,6 +319,7 @@ public sealed class HttpFrameGrabber : IAsyncDisposable, IDisposable
 
         buffer = buffer.Slice(reader.Position);
         state = State.FrameBody;
+        BeginStreamingDecode();
         return true;
     }
 
@@ -305,8 +359,12 @@ public sealed class HttpFrameGrabber : IAsyncDisposable, IDisposable
         {
             // Fast path: known content length
             if (buffer.Length < contentLength)
+            {
+                FeedStreamingDecode(buffer, buffer.Length, isLast: false);
                 return false;
+            }
 
+            FeedStreamingDecode(buffer, contentLength, isLast: true);
             var jpegSequence = buffer.Slice(0, contentLength);
             PublishFrame(jpegSequence, contentLength);
 
@@ -332,8 +390,12 @@ public sealed class HttpFrameGrabber : IAsyncDisposable, IDisposable
             }
 
             if (frameEnd < 0)
+            {
+                FeedStreamingDecode(buffer, buffer.Length, isLast: false);
                 return false;
+            }
 
+            FeedStreamingDecode(buffer, frameEnd, isLast: true);
             var jpegSequence = buffer.Slice(0, frameEnd);
             PublishFrame(jpegSequence, (int)frameEnd);
 
@@ -407,6 +469,52 @@ public sealed class HttpFrameGrabber : IAsyncDisposable, IDisposable
             old.Dispose();
     }
 
+    private void BeginStreamingDecode()
+    {
+        if (_streamDecoder == null) return;
+
+        // A frame cut short by a reconnect never completed; its buffer is reused
+        if (!_decoding.IsValid)
+            _decoding = DecodedFrameHandle.Rent(_streamCapacity);
+        _streamDecoder.Begin(_decoding.WritableData, _streamCapacity.Format);
+        _fed = 0;
+    }
+
+    /// <summary>
+    /// Feeds the body bytes in [fed, end) that arrived since the last call. The pipe keeps the whole body
+    /// until the frame is published, so offsets are relative to the start of the body.
+    /// </summary>
+    private void FeedStreamingDecode(in ReadOnlySequence<byte> body, long end, bool isLast)
+    {
+        if (_streamDecoder == null || _streamDecoder.Status != StreamingDecodeStatus.NeedMoreData)
+            return;
+
+        var status = _streamDecoder.Feed(body.Slice(_fed, end - _fed), isLast);
+        _fed = end;
+
+        if (status == StreamingDecodeStatus.Completed)
+            PublishDecoded(_decoding.WithHeader(_streamDecoder.Header));
+        else if (status == StreamingDecodeStatus.Failed)
+            _logger?.LogDebug("Streaming decode failed for frame {Frame}.", _frameCount + 1);
+    }
+
+    private void PublishDecoded(DecodedFrameHandle handle)
+    {
+        _decoding = default;
+
+        DecodedFrameHandle old;
+        lock (_frameLock)
+        {
+            old = _latestDecoded;
+            _latestDecoded = handle;
+        }
+
+        Interlocked.Increment(ref _decodedFrameCount);
+
+        if (old.IsValid)
+            old.Dispose();
+    }
+
     #endregion
 
     /// <summary>
@@ -429,12 +537,28 @@ public sealed class HttpFrameGrabber : IAsyncDisposable, IDisposable
         _tcp?.Dispose();
         _tcp = null;
 
+        ReleaseFrames();
+    }
+
+    private void ReleaseFrames()
+    {
         lock (_frameLock)
         {
             if (_latest.IsValid)
                 _latest.Dispose();
             _latest = default;
+
+            if (_latestDecoded.IsValid)
+                _latestDecoded.Dispose();
+            _latestDecoded = default;
         }
+
+        // The parse loop has stopped, so the decoder no longer holds the in-progress buffer pinned
+        _streamDecoder?.Dispose();
+        _streamDecoder = null;
+        if (_decoding.IsValid)
+            _decoding.Dispose();
+        _decoding = default;
     }
 
     /// <summary>
@@ -454,11 +578,6 @@ public sealed class HttpFrameGrabber : IAsyncDisposable, IDisposable
         _tcp?.Dispose();
         _tcp = null;
 
-        lock (_frameLock)
-        {
-            if (_latest.IsValid)
-                _latest.Dispose();
-            _latest = default;
-        }
+        ReleaseFrames();
     }
 }
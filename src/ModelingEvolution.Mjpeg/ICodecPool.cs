@@ -1,3 +1,5 @@
+using System.Buffers;
+
 namespace ModelingEvolution.Mjpeg;
 
 /// <summary>
@@ -56,6 +58,40 @@ public interface ICodecPool : IDisposable
     /// </summary>
     FrameHeader DecodeGray(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer);
 
+    /// <summary>
+    /// Decodes JPEG to I420 at a reduced size (DCT-domain scaling) using a pooled decoder.
+    /// The returned header carries the scaled dimensions.
+    /// </summary>
+    FrameHeader DecodeI420(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, DecodeScale scale);
+
+    /// <summary>
+    /// Decodes JPEG to grayscale at a reduced size (DCT-domain scaling) using a pooled decoder.
+    /// The returned header carries the scaled dimensions.
+    /// </summary>
+    FrameHeader DecodeGray(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, DecodeScale scale);
+
+    /// <summary>
+    /// Decodes only a region of the JPEG to tightly packed I420. Region offsets and size must be even.
+    /// </summary>
+    FrameHeader DecodeI420(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, CropRegion region);
+
+    /// <summary>
+    /// Decodes only a region of the JPEG to grayscale. Rows may be padded; the header carries the stride.
+    /// </summary>
+    FrameHeader DecodeGray(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, CropRegion region);
+
+    /// <summary>
+    /// Decodes several JPEGs to I420 or Gray8 in one call. Headers receive the decoded layout per image.
+    /// Throws if any image fails to decode.
+    /// </summary>
+    void DecodeBatch(PixelFormat format, ReadOnlySpan<ReadOnlyMemory<byte>> jpegData, ReadOnlySpan<Memory<byte>> outputBuffers, Span<FrameHeader> headers);
+
+    /// <summary>
+    /// Decodes an HDR window and blends it (Average or Weighted) in one pass, writing only the blended image.
+    /// Weights are required for Weighted mode.
+    /// </summary>
+    FrameHeader DecodeBlend(PixelFormat format, HdrBlendMode mode, ReadOnlySpan<ReadOnlyMemory<byte>> jpegData, HdrWeights? weights, Memory<byte> outputBuffer);
+
     /// <summary>
     /// Encodes I420 frame to JPEG using a pooled encoder.
     /// </summary>
@@ -65,4 +101,29 @@ public interface ICodecPool : IDisposable
     /// Encodes Gray8 frame to JPEG.
     /// </summary>
     int EncodeGray8(int width, int height, ReadOnlyMemory<byte> frameData, Memory<byte> outputBuffer);
+
+    /// <summary>
+    /// Encodes I420 from separate planes with row strides using a pooled encoder. uvStride applies to both chroma planes.
+    /// </summary>
+    int EncodePlanes(nint encoder, ReadOnlyMemory<byte> y, int yStride, ReadOnlyMemory<byte> u, ReadOnlyMemory<byte> v, int uvStride, Memory<byte> outputBuffer);
+
+    /// <summary>
+    /// Encodes NV12 (Y plane + interleaved CbCr plane) with row strides using a pooled encoder.
+    /// </summary>
+    int EncodeNv12(nint encoder, ReadOnlyMemory<byte> y, int yStride, ReadOnlyMemory<byte> uv, int uvStride, Memory<byte> outputBuffer);
+
+    /// <summary>
+    /// Encodes an I420 or NV12 frame using a pooled encoder, honoring the header stride.
+    /// </summary>
+    int Encode(nint encoder, in FrameImage frame, Memory<byte> outputBuffer);
+
+    /// <summary>
+    /// Encodes I420 frame to JPEG using a pooled encoder, growing into the writer as needed.
+    /// </summary>
+    int EncodeI420(nint encoder, ReadOnlyMemory<byte> frameData, IBufferWriter<byte> output);
+
+    /// <summary>
+    /// Encodes Gray8 frame to JPEG, growing into the writer as needed.
+    /// </summary>
+    int EncodeGray8(int width, int height, ReadOnlyMemory<byte> frameData, IBufferWriter<byte> output);
 }
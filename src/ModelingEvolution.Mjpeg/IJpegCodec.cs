@@ -1,3 +1,5 @@
+using System.Buffers;
+
 namespace ModelingEvolution.Mjpeg;
 
 /// <summary>
@@ -63,6 +65,14 @@ public interface IJpegCodec : IDisposable
     /// <returns>Number of bytes written to outputBuffer.</returns>
     int Encode(in FrameImage frame, Memory<byte> outputBuffer);
 
+    /// <summary>
+    /// Encodes raw frame to JPEG, growing into the writer as needed.
+    /// </summary>
+    /// <param name="frame">The raw frame to encode.</param>
+    /// <param name="output">Writer receiving the JPEG data.</param>
+    /// <returns>Number of bytes written to output.</returns>
+    int Encode(in FrameImage frame, IBufferWriter<byte> output);
+
     /// <summary>
     /// Encodes raw frame to JPEG, allocating output buffer.
     /// </summary>
@@ -0,0 +1,14 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Native codec backend used by LibJpegWrap encoders and decoders.
+/// </summary>
+public enum JpegBackend
+{
+    /// <summary>libjpeg v6 API - scanline and raw-data loops. Always available.</summary>
+    LibJpeg = 0,
+
+    /// <summary>TurboJPEG 3 API (tj3*) - whole-image calls with persistent handles.
+    /// Requires LibJpegWrap built against libjpeg-turbo 3.x.</summary>
+    TurboJpeg = 1
+}
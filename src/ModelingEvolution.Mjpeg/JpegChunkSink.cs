@@ -0,0 +1,85 @@
+using System.Buffers;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Bridges the native chunk allocator (jpeg_chunk_alloc) to an IBufferWriter.
+/// Each chunk is pinned memory from the writer; committed bytes are advanced into it.
+/// </summary>
+internal sealed unsafe class JpegChunkSink : IDisposable
+{
+    private const int ChunkSizeHint = 16 * 1024;
+
+    private readonly IBufferWriter<byte> _writer;
+    private GCHandle _self;
+    private MemoryHandle _pinned;
+    private Exception? _error;
+
+    public JpegChunkSink(IBufferWriter<byte> writer)
+    {
+        _writer = writer ?? throw new ArgumentNullException(nameof(writer));
+        _self = GCHandle.Alloc(this);
+    }
+
+    /// <summary>
+    /// Native callback matching jpeg_chunk_alloc.
+    /// </summary>
+    public static delegate* unmanaged[Cdecl]<nint, ulong, ulong*, nint> Callback => &OnChunk;
+
+    /// <summary>
+    /// Opaque context passed to the native callback.
+    /// </summary>
+    public nint Context => GCHandle.ToIntPtr(_self);
+
+    /// <summary>
+    /// Throws the exception raised by the writer during the native call, if any.
+    /// </summary>
+    public void ThrowIfFailed()
+    {
+        if (_error != null)
+            throw new InvalidOperationException("Failed to allocate JPEG output chunk.", _error);
+    }
+
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) })]
+    private static nint OnChunk(nint context, ulong committed, ulong* chunkSize)
+    {
+        var sink = (JpegChunkSink)GCHandle.FromIntPtr(context).Target!;
+        return sink.Next(committed, chunkSize);
+    }
+
+    private nint Next(ulong committed, ulong* chunkSize)
+    {
+        // Exceptions must not cross the native boundary; capture and report as allocation failure.
+        try
+        {
+            _pinned.Dispose();
+            _pinned = default;
+
+            if (committed > 0)
+                _writer.Advance((int)committed);
+
+            if (chunkSize == null)
+                return nint.Zero;
+
+            var memory = _writer.GetMemory(ChunkSizeHint);
+            _pinned = memory.Pin();
+            *chunkSize = (ulong)memory.Length;
+            return (nint)_pinned.Pointer;
+        }
+        catch (Exception ex)
+        {
+            _error = ex;
+            return nint.Zero;
+        }
+    }
+
+    public void Dispose()
+    {
+        _pinned.Dispose();
+        _pinned = default;
+        if (_self.IsAllocated)
+            _self.Free();
+    }
+}
@@ -18,6 +18,18 @@ public class JpegCodecOptions
 
     /// <summary>DCT algorithm to use.</summary>
     public DctMethod DctMethod { get; set; } = DctMethod.Integer;
+
+    /// <summary>Native codec backend.</summary>
+    public JpegBackend Backend { get; set; } = JpegBackend.LibJpeg;
+
+    /// <summary>Threads for restart-marker stripe decode of JPEGs with DRI (1 = serial).</summary>
+    public int StripeThreads { get; set; } = 1;
+
+    /// <summary>Restart marker every N MCU rows in encoded output (0 = none).</summary>
+    public int RestartRows { get; set; }
+
+    /// <summary>Per-frame quality selection for a target frame size or bitrate (I420 encodes). Null = fixed Quality.</summary>
+    public RateControl? RateControl { get; set; }
 }
 
 /// <summary>
@@ -29,9 +41,11 @@ public sealed class JpegCodec : IJpegCodec
 {
     private readonly nint _encoderPtr;
     private readonly nint _decoderPtr;
+    private nint _grayEncoderPtr;       // Created on first Gray8 encode
     private bool _disposed;
     private int _quality;
     private DctMethod _dctMethod;
+    private readonly bool _rateControlled;
 
     /// <summary>
     /// Creates a new JpegCodec with default options.
@@ -46,12 +60,14 @@ public sealed class JpegCodec : IJpegCodec
     public JpegCodec(JpegCodecOptions options)
     {
         ArgumentNullException.ThrowIfNull(options);
+        JpegTurboNative.EnsureBackendAvailable(options.Backend);
+        options.RateControl?.Validate();
 
         _quality = options.Quality;
         _dctMethod = options.DctMethod;
 
-        ulong bufferSize = (ulong)(options.MaxWidth * options.MaxHeight * 3 / 2);
-        _encoderPtr = JpegTurboNative.Create(options.MaxWidth, options.MaxHeight, options.Quality, bufferSize);
+        // Output buffers are supplied per call, no need to reserve one here
+        _encoderPtr = JpegTurboNative.CreateEncoder(options.MaxWidth, options.MaxHeight, options.Quality, 0, options.Backend);
 
         if (_encoderPtr == nint.Zero)
         {
@@ -59,21 +75,35 @@ public sealed class JpegCodec : IJpegCodec
         }
 
         JpegTurboNative.SetMode(_encoderPtr, (int)options.DctMethod);
+        if (options.RestartRows > 0)
+            JpegTurboNative.SetRestartRows(_encoderPtr, options.RestartRows);
+        if (options.RateControl is { } rateControl)
+        {
+            rateControl.Apply(_encoderPtr);
+            _rateControlled = true;
+        }
 
         // Create pooled decoder
-        _decoderPtr = JpegTurboNative.CreateDecoder(options.MaxWidth, options.MaxHeight);
+        _decoderPtr = JpegTurboNative.CreateDecoder(options.MaxWidth, options.MaxHeight, options.Backend);
 
         if (_decoderPtr == nint.Zero)
         {
             JpegTurboNative.Close(_encoderPtr);
             throw new InvalidOperationException("Failed to create JPEG decoder. Native library may not be loaded.");
         }
+
+        if (options.StripeThreads > 1)
+            JpegTurboNative.DecoderSetStripeThreads(_decoderPtr, options.StripeThreads);
     }
 
     /// <inheritdoc/>
+    /// <remarks>
+    /// With <see cref="JpegCodecOptions.RateControl"/> set this reports the quality chosen for the last
+    /// I420 frame; a value set here only lasts until the controller picks the next one.
+    /// </remarks>
     public int Quality
     {
-        get => _quality;
+        get => _rateControlled ? JpegTurboNative.GetQuality(_encoderPtr) : _quality;
         set
         {
             if (value < 1 || value > 100)
@@ -107,7 +137,7 @@ public sealed class JpegCodec : IJpegCodec
         ObjectDisposedException.ThrowIf(_disposed, this);
 
         using var inputHandle = jpegData.Pin();
-        var result = JpegTurboNative.GetJpegImageInfo((nint)inputHandle.Pointer, (ulong)jpegData.Length, out var info);
+        var result = JpegTurboNative.DecoderGetImageInfo(_decoderPtr, (nint)inputHandle.Pointer, (ulong)jpegData.Length, out var info);
         if (result == 0)
             throw new InvalidOperationException("Failed to read JPEG header.");
 
@@ -145,7 +175,7 @@ public sealed class JpegCodec : IJpegCodec
         // First get dimensions
         using var inputHandle = jpegData.Pin();
 
-        var result = JpegTurboNative.GetJpegImageInfo((nint)inputHandle.Pointer, (ulong)jpegData.Length, out var info);
+        var result = JpegTurboNative.DecoderGetImageInfo(_decoderPtr, (nint)inputHandle.Pointer, (ulong)jpegData.Length, out var info);
         if (result == 0)
             throw new InvalidOperationException("Failed to read JPEG header.");
 
@@ -192,9 +222,7 @@ public sealed class JpegCodec : IJpegCodec
         if (bytesWritten == 0)
             throw new InvalidOperationException("Failed to decode JPEG image to I420.");
 
-        // I420 length = width * height * 1.5
-        int i420Length = info.Width * info.Height * 3 / 2;
-        return new FrameHeader(info.Width, info.Height, info.Width, PixelFormat.I420, i420Length);
+        return FrameHeader.Create(info.Width, info.Height, PixelFormat.I420);
     }
 
     /// <inheritdoc/>
@@ -205,12 +233,12 @@ public sealed class JpegCodec : IJpegCodec
         // First get dimensions
         using var inputHandle = jpegData.Pin();
 
-        var result = JpegTurboNative.GetJpegImageInfo((nint)inputHandle.Pointer, (ulong)jpegData.Length, out var info);
+        var result = JpegTurboNative.DecoderGetImageInfo(_decoderPtr, (nint)inputHandle.Pointer, (ulong)jpegData.Length, out var info);
         if (result == 0)
             throw new InvalidOperationException("Failed to read JPEG header.");
 
-        // Rent output buffer for I420 (width * height * 1.5) from pool
-        int outputSize = info.Width * info.Height * 3 / 2;
+        // Rent output buffer for I420 (Y plus two rounded-up quarter planes) from pool
+        int outputSize = FrameHeader.Create(info.Width, info.Height, PixelFormat.I420).Length;
         var outputOwner = MemoryPool<byte>.Shared.Rent(outputSize);
 
         using var outputHandle = outputOwner.Memory.Pin();
@@ -243,11 +271,39 @@ public sealed class JpegCodec : IJpegCodec
 
         return frame.Header.Format switch
         {
-            PixelFormat.I420 => EncodeI420(inputHandle, outputHandle, outputBuffer.Length),
+            PixelFormat.I420 when frame.Header.Stride == frame.Header.Width => EncodeI420(inputHandle, outputHandle, outputBuffer.Length),
+            PixelFormat.I420 or PixelFormat.Nv12 => EncodeStrided(frame, outputHandle, outputBuffer.Length),
             PixelFormat.Gray8 => EncodeGray8(frame.Header, inputHandle, outputHandle, outputBuffer.Length),
+            _ => throw new NotSupportedException(
+                $"Only I420, NV12 and Gray8 formats are supported. Got: {frame.Header.Format}")
+        };
+    }
+
+    /// <inheritdoc/>
+    public unsafe int Encode(in FrameImage frame, IBufferWriter<byte> output)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        using var inputHandle = frame.Data.Pin();
+        using var sink = new JpegChunkSink(output);
+
+        ulong bytesWritten = frame.Header.Format switch
+        {
+            PixelFormat.I420 => JpegTurboNative.EncodeChunked(
+                _encoderPtr, (nint)inputHandle.Pointer,
+                JpegChunkSink.Callback, sink.Context, null, 0, out _),
+            PixelFormat.Gray8 => JpegTurboNative.GrayEncoderEncodeChunked(
+                GrayEncoder, (nint)inputHandle.Pointer, frame.Header.Width, frame.Header.Height, _quality,
+                JpegChunkSink.Callback, sink.Context, null, 0, out _),
             _ => throw new NotSupportedException(
                 $"Only I420 and Gray8 formats are supported. Got: {frame.Header.Format}")
         };
+
+        sink.ThrowIfFailed();
+        if (bytesWritten == 0)
+            throw new InvalidOperationException($"Failed to encode {frame.Header.Format} image to JPEG.");
+
+        return (int)bytesWritten;
     }
 
     private unsafe int EncodeI420(MemoryHandle inputHandle, MemoryHandle outputHandle, int outputLength)
@@ -261,9 +317,35 @@ public sealed class JpegCodec : IJpegCodec
         return (int)bytesWritten;
     }
 
+    private nint GrayEncoder
+    {
+        get
+        {
+            if (_grayEncoderPtr == nint.Zero)
+            {
+                _grayEncoderPtr = JpegTurboNative.CreateGrayEncoder(_quality);
+                if (_grayEncoderPtr == nint.Zero)
+                    throw new InvalidOperationException("Failed to create Gray8 encoder. Native library may not be loaded.");
+            }
+            return _grayEncoderPtr;
+        }
+    }
+
+    private unsafe int EncodeStrided(in FrameImage frame, MemoryHandle outputHandle, int outputLength)
+    {
+        ulong bytesWritten = JpegTurboNative.EncodeFrame(_encoderPtr, frame.Header, frame.Data.Span,
+            (byte*)outputHandle.Pointer, (ulong)outputLength);
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException($"Failed to encode {frame.Header.Format} image to JPEG.");
+
+        return (int)bytesWritten;
+    }
+
     private unsafe int EncodeGray8(FrameHeader header, MemoryHandle inputHandle, MemoryHandle outputHandle, int outputLength)
     {
-        ulong bytesWritten = JpegTurboNative.EncodeGray8ToJpeg(
+        ulong bytesWritten = JpegTurboNative.GrayEncoderEncode(
+            GrayEncoder,
             (nint)inputHandle.Pointer,
             header.Width,
             header.Height,
@@ -280,11 +362,19 @@ public sealed class JpegCodec : IJpegCodec
     /// <inheritdoc/>
     public FrameImage Encode(in FrameImage frame)
     {
-        // Rent from pool - may be larger than needed
-        int maxSize = frame.Header.Length;
-        var owner = MemoryPool<byte>.Shared.Rent(maxSize);
+        // Start from a typical compressed size; the writer grows if the frame needs more
+        var owner = new PooledBufferWriter(frame.Header.Length / 8);
 
-        int length = Encode(frame, owner.Memory);
+        int length;
+        try
+        {
+            length = Encode(frame, owner);
+        }
+        catch
+        {
+            owner.Dispose();
+            throw;
+        }
 
         // Create header with actual encoded length
         var header = new FrameHeader(
@@ -315,6 +405,11 @@ public sealed class JpegCodec : IJpegCodec
             JpegTurboNative.CloseDecoder(_decoderPtr);
         }
 
+        if (_grayEncoderPtr != nint.Zero)
+        {
+            JpegTurboNative.CloseGrayEncoder(_grayEncoderPtr);
+        }
+
         _disposed = true;
         GC.SuppressFinalize(this);
     }
@@ -1,4 +1,4 @@
-using System.Collections.Concurrent;
+using System.Buffers;
 
 namespace ModelingEvolution.Mjpeg;
 
@@ -6,116 +6,363 @@ namespace ModelingEvolution.Mjpeg;
 /// Thread-safe pool of native JPEG encoders and decoders.
 /// Each MjpegHdrEngine should own its own pool for optimal performance.
 /// </summary>
+/// <remarks>
+/// Each kind of native handle lives in its own <see cref="NativeHandlePool"/>: a per-core cache slot in
+/// front of a shared LIFO stack, an optional cap on live handles and periodic trimming of idle ones.
+/// </remarks>
 public sealed class JpegCodecPool : ICodecPool
 {
-    private readonly ConcurrentQueue<nint> _encoderPool = new();
-    private readonly ConcurrentQueue<nint> _decoderPool = new();
+    private readonly NativeHandlePool _encoderPool;
+    private readonly NativeHandlePool _decoderPool;
+    private readonly NativeHandlePool _decoderSetPool;
+    private readonly NativeHandlePool _fusedDecoderPool;
+    private readonly NativeHandlePool _grayEncoderPool;
+    private readonly NativeHandlePool _transformerPool;
+    private readonly Timer? _trimTimer;
+    private readonly TimeSpan _idleTimeout;
     private readonly int _maxWidth;
     private readonly int _maxHeight;
     private readonly int _quality;
     private readonly DctMethod _dctMethod;
+    private readonly JpegBackend _backend;
+    private readonly int _stripeThreads;
+    private readonly int _restartRows;
+    private readonly bool _abbreviatedStreams;
+    private readonly RateControl? _rateControl;
+    private readonly object _tablesSync = new();
+    private byte[]? _tables;
+    private readonly int _batchThreads = Math.Clamp(Environment.ProcessorCount, 1, MaxBatchThreads);
     private bool _disposed;
 
+    // An HDR window is at most 10 frames; more threads than that would idle
+    private const int MaxBatchThreads = 10;
+    private const int MaxBatchSlice = 64;
+
     /// <summary>
     /// Creates a new codec pool with specified dimensions and quality settings.
     /// </summary>
-    public JpegCodecPool(int maxWidth, int maxHeight, int quality = 85, DctMethod dctMethod = DctMethod.Integer)
+    /// <param name="maxWidth">Maximum image width to support.</param>
+    /// <param name="maxHeight">Maximum image height to support.</param>
+    /// <param name="quality">JPEG quality (1-100).</param>
+    /// <param name="dctMethod">DCT algorithm to use.</param>
+    /// <param name="backend">Native codec backend.</param>
+    /// <param name="stripeThreads">
+    /// Threads per pooled decoder for restart-marker stripe decode. Values above 1 split JPEGs with DRI
+    /// restart intervals into horizontal stripes decoded concurrently; others decode serially.
+    /// </param>
+    /// <param name="restartRows">Restart marker every N MCU rows in encoded output (0 = none).</param>
+    /// <param name="abbreviatedStreams">
+    /// Encode abbreviated JPEGs without DQT/DHT segments. Tables depend only on the quality and are
+    /// published once via <see cref="Tables"/>; decoders of this pool load them automatically.
+    /// Batch and fused HDR decode need full JPEGs. Requires <see cref="JpegBackend.LibJpeg"/> and a fixed quality.
+    /// </param>
+    /// <param name="rateControl">
+    /// Per-frame quality selection for a target frame size or bitrate. Each pooled encoder keeps its own
+    /// size model. Cannot be combined with <paramref name="abbreviatedStreams"/>, whose tables are published
+    /// for <paramref name="quality"/> only.
+    /// </param>
+    /// <param name="maxHandles">
+    /// Maximum live handles of each kind (encoders, decoders, ...); 0 = unbounded. When all are rented,
+    /// <see cref="RentEncoder"/>/<see cref="RentDecoder"/> block and the async variants wait.
+    /// </param>
+    /// <param name="idleTimeout">
+    /// Handles unused for this long are closed. Default 1 minute; <see cref="Timeout.InfiniteTimeSpan"/> keeps them.
+    /// </param>
+    /// <exception cref="NotSupportedException">The native library was built without the requested backend,
+    /// or abbreviated streams were requested for a backend that cannot produce them or together with rate control.</exception>
+    public JpegCodecPool(int maxWidth, int maxHeight, int quality = 85, DctMethod dctMethod = DctMethod.Integer,
+        JpegBackend backend = JpegBackend.LibJpeg, int stripeThreads = 1, int restartRows = 0, bool abbreviatedStreams = false,
+        RateControl? rateControl = null, int maxHandles = 0, TimeSpan? idleTimeout = null)
     {
+        JpegTurboNative.EnsureBackendAvailable(backend);
+        if (abbreviatedStreams && backend != JpegBackend.LibJpeg)
+            throw new NotSupportedException("Abbreviated JPEG streams require the LibJpeg backend.");
+        if (abbreviatedStreams && rateControl != null)
+            throw new NotSupportedException("Abbreviated JPEG streams require a fixed quality and cannot use rate control.");
+        rateControl?.Validate();
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(stripeThreads);
+        ArgumentOutOfRangeException.ThrowIfNegative(restartRows);
+        ArgumentOutOfRangeException.ThrowIfNegative(maxHandles);
+
         _maxWidth = maxWidth;
         _maxHeight = maxHeight;
         _quality = quality;
         _dctMethod = dctMethod;
+        _backend = backend;
+        _stripeThreads = stripeThreads;
+        _restartRows = restartRows;
+        _abbreviatedStreams = abbreviatedStreams;
+        _rateControl = rateControl;
+
+        _encoderPool = new NativeHandlePool(CreateEncoder, JpegTurboNative.Close, maxHandles, JpegTurboNative.GetEncoderStats);
+        _decoderPool = new NativeHandlePool(CreateDecoder, JpegTurboNative.CloseDecoder, maxHandles, JpegTurboNative.GetDecoderStats);
+        _decoderSetPool = new NativeHandlePool(CreateDecoderSet, JpegTurboNative.CloseDecoderSet, maxHandles,
+            JpegTurboNative.GetDecoderSetStats);
+        _fusedDecoderPool = new NativeHandlePool(CreateFusedDecoder, JpegTurboNative.CloseHdrFusedDecoder, maxHandles,
+            JpegTurboNative.GetHdrFusedDecoderStats);
+        _grayEncoderPool = new NativeHandlePool(CreateGrayEncoder, JpegTurboNative.CloseGrayEncoder, maxHandles,
+            JpegTurboNative.GetGrayEncoderStats);
+        _transformerPool = new NativeHandlePool(CreateTransformer, JpegTurboNative.CloseTransformer, maxHandles,
+            JpegTurboNative.GetTransformerStats);
+
+        // Decoders load the tables when created; build them now so that never needs a second rent
+        if (abbreviatedStreams)
+            _ = Tables;
+
+        _idleTimeout = idleTimeout ?? TimeSpan.FromMinutes(1);
+        if (_idleTimeout != Timeout.InfiniteTimeSpan)
+        {
+            ArgumentOutOfRangeException.ThrowIfLessThanOrEqual(_idleTimeout, TimeSpan.Zero, nameof(idleTimeout));
+
+            // Weak reference: the timer must not keep an undisposed pool alive
+            _trimTimer = new Timer(static state =>
+            {
+                // Racing Dispose is harmless: both sides take handles with interlocked exchanges
+                if (((WeakReference<JpegCodecPool>)state!).TryGetTarget(out var pool) && !pool._disposed)
+                    pool.TrimCore(pool._idleTimeout);
+            }, new WeakReference<JpegCodecPool>(this), _idleTimeout, _idleTimeout);
+        }
+
+        MjpegMetrics.Register(this);
     }
 
     /// <summary>
-    /// Rents an encoder from the pool. Creates a new one if pool is empty.
-    /// Caller must return the encoder using ReturnEncoder.
+    /// Native backend used by all encoders and decoders of this pool.
     /// </summary>
-    public nint RentEncoder()
+    public JpegBackend Backend => _backend;
+
+    /// <summary>
+    /// Threads each pooled decoder uses for restart-marker stripe decode (1 = serial).
+    /// </summary>
+    public int StripeThreads => _stripeThreads;
+
+    /// <summary>
+    /// Restart marker interval in MCU rows for encoded output (0 = none).
+    /// </summary>
+    public int RestartRows => _restartRows;
+
+    /// <summary>
+    /// True when encoders of this pool write abbreviated JPEGs (no quantization and Huffman tables).
+    /// </summary>
+    public bool AbbreviatedStreams => _abbreviatedStreams;
+
+    /// <summary>
+    /// Rate control applied to every pooled encoder, or null for the fixed <see cref="Quality"/>.
+    /// </summary>
+    public RateControl? RateControl => _rateControl;
+
+    /// <summary>
+    /// Quality the encoder used for its last I420 frame (the fixed quality without rate control).
+    /// </summary>
+    public int GetQuality(nint encoder)
     {
         ObjectDisposedException.ThrowIf(_disposed, this);
+        return JpegTurboNative.GetQuality(encoder);
+    }
 
-        if (_encoderPool.TryDequeue(out var encoder))
+    /// <summary>
+    /// Tables-only JPEG (SOI, DQT, DHT, EOI) for this pool's quality. Built once and cached.
+    /// Send it ahead of abbreviated frames; receivers pass it to <see cref="LoadTables"/>.
+    /// </summary>
+    public unsafe ReadOnlyMemory<byte> Tables
+    {
+        get
         {
-            return encoder;
-        }
+            ObjectDisposedException.ThrowIf(_disposed, this);
 
-        // Create new encoder
-        ulong bufferSize = (ulong)(_maxWidth * _maxHeight * 3 / 2);
-        encoder = JpegTurboNative.Create(_maxWidth, _maxHeight, _quality, bufferSize);
+            var tables = Volatile.Read(ref _tables);
+            if (tables != null)
+                return tables;
 
-        if (encoder == nint.Zero)
-        {
-            throw new InvalidOperationException("Failed to create JPEG encoder. Native library may not be loaded.");
+            lock (_tablesSync)
+            {
+                if (_tables != null)
+                    return _tables;
+
+                // Two quant tables and four Huffman tables stay well below 1 KB
+                Span<byte> buffer = stackalloc byte[2048];
+                var encoder = RentEncoder();
+                ulong size;
+                try
+                {
+                    fixed (byte* ptr = buffer)
+                        size = JpegTurboNative.WriteTables(encoder, (nint)ptr, (ulong)buffer.Length);
+                }
+                finally
+                {
+                    ReturnEncoder(encoder);
+                }
+
+                if (size == 0)
+                    throw new InvalidOperationException("Failed to write JPEG tables.");
+
+                Volatile.Write(ref _tables, buffer[..(int)size].ToArray());
+                return _tables;
+            }
         }
+    }
 
-        JpegTurboNative.SetMode(encoder, (int)_dctMethod);
-        return encoder;
+    /// <summary>
+    /// Loads quantization and Huffman tables from a tables-only JPEG into a pooled decoder,
+    /// so it can decode abbreviated frames produced elsewhere. Tables stay loaded until replaced
+    /// by a later tables-only stream or by a full JPEG carrying its own.
+    /// </summary>
+    public unsafe void LoadTables(nint decoder, ReadOnlyMemory<byte> tables)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        using var handle = tables.Pin();
+        if (JpegTurboNative.DecoderLoadTables(decoder, (nint)handle.Pointer, (ulong)tables.Length) == 0)
+            throw new InvalidOperationException("Failed to load JPEG tables.");
     }
 
     /// <summary>
-    /// Returns an encoder to the pool.
+    /// Maximum live handles of each kind (0 = unbounded).
+    /// </summary>
+    public int MaxHandles => _encoderPool.Capacity;
+
+    /// <summary>
+    /// Live native encoders, rented or idle.
+    /// </summary>
+    public int LiveEncoders => _encoderPool.LiveCount;
+
+    /// <summary>
+    /// Live native decoders, rented or idle.
     /// </summary>
-    public void ReturnEncoder(nint encoder)
+    public int LiveDecoders => _decoderPool.LiveCount;
+
+    /// <summary>
+    /// Native counters of every decoder this pool has created: pooled, batch and fused HDR decoders and
+    /// lossless transcoders, including ones already trimmed. All zero when LibJpegWrap was built without stats.
+    /// </summary>
+    public CodecStats DecoderStats => _decoderPool.Stats + _decoderSetPool.Stats + _fusedDecoderPool.Stats
+        + _transformerPool.Stats;
+
+    /// <summary>
+    /// Native counters of every I420 and Gray8 encoder this pool has created, including ones already trimmed.
+    /// </summary>
+    public CodecStats EncoderStats => _encoderPool.Stats + _grayEncoderPool.Stats;
+
+    /// <summary>
+    /// Rents an encoder from the pool. Creates a new one if pool is empty.
+    /// Blocks while <see cref="MaxHandles"/> encoders are rented.
+    /// Caller must return the encoder using ReturnEncoder.
+    /// </summary>
+    public nint RentEncoder()
     {
-        if (_disposed)
-        {
-            // Pool is disposed, close the encoder
-            JpegTurboNative.Close(encoder);
-            return;
-        }
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        return _encoderPool.Rent();
+    }
 
-        _encoderPool.Enqueue(encoder);
+    /// <summary>
+    /// Rents an encoder, waiting asynchronously while <see cref="MaxHandles"/> encoders are rented.
+    /// </summary>
+    public ValueTask<nint> RentEncoderAsync(CancellationToken cancellationToken = default)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        return _encoderPool.RentAsync(cancellationToken);
     }
 
+    /// <summary>
+    /// Returns an encoder to the pool.
+    /// </summary>
+    public void ReturnEncoder(nint encoder) => _encoderPool.Return(encoder);
+
     /// <summary>
     /// Rents a decoder from the pool. Creates a new one if pool is empty.
+    /// Blocks while <see cref="MaxHandles"/> decoders are rented.
     /// Caller must return the decoder using ReturnDecoder.
     /// </summary>
     public nint RentDecoder()
     {
         ObjectDisposedException.ThrowIf(_disposed, this);
+        return _decoderPool.Rent();
+    }
 
-        if (_decoderPool.TryDequeue(out var decoder))
-        {
-            return decoder;
-        }
+    /// <summary>
+    /// Rents a decoder, waiting asynchronously while <see cref="MaxHandles"/> decoders are rented.
+    /// </summary>
+    public ValueTask<nint> RentDecoderAsync(CancellationToken cancellationToken = default)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        return _decoderPool.RentAsync(cancellationToken);
+    }
 
-        // Create new decoder
-        decoder = JpegTurboNative.CreateDecoder(_maxWidth, _maxHeight);
+    /// <summary>
+    /// Returns a decoder to the pool.
+    /// </summary>
+    public void ReturnDecoder(nint decoder) => _decoderPool.Return(decoder);
 
-        if (decoder == nint.Zero)
+    /// <summary>
+    /// Closes pooled handles that have not been used for <paramref name="idleFor"/>. Runs periodically on its own
+    /// unless the pool was created with an infinite idle timeout. Returns the number of handles closed.
+    /// </summary>
+    public int TrimIdle(TimeSpan idleFor)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        return TrimCore(idleFor);
+    }
+
+    private int TrimCore(TimeSpan idleFor) =>
+        _encoderPool.Trim(idleFor) + _decoderPool.Trim(idleFor) + _decoderSetPool.Trim(idleFor)
+        + _fusedDecoderPool.Trim(idleFor) + _grayEncoderPool.Trim(idleFor) + _transformerPool.Trim(idleFor);
+
+    private nint CreateEncoder()
+    {
+        // Output buffers are supplied per call, no need to reserve one here.
+        var encoder = JpegTurboNative.CreateEncoder(_maxWidth, _maxHeight, _quality, 0, _backend);
+
+        if (encoder == nint.Zero)
         {
-            throw new InvalidOperationException("Failed to create JPEG decoder. Native library may not be loaded.");
+            throw new InvalidOperationException("Failed to create JPEG encoder. Native library may not be loaded.");
         }
 
-        return decoder;
+        JpegTurboNative.SetMode(encoder, (int)_dctMethod);
+        if (_restartRows > 0)
+            JpegTurboNative.SetRestartRows(encoder, _restartRows);
+        if (_abbreviatedStreams)
+            JpegTurboNative.SetAbbreviated(encoder, 1);
+        _rateControl?.Apply(encoder);
+        return encoder;
     }
 
-    /// <summary>
-    /// Returns a decoder to the pool.
-    /// </summary>
-    public void ReturnDecoder(nint decoder)
+    private nint CreateDecoder()
     {
-        if (_disposed)
+        var decoder = JpegTurboNative.CreateDecoder(_maxWidth, _maxHeight, _backend);
+
+        if (decoder == nint.Zero)
         {
-            // Pool is disposed, close the decoder
-            JpegTurboNative.CloseDecoder(decoder);
-            return;
+            throw new InvalidOperationException("Failed to create JPEG decoder. Native library may not be loaded.");
         }
 
-        _decoderPool.Enqueue(decoder);
+        if (_stripeThreads > 1)
+            JpegTurboNative.DecoderSetStripeThreads(decoder, _stripeThreads);
+        if (_abbreviatedStreams)
+            LoadTables(decoder, Tables);
+
+        return decoder;
     }
 
     /// <summary>
-    /// Gets image info from JPEG data without full decode.
+    /// Gets image info from JPEG data without full decode, reading the header with a pooled decoder.
     /// </summary>
     public unsafe FrameHeader GetImageInfo(ReadOnlyMemory<byte> jpegData)
     {
         ObjectDisposedException.ThrowIf(_disposed, this);
 
         using var inputHandle = jpegData.Pin();
-        var result = JpegTurboNative.GetJpegImageInfo((nint)inputHandle.Pointer, (ulong)jpegData.Length, out var info);
+        var decoder = RentDecoder();
+        int result;
+        JpegTurboNative.DecodeInfo info;
+        try
+        {
+            result = JpegTurboNative.DecoderGetImageInfo(decoder, (nint)inputHandle.Pointer, (ulong)jpegData.Length, out info);
+        }
+        finally
+        {
+            ReturnDecoder(decoder);
+        }
+
         if (result == 0)
             throw new InvalidOperationException("Failed to read JPEG header.");
 
@@ -144,8 +391,7 @@ public sealed class JpegCodecPool : ICodecPool
         if (bytesWritten == 0)
             throw new InvalidOperationException("Failed to decode JPEG image to I420.");
 
-        int i420Length = info.Width * info.Height * 3 / 2;
-        return new FrameHeader(info.Width, info.Height, info.Width, PixelFormat.I420, i420Length);
+        return FrameHeader.Create(info.Width, info.Height, PixelFormat.I420);
     }
 
     /// <summary>
@@ -172,6 +418,565 @@ public sealed class JpegCodecPool : ICodecPool
         return new FrameHeader(info.Width, info.Height, info.Width, PixelFormat.Gray8, (int)bytesWritten);
     }
 
+    /// <summary>
+    /// Decodes a JPEG spread over the segments of <paramref name="jpegData"/> (e.g. a PipeReader buffer) to I420
+    /// without copying it into contiguous memory first. libjpeg reads the segments in order; frames in several
+    /// segments decode serially on libjpeg, single-segment input takes the regular path.
+    /// </summary>
+    public unsafe FrameHeader DecodeI420(nint decoder, in ReadOnlySequence<byte> jpegData, Memory<byte> outputBuffer)
+    {
+        if (jpegData.IsSingleSegment)
+            return DecodeI420(decoder, jpegData.First, outputBuffer);
+
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        using var outputHandle = outputBuffer.Pin();
+        int count = PinSegments(jpegData, out var segments, out var handles);
+        ulong bytesWritten;
+        JpegTurboNative.DecodeInfo info;
+        try
+        {
+            fixed (JpegTurboNative.JpegSegment* segs = segments)
+            {
+                bytesWritten = JpegTurboNative.DecoderDecodeI420Segments(decoder, segs, count,
+                    (nint)outputHandle.Pointer, (ulong)outputBuffer.Length, out info);
+            }
+        }
+        finally
+        {
+            UnpinSegments(segments, handles, count);
+        }
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException("Failed to decode JPEG image to I420.");
+
+        return FrameHeader.Create(info.Width, info.Height, PixelFormat.I420);
+    }
+
+    /// <summary>
+    /// Grayscale counterpart of <see cref="DecodeI420(nint, in ReadOnlySequence{byte}, Memory{byte})"/>.
+    /// </summary>
+    public unsafe FrameHeader DecodeGray(nint decoder, in ReadOnlySequence<byte> jpegData, Memory<byte> outputBuffer)
+    {
+        if (jpegData.IsSingleSegment)
+            return DecodeGray(decoder, jpegData.First, outputBuffer);
+
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        using var outputHandle = outputBuffer.Pin();
+        int count = PinSegments(jpegData, out var segments, out var handles);
+        ulong bytesWritten;
+        JpegTurboNative.DecodeInfo info;
+        try
+        {
+            fixed (JpegTurboNative.JpegSegment* segs = segments)
+            {
+                bytesWritten = JpegTurboNative.DecoderDecodeGraySegments(decoder, segs, count,
+                    (nint)outputHandle.Pointer, (ulong)outputBuffer.Length, out info);
+            }
+        }
+        finally
+        {
+            UnpinSegments(segments, handles, count);
+        }
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException("Failed to decode JPEG image.");
+
+        return new FrameHeader(info.Width, info.Height, info.Width, PixelFormat.Gray8, (int)bytesWritten);
+    }
+
+    // Pins every segment for the native scatter list; UnpinSegments releases them and the rented arrays
+    private static unsafe int PinSegments(in ReadOnlySequence<byte> data,
+        out JpegTurboNative.JpegSegment[] segments, out MemoryHandle[] handles)
+    {
+        int count = 0;
+        foreach (var _ in data)
+            count++;
+
+        segments = ArrayPool<JpegTurboNative.JpegSegment>.Shared.Rent(count);
+        handles = ArrayPool<MemoryHandle>.Shared.Rent(count);
+
+        int i = 0;
+        foreach (var memory in data)
+        {
+            handles[i] = memory.Pin();
+            segments[i] = new JpegTurboNative.JpegSegment { Data = (nint)handles[i].Pointer, Size = (nuint)memory.Length };
+            i++;
+        }
+        return count;
+    }
+
+    private static void UnpinSegments(JpegTurboNative.JpegSegment[] segments, MemoryHandle[] handles, int count)
+    {
+        for (int i = 0; i < count; i++)
+            handles[i].Dispose();
+
+        ArrayPool<MemoryHandle>.Shared.Return(handles, clearArray: true);
+        ArrayPool<JpegTurboNative.JpegSegment>.Shared.Return(segments);
+    }
+
+    /// <summary>
+    /// Decodes JPEG to I420 at 1/scale of its size. The IDCT produces the smaller image directly.
+    /// </summary>
+    public unsafe FrameHeader DecodeI420(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, DecodeScale scale)
+    {
+        if (scale == DecodeScale.Full)
+            return DecodeI420(decoder, jpegData, outputBuffer);
+
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        ValidateScale(scale);
+
+        using var inputHandle = jpegData.Pin();
+        using var outputHandle = outputBuffer.Pin();
+
+        var bytesWritten = JpegTurboNative.DecoderDecodeI420Scaled(
+            decoder,
+            (nint)inputHandle.Pointer,
+            (ulong)jpegData.Length,
+            (nint)outputHandle.Pointer,
+            (ulong)outputBuffer.Length,
+            out var info,
+            (int)scale);
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException("Failed to decode JPEG image to I420.");
+
+        return FrameHeader.Create(info.Width, info.Height, PixelFormat.I420);
+    }
+
+    /// <summary>
+    /// Decodes JPEG to planar YUV: <see cref="PixelFormat.I420"/>, <see cref="PixelFormat.I422"/> or <see cref="PixelFormat.I444"/>,
+    /// or the JPEG's own sampling when <paramref name="format"/> is null (I420 for sampling none of them expresses).
+    /// Chroma finer than the layout is box-filtered down inside the raw-data loop, so 4:4:4 sources decode to I420
+    /// directly; a layout finer than the JPEG's chroma is rejected. Grayscale JPEGs get neutral chroma.
+    /// Odd sizes round the chroma planes up, see <see cref="FrameHeader.Create"/>; an I444-sized buffer fits any result.
+    /// </summary>
+    public unsafe FrameHeader DecodeYuv(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer,
+        PixelFormat? format = null, DecodeScale scale = DecodeScale.Full)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        ValidateScale(scale);
+        int layout = format switch
+        {
+            null => 3,
+            PixelFormat.I420 => 0,
+            PixelFormat.I422 => 1,
+            PixelFormat.I444 => 2,
+            _ => throw new NotSupportedException($"Planar YUV decodes to I420, I422 or I444. Got: {format}")
+        };
+
+        using var inputHandle = jpegData.Pin();
+        using var outputHandle = outputBuffer.Pin();
+
+        var bytesWritten = JpegTurboNative.DecoderDecodeYuv(
+            decoder,
+            (nint)inputHandle.Pointer,
+            (ulong)jpegData.Length,
+            (nint)outputHandle.Pointer,
+            (ulong)outputBuffer.Length,
+            out var info,
+            layout,
+            (int)scale);
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException($"Failed to decode JPEG image to {format?.ToString() ?? "planar YUV"}.");
+
+        var written = info.Layout switch
+        {
+            1 => PixelFormat.I422,
+            2 => PixelFormat.I444,
+            _ => PixelFormat.I420
+        };
+        return FrameHeader.Create(info.Width, info.Height, written);
+    }
+
+    /// <summary>
+    /// Decodes JPEG to grayscale at 1/scale of its size. The IDCT produces the smaller image directly.
+    /// </summary>
+    public unsafe FrameHeader DecodeGray(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, DecodeScale scale)
+    {
+        if (scale == DecodeScale.Full)
+            return DecodeGray(decoder, jpegData, outputBuffer);
+
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        ValidateScale(scale);
+
+        using var inputHandle = jpegData.Pin();
+        using var outputHandle = outputBuffer.Pin();
+
+        var bytesWritten = JpegTurboNative.DecoderDecodeGrayScaled(
+            decoder,
+            (nint)inputHandle.Pointer,
+            (ulong)jpegData.Length,
+            (nint)outputHandle.Pointer,
+            (ulong)outputBuffer.Length,
+            out var info,
+            (int)scale);
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException("Failed to decode JPEG image.");
+
+        return new FrameHeader(info.Width, info.Height, info.Width, PixelFormat.Gray8, (int)bytesWritten);
+    }
+
+    /// <summary>
+    /// Scores how much a frame changed against the decoder's reference map from the DC terms of luma only:
+    /// a 1/8 grayscale decode gives the mean of every 8x8 block while the AC terms, the chroma IDCT and
+    /// upsampling are skipped, so a 1080p frame costs 30-60% of a full decode (Huffman decoding remains).
+    /// The reference is the previous frame's map, or the first one while <paramref name="keepReference"/> is set.
+    /// </summary>
+    /// <remarks>
+    /// The reference lives in the native decoder handle: rent one decoder per stream and keep it, since a
+    /// decoder returned to the pool may come back holding another stream's map.
+    /// </remarks>
+    /// <param name="decoder">Decoder dedicated to the stream.</param>
+    /// <param name="jpegData">JPEG frame.</param>
+    /// <param name="threshold">Mean luma change (0-255) above which a block counts as changed.</param>
+    /// <param name="thumbnail">Optional Gray8 output of the DC map, at least width/8 x height/8 bytes (rounded up).</param>
+    /// <param name="keepReference">Compare without replacing the reference, for a fixed background.</param>
+    public unsafe DcChange AnalyzeChange(nint decoder, ReadOnlyMemory<byte> jpegData, int threshold = 8,
+        Memory<byte> thumbnail = default, bool keepReference = false)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        ArgumentOutOfRangeException.ThrowIfNegative(threshold);
+
+        using var inputHandle = jpegData.Pin();
+        using var thumbnailHandle = thumbnail.Pin();
+
+        var bytesWritten = JpegTurboNative.DecoderAnalyzeDc(
+            decoder,
+            (nint)inputHandle.Pointer,
+            (ulong)jpegData.Length,
+            threshold,
+            keepReference ? 1 : 0,
+            thumbnail.IsEmpty ? 0 : (nint)thumbnailHandle.Pointer,
+            (ulong)thumbnail.Length,
+            out var info);
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException("Failed to analyze JPEG image.");
+
+        return new DcChange(info.Width, info.Height, info.Compared != 0, info.ChangedBlocks, info.MaxDifference,
+            (long)info.SumDifference);
+    }
+
+    /// <summary>
+    /// Drops the decoder's <see cref="AnalyzeChange"/> reference map; the next frame starts a new one.
+    /// </summary>
+    public void ResetChangeReference(nint decoder)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        JpegTurboNative.DecoderResetDcReference(decoder);
+    }
+
+    /// <summary>
+    /// Decodes only a region of the JPEG to tightly packed I420. Rows above and below the region are skipped
+    /// and only the MCU columns it touches are decoded. Region offsets and size must be even.
+    /// </summary>
+    public unsafe FrameHeader DecodeI420(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, CropRegion region)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        if (((region.X | region.Y | region.Width | region.Height) & 1) != 0)
+            throw new ArgumentException("I420 crop region offsets and size must be even.", nameof(region));
+
+        using var inputHandle = jpegData.Pin();
+        using var outputHandle = outputBuffer.Pin();
+
+        var bytesWritten = JpegTurboNative.DecoderDecodeI420Crop(
+            decoder,
+            (nint)inputHandle.Pointer,
+            (ulong)jpegData.Length,
+            region.X, region.Y, region.Width, region.Height,
+            (nint)outputHandle.Pointer,
+            (ulong)outputBuffer.Length,
+            out var info);
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException("Failed to decode JPEG region to I420.");
+
+        return new FrameHeader(info.Width, info.Height, info.Stride, PixelFormat.I420, (int)bytesWritten);
+    }
+
+    /// <summary>
+    /// Decodes only a region of the JPEG to grayscale. Rows are decoded in place at a stride widened to
+    /// the MCU columns the region touches, so the output buffer must hold Stride * Height bytes
+    /// (at most MCU width - 1 + region width per row).
+    /// </summary>
+    public unsafe FrameHeader DecodeGray(nint decoder, ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, CropRegion region)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        using var inputHandle = jpegData.Pin();
+        using var outputHandle = outputBuffer.Pin();
+
+        var bytesWritten = JpegTurboNative.DecoderDecodeGrayCrop(
+            decoder,
+            (nint)inputHandle.Pointer,
+            (ulong)jpegData.Length,
+            region.X, region.Y, region.Width, region.Height,
+            (nint)outputHandle.Pointer,
+            (ulong)outputBuffer.Length,
+            out var info);
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException("Failed to decode JPEG region.");
+
+        return new FrameHeader(info.Width, info.Height, info.Stride, PixelFormat.Gray8, (int)bytesWritten);
+    }
+
+    /// <summary>
+    /// Rotates, mirrors, crops or requantizes a JPEG in the DCT domain with a pooled transformer, without
+    /// decoding pixels. Much cheaper than decode + encode, and lossless unless a quality is given.
+    /// See <see cref="JpegTransformOptions"/> for the edge trimming and crop alignment rules.
+    /// </summary>
+    /// <returns>Bytes written to <paramref name="outputBuffer"/>.</returns>
+    /// <exception cref="InvalidOperationException">The JPEG could not be read, the crop lies outside the
+    /// transformed image, or the output buffer is too small (the input size plus an eighth is ample).</exception>
+    public unsafe int Transform(ReadOnlyMemory<byte> jpegData, Memory<byte> outputBuffer, in JpegTransformOptions options)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        if (!Enum.IsDefined(options.Transform))
+            throw new ArgumentOutOfRangeException(nameof(options), options.Transform, "Unknown JPEG transform.");
+        ArgumentOutOfRangeException.ThrowIfNegative(options.Quality, nameof(options));
+        ArgumentOutOfRangeException.ThrowIfGreaterThan(options.Quality, 100, nameof(options));
+
+        var crop = options.Crop ?? default;
+        if ((crop.X | crop.Y | crop.Width | crop.Height) < 0)
+            throw new ArgumentException("Crop region must not be negative.", nameof(options));
+
+        using var inputHandle = jpegData.Pin();
+        using var outputHandle = outputBuffer.Pin();
+
+        var transformer = _transformerPool.Rent();
+        try
+        {
+            var bytesWritten = JpegTurboNative.TransformerTransform(
+                transformer,
+                (nint)inputHandle.Pointer,
+                (ulong)jpegData.Length,
+                (int)options.Transform,
+                crop.X, crop.Y, crop.Width, crop.Height,
+                options.Quality,
+                options.StripMarkers ? 1 : 0,
+                (nint)outputHandle.Pointer,
+                (ulong)outputBuffer.Length,
+                out _);
+
+            if (bytesWritten == 0)
+                throw new InvalidOperationException("Failed to transform JPEG image.");
+
+            return (int)bytesWritten;
+        }
+        finally
+        {
+            _transformerPool.Return(transformer);
+        }
+    }
+
+    private static void ValidateScale(DecodeScale scale)
+    {
+        if (!Enum.IsDefined(scale))
+            throw new ArgumentOutOfRangeException(nameof(scale), scale, "Scale must be Full, Half, Quarter or Eighth.");
+    }
+
+    /// <summary>
+    /// Decodes several JPEGs in one native call, spread over the worker threads of a pooled decoder set.
+    /// </summary>
+    public void DecodeBatch(PixelFormat format, ReadOnlySpan<ReadOnlyMemory<byte>> jpegData, ReadOnlySpan<Memory<byte>> outputBuffers, Span<FrameHeader> headers)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        if (format != PixelFormat.I420 && format != PixelFormat.Gray8)
+            throw new NotSupportedException($"Only I420 and Gray8 formats are supported. Got: {format}");
+        if (outputBuffers.Length != jpegData.Length || headers.Length < jpegData.Length)
+            throw new ArgumentException("Output buffers and headers must match the number of JPEG images.");
+
+        if (jpegData.Length == 0)
+            return;
+
+        var set = RentDecoderSet();
+        try
+        {
+            for (int offset = 0; offset < jpegData.Length; offset += MaxBatchSlice)
+            {
+                int count = Math.Min(MaxBatchSlice, jpegData.Length - offset);
+                DecodeBatchSlice(set, format, jpegData.Slice(offset, count), outputBuffers.Slice(offset, count),
+                    headers.Slice(offset, count), offset);
+            }
+        }
+        finally
+        {
+            ReturnDecoderSet(set);
+        }
+    }
+
+    private unsafe void DecodeBatchSlice(nint set, PixelFormat format, ReadOnlySpan<ReadOnlyMemory<byte>> jpegData,
+        ReadOnlySpan<Memory<byte>> outputBuffers, Span<FrameHeader> headers, int offset)
+    {
+        int count = jpegData.Length;
+        nint* jpegs = stackalloc nint[count];
+        ulong* sizes = stackalloc ulong[count];
+        nint* outputs = stackalloc nint[count];
+        ulong* outputSizes = stackalloc ulong[count];
+        ulong* results = stackalloc ulong[count];
+        var infos = stackalloc JpegTurboNative.DecodeInfo[count];
+
+        var handles = ArrayPool<MemoryHandle>.Shared.Rent(count * 2);
+        try
+        {
+            for (int i = 0; i < count; i++)
+            {
+                handles[i * 2] = jpegData[i].Pin();
+                handles[i * 2 + 1] = outputBuffers[i].Pin();
+                jpegs[i] = (nint)handles[i * 2].Pointer;
+                sizes[i] = (ulong)jpegData[i].Length;
+                outputs[i] = (nint)handles[i * 2 + 1].Pointer;
+                outputSizes[i] = (ulong)outputBuffers[i].Length;
+            }
+
+            int succeeded = format == PixelFormat.Gray8
+                ? JpegTurboNative.DecoderDecodeGrayBatch(set, jpegs, sizes, outputs, outputSizes, infos, results, count)
+                : JpegTurboNative.DecoderDecodeBatch(set, jpegs, sizes, outputs, outputSizes, infos, results, count);
+
+            if (succeeded != count)
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    if (results[i] == 0)
+                        throw new InvalidOperationException($"Failed to decode JPEG image {offset + i} of batch to {format}.");
+                }
+            }
+        }
+        finally
+        {
+            for (int i = 0; i < count * 2; i++)
+                handles[i].Dispose();
+            ArrayPool<MemoryHandle>.Shared.Return(handles, clearArray: true);
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            var info = infos[i];
+            headers[i] = format == PixelFormat.Gray8
+                ? new FrameHeader(info.Width, info.Height, info.Width, PixelFormat.Gray8, (int)results[i])
+                : FrameHeader.Create(info.Width, info.Height, PixelFormat.I420);
+        }
+    }
+
+    /// <summary>
+    /// Decodes an HDR window and blends it in one pass. Frames are decoded in lock-step one MCU row
+    /// at a time and blended while the rows are hot in cache; only the blended image is written.
+    /// </summary>
+    public unsafe FrameHeader DecodeBlend(PixelFormat format, HdrBlendMode mode, ReadOnlySpan<ReadOnlyMemory<byte>> jpegData,
+        HdrWeights? weights, Memory<byte> outputBuffer)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        if (format != PixelFormat.I420 && format != PixelFormat.Gray8)
+            throw new NotSupportedException($"Only I420 and Gray8 formats are supported. Got: {format}");
+        if (mode != HdrBlendMode.Average && mode != HdrBlendMode.Weighted)
+            throw new NotSupportedException($"Only Average and Weighted modes can be fused. Got: {mode}");
+        if (jpegData.Length < 2 || jpegData.Length > 10)
+            throw new ArgumentException("Fused decode requires between 2 and 10 frames.", nameof(jpegData));
+        if (mode == HdrBlendMode.Weighted && (weights == null || weights.NumFrames != jpegData.Length))
+            throw new ArgumentException("Weights must be set and match the number of frames for Weighted mode.", nameof(weights));
+
+        int count = jpegData.Length;
+        nint* jpegs = stackalloc nint[count];
+        ulong* sizes = stackalloc ulong[count];
+        var handles = ArrayPool<MemoryHandle>.Shared.Rent(count);
+        var decoder = RentFusedDecoder();
+        try
+        {
+            for (int i = 0; i < count; i++)
+            {
+                handles[i] = jpegData[i].Pin();
+                jpegs[i] = (nint)handles[i].Pointer;
+                sizes[i] = (ulong)jpegData[i].Length;
+            }
+
+            using var outputHandle = outputBuffer.Pin();
+            ReadOnlySpan<byte> table = weights != null ? weights.AsSpan() : default;
+
+            ulong bytesWritten;
+            fixed (byte* weightsPtr = table)
+            {
+                bytesWritten = JpegTurboNative.HdrFusedDecodeBlend(
+                    decoder,
+                    format == PixelFormat.Gray8 ? 1 : 0,
+                    mode == HdrBlendMode.Weighted ? 1 : 0,
+                    jpegs,
+                    sizes,
+                    count,
+                    weightsPtr,
+                    (nint)outputHandle.Pointer,
+                    (ulong)outputBuffer.Length,
+                    out var info);
+
+                if (bytesWritten == 0)
+                    throw new InvalidOperationException($"Failed to decode and blend JPEG images to {format}.");
+
+                return new FrameHeader(info.Width, info.Height, info.Width, format, (int)bytesWritten);
+            }
+        }
+        finally
+        {
+            for (int i = 0; i < count; i++)
+                handles[i].Dispose();
+            ArrayPool<MemoryHandle>.Shared.Return(handles, clearArray: true);
+            ReturnFusedDecoder(decoder);
+        }
+    }
+
+    private nint RentFusedDecoder() => _fusedDecoderPool.Rent();
+
+    private void ReturnFusedDecoder(nint decoder) => _fusedDecoderPool.Return(decoder);
+
+    private nint RentGrayEncoder() => _grayEncoderPool.Rent();
+
+    private void ReturnGrayEncoder(nint encoder) => _grayEncoderPool.Return(encoder);
+
+    private nint RentDecoderSet() => _decoderSetPool.Rent();
+
+    private void ReturnDecoderSet(nint set) => _decoderSetPool.Return(set);
+
+    private nint CreateFusedDecoder()
+    {
+        var decoder = JpegTurboNative.CreateHdrFusedDecoder(_maxWidth, _maxHeight);
+        if (decoder == nint.Zero)
+            throw new InvalidOperationException("Failed to create fused HDR decoder. Native library may not be loaded.");
+
+        return decoder;
+    }
+
+    private nint CreateGrayEncoder()
+    {
+        var encoder = JpegTurboNative.CreateGrayEncoder(_quality);
+        if (encoder == nint.Zero)
+            throw new InvalidOperationException("Failed to create Gray8 encoder. Native library may not be loaded.");
+
+        return encoder;
+    }
+
+    private nint CreateTransformer()
+    {
+        var transformer = JpegTurboNative.CreateTransformer();
+        if (transformer == nint.Zero)
+            throw new InvalidOperationException("Failed to create JPEG transformer. Native library may not be loaded.");
+
+        return transformer;
+    }
+
+    private nint CreateDecoderSet()
+    {
+        var set = JpegTurboNative.CreateDecoderSet(_batchThreads, _maxWidth, _maxHeight, (int)_backend);
+        if (set == nint.Zero)
+            throw new InvalidOperationException("Failed to create JPEG decoder set. Native library may not be loaded.");
+
+        return set;
+    }
+
     /// <summary>
     /// Encodes I420 frame to JPEG using a pooled encoder.
     /// </summary>
@@ -191,6 +996,85 @@ public sealed class JpegCodecPool : ICodecPool
         return (int)bytesWritten;
     }
 
+    /// <summary>
+    /// Encodes I420 from separate planes with row strides using a pooled encoder. uvStride applies to both chroma planes.
+    /// </summary>
+    public unsafe int EncodePlanes(nint encoder, ReadOnlyMemory<byte> y, int yStride, ReadOnlyMemory<byte> u, ReadOnlyMemory<byte> v,
+        int uvStride, Memory<byte> outputBuffer)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        int chromaWidth = (_maxWidth + 1) / 2;
+        int chromaHeight = (_maxHeight + 1) / 2;
+        ValidatePlane(y, yStride, _maxWidth, _maxHeight, nameof(y));
+        ValidatePlane(u, uvStride, chromaWidth, chromaHeight, nameof(u));
+        ValidatePlane(v, uvStride, chromaWidth, chromaHeight, nameof(v));
+
+        using var yHandle = y.Pin();
+        using var uHandle = u.Pin();
+        using var vHandle = v.Pin();
+        using var outputHandle = outputBuffer.Pin();
+
+        ulong bytesWritten = JpegTurboNative.EncodePlanes(encoder,
+            (nint)yHandle.Pointer, yStride, (nint)uHandle.Pointer, (nint)vHandle.Pointer, uvStride,
+            (nint)outputHandle.Pointer, (ulong)outputBuffer.Length);
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException("Failed to encode I420 planes to JPEG.");
+
+        return (int)bytesWritten;
+    }
+
+    /// <summary>
+    /// Encodes NV12 (Y plane + interleaved CbCr plane) with row strides using a pooled encoder.
+    /// Chroma is deinterleaved natively one MCU row at a time, so no repacked copy is made.
+    /// </summary>
+    public unsafe int EncodeNv12(nint encoder, ReadOnlyMemory<byte> y, int yStride, ReadOnlyMemory<byte> uv, int uvStride,
+        Memory<byte> outputBuffer)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        ValidatePlane(y, yStride, _maxWidth, _maxHeight, nameof(y));
+        ValidatePlane(uv, uvStride, (_maxWidth + 1) / 2 * 2, (_maxHeight + 1) / 2, nameof(uv));
+
+        using var yHandle = y.Pin();
+        using var uvHandle = uv.Pin();
+        using var outputHandle = outputBuffer.Pin();
+
+        ulong bytesWritten = JpegTurboNative.EncodeNv12(encoder,
+            (nint)yHandle.Pointer, yStride, (nint)uvHandle.Pointer, uvStride,
+            (nint)outputHandle.Pointer, (ulong)outputBuffer.Length);
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException("Failed to encode NV12 image to JPEG.");
+
+        return (int)bytesWritten;
+    }
+
+    /// <summary>
+    /// Encodes an I420 or NV12 frame using a pooled encoder, honoring the header stride (luma row stride).
+    /// </summary>
+    public unsafe int Encode(nint encoder, in FrameImage frame, Memory<byte> outputBuffer)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        if (frame.Header.Width != _maxWidth || frame.Header.Height != _maxHeight)
+            throw new ArgumentException($"Frame is {frame.Header.Width}x{frame.Header.Height}; pooled encoders are {_maxWidth}x{_maxHeight}.", nameof(frame));
+
+        using var outputHandle = outputBuffer.Pin();
+
+        ulong bytesWritten = JpegTurboNative.EncodeFrame(encoder, frame.Header, frame.Data.Span,
+            (byte*)outputHandle.Pointer, (ulong)outputBuffer.Length);
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException($"Failed to encode {frame.Header.Format} image to JPEG.");
+
+        return (int)bytesWritten;
+    }
+
+    private static void ValidatePlane(ReadOnlyMemory<byte> plane, int stride, int rowBytes, int rows, string paramName)
+    {
+        if (stride < rowBytes || plane.Length < (long)stride * (rows - 1) + rowBytes)
+            throw new ArgumentException($"Plane is too small for {rows} rows of {rowBytes} bytes at stride {stride}.", paramName);
+    }
+
     /// <summary>
     /// Encodes Gray8 frame to JPEG.
     /// </summary>
@@ -201,14 +1085,88 @@ public sealed class JpegCodecPool : ICodecPool
         using var inputHandle = frameData.Pin();
         using var outputHandle = outputBuffer.Pin();
 
-        ulong bytesWritten = JpegTurboNative.EncodeGray8ToJpeg(
+        var encoder = RentGrayEncoder();
+        ulong bytesWritten;
+        try
+        {
+            bytesWritten = JpegTurboNative.GrayEncoderEncode(
+                encoder,
+                (nint)inputHandle.Pointer,
+                width,
+                height,
+                _quality,
+                (nint)outputHandle.Pointer,
+                (ulong)outputBuffer.Length);
+        }
+        finally
+        {
+            ReturnGrayEncoder(encoder);
+        }
+
+        if (bytesWritten == 0)
+            throw new InvalidOperationException("Failed to encode Gray8 image to JPEG.");
+
+        return (int)bytesWritten;
+    }
+
+    /// <summary>
+    /// Encodes I420 frame to JPEG using a pooled encoder, growing into the writer as needed.
+    /// </summary>
+    public unsafe int EncodeI420(nint encoder, ReadOnlyMemory<byte> frameData, IBufferWriter<byte> output)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        using var inputHandle = frameData.Pin();
+        using var sink = new JpegChunkSink(output);
+
+        ulong bytesWritten = JpegTurboNative.EncodeChunked(
+            encoder,
             (nint)inputHandle.Pointer,
-            width,
-            height,
-            _quality,
-            (nint)outputHandle.Pointer,
-            (ulong)outputBuffer.Length);
+            JpegChunkSink.Callback,
+            sink.Context,
+            null,
+            0,
+            out _);
+
+        sink.ThrowIfFailed();
+        if (bytesWritten == 0)
+            throw new InvalidOperationException("Failed to encode I420 image to JPEG.");
+
+        return (int)bytesWritten;
+    }
+
+    /// <summary>
+    /// Encodes Gray8 frame to JPEG, growing into the writer as needed.
+    /// </summary>
+    public unsafe int EncodeGray8(int width, int height, ReadOnlyMemory<byte> frameData, IBufferWriter<byte> output)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        using var inputHandle = frameData.Pin();
+        using var sink = new JpegChunkSink(output);
+
+        var encoder = RentGrayEncoder();
+        ulong bytesWritten;
+        try
+        {
+            bytesWritten = JpegTurboNative.GrayEncoderEncodeChunked(
+                encoder,
+                (nint)inputHandle.Pointer,
+                width,
+                height,
+                _quality,
+                JpegChunkSink.Callback,
+                sink.Context,
+                null,
+                0,
+                out _);
+        }
+        finally
+        {
+            ReturnGrayEncoder(encoder);
+        }
 
+        sink.ThrowIfFailed();
         if (bytesWritten == 0)
             throw new InvalidOperationException("Failed to encode Gray8 image to JPEG.");
 
@@ -238,16 +1196,16 @@ public sealed class JpegCodecPool : ICodecPool
         if (_disposed) return;
         _disposed = true;
 
-        // Drain and close all encoders
-        while (_encoderPool.TryDequeue(out var encoder))
-        {
-            JpegTurboNative.Close(encoder);
-        }
+        _trimTimer?.Dispose();
 
-        // Drain and close all decoders
-        while (_decoderPool.TryDequeue(out var decoder))
-        {
-            JpegTurboNative.CloseDecoder(decoder);
-        }
+        // Close idle handles; rented ones are closed as they come back
+        _encoderPool.Dispose();
+        _decoderPool.Dispose();
+        _decoderSetPool.Dispose();      // Joins the decoder sets' worker threads
+        _fusedDecoderPool.Dispose();
+        _grayEncoderPool.Dispose();
+        _transformerPool.Dispose();
+
+        MjpegMetrics.Unregister(this);
     }
 }
@@ -39,6 +39,57 @@ public static class JpegDimensionExtractor
         return (0, 0);
     }
 
+    /// <summary>
+    /// Extracts dimensions, component count and chroma subsampling from JPEG data.
+    /// </summary>
+    /// <param name="jpegData">The JPEG frame data.</param>
+    /// <param name="info">The image info. Subsampling is Unknown if the component table is truncated.</param>
+    /// <returns>True if a SOF marker was found.</returns>
+    public static bool TryExtractInfo(ReadOnlySpan<byte> jpegData, out JpegImageInfo info)
+    {
+        // SOF structure: FF Cx LL LL PP HH HH WW WW NN (CI HV TQ) x NN
+        for (var i = 0; i < jpegData.Length - 9; i++)
+        {
+            if (jpegData[i] != MarkerPrefix) continue;
+
+            var marker = jpegData[i + 1];
+            if (marker != SOF0 && marker != SOF1 && marker != SOF2 && marker != SOF3) continue;
+
+            var height = (jpegData[i + 5] << 8) | jpegData[i + 6];
+            var width = (jpegData[i + 7] << 8) | jpegData[i + 8];
+            var components = (int)jpegData[i + 9];
+            info = new JpegImageInfo(width, height, components, GetSubsampling(jpegData.Slice(i + 10), components));
+            return true;
+        }
+
+        info = default;
+        return false;
+    }
+
+    private static ChromaSubsampling GetSubsampling(ReadOnlySpan<byte> componentTable, int components)
+    {
+        if (components == 1)
+            return ChromaSubsampling.Gray;
+        if (components != 3 || componentTable.Length < 9)
+            return ChromaSubsampling.Unknown;
+
+        // Sampling byte is at offset 1 of each 3-byte component entry; chroma planes must match
+        int lumaH = componentTable[1] >> 4, lumaV = componentTable[1] & 0x0F;
+        byte cb = componentTable[4], cr = componentTable[7];
+        if (cb != cr || cb != 0x11)
+            return ChromaSubsampling.Unknown;
+
+        return (lumaH, lumaV) switch
+        {
+            (1, 1) => ChromaSubsampling.Yuv444,
+            (2, 1) => ChromaSubsampling.Yuv422,
+            (2, 2) => ChromaSubsampling.Yuv420,
+            (1, 2) => ChromaSubsampling.Yuv440,
+            (4, 1) => ChromaSubsampling.Yuv411,
+            _ => ChromaSubsampling.Unknown
+        };
+    }
+
     /// <summary>
     /// Extracts width and height from JPEG data.
     /// </summary>
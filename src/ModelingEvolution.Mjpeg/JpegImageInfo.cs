@@ -0,0 +1,10 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Image properties read from a JPEG SOF segment.
+/// </summary>
+/// <param name="Width">Image width in pixels.</param>
+/// <param name="Height">Image height in pixels.</param>
+/// <param name="Components">Number of color components (1 = grayscale, 3 = YCbCr).</param>
+/// <param name="Subsampling">Chroma subsampling derived from the component sampling factors.</param>
+public readonly record struct JpegImageInfo(int Width, int Height, int Components, ChromaSubsampling Subsampling);
@@ -0,0 +1,55 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Lossless DCT-domain transform applied by <see cref="JpegCodecPool.Transform"/>.
+/// </summary>
+public enum JpegTransform
+{
+    /// <summary>No rotation or mirroring (crop, requantize or strip markers only).</summary>
+    None = 0,
+
+    /// <summary>Mirror left to right.</summary>
+    FlipHorizontal = 1,
+
+    /// <summary>Mirror top to bottom.</summary>
+    FlipVertical = 2,
+
+    /// <summary>Mirror across the top-left to bottom-right diagonal.</summary>
+    Transpose = 3,
+
+    /// <summary>Mirror across the top-right to bottom-left diagonal.</summary>
+    Transverse = 4,
+
+    /// <summary>Rotate 90 degrees clockwise.</summary>
+    Rotate90 = 5,
+
+    /// <summary>Rotate 180 degrees (an upside-down camera).</summary>
+    Rotate180 = 6,
+
+    /// <summary>Rotate 270 degrees clockwise.</summary>
+    Rotate270 = 7
+}
+
+/// <summary>
+/// Options of a lossless JPEG transcode. The coefficients are moved between blocks and never
+/// inverse-transformed, so the result carries exactly the source's image data.
+/// </summary>
+/// <remarks>
+/// Mirroring can only move whole MCUs: a partial MCU column or row on an edge the mirror would bring
+/// inside the image is dropped (as jpegtran -trim does), so a 1920x1080 4:2:0 frame rotated by 180
+/// degrees comes out 1920x1072. An axis shorter than one MCU has nothing to mirror and keeps its blocks
+/// in place. Transposing operations swap the chroma sampling factors. Huffman tables are
+/// re-optimized, progressive JPEGs stay progressive and restart markers keep their MCU-row spacing.
+/// </remarks>
+/// <param name="Transform">Rotation or mirroring.</param>
+/// <param name="Crop">
+/// Region of the transformed image to keep. X and Y snap down to the MCU grid (16 pixels for 4:2:0) and the
+/// size grows by the same amount; a width or height of 0 runs to the edge. Null keeps the whole image.
+/// </param>
+/// <param name="Quality">
+/// 1-100 requantizes to the standard tables at that quality, never finer than the source's tables;
+/// 0 keeps the source quantization and loses nothing.
+/// </param>
+/// <param name="StripMarkers">Drops APPn (EXIF, ICC, ...) and COM segments.</param>
+public readonly record struct JpegTransformOptions(JpegTransform Transform = JpegTransform.None, CropRegion? Crop = null,
+    int Quality = 0, bool StripMarkers = false);
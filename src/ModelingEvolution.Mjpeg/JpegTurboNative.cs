@@ -14,36 +14,181 @@ internal static class JpegTurboNative
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     internal static extern nint Create(int width, int height, int quality, ulong bufSize);
 
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern nint CreateWithBackend(int width, int height, int quality, ulong bufSize, int backend);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     internal static extern void Close(nint encoder);
 
+    // Per-handle counters; return 0 when the library was built without LIBJPEGWRAP_WITH_STATS
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int GetEncoderStats(nint encoder, out NativeCodecStats stats);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int GetGrayEncoderStats(nint encoder, out NativeCodecStats stats);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int GetDecoderStats(nint decoder, out NativeCodecStats stats);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int GetDecoderSetStats(nint set, out NativeCodecStats stats);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int GetHdrFusedDecoderStats(nint decoder, out NativeCodecStats stats);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int IsBackendAvailable(int backend);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     internal static extern void SetMode(nint encoder, int mode);
 
+    // Returns 0 on encoders writing abbreviated frames, whose tables are fixed
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int SetQuality(nint encoder, int quality);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern void SetRestartRows(nint encoder, int rows);
+
+    // Target-size rate control; flags match RateControlMode, targetBytes 0 turns it off
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern void SetTargetSize(nint encoder, ulong targetBytes, int minQuality, int maxQuality, int flags);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
-    internal static extern void SetQuality(nint encoder, int quality);
+    internal static extern int GetQuality(nint encoder);
+
+    // Abbreviated datastreams - frames omit DQT/DHT, tables travel once in a tables-only stream
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int SetAbbreviated(nint encoder, int enabled);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong WriteTables(nint encoder, nint dstBuffer, ulong dstBufferSize);
 
     // Encoder operations
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl, EntryPoint = "Encode")]
     internal static extern ulong Encode(nint encoder, nint data, nint dstBuffer, ulong dstBufferSize);
 
+    // Strided planar I420 and NV12 input; uvStride applies to both chroma planes
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong EncodePlanes(nint encoder, nint y, int yStride, nint u, nint v, int uvStride, nint dstBuffer, ulong dstBufferSize);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong EncodeNv12(nint encoder, nint y, int yStride, nint uv, int uvStride, nint dstBuffer, ulong dstBufferSize);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     internal static extern ulong EncodeGray8ToJpeg(nint grayData, int width, int height, int quality, nint output, ulong outputSize);
 
+    // Pooled Gray8 encoder - compress object and tables persist across calls
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern nint CreateGrayEncoder(int quality);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern void CloseGrayEncoder(nint encoder);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong GrayEncoderEncode(nint encoder, nint grayData, int width, int height, int quality, nint output, ulong outputSize);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe ulong GrayEncoderEncodeChunked(nint encoder, nint grayData, int width, int height, int quality,
+        delegate* unmanaged[Cdecl]<nint, ulong, ulong*, nint> alloc, nint context,
+        JpegSegment* segments, int maxSegments, out int segmentCount);
+
+    // Chunked encoder operations - output grows into chunks returned by the allocator callback
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe ulong EncodeChunked(nint encoder, nint data,
+        delegate* unmanaged[Cdecl]<nint, ulong, ulong*, nint> alloc, nint context,
+        JpegSegment* segments, int maxSegments, out int segmentCount);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe ulong EncodeGray8ToJpegChunked(nint grayData, int width, int height, int quality,
+        delegate* unmanaged[Cdecl]<nint, ulong, ulong*, nint> alloc, nint context,
+        JpegSegment* segments, int maxSegments, out int segmentCount);
+
     // Decoder lifecycle
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     internal static extern nint CreateDecoder(int maxWidth, int maxHeight);
 
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern nint CreateDecoderWithBackend(int maxWidth, int maxHeight, int backend);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     internal static extern void CloseDecoder(nint decoder);
 
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern void DecoderSetStripeThreads(nint decoder, int threads);
+
     // Decoder operations (pooled)
+    // Header probe on a pooled decoder
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int DecoderGetImageInfo(nint decoder, nint jpegData, ulong jpegSize, out DecodeInfo info);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int DecoderLoadTables(nint decoder, nint tables, ulong tablesSize);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     internal static extern ulong DecoderDecodeI420(nint decoder, nint jpegData, ulong jpegSize, nint output, ulong outputSize, out DecodeInfo info);
 
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     internal static extern ulong DecoderDecodeGray(nint decoder, nint jpegData, ulong jpegSize, nint output, ulong outputSize, out DecodeInfo info);
 
+    // Scatter-list input read segment by segment, no coalescing copy
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe ulong DecoderDecodeI420Segments(nint decoder, JpegSegment* segments, int count, nint output, ulong outputSize, out DecodeInfo info);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe ulong DecoderDecodeGraySegments(nint decoder, JpegSegment* segments, int count, nint output, ulong outputSize, out DecodeInfo info);
+
+    // scaleDenom: 1, 2, 4 or 8 - DCT-domain downscale, info reports the scaled size
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong DecoderDecodeI420Scaled(nint decoder, nint jpegData, ulong jpegSize, nint output, ulong outputSize, out DecodeInfo info, int scaleDenom);
+
+    // layout: 0 = I420, 1 = I422, 2 = I444, 3 = the JPEG's own sampling; info.Layout reports the one written
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong DecoderDecodeYuv(nint decoder, nint jpegData, ulong jpegSize, nint output, ulong outputSize, out DecodeInfo info, int layout, int scaleDenom);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong DecoderDecodeGrayScaled(nint decoder, nint jpegData, ulong jpegSize, nint output, ulong outputSize, out DecodeInfo info, int scaleDenom);
+
+    // DC-only change detection against the handle's reference map; flags: 1 keeps the reference.
+    // thumbnail may be 0; returns the map size in bytes (info.Width x info.Height), 0 on error
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong DecoderAnalyzeDc(nint decoder, nint jpegData, ulong jpegSize, int threshold, int flags, nint thumbnail, ulong thumbnailSize, out DcChangeInfo info);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern void DecoderResetDcReference(nint decoder);
+
+    // Region-of-interest decode; info.Stride reports the row stride of the output
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong DecoderDecodeI420Crop(nint decoder, nint jpegData, ulong jpegSize, int x, int y, int width, int height, nint output, ulong outputSize, out DecodeInfo info);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong DecoderDecodeGrayCrop(nint decoder, nint jpegData, ulong jpegSize, int x, int y, int width, int height, nint output, ulong outputSize, out DecodeInfo info);
+
+    // Decoder set - batch decode on native worker threads, one transition per batch
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern nint CreateDecoderSet(int threads, int maxWidth, int maxHeight, int backend);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern void CloseDecoderSet(nint set);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe int DecoderDecodeBatch(nint set, nint* jpegs, ulong* sizes, nint* outputs,
+        ulong* outputSizes, DecodeInfo* infos, ulong* results, int count);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe int DecoderDecodeGrayBatch(nint set, nint* jpegs, ulong* sizes, nint* outputs,
+        ulong* outputSizes, DecodeInfo* infos, ulong* results, int count);
+
+    // Fused decode + HDR blend (format: 0 = I420, 1 = Gray8; mode: 0 = Average, 1 = Weighted)
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern nint CreateHdrFusedDecoder(int maxWidth, int maxHeight);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern void CloseHdrFusedDecoder(nint decoder);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe ulong HdrFusedDecodeBlend(nint decoder, int format, int mode,
+        nint* jpegs, ulong* sizes, int count, byte* weights, nint output, ulong outputSize, out DecodeInfo info);
+
     // Legacy non-pooled functions
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     internal static extern ulong DecodeJpegToGray(nint jpegData, ulong jpegSize, nint output, ulong outputSize, out DecodeInfo info);
@@ -54,6 +199,162 @@ internal static class JpegTurboNative
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     internal static extern int GetJpegImageInfo(nint jpegData, ulong jpegSize, out DecodeInfo info);
 
+    // I420 planes to packed BGRA (order 0) or RGBA (order 1) rows outStride bytes apart
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong ConvertI420ToBGRA(nint y, int yStride, nint u, nint v, int uvStride,
+        int width, int height, nint output, int outStride, int order);
+
+    // Streaming decoder (suspending source, fed segment by segment)
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern nint CreateStreamingDecoder(int maxWidth, int maxHeight);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern void CloseStreamingDecoder(nint decoder);
+
+    // format: 0 = I420, 1 = Gray8
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int StreamingDecoderBegin(nint decoder, int format, nint output, ulong outputSize);
+
+    // Returns 0 = need more data, 1 = done (info and written set), -1 = error
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int StreamingDecoderFeed(nint decoder, nint data, ulong size, int last, out DecodeInfo info, out ulong written);
+
+    // Lossless DCT-domain transcoder
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern nint CreateTransformer();
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern void CloseTransformer(nint transformer);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int GetTransformerStats(nint transformer, out NativeCodecStats stats);
+
+    // op matches JpegTransform; cropWidth/cropHeight 0 = to the edge; quality 0 keeps the tables; flags: 1 = strip APPn/COM
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong TransformerTransform(nint transformer, nint jpegData, ulong jpegSize,
+        int op, int cropX, int cropY, int cropWidth, int cropHeight, int quality, int flags,
+        nint output, ulong outputSize, out DecodeInfo info);
+
+    // V4L2 M2M hardware decoder; device null = first JPEG-capable /dev/videoN. Returns 0 without one.
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern nint CreateV4l2Decoder([MarshalAs(UnmanagedType.LPStr)] string? device, int maxWidth, int maxHeight);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern void CloseV4l2Decoder(nint decoder);
+
+    // Returns 1 and the NUL-terminated path of the first JPEG-capable /dev/videoN, 0 without one
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern unsafe int FindV4l2Decoder(byte* path, int pathSize);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int GetV4l2DecoderStats(nint decoder, out NativeCodecStats stats);
+
+    // format: 0 = I420, 1 = Gray8; returns 0 for frames the engine does not take
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern ulong V4l2DecoderDecode(nint decoder, nint jpegData, ulong jpegSize, int format,
+        nint output, ulong outputSize, out DecodeInfo info);
+
+    /// <summary>
+    /// Creates an encoder for the backend. LibJpeg uses the original export so older native builds keep working.
+    /// </summary>
+    internal static nint CreateEncoder(int width, int height, int quality, ulong bufSize, JpegBackend backend)
+    {
+        return backend == JpegBackend.LibJpeg
+            ? Create(width, height, quality, bufSize)
+            : CreateWithBackend(width, height, quality, bufSize, (int)backend);
+    }
+
+    /// <summary>
+    /// Creates a decoder for the backend. LibJpeg uses the original export so older native builds keep working.
+    /// </summary>
+    internal static nint CreateDecoder(int maxWidth, int maxHeight, JpegBackend backend)
+    {
+        return backend == JpegBackend.LibJpeg
+            ? CreateDecoder(maxWidth, maxHeight)
+            : CreateDecoderWithBackend(maxWidth, maxHeight, (int)backend);
+    }
+
+    /// <summary>
+    /// Encodes an I420 or NV12 frame whose header stride is the luma row stride.
+    /// Tightly packed I420 uses the original export so older native builds keep working.
+    /// </summary>
+    internal static unsafe ulong EncodeFrame(nint encoder, in FrameHeader header, ReadOnlySpan<byte> data, byte* output, ulong outputSize)
+    {
+        int stride = header.Stride;
+        int chromaHeight = (header.Height + 1) / 2;
+        long lumaSize = (long)stride * header.Height;
+        long required = header.Format switch
+        {
+            PixelFormat.I420 => lumaSize + 2L * ((stride + 1) / 2) * chromaHeight,
+            PixelFormat.Nv12 => lumaSize + (long)stride * chromaHeight,
+            _ => throw new NotSupportedException($"Only I420 and NV12 frames can be encoded here. Got: {header.Format}")
+        };
+        if (stride < header.Width || data.Length < required)
+            throw new ArgumentException($"Frame data ({data.Length} bytes, stride {stride}) is too small for {header.Width}x{header.Height} {header.Format}.");
+
+        fixed (byte* y = data)
+        {
+            byte* chroma = y + lumaSize;
+            if (header.Format == PixelFormat.Nv12)
+                return EncodeNv12(encoder, (nint)y, stride, (nint)chroma, stride, (nint)output, outputSize);
+            if (stride == header.Width)
+                return Encode(encoder, (nint)y, (nint)output, outputSize);
+
+            int chromaStride = (stride + 1) / 2;
+            return EncodePlanes(encoder, (nint)y, stride, (nint)chroma,
+                (nint)(chroma + (long)chromaStride * chromaHeight), chromaStride, (nint)output, outputSize);
+        }
+    }
+
+    /// <summary>
+    /// Throws NotSupportedException when the native library was built without the backend.
+    /// </summary>
+    internal static void EnsureBackendAvailable(JpegBackend backend)
+    {
+        if (backend != JpegBackend.LibJpeg && IsBackendAvailable((int)backend) == 0)
+            throw new NotSupportedException($"JPEG backend {backend} is not available in this build of LibJpegWrap.");
+    }
+
+    /// <summary>
+    /// One piece of a chunked JPEG output or scatter-list input (native JpegSegment).
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct JpegSegment
+    {
+        public nint Data;
+        public nuint Size;
+    }
+
+    /// <summary>
+    /// Reads a handle's counters with one of the Get*Stats imports; all zero without native stats.
+    /// </summary>
+    internal static CodecStats ReadStats(nint handle, StatsReader reader)
+    {
+        if (reader(handle, out var native) == 0)
+            return default;
+
+        return new CodecStats((long)native.Calls, (long)native.Errors, (long)native.BytesIn, (long)native.BytesOut,
+            TimeSpan.FromTicks((long)(native.HeaderNs / 100)), TimeSpan.FromTicks((long)(native.CodingNs / 100)),
+            (long)native.PeakPoolBytes);
+    }
+
+    internal delegate int StatsReader(nint handle, out NativeCodecStats stats);
+
+    /// <summary>
+    /// Per-handle counters from native library (native CodecStats).
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct NativeCodecStats
+    {
+        public ulong Calls;
+        public ulong Errors;
+        public ulong BytesIn;
+        public ulong BytesOut;
+        public ulong HeaderNs;
+        public ulong CodingNs;
+        public ulong PeakPoolBytes;
+    }
+
     /// <summary>
     /// Decode result info from native library.
     /// </summary>
@@ -64,5 +365,21 @@ internal static class JpegTurboNative
         public int Height;
         public int Components;
         public int ColorSpace;
+        public int Stride;      // Set by crop and packed (BGRA/RGBA) decodes
+        public int Layout;      // Planar YUV layout written (0 = I420, 1 = I422, 2 = I444); the JPEG's own from header probes, -1 for none
+    }
+
+    /// <summary>
+    /// DC change analysis result from native library (native DcChangeInfo).
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct DcChangeInfo
+    {
+        public int Width;
+        public int Height;
+        public int Compared;
+        public int ChangedBlocks;
+        public int MaxDifference;
+        public ulong SumDifference;
     }
 }
@@ -0,0 +1,284 @@
+using System.Buffers.Binary;
+using System.IO.MemoryMappedFiles;
+
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Read-only, memory-mapped frame index sidecar for an MJPEG recording.
+/// Opening is O(1) regardless of recording length; frames are looked up by index or by file offset (binary search).
+/// Thread-safe for concurrent reads.
+/// </summary>
+/// <remarks>
+/// File layout (little-endian): a 32-byte header followed by 16-byte entries.
+/// Header: magic "MJIX", u16 version, u16 entry size, i32 width, i32 height, u8 components, u8 subsampling, reserved.
+/// Entry: i64 start offset, i64 size. The frame count is derived from the file length and a torn
+/// trailing entry is ignored, so the file can be appended to while a recording is in progress.
+/// The mapping covers the file as it was when opened; reopen to see frames appended later.
+/// </remarks>
+public sealed class MjpegFrameIndex : IDisposable
+{
+    /// <summary>
+    /// File extension of index sidecars, appended to the recording file name.
+    /// </summary>
+    public const string FileExtension = ".mjidx";
+
+    internal const int HeaderSize = 32;
+    internal const int EntrySize = 16;
+    private const uint Magic = 0x58494A4D; // "MJIX"
+    private const ushort Version = 1;
+
+    private readonly MemoryMappedFile _file;
+    private readonly MemoryMappedViewAccessor _view;
+    private readonly unsafe byte* _entries;
+    private bool _disposed;
+
+    /// <summary>
+    /// Number of indexed frames.
+    /// </summary>
+    public int Count { get; }
+
+    /// <summary>
+    /// Image properties of the recording, as probed from its first frame.
+    /// </summary>
+    public JpegImageInfo ImageInfo { get; }
+
+    /// <summary>
+    /// Image width in pixels (0 if unknown).
+    /// </summary>
+    public int Width => ImageInfo.Width;
+
+    /// <summary>
+    /// Image height in pixels (0 if unknown).
+    /// </summary>
+    public int Height => ImageInfo.Height;
+
+    /// <summary>
+    /// Chroma subsampling of the recording.
+    /// </summary>
+    public ChromaSubsampling Subsampling => ImageInfo.Subsampling;
+
+    /// <summary>
+    /// Byte offset just past the last indexed frame (0 when empty).
+    /// </summary>
+    public long EndOffset => Count == 0 ? 0 : ReadStart(Count - 1) + ReadSize(Count - 1);
+
+    private unsafe MjpegFrameIndex(MemoryMappedFile file, MemoryMappedViewAccessor view, int count, JpegImageInfo info)
+    {
+        _file = file;
+        _view = view;
+        Count = count;
+        ImageInfo = info;
+
+        byte* ptr = null;
+        view.SafeMemoryMappedViewHandle.AcquirePointer(ref ptr);
+        _entries = ptr + view.PointerOffset + HeaderSize;
+    }
+
+    /// <summary>
+    /// Returns the default sidecar path for a recording file.
+    /// </summary>
+    public static string GetDefaultPath(string recordingPath) => recordingPath + FileExtension;
+
+    /// <summary>
+    /// Opens an index sidecar. Throws InvalidDataException if the file is not a frame index.
+    /// </summary>
+    public static MjpegFrameIndex Open(string indexPath)
+    {
+        // ReadWrite sharing lets a reader open the index while a recorder is still appending
+        var stream = new FileStream(indexPath, FileMode.Open, FileAccess.Read, FileShare.ReadWrite);
+        try
+        {
+            if (stream.Length < HeaderSize || !TryReadHeader(stream, out var info))
+                throw new InvalidDataException($"Not an MJPEG frame index: {indexPath}");
+
+            long length = stream.Length;
+            int count = checked((int)((length - HeaderSize) / EntrySize));
+            var file = MemoryMappedFile.CreateFromFile(stream, null, 0, MemoryMappedFileAccess.Read,
+                HandleInheritability.None, leaveOpen: false);
+            try
+            {
+                var view = file.CreateViewAccessor(0, HeaderSize + (long)count * EntrySize, MemoryMappedFileAccess.Read);
+                return new MjpegFrameIndex(file, view, count, info);
+            }
+            catch
+            {
+                file.Dispose();
+                throw;
+            }
+        }
+        catch
+        {
+            stream.Dispose();
+            throw;
+        }
+    }
+
+    /// <summary>
+    /// Brings the sidecar of a recording up to date and opens it.
+    /// Only bytes past the last indexed frame are scanned, so an existing index costs almost nothing
+    /// and a growing recording is indexed incrementally. An index that extends past the end of the
+    /// recording, or whose last frame no longer ends in EOI, is stale and is rebuilt from scratch.
+    /// </summary>
+    /// <param name="recordingPath">Path of the MJPEG recording.</param>
+    /// <param name="indexPath">Path of the sidecar; defaults to <see cref="GetDefaultPath"/>.</param>
+    /// <param name="cancellationToken">Cancellation token.</param>
+    public static async Task<MjpegFrameIndex> BuildAsync(
+        string recordingPath,
+        string? indexPath = null,
+        CancellationToken cancellationToken = default)
+    {
+        indexPath ??= GetDefaultPath(recordingPath);
+
+        await using (var recording = new FileStream(recordingPath, FileMode.Open, FileAccess.Read, FileShare.ReadWrite,
+                         bufferSize: 0, FileOptions.SequentialScan))
+        {
+            var writer = new MjpegFrameIndexWriter(indexPath, append: true);
+            try
+            {
+                if (writer.EndOffset > recording.Length || !EndsWithEoi(recording, writer.EndOffset))
+                {
+                    writer.Dispose();
+                    writer = new MjpegFrameIndexWriter(indexPath);
+                }
+
+                await ScanIntoAsync(recording, writer, cancellationToken);
+            }
+            finally
+            {
+                writer.Dispose();
+            }
+        }
+
+        return Open(indexPath);
+    }
+
+    private static bool EndsWithEoi(FileStream recording, long endOffset)
+    {
+        if (endOffset == 0) return true;
+
+        Span<byte> eoi = stackalloc byte[2];
+        return endOffset >= 2
+            && RandomAccess.Read(recording.SafeFileHandle, eoi, endOffset - 2) == 2
+            && eoi[0] == 0xFF && eoi[1] == 0xD9;
+    }
+
+    private static async Task ScanIntoAsync(FileStream recording, MjpegFrameIndexWriter writer, CancellationToken cancellationToken)
+    {
+        long baseOffset = writer.EndOffset;
+        recording.Position = baseOffset;
+
+        var scanner = new FrameBoundaryScanner();
+        var buffer = new byte[1024 * 1024];
+        var frames = new List<FrameInfo>();
+        FrameInfo? firstFrame = null;
+
+        while (true)
+        {
+            cancellationToken.ThrowIfCancellationRequested();
+
+            var bytesRead = await recording.ReadAsync(buffer, cancellationToken);
+            if (bytesRead == 0) break;
+
+            scanner.Scan(buffer.AsSpan(0, bytesRead), frames);
+            foreach (var frame in frames)
+            {
+                firstFrame ??= frame;
+                writer.Append(baseOffset + frame.StartOffset, frame.Size);
+            }
+            frames.Clear();
+        }
+
+        if (writer.ImageInfo.Width == 0 && firstFrame is { } first)
+        {
+            // SOF normally sits within the first few KB; APP segments can push it to ~64KB
+            var head = buffer.AsMemory(0, (int)Math.Min(first.Size, buffer.Length));
+            int read = await RandomAccess.ReadAsync(recording.SafeFileHandle, head, baseOffset + first.StartOffset, cancellationToken);
+            if (JpegDimensionExtractor.TryExtractInfo(head.Span[..read], out var info))
+                writer.SetImageInfo(info);
+        }
+    }
+
+    /// <summary>
+    /// Gets the frame at the specified index.
+    /// </summary>
+    public FrameInfo this[int index]
+    {
+        get
+        {
+            ObjectDisposedException.ThrowIf(_disposed, this);
+            if ((uint)index >= (uint)Count)
+                throw new ArgumentOutOfRangeException(nameof(index));
+            return new FrameInfo(ReadStart(index), ReadSize(index), (ulong)index);
+        }
+    }
+
+    /// <summary>
+    /// Finds the frame containing the byte offset, or the last frame starting before it when the
+    /// offset falls between frames. Returns -1 if the offset precedes the first frame.
+    /// </summary>
+    public int FindFrame(long offset)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        int lo = 0, hi = Count - 1;
+        while (lo <= hi)
+        {
+            int mid = lo + ((hi - lo) >> 1);
+            if (ReadStart(mid) <= offset)
+                lo = mid + 1;
+            else
+                hi = mid - 1;
+        }
+        return hi;
+    }
+
+    private unsafe long ReadStart(int index) =>
+        BinaryPrimitives.ReadInt64LittleEndian(new ReadOnlySpan<byte>(_entries + (long)index * EntrySize, 8));
+
+    private unsafe long ReadSize(int index) =>
+        BinaryPrimitives.ReadInt64LittleEndian(new ReadOnlySpan<byte>(_entries + (long)index * EntrySize + 8, 8));
+
+    internal static void WriteHeader(Span<byte> header, in JpegImageInfo info)
+    {
+        header.Clear();
+        BinaryPrimitives.WriteUInt32LittleEndian(header, Magic);
+        BinaryPrimitives.WriteUInt16LittleEndian(header[4..], Version);
+        BinaryPrimitives.WriteUInt16LittleEndian(header[6..], EntrySize);
+        BinaryPrimitives.WriteInt32LittleEndian(header[8..], info.Width);
+        BinaryPrimitives.WriteInt32LittleEndian(header[12..], info.Height);
+        header[16] = (byte)info.Components;
+        header[17] = (byte)info.Subsampling;
+    }
+
+    internal static bool TryReadHeader(Stream stream, out JpegImageInfo info)
+    {
+        Span<byte> header = stackalloc byte[HeaderSize];
+        stream.Position = 0;
+        stream.ReadExactly(header);
+
+        info = default;
+        if (BinaryPrimitives.ReadUInt32LittleEndian(header) != Magic
+            || BinaryPrimitives.ReadUInt16LittleEndian(header[4..]) != Version
+            || BinaryPrimitives.ReadUInt16LittleEndian(header[6..]) != EntrySize)
+            return false;
+
+        info = new JpegImageInfo(
+            BinaryPrimitives.ReadInt32LittleEndian(header[8..]),
+            BinaryPrimitives.ReadInt32LittleEndian(header[12..]),
+            header[16],
+            (ChromaSubsampling)header[17]);
+        return true;
+    }
+
+    /// <summary>
+    /// Releases the mapping.
+    /// </summary>
+    public void Dispose()
+    {
+        if (_disposed) return;
+        _disposed = true;
+        _view.SafeMemoryMappedViewHandle.ReleasePointer();
+        _view.Dispose();
+        _file.Dispose();
+    }
+}
@@ -0,0 +1,152 @@
+using System.Buffers.Binary;
+
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Appends frame entries to an <see cref="MjpegFrameIndex"/> sidecar while a recording is written or scanned.
+/// Entries are fixed-size, so a crash leaves at most one torn entry which readers ignore.
+/// Not thread-safe.
+/// </summary>
+public sealed class MjpegFrameIndexWriter : IDisposable
+{
+    private readonly FileStream _stream;
+    private readonly byte[] _entry = new byte[MjpegFrameIndex.EntrySize];
+    private JpegImageInfo _imageInfo;
+    private bool _headerDirty;
+    private bool _disposed;
+
+    /// <summary>
+    /// Number of frames in the index.
+    /// </summary>
+    public int Count { get; private set; }
+
+    /// <summary>
+    /// Byte offset just past the last indexed frame (0 when empty). Scanning can resume from here.
+    /// </summary>
+    public long EndOffset { get; private set; }
+
+    /// <summary>
+    /// Image properties stored in the header. Default until set or probed from the first frame.
+    /// </summary>
+    public JpegImageInfo ImageInfo => _imageInfo;
+
+    /// <summary>
+    /// Creates a new index file, or continues an existing one when <paramref name="append"/> is true.
+    /// </summary>
+    /// <param name="path">Path of the index sidecar.</param>
+    /// <param name="append">Keep the entries of an existing index and append after them.</param>
+    public MjpegFrameIndexWriter(string path, bool append = false)
+    {
+        _stream = new FileStream(path, append ? FileMode.OpenOrCreate : FileMode.Create,
+            FileAccess.ReadWrite, FileShare.Read);
+
+        try
+        {
+            if (_stream.Length >= MjpegFrameIndex.HeaderSize && MjpegFrameIndex.TryReadHeader(_stream, out _imageInfo))
+                Resume();
+            else
+                WriteHeader();
+        }
+        catch
+        {
+            _stream.Dispose();
+            throw;
+        }
+    }
+
+    /// <summary>
+    /// Sets the image properties stored in the header.
+    /// </summary>
+    public void SetImageInfo(in JpegImageInfo info)
+    {
+        _imageInfo = info;
+        _headerDirty = true;
+    }
+
+    /// <summary>
+    /// Appends a frame. Frame indices are assigned in append order; <see cref="FrameInfo.FrameIndex"/> is ignored.
+    /// </summary>
+    public void Append(in FrameInfo frame) => Append(frame.StartOffset, frame.Size);
+
+    /// <summary>
+    /// Appends a frame located at <paramref name="startOffset"/> in the recording.
+    /// </summary>
+    public void Append(long startOffset, long size)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        ArgumentOutOfRangeException.ThrowIfNegative(startOffset);
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(size);
+        if (startOffset < EndOffset)
+            throw new ArgumentException("Frames must be appended in file order.", nameof(startOffset));
+
+        BinaryPrimitives.WriteInt64LittleEndian(_entry, startOffset);
+        BinaryPrimitives.WriteInt64LittleEndian(_entry.AsSpan(8), size);
+        _stream.Write(_entry);
+
+        Count++;
+        EndOffset = startOffset + size;
+    }
+
+    /// <summary>
+    /// Appends a frame, probing the header image properties from it if they are not set yet.
+    /// </summary>
+    public void Append(long startOffset, ReadOnlySpan<byte> jpeg)
+    {
+        if (_imageInfo.Width == 0 && JpegDimensionExtractor.TryExtractInfo(jpeg, out var info))
+            SetImageInfo(info);
+        Append(startOffset, jpeg.Length);
+    }
+
+    /// <summary>
+    /// Writes buffered entries and pending header changes to disk.
+    /// </summary>
+    public void Flush()
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        if (_headerDirty)
+        {
+            var end = _stream.Position;
+            _stream.Position = 0;
+            WriteHeader();
+            _stream.Position = end;
+        }
+        _stream.Flush();
+    }
+
+    private void WriteHeader()
+    {
+        Span<byte> header = stackalloc byte[MjpegFrameIndex.HeaderSize];
+        MjpegFrameIndex.WriteHeader(header, _imageInfo);
+        _stream.Write(header);
+        _headerDirty = false;
+    }
+
+    private void Resume()
+    {
+        // Drop a torn trailing entry so appends stay aligned
+        long entries = (_stream.Length - MjpegFrameIndex.HeaderSize) / MjpegFrameIndex.EntrySize;
+        long end = MjpegFrameIndex.HeaderSize + entries * MjpegFrameIndex.EntrySize;
+        _stream.SetLength(end);
+        Count = checked((int)entries);
+
+        if (entries > 0)
+        {
+            _stream.Position = end - MjpegFrameIndex.EntrySize;
+            _stream.ReadExactly(_entry);
+            EndOffset = BinaryPrimitives.ReadInt64LittleEndian(_entry) + BinaryPrimitives.ReadInt64LittleEndian(_entry.AsSpan(8));
+        }
+        _stream.Position = end;
+    }
+
+    /// <summary>
+    /// Flushes and closes the index file.
+    /// </summary>
+    public void Dispose()
+    {
+        if (_disposed) return;
+        Flush();
+        _disposed = true;
+        _stream.Dispose();
+    }
+}
@@ -9,7 +9,7 @@ namespace ModelingEvolution.Mjpeg;
 public readonly record struct FrameInfo(long StartOffset, long Size, ulong FrameIndex);
 
 /// <summary>
-/// Scans MJPEG streams to extract frame boundary information.
+/// Scans MJPEG streams to extract frame boundary information. Built on <see cref="FrameBoundaryScanner"/>.
 /// </summary>
 public static class MjpegFrameScanner
 {
@@ -25,11 +25,9 @@ public static class MjpegFrameScanner
         int bufferSize = 64 * 1024,
         [System.Runtime.CompilerServices.EnumeratorCancellation] CancellationToken cancellationToken = default)
     {
-        var decoder = new MjpegDecoder();
+        var scanner = new FrameBoundaryScanner();
         var buffer = new byte[bufferSize];
-        long position = 0;
-        long frameStart = -1;
-        ulong frameIndex = 0;
+        var frames = new List<FrameInfo>();
 
         while (true)
         {
@@ -38,27 +36,10 @@ public static class MjpegFrameScanner
             var bytesRead = await stream.ReadAsync(buffer, cancellationToken);
             if (bytesRead == 0) break;
 
-            for (var i = 0; i < bytesRead; i++)
-            {
-                var absolutePosition = position + i;
-                var marker = decoder.Decode(buffer[i]);
-
-                switch (marker)
-                {
-                    case JpegMarker.Start when frameStart < 0:
-                        frameStart = absolutePosition - 1; // -1 because SOI is 2 bytes (FF D8)
-                        break;
-
-                    case JpegMarker.End when frameStart >= 0:
-                        var frameSize = absolutePosition - frameStart + 1;
-                        yield return new FrameInfo(frameStart, frameSize, frameIndex);
-                        frameIndex++;
-                        frameStart = -1;
-                        break;
-                }
-            }
-
-            position += bytesRead;
+            scanner.Scan(buffer.AsSpan(0, bytesRead), frames);
+            foreach (var frame in frames)
+                yield return frame;
+            frames.Clear();
         }
     }
 
@@ -70,29 +51,7 @@ public static class MjpegFrameScanner
     public static List<FrameInfo> Scan(ReadOnlySpan<byte> data)
     {
         var frames = new List<FrameInfo>();
-        var decoder = new MjpegDecoder();
-        long frameStart = -1;
-        ulong frameIndex = 0;
-
-        for (var i = 0; i < data.Length; i++)
-        {
-            var marker = decoder.Decode(data[i]);
-
-            switch (marker)
-            {
-                case JpegMarker.Start when frameStart < 0:
-                    frameStart = i - 1;
-                    break;
-
-                case JpegMarker.End when frameStart >= 0:
-                    var frameSize = i - frameStart + 1;
-                    frames.Add(new FrameInfo(frameStart, frameSize, frameIndex));
-                    frameIndex++;
-                    frameStart = -1;
-                    break;
-            }
-        }
-
+        new FrameBoundaryScanner().Scan(data, frames);
         return frames;
     }
 }
@@ -1,4 +1,5 @@
 using System.Buffers;
+using System.Diagnostics;
 using System.Runtime.CompilerServices;
 using Microsoft.Extensions.Logging;
 using Microsoft.Extensions.Logging.Abstractions;
@@ -10,6 +11,7 @@ namespace ModelingEvolution.Mjpeg;
 /// Fetches frames, decodes JPEG, blends using HDR algorithms, and re-encodes to JPEG.
 /// Matches GStreamer gsthdr plugin processing pipeline.
 /// Each engine owns its own codec pool for optimal performance with parallel decode.
+/// Produced frames are counted and timed on the "ModelingEvolution.Mjpeg" meter (mjpeg.hdr.frames, mjpeg.hdr.duration).
 /// </summary>
 public sealed class MjpegHdrEngine : IDisposable
 {
@@ -36,6 +38,19 @@ public sealed class MjpegHdrEngine : IDisposable
     /// </summary>
     public HdrWeights? Weights { get; set; }
 
+    /// <summary>
+    /// Decode and blend the window in a single native pass (Average and Weighted modes only).
+    /// Avoids per-frame decode buffers; GrayToRgb always uses the separate decode and blend path.
+    /// </summary>
+    public bool FusedDecodeBlend { get; set; }
+
+    /// <summary>
+    /// Optional cache of decoded frames shared by overlapping windows. With sequential access each
+    /// JPEG is then fetched and decoded once instead of once per window. Takes precedence over
+    /// <see cref="FusedDecodeBlend"/>, which cannot reuse per-frame decodes. Not owned by the engine.
+    /// </summary>
+    public DecodedFrameCache? FrameCache { get; set; }
+
     /// <summary>
     /// JPEG output quality (1-100).
     /// </summary>
@@ -101,9 +116,35 @@ public sealed class MjpegHdrEngine : IDisposable
         ObjectDisposedException.ThrowIf(_disposed, this);
         ValidateConfiguration();
 
+        long started = Stopwatch.GetTimestamp();
+        var frame = await GetCoreAsync(frameId);
+        MjpegMetrics.RecordHdrFrame(HdrMode, Stopwatch.GetElapsedTime(started));
+        return frame;
+    }
+
+    private async Task<FrameImage> GetCoreAsync(ulong frameId)
+    {
         _logger.LogDebug("GetAsync started: FrameId={FrameId}, Mode={Mode}, WindowCount={WindowCount}",
             frameId, HdrMode, HdrFrameWindowCount);
 
+        if (FrameCache is { } cache)
+        {
+            return await GetCachedAsync(frameId, cache);
+        }
+
+        if (FusedDecodeBlend && HdrMode is HdrBlendMode.Average or HdrBlendMode.Weighted)
+        {
+            _logger.LogDebug("Decoding and blending {Count} frames using fused {Mode} mode", HdrFrameWindowCount, HdrMode);
+            using var fusedFrame = await FetchAndDecodeBlendAsync(frameId);
+
+            var fusedResult = EncodeWithPooledEncoder(fusedFrame);
+
+            _logger.LogDebug("GetAsync completed: FrameId={FrameId}, OutputSize={OutputSize}",
+                frameId, fusedResult.Header.Length);
+
+            return fusedResult;
+        }
+
         // Fetch and decode frames
         var decodedFrames = await FetchAndDecodeFramesAsync(frameId);
 
@@ -131,23 +172,61 @@ public sealed class MjpegHdrEngine : IDisposable
         }
     }
 
+    private async Task<FrameImage> GetCachedAsync(ulong frameId, DecodedFrameCache cache)
+    {
+        var handles = await FetchAndDecodeCachedAsync(frameId, cache);
+        try
+        {
+            var frames = new FrameImage[handles.Length];
+            for (int i = 0; i < handles.Length; i++)
+            {
+                frames[i] = handles[i].AsFrameImage();
+            }
+
+            _logger.LogDebug("Blending {Count} frames using {Mode} mode", frames.Length, HdrMode);
+            using var blendedFrame = BlendFrames(frames);
+
+            var result = EncodeWithPooledEncoder(blendedFrame);
+
+            _logger.LogDebug("GetAsync completed: FrameId={FrameId}, OutputSize={OutputSize}",
+                frameId, result.Header.Length);
+
+            return result;
+        }
+        finally
+        {
+            foreach (var handle in handles)
+            {
+                handle.Dispose();
+            }
+        }
+    }
+
     private FrameImage EncodeWithPooledEncoder(FrameImage frame)
     {
         var encoder = _codecPool.RentEncoder();
         try
         {
-            // Rent output buffer from pool - may be larger than needed
-            int maxSize = frame.Header.Length;
-            var outputOwner = _pool.Rent(maxSize);
+            // Start from a typical compressed size; the writer grows if the frame needs more
+            var output = new PooledBufferWriter(frame.Header.Length / 8, _pool);
 
             _logger.LogDebug("Encoding {Width}x{Height} {Format} frame", frame.Header.Width, frame.Header.Height, frame.Header.Format);
 
-            int length = frame.Header.Format switch
+            int length;
+            try
+            {
+                length = frame.Header.Format switch
+                {
+                    PixelFormat.I420 => _codecPool.EncodeI420(encoder, frame.Data, output),
+                    PixelFormat.Gray8 => _codecPool.EncodeGray8(frame.Header.Width, frame.Header.Height, frame.Data, output),
+                    _ => throw new NotSupportedException($"Only I420 and Gray8 formats are supported. Got: {frame.Header.Format}")
+                };
+            }
+            catch
             {
-                PixelFormat.I420 => _codecPool.EncodeI420(encoder, frame.Data, outputOwner.Memory),
-                PixelFormat.Gray8 => _codecPool.EncodeGray8(frame.Header.Width, frame.Header.Height, frame.Data, outputOwner.Memory),
-                _ => throw new NotSupportedException($"Only I420 and Gray8 formats are supported. Got: {frame.Header.Format}")
-            };
+                output.Dispose();
+                throw;
+            }
 
             _logger.LogDebug("Encoded to {Length} bytes (ratio: {Ratio:P1})", length, (double)length / frame.Header.Length);
 
@@ -159,7 +238,7 @@ public sealed class MjpegHdrEngine : IDisposable
                 frame.Header.Format,
                 length);
 
-            return new FrameImage(header, outputOwner);
+            return new FrameImage(header, output);
         }
         finally
         {
@@ -175,6 +254,201 @@ public sealed class MjpegHdrEngine : IDisposable
         return GetAsync(frameId).GetAwaiter().GetResult();
     }
 
+    /// <summary>
+    /// Streams HDR-processed frames <paramref name="firstFrameId"/> .. <paramref name="firstFrameId"/> + <paramref name="frameCount"/> - 1
+    /// in order. Unlike repeated <see cref="GetAsync"/> calls the stages overlap: up to <paramref name="prefetch"/>
+    /// windows are in flight, so upcoming JPEGs are fetched and decoded on the codec pool while earlier windows
+    /// are blended and encoded, and each JPEG is fetched and decoded once for all the windows it falls into.
+    /// </summary>
+    /// <remarks>
+    /// Output is bounded: a window is only started once the frame <paramref name="prefetch"/> places before it
+    /// has been handed out, so a slow consumer holds at most that many encoded frames. Each yielded frame must be
+    /// disposed by the caller. <see cref="FrameCache"/> is consulted and filled as in <see cref="GetAsync"/>;
+    /// <see cref="FusedDecodeBlend"/> is ignored, since the fused pass cannot share decodes between windows.
+    /// Breaking out of the loop or cancelling waits for the in-flight windows and releases their frames.
+    /// </remarks>
+    /// <param name="firstFrameId">Target frame ID of the first window.</param>
+    /// <param name="frameCount">Number of output frames.</param>
+    /// <param name="prefetch">Windows processed ahead of the consumer (1 = no overlap between output frames).</param>
+    /// <param name="cancellationToken">Stops scheduling new windows and fetches.</param>
+    public async IAsyncEnumerable<FrameImage> StreamAsync(
+        ulong firstFrameId,
+        int frameCount,
+        int prefetch = 4,
+        [EnumeratorCancellation] CancellationToken cancellationToken = default)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        ArgumentOutOfRangeException.ThrowIfNegative(frameCount);
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(prefetch);
+        ValidateConfiguration();
+
+        int windowCount = HdrFrameWindowCount;
+        var cache = FrameCache;
+        var format = PixelFormat == PixelFormat.Gray8 ? PixelFormat.Gray8 : PixelFormat.I420;
+        var decodes = new Dictionary<ulong, StreamFrame>();
+        var pending = new Queue<Task<FrameImage>>(prefetch);
+        int scheduled = 0;
+
+        _logger.LogDebug("StreamAsync started: FirstFrameId={FirstFrameId}, Count={Count}, Prefetch={Prefetch}",
+            firstFrameId, frameCount, prefetch);
+
+        try
+        {
+            while (true)
+            {
+                while (scheduled < frameCount && pending.Count < prefetch)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    ulong frameId = firstFrameId + (ulong)scheduled++;
+
+                    var window = new StreamFrame[windowCount];
+                    for (int i = 0; i < windowCount; i++)
+                    {
+                        ulong id = WindowFrameId(frameId, i);
+                        if (!decodes.TryGetValue(id, out var decoded))
+                        {
+                            decoded = new StreamFrame(Task.Run(() => FetchAndDecodeOneAsync(id, format, cache), cancellationToken));
+                            decodes.Add(id, decoded);
+                        }
+                        decoded.AddUser();
+                        window[i] = decoded;
+                    }
+                    // Frames older than this window are used by no later window
+                    ReleaseOlderThan(decodes, WindowFrameId(frameId, windowCount - 1));
+
+                    pending.Enqueue(Task.Run(() => BlendWindowAsync(window)));
+                }
+
+                // A failed window has no output to release, so it can leave the queue before the await
+                if (!pending.TryDequeue(out var head)) break;
+
+                yield return await head;
+            }
+        }
+        finally
+        {
+            // Early exit: let in-flight windows finish and drop their output
+            while (pending.TryDequeue(out var task))
+            {
+                try
+                {
+                    (await task).Dispose();
+                }
+                catch (Exception ex)
+                {
+                    _logger.LogDebug(ex, "Discarded in-flight HDR window");
+                }
+            }
+            foreach (var decoded in decodes.Values)
+            {
+                decoded.Release();
+            }
+        }
+    }
+
+    private static void ReleaseOlderThan(Dictionary<ulong, StreamFrame> decodes, ulong oldestId)
+    {
+        if (oldestId == 0) return;
+
+        List<ulong>? stale = null;
+        foreach (var id in decodes.Keys)
+        {
+            if (id < oldestId)
+                (stale ??= new List<ulong>()).Add(id);
+        }
+        if (stale == null) return;
+
+        foreach (var id in stale)
+        {
+            decodes.Remove(id, out var decoded);
+            decoded!.Release();
+        }
+    }
+
+    private async Task<DecodedFrameHandle> FetchAndDecodeOneAsync(ulong frameId, PixelFormat format, DecodedFrameCache? cache)
+    {
+        if (cache != null && cache.TryGet(frameId, format, out var cached))
+            return cached;
+
+        using var jpegOwner = await FetchFrameAsync(frameId);
+        var jpegData = jpegOwner.Memory;
+        var handle = DecodedFrameHandle.Rent(GetDecodedHeader(jpegData, format));
+        var decoder = _codecPool.RentDecoder();
+        try
+        {
+            var header = format == PixelFormat.Gray8
+                ? _codecPool.DecodeGray(decoder, jpegData, handle.WritableData)
+                : _codecPool.DecodeI420(decoder, jpegData, handle.WritableData);
+            handle = handle.WithHeader(header);
+        }
+        catch
+        {
+            handle.Dispose();
+            throw;
+        }
+        finally
+        {
+            _codecPool.ReturnDecoder(decoder);
+        }
+
+        cache?.Add(frameId, format, handle);
+        return handle;
+    }
+
+    private async Task<FrameImage> BlendWindowAsync(StreamFrame[] window)
+    {
+        long started = Stopwatch.GetTimestamp();
+        try
+        {
+            var frames = new FrameImage[window.Length];
+            var headers = new FrameHeader[window.Length];
+            for (int i = 0; i < window.Length; i++)
+            {
+                var handle = await window[i].Decode;
+                frames[i] = handle.AsFrameImage();
+                headers[i] = handle.Header;
+            }
+            ValidateDimensions(headers);
+
+            using var blendedFrame = BlendFrames(frames);
+            var result = EncodeWithPooledEncoder(blendedFrame);
+            MjpegMetrics.RecordHdrFrame(HdrMode, Stopwatch.GetElapsedTime(started));
+            return result;
+        }
+        finally
+        {
+            foreach (var decoded in window)
+            {
+                decoded.Release();
+            }
+        }
+    }
+
+    /// <summary>
+    /// One decoded source frame of <see cref="StreamAsync"/>, shared by the windows it falls into.
+    /// The stream holds one reference while new windows may still pick it up, each window one more.
+    /// </summary>
+    private sealed class StreamFrame
+    {
+        private int _users = 1;
+
+        public StreamFrame(Task<DecodedFrameHandle> decode) => Decode = decode;
+
+        public Task<DecodedFrameHandle> Decode { get; }
+
+        public void AddUser() => Interlocked.Increment(ref _users);
+
+        public void Release()
+        {
+            if (Interlocked.Decrement(ref _users) != 0) return;
+
+            // Windows await the decode before releasing; unused or cancelled prefetches may still be running
+            _ = Decode.ContinueWith(static t => t.Result.Dispose(), CancellationToken.None,
+                TaskContinuationOptions.OnlyOnRanToCompletion | TaskContinuationOptions.ExecuteSynchronously,
+                TaskScheduler.Default);
+        }
+    }
+
     private void ValidateConfiguration()
     {
         if (HdrFrameWindowCount < 2 || HdrFrameWindowCount > 10)
@@ -190,97 +464,311 @@ public sealed class MjpegHdrEngine : IDisposable
             throw new InvalidOperationException("GrayToRgb mode requires exactly 3 frames.");
     }
 
-    private async Task<FrameImage[]> FetchAndDecodeFramesAsync(ulong frameId)
+    private static ulong WindowFrameId(ulong frameId, int index)
     {
-        var frameCount = HdrFrameWindowCount;
-        var decodeTasks = ArrayPool<Task<FrameImage>>.Shared.Rent(frameCount);
+        return frameId >= (ulong)index ? frameId - (ulong)index : 0;
+    }
+
+    private Task<IMemoryOwner<byte>[]> FetchFramesAsync(ulong frameId)
+    {
+        var frameIds = new ulong[HdrFrameWindowCount];
+        for (int i = 0; i < frameIds.Length; i++)
+        {
+            frameIds[i] = WindowFrameId(frameId, i);
+        }
+        return FetchFramesAsync(frameIds, frameIds.Length);
+    }
+
+    private async Task<IMemoryOwner<byte>[]> FetchFramesAsync(ulong[] frameIds, int frameCount)
+    {
+        var fetchTasks = ArrayPool<Task<IMemoryOwner<byte>>>.Shared.Rent(frameCount);
+        var jpegOwners = new IMemoryOwner<byte>[frameCount];
+        int fetched = 0;
 
         try
         {
-            // Start fetch + decode tasks in parallel
+            // Start fetch tasks in parallel
             for (int i = 0; i < frameCount; i++)
             {
-                ulong targetFrameId = frameId >= (ulong)i ? frameId - (ulong)i : 0;
-                decodeTasks[i] = FetchAndDecodeOneFrameAsync(targetFrameId);
+                fetchTasks[i] = FetchFrameAsync(frameIds[i]);
             }
 
-            // Await all and collect results
-            var frames = new FrameImage[frameCount];
+            // Await all fetches
+            for (; fetched < frameCount; fetched++)
+            {
+                jpegOwners[fetched] = await fetchTasks[fetched];
+            }
+
+            return jpegOwners;
+        }
+        catch
+        {
             for (int i = 0; i < frameCount; i++)
             {
-                frames[i] = await decodeTasks[i];
+                if (i < fetched)
+                    jpegOwners[i].Dispose();
+                else if (fetchTasks[i] is { IsCompletedSuccessfully: true } completed)
+                    completed.Result.Dispose();
             }
+            throw;
+        }
+        finally
+        {
+            ArrayPool<Task<IMemoryOwner<byte>>>.Shared.Return(fetchTasks, clearArray: true);
+        }
+    }
 
-            // Validate all frames have same dimensions
-            var firstHeader = frames[0].Header;
-            for (int i = 1; i < frameCount; i++)
+    private async Task<FrameImage[]> FetchAndDecodeFramesAsync(ulong frameId)
+    {
+        var jpegOwners = await FetchFramesAsync(frameId);
+        try
+        {
+            // Decode the whole window in one batch call
+            return DecodeFrames(jpegOwners);
+        }
+        finally
+        {
+            foreach (var owner in jpegOwners)
             {
-                if (frames[i].Header.Width != firstHeader.Width ||
-                    frames[i].Header.Height != firstHeader.Height)
+                owner.Dispose();
+            }
+        }
+    }
+
+    private async Task<FrameImage> FetchAndDecodeBlendAsync(ulong frameId)
+    {
+        var jpegOwners = await FetchFramesAsync(frameId);
+        try
+        {
+            return DecodeBlendFrames(jpegOwners);
+        }
+        finally
+        {
+            foreach (var owner in jpegOwners)
+            {
+                owner.Dispose();
+            }
+        }
+    }
+
+    private async Task<DecodedFrameHandle[]> FetchAndDecodeCachedAsync(ulong frameId, DecodedFrameCache cache)
+    {
+        int frameCount = HdrFrameWindowCount;
+        var format = PixelFormat == PixelFormat.Gray8 ? PixelFormat.Gray8 : PixelFormat.I420;
+        var handles = new DecodedFrameHandle[frameCount];
+        var missingIndices = new int[frameCount];
+        var missingIds = new ulong[frameCount];
+        int missing = 0;
+
+        try
+        {
+            for (int i = 0; i < frameCount; i++)
+            {
+                ulong targetFrameId = WindowFrameId(frameId, i);
+                if (!cache.TryGet(targetFrameId, format, out handles[i]))
                 {
-                    // Dispose already decoded frames on error
-                    foreach (var frame in frames)
+                    missingIndices[missing] = i;
+                    missingIds[missing] = targetFrameId;
+                    missing++;
+                }
+            }
+
+            _logger.LogDebug("Frame cache: {Hits} hit(s), {Misses} miss(es)", frameCount - missing, missing);
+
+            if (missing > 0)
+            {
+                var jpegOwners = await FetchFramesAsync(missingIds, missing);
+                try
+                {
+                    DecodeIntoCache(jpegOwners, missingIndices, missingIds, handles, format, cache);
+                }
+                finally
+                {
+                    foreach (var owner in jpegOwners)
                     {
-                        frame.Dispose();
+                        owner.Dispose();
                     }
-                    throw new InvalidOperationException(
-                        $"Frame {i} dimensions ({frames[i].Header.Width}x{frames[i].Header.Height}) " +
-                        $"don't match frame 0 ({firstHeader.Width}x{firstHeader.Height}).");
                 }
             }
 
-            return frames;
+            var headers = new FrameHeader[frameCount];
+            for (int i = 0; i < frameCount; i++)
+            {
+                headers[i] = handles[i].Header;
+            }
+            ValidateDimensions(headers);
+            return handles;
         }
-        finally
+        catch
         {
-            ArrayPool<Task<FrameImage>>.Shared.Return(decodeTasks, clearArray: true);
+            foreach (var handle in handles)
+            {
+                handle.Dispose();
+            }
+            throw;
         }
     }
 
-    private async Task<FrameImage> FetchAndDecodeOneFrameAsync(ulong frameId)
+    private void DecodeIntoCache(IMemoryOwner<byte>[] jpegOwners, int[] windowIndices, ulong[] frameIds,
+        DecodedFrameHandle[] handles, PixelFormat format, DecodedFrameCache cache)
+    {
+        int count = jpegOwners.Length;
+        var jpegData = new ReadOnlyMemory<byte>[count];
+        var outputs = new Memory<byte>[count];
+        var rented = new DecodedFrameHandle[count];
+        var headers = new FrameHeader[count];
+
+        try
+        {
+            for (int i = 0; i < count; i++)
+            {
+                jpegData[i] = jpegOwners[i].Memory;
+                rented[i] = DecodedFrameHandle.Rent(GetDecodedHeader(jpegData[i], format));
+                outputs[i] = rented[i].WritableData;
+            }
+
+            _codecPool.DecodeBatch(format, jpegData, outputs, headers);
+        }
+        catch
+        {
+            foreach (var handle in rented)
+            {
+                handle.Dispose();
+            }
+            throw;
+        }
+
+        // Ownership of each rented reference moves to the window; the cache takes its own
+        for (int i = 0; i < count; i++)
+        {
+            var handle = rented[i].WithHeader(headers[i]);
+            handles[windowIndices[i]] = handle;
+            cache.Add(frameIds[i], format, handle);
+        }
+
+        _logger.LogDebug("Decoded {Count} uncached frames: {Width}x{Height} {Format}", count, headers[0].Width, headers[0].Height, format);
+    }
+
+    private FrameHeader GetDecodedHeader(ReadOnlyMemory<byte> jpegData, PixelFormat format)
+    {
+        var info = _codecPool.GetImageInfo(jpegData);
+        return FrameHeader.Create(info.Width, info.Height, format);
+    }
+
+    private static void ValidateDimensions(FrameHeader[] headers)
+    {
+        var firstHeader = headers[0];
+        for (int i = 1; i < headers.Length; i++)
+        {
+            if (headers[i].Width != firstHeader.Width ||
+                headers[i].Height != firstHeader.Height)
+            {
+                throw new InvalidOperationException(
+                    $"Frame {i} dimensions ({headers[i].Width}x{headers[i].Height}) " +
+                    $"don't match frame 0 ({firstHeader.Width}x{firstHeader.Height}).");
+            }
+        }
+    }
+
+    private async Task<IMemoryOwner<byte>> FetchFrameAsync(ulong frameId)
     {
         _logger.LogDebug("Fetching frame {FrameId}", frameId);
 
         // Fetch JPEG data (pooled)
-        using var jpegOwner = await _getImageByFrameId(frameId);
+        var jpegOwner = await _getImageByFrameId(frameId);
 
         _logger.LogDebug("Fetched frame {FrameId}: {JpegSize} bytes", frameId, jpegOwner.Memory.Length);
+        return jpegOwner;
+    }
+
+    private FrameImage DecodeBlendFrames(IMemoryOwner<byte>[] jpegOwners)
+    {
+        var jpegData = new ReadOnlyMemory<byte>[jpegOwners.Length];
+        for (int i = 0; i < jpegOwners.Length; i++)
+        {
+            jpegData[i] = jpegOwners[i].Memory;
+        }
 
-        // Get dimensions to know how much to rent
-        var info = _codecPool.GetImageInfo(jpegOwner.Memory);
+        var format = PixelFormat == PixelFormat.Gray8 ? PixelFormat.Gray8 : PixelFormat.I420;
+        var info = _codecPool.GetImageInfo(jpegData[0]);
+        int bufferSize = FrameHeader.Create(info.Width, info.Height, format).Length;
 
-        // Calculate buffer size based on pixel format
-        int bufferSize = PixelFormat == PixelFormat.Gray8
-            ? info.Width * info.Height           // Gray8: 1 byte per pixel
-            : info.Width * info.Height * 3 / 2;  // I420: 1.5 bytes per pixel
+        // Only the blended frame is allocated; no per-frame decode buffers
+        var outputOwner = _pool.Rent(bufferSize);
+        try
+        {
+            var header = _codecPool.DecodeBlend(format, HdrMode, jpegData, Weights, outputOwner.Memory);
+            return new FrameImage(header, outputOwner);
+        }
+        catch
+        {
+            outputOwner.Dispose();
+            throw;
+        }
+    }
 
-        // Rent decode buffer from pool
-        var decodeOwner = _pool.Rent(bufferSize);
+    private FrameImage[] DecodeFrames(IMemoryOwner<byte>[] jpegOwners)
+    {
+        int frameCount = jpegOwners.Length;
+        var jpegData = new ReadOnlyMemory<byte>[frameCount];
+        var outputs = new Memory<byte>[frameCount];
+        var decodeOwners = new IMemoryOwner<byte>?[frameCount];
+        var headers = new FrameHeader[frameCount];
+        var format = PixelFormat == PixelFormat.Gray8 ? PixelFormat.Gray8 : PixelFormat.I420;
 
-        // Rent decoder from pool
-        var decoder = _codecPool.RentDecoder();
         try
         {
-            // Decode based on configured pixel format
-            var header = PixelFormat == PixelFormat.Gray8
-                ? _codecPool.DecodeGray(decoder, jpegOwner.Memory, decodeOwner.Memory)
-                : _codecPool.DecodeI420(decoder, jpegOwner.Memory, decodeOwner.Memory);
+            for (int i = 0; i < frameCount; i++)
+            {
+                jpegData[i] = jpegOwners[i].Memory;
+
+                // Get dimensions to know how much to rent
+                var info = _codecPool.GetImageInfo(jpegData[i]);
 
-            _logger.LogDebug("Decoded frame {FrameId}: {Width}x{Height} {Format}", frameId, header.Width, header.Height, PixelFormat);
+                // Calculate buffer size based on pixel format
+                int bufferSize = FrameHeader.Create(info.Width, info.Height, format).Length;
 
-            // Return FrameImage that owns the pooled memory
-            // Will be disposed in GetAsync finally block, returning buffer to pool
-            return new FrameImage(header, decodeOwner);
+                // Rent decode buffer from pool
+                decodeOwners[i] = _pool.Rent(bufferSize);
+                outputs[i] = decodeOwners[i]!.Memory;
+            }
+
+            _codecPool.DecodeBatch(format, jpegData, outputs, headers);
         }
         catch
         {
-            decodeOwner.Dispose();
+            foreach (var owner in decodeOwners)
+            {
+                owner?.Dispose();
+            }
             throw;
         }
-        finally
+
+        _logger.LogDebug("Decoded {Count} frames: {Width}x{Height} {Format}", frameCount, headers[0].Width, headers[0].Height, format);
+
+        // FrameImages own the pooled memory; disposed in GetAsync finally block
+        var frames = new FrameImage[frameCount];
+        for (int i = 0; i < frameCount; i++)
         {
-            _codecPool.ReturnDecoder(decoder);
+            frames[i] = new FrameImage(headers[i], decodeOwners[i]!);
+        }
+
+        // Validate all frames have same dimensions
+        try
+        {
+            ValidateDimensions(headers);
         }
+        catch
+        {
+            // Dispose already decoded frames on error
+            foreach (var frame in frames)
+            {
+                frame.Dispose();
+            }
+            throw;
+        }
+
+        return frames;
     }
 
     private FrameImage BlendFrames(FrameImage[] frames)
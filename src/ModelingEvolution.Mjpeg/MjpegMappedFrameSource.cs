@@ -0,0 +1,209 @@
+using System.Buffers;
+using System.IO.MemoryMappedFiles;
+
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Zero-copy frame source over a memory-mapped MJPEG recording.
+/// Frames are served straight from the mapping, so decoders pin pointers into the page cache
+/// instead of copying each JPEG into a rented buffer. Random access by index makes reverse
+/// playback as cheap as forward. Thread-safe.
+/// </summary>
+/// <remarks>
+/// Frame memory stays valid until the returned owner is disposed, even if the source is disposed first:
+/// the mapping is released when the source and all outstanding frames are gone.
+/// Frames are read-only recording data. <see cref="IMemoryOwner{T}"/> can only hand out writable memory, so
+/// the recording is mapped copy-on-write: a stray write lands in a private page instead of faulting on a
+/// read-only one, and never reaches the file.
+/// Plugs into <see cref="MjpegHdrEngine"/> via <see cref="GetFrameAsync"/>.
+/// </remarks>
+public sealed class MjpegMappedFrameSource : IDisposable
+{
+    private readonly MjpegFrameIndex _index;
+    private readonly bool _ownsIndex;
+    private readonly MemoryMappedFile _file;
+    private readonly MemoryMappedViewAccessor _view;
+    private readonly unsafe byte* _data;
+    private readonly long _length;
+    private int _refCount = 1;
+    private int _disposed;
+
+    /// <summary>
+    /// Number of frames in the recording.
+    /// </summary>
+    public int Count => _index.Count;
+
+    /// <summary>
+    /// Frame index of the recording.
+    /// </summary>
+    public MjpegFrameIndex Index => _index;
+
+    /// <summary>
+    /// Maps a recording using an existing frame index.
+    /// </summary>
+    /// <param name="recordingPath">Path of the MJPEG recording.</param>
+    /// <param name="index">Frame index of the recording.</param>
+    /// <param name="ownsIndex">Dispose the index together with the source.</param>
+    public unsafe MjpegMappedFrameSource(string recordingPath, MjpegFrameIndex index, bool ownsIndex = false)
+    {
+        _index = index ?? throw new ArgumentNullException(nameof(index));
+
+        // ReadWrite sharing so a recording that is still being written can be played back
+        var stream = new FileStream(recordingPath, FileMode.Open, FileAccess.Read, FileShare.ReadWrite);
+        try
+        {
+            _length = stream.Length;
+            if (_length == 0)
+                throw new InvalidDataException($"Recording is empty: {recordingPath}");
+
+            _file = MemoryMappedFile.CreateFromFile(stream, null, 0, MemoryMappedFileAccess.CopyOnWrite,
+                HandleInheritability.None, leaveOpen: false);
+        }
+        catch
+        {
+            stream.Dispose();
+            throw;
+        }
+
+        try
+        {
+            _view = _file.CreateViewAccessor(0, _length, MemoryMappedFileAccess.CopyOnWrite);
+        }
+        catch
+        {
+            _file.Dispose();
+            throw;
+        }
+
+        byte* ptr = null;
+        _view.SafeMemoryMappedViewHandle.AcquirePointer(ref ptr);
+        _data = ptr + _view.PointerOffset;
+        _ownsIndex = ownsIndex;
+    }
+
+    /// <summary>
+    /// Opens a recording, bringing its <see cref="MjpegFrameIndex"/> sidecar up to date first.
+    /// </summary>
+    public static async Task<MjpegMappedFrameSource> OpenAsync(string recordingPath, CancellationToken cancellationToken = default)
+    {
+        var index = await MjpegFrameIndex.BuildAsync(recordingPath, cancellationToken: cancellationToken);
+        try
+        {
+            return new MjpegMappedFrameSource(recordingPath, index, ownsIndex: true);
+        }
+        catch
+        {
+            index.Dispose();
+            throw;
+        }
+    }
+
+    /// <summary>
+    /// Returns the JPEG bytes of a frame as a span into the mapping. Valid while the source is not disposed.
+    /// </summary>
+    public unsafe ReadOnlySpan<byte> GetFrameSpan(int index)
+    {
+        ObjectDisposedException.ThrowIf(Volatile.Read(ref _disposed) != 0, this);
+        var frame = GetFrameInfo(index);
+        return new ReadOnlySpan<byte>(_data + frame.StartOffset, (int)frame.Size);
+    }
+
+    /// <summary>
+    /// Returns an owner whose memory points into the mapping. Caller takes ownership and must dispose;
+    /// disposing it again does nothing. The memory is for reading only, see the remarks.
+    /// </summary>
+    public unsafe IMemoryOwner<byte> GetFrame(ulong frameId)
+    {
+        if (frameId > int.MaxValue)
+            throw new ArgumentOutOfRangeException(nameof(frameId));
+        var frame = GetFrameInfo((int)frameId);
+
+        if (!TryAddRef())
+            throw new ObjectDisposedException(GetType().FullName);
+
+        // One owner per call: a recycled one could be disposed twice and release another caller's frame
+        return new MappedFrame(this, _data + frame.StartOffset, (int)frame.Size);
+    }
+
+    /// <summary>
+    /// <see cref="GetFrame"/> shaped for the <see cref="MjpegHdrEngine"/> frame callback.
+    /// </summary>
+    public Task<IMemoryOwner<byte>> GetFrameAsync(ulong frameId) => Task.FromResult(GetFrame(frameId));
+
+    private FrameInfo GetFrameInfo(int index)
+    {
+        var frame = _index[index];
+        if (frame.Size > int.MaxValue || frame.StartOffset + frame.Size > _length)
+            throw new InvalidDataException($"Frame {index} lies outside the mapped recording.");
+        return frame;
+    }
+
+    private bool TryAddRef()
+    {
+        while (true)
+        {
+            int current = Volatile.Read(ref _refCount);
+            if (current == 0) return false;
+            if (Interlocked.CompareExchange(ref _refCount, current + 1, current) == current) return true;
+        }
+    }
+
+    private void Release()
+    {
+        if (Interlocked.Decrement(ref _refCount) != 0) return;
+
+        _view.SafeMemoryMappedViewHandle.ReleasePointer();
+        _view.Dispose();
+        _file.Dispose();
+        if (_ownsIndex)
+            _index.Dispose();
+    }
+
+    /// <summary>
+    /// Releases the source. The mapping is unmapped once every outstanding frame is disposed too.
+    /// </summary>
+    public void Dispose()
+    {
+        if (Interlocked.Exchange(ref _disposed, 1) != 0) return;
+        Release();
+    }
+
+    private sealed unsafe class MappedFrame : MemoryManager<byte>
+    {
+        private readonly MjpegMappedFrameSource _source;
+        private byte* _pointer;
+        private int _length;
+        private int _released;
+
+        public MappedFrame(MjpegMappedFrameSource source, byte* pointer, int length)
+        {
+            _source = source;
+            _pointer = pointer;
+            _length = length;
+        }
+
+        public override Span<byte> GetSpan()
+        {
+            ObjectDisposedException.ThrowIf(Volatile.Read(ref _released) != 0, this);
+            return new(_pointer, _length);
+        }
+
+        // Mapped memory never moves; pinning is just handing out the pointer
+        public override MemoryHandle Pin(int elementIndex = 0)
+        {
+            ObjectDisposedException.ThrowIf(Volatile.Read(ref _released) != 0, this);
+            return new(_pointer + elementIndex);
+        }
+
+        public override void Unpin() { }
+
+        protected override void Dispose(bool disposing)
+        {
+            if (Interlocked.Exchange(ref _released, 1) != 0) return;
+
+            _pointer = null;
+            _length = 0;
+            _source.Release();
+        }
+    }
+}
@@ -0,0 +1,120 @@
+using System.Diagnostics.Metrics;
+
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// System.Diagnostics.Metrics instruments of the library, published on the "ModelingEvolution.Mjpeg" meter.
+/// </summary>
+/// <remarks>
+/// Codec instruments are observable: each collection sums the native counters of every live
+/// <see cref="JpegCodecPool"/> plus the totals left by disposed ones, tagged <c>mjpeg.codec.kind</c>
+/// (decoder or encoder). Nothing is read unless a listener is attached.
+/// </remarks>
+internal static class MjpegMetrics
+{
+    public const string MeterName = "ModelingEvolution.Mjpeg";
+
+    private static readonly Meter Meter = new(MeterName);
+    private static readonly object Sync = new();
+    private static readonly List<WeakReference<JpegCodecPool>> Pools = new();
+    private static CodecStats _retiredDecoders;
+    private static CodecStats _retiredEncoders;
+
+    private static readonly Counter<long> HdrFrames = Meter.CreateCounter<long>(
+        "mjpeg.hdr.frames", "{frame}", "HDR frames produced by MjpegHdrEngine.");
+
+    private static readonly Histogram<double> HdrDuration = Meter.CreateHistogram<double>(
+        "mjpeg.hdr.duration", "s", "Time to fetch, decode, blend and encode one HDR frame.");
+
+    static MjpegMetrics()
+    {
+        Meter.CreateObservableCounter("mjpeg.codec.operations", () => Observe(s => s.Calls),
+            "{call}", "Native encode and decode calls.");
+        Meter.CreateObservableCounter("mjpeg.codec.errors", () => Observe(s => s.Errors),
+            "{call}", "Native encode and decode calls that failed.");
+        Meter.CreateObservableCounter("mjpeg.codec.bytes_in", () => Observe(s => s.BytesIn),
+            "By", "Bytes consumed by native codecs.");
+        Meter.CreateObservableCounter("mjpeg.codec.bytes_out", () => Observe(s => s.BytesOut),
+            "By", "Bytes produced by native codecs.");
+        Meter.CreateObservableCounter("mjpeg.codec.time", ObserveTime,
+            "s", "Time spent in native codecs, by phase (header or coding).");
+        Meter.CreateObservableGauge("mjpeg.codec.memory.peak", () => Observe(s => s.PeakPoolBytes),
+            "By", "Largest libjpeg memory pool footprint of a single native handle.");
+    }
+
+    /// <summary>
+    /// Includes the pool in the codec instruments until it is disposed.
+    /// </summary>
+    public static void Register(JpegCodecPool pool)
+    {
+        lock (Sync)
+        {
+            // Drop pools collected without being disposed
+            Pools.RemoveAll(r => !r.TryGetTarget(out _));
+            Pools.Add(new WeakReference<JpegCodecPool>(pool));
+        }
+    }
+
+    /// <summary>
+    /// Removes a disposed pool, keeping its final counters so the cumulative totals never go back.
+    /// </summary>
+    public static void Unregister(JpegCodecPool pool)
+    {
+        lock (Sync)
+        {
+            Pools.RemoveAll(r => !r.TryGetTarget(out var p) || p == pool);
+            _retiredDecoders += pool.DecoderStats;
+            _retiredEncoders += pool.EncoderStats;
+        }
+    }
+
+    public static void RecordHdrFrame(HdrBlendMode mode, TimeSpan elapsed)
+    {
+        var tag = new KeyValuePair<string, object?>("mjpeg.hdr.mode", mode.ToString());
+        HdrFrames.Add(1, tag);
+        HdrDuration.Record(elapsed.TotalSeconds, tag);
+    }
+
+    private static (CodecStats Decoders, CodecStats Encoders) Totals()
+    {
+        lock (Sync)
+        {
+            var decoders = _retiredDecoders;
+            var encoders = _retiredEncoders;
+            foreach (var reference in Pools)
+            {
+                if (!reference.TryGetTarget(out var pool)) continue;
+                decoders += pool.DecoderStats;
+                encoders += pool.EncoderStats;
+            }
+            return (decoders, encoders);
+        }
+    }
+
+    private static Measurement<long>[] Observe(Func<CodecStats, long> value)
+    {
+        var (decoders, encoders) = Totals();
+        return
+        [
+            new(value(decoders), new KeyValuePair<string, object?>("mjpeg.codec.kind", "decoder")),
+            new(value(encoders), new KeyValuePair<string, object?>("mjpeg.codec.kind", "encoder"))
+        ];
+    }
+
+    private static Measurement<double>[] ObserveTime()
+    {
+        var (decoders, encoders) = Totals();
+        return
+        [
+            Time(decoders.HeaderTime, "decoder", "header"),
+            Time(decoders.CodingTime, "decoder", "coding"),
+            Time(encoders.HeaderTime, "encoder", "header"),
+            Time(encoders.CodingTime, "encoder", "coding")
+        ];
+    }
+
+    private static Measurement<double> Time(TimeSpan value, string kind, string phase) =>
+        new(value.TotalSeconds,
+            new KeyValuePair<string, object?>("mjpeg.codec.kind", kind),
+            new KeyValuePair<string, object?>("mjpeg.codec.phase", phase));
+}
@@ -0,0 +1,209 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Writes a low-resolution proxy of an MJPEG recording alongside it: every frame is decoded at 1/8 (or another
+/// <see cref="DecodeScale"/>) in the DCT domain, re-encoded and appended to a proxy recording with its own
+/// <see cref="MjpegFrameIndex"/> sidecar. Proxy frame n is recording frame n, so a player scrubs and draws
+/// timeline thumbnails from the proxy and jumps into the full recording by the same frame number.
+/// Not thread-safe.
+/// </summary>
+/// <remarks>
+/// A 1/8 proxy frame of a 1080p recording is 240x135, roughly 1/60 of the pixels, and the scaled decode runs
+/// only the DC term of each block, so producing it costs a fraction of a full decode. Gray8 recordings get
+/// grayscale proxies; all others I420. All frames must have the size of the first one.
+/// </remarks>
+public sealed class MjpegProxyWriter : IDisposable
+{
+    /// <summary>
+    /// Suffix that replaces the recording's extension in <see cref="GetDefaultPath"/>.
+    /// </summary>
+    public const string FileSuffix = ".proxy.mjpeg";
+
+    private readonly FileStream _stream;
+    private readonly MjpegFrameIndexWriter _index;
+    private readonly DecodeScale _scale;
+    private readonly int _quality;
+    private JpegCodecPool? _pool;
+    private PixelFormat _format;
+    private byte[] _frame = [];
+    private byte[] _jpeg = [];
+    private bool _disposed;
+
+    /// <summary>
+    /// Creates a proxy recording, or continues an existing one when <paramref name="append"/> is true.
+    /// </summary>
+    /// <param name="proxyPath">Path of the proxy recording; its index goes to <see cref="MjpegFrameIndex.GetDefaultPath"/>.</param>
+    /// <param name="scale">Proxy size relative to the recording.</param>
+    /// <param name="quality">JPEG quality of proxy frames (1-100).</param>
+    /// <param name="append">Keep the indexed frames of an existing proxy and append after them.</param>
+    public MjpegProxyWriter(string proxyPath, DecodeScale scale = DecodeScale.Eighth, int quality = 60, bool append = false)
+    {
+        if (!Enum.IsDefined(scale))
+            throw new ArgumentOutOfRangeException(nameof(scale), scale, "Scale must be Full, Half, Quarter or Eighth.");
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(quality);
+        ArgumentOutOfRangeException.ThrowIfGreaterThan(quality, 100);
+
+        _scale = scale;
+        _quality = quality;
+        _index = new MjpegFrameIndexWriter(MjpegFrameIndex.GetDefaultPath(proxyPath), append);
+        try
+        {
+            _stream = new FileStream(proxyPath, FileMode.OpenOrCreate, FileAccess.Write, FileShare.Read);
+
+            // Bytes past the last indexed frame are a frame torn by a crash; the index decides what is kept
+            _stream.SetLength(_index.EndOffset);
+            _stream.Position = _index.EndOffset;
+        }
+        catch
+        {
+            _index.Dispose();
+            throw;
+        }
+    }
+
+    /// <summary>
+    /// Returns the default proxy path for a recording: <c>stream.mjpeg</c> becomes <c>stream.proxy.mjpeg</c>.
+    /// </summary>
+    public static string GetDefaultPath(string recordingPath) => Path.ChangeExtension(recordingPath, null) + FileSuffix;
+
+    /// <summary>
+    /// Number of frames in the proxy, which is the recording frame the next <see cref="Append"/> stands for.
+    /// </summary>
+    public int Count => _index.Count;
+
+    /// <summary>
+    /// Decodes a recording frame at the proxy scale, encodes it and appends it to the proxy.
+    /// </summary>
+    /// <returns>Size of the proxy frame in bytes.</returns>
+    /// <exception cref="InvalidDataException">The frame is not a JPEG, or its size differs from the first frame.</exception>
+    public int Append(ReadOnlyMemory<byte> jpeg)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        var pool = _pool ?? Initialize(jpeg.Span);
+        var decoder = pool.RentDecoder();
+        FrameHeader header;
+        try
+        {
+            header = _format == PixelFormat.Gray8
+                ? pool.DecodeGray(decoder, jpeg, _frame, _scale)
+                : pool.DecodeI420(decoder, jpeg, _frame, _scale);
+        }
+        finally
+        {
+            pool.ReturnDecoder(decoder);
+        }
+
+        if (header.Width != pool.MaxWidth || header.Height != pool.MaxHeight)
+            throw new InvalidDataException(
+                $"Frame decodes to {header.Width}x{header.Height} at {_scale}, but the proxy is {pool.MaxWidth}x{pool.MaxHeight}.");
+
+        int length;
+        if (_format == PixelFormat.Gray8)
+        {
+            length = pool.EncodeGray8(header.Width, header.Height, _frame, _jpeg);
+        }
+        else
+        {
+            var encoder = pool.RentEncoder();
+            try
+            {
+                length = pool.EncodeI420(encoder, _frame, _jpeg);
+            }
+            finally
+            {
+                pool.ReturnEncoder(encoder);
+            }
+        }
+
+        long start = _stream.Position;
+        _stream.Write(_jpeg, 0, length);
+        _index.Append(start, _jpeg.AsSpan(0, length));
+        return length;
+    }
+
+    /// <summary>
+    /// Writes buffered proxy frames and index entries to disk.
+    /// </summary>
+    public void Flush()
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        // Frames before their index entries: a reader never sees an entry whose bytes are missing
+        _stream.Flush();
+        _index.Flush();
+    }
+
+    /// <summary>
+    /// Brings the proxy of an existing recording up to date and opens its index. Only recording frames
+    /// past the last proxy frame are converted; a proxy longer than the recording is rebuilt.
+    /// </summary>
+    /// <param name="recordingPath">Path of the MJPEG recording.</param>
+    /// <param name="proxyPath">Path of the proxy; defaults to <see cref="GetDefaultPath"/>.</param>
+    /// <param name="scale">Proxy size relative to the recording.</param>
+    /// <param name="quality">JPEG quality of proxy frames (1-100).</param>
+    /// <param name="cancellationToken">Cancellation token, checked between frames.</param>
+    public static async Task<MjpegFrameIndex> BuildAsync(
+        string recordingPath,
+        string? proxyPath = null,
+        DecodeScale scale = DecodeScale.Eighth,
+        int quality = 60,
+        CancellationToken cancellationToken = default)
+    {
+        proxyPath ??= GetDefaultPath(recordingPath);
+
+        using (var source = await MjpegMappedFrameSource.OpenAsync(recordingPath, cancellationToken))
+        {
+            var writer = new MjpegProxyWriter(proxyPath, scale, quality, append: true);
+            try
+            {
+                if (writer.Count > source.Count)
+                {
+                    writer.Dispose();
+                    writer = new MjpegProxyWriter(proxyPath, scale, quality);
+                }
+
+                for (int i = writer.Count; i < source.Count; i++)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    using var frame = source.GetFrame((ulong)i);
+                    writer.Append(frame.Memory);
+                }
+            }
+            finally
+            {
+                writer.Dispose();
+            }
+        }
+
+        return MjpegFrameIndex.Open(MjpegFrameIndex.GetDefaultPath(proxyPath));
+    }
+
+    private JpegCodecPool Initialize(ReadOnlySpan<byte> jpeg)
+    {
+        if (!JpegDimensionExtractor.TryExtractInfo(jpeg, out var info))
+            throw new InvalidDataException("Recording frame is not a JPEG image.");
+
+        _format = info.Components == 1 ? PixelFormat.Gray8 : PixelFormat.I420;
+        int width = _scale.Apply(info.Width), height = _scale.Apply(info.Height);
+
+        // Raw frames and libjpeg output of noise-free video stay well below twice the raw size
+        _frame = new byte[FrameHeader.Create(width, height, _format).Length];
+        _jpeg = new byte[_frame.Length * 2 + 1024];
+        _pool = new JpegCodecPool(width, height, _quality);
+        return _pool;
+    }
+
+    /// <summary>
+    /// Flushes and closes the proxy recording and its index.
+    /// </summary>
+    public void Dispose()
+    {
+        if (_disposed) return;
+        _disposed = true;
+
+        _stream.Dispose();
+        _index.Dispose();
+        _pool?.Dispose();
+    }
+}
@@ -0,0 +1,370 @@
+using System.Collections.Concurrent;
+
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Pool of native codec handles with an optional cap on live handles, a per-core fast path and idle trimming.
+/// </summary>
+/// <remarks>
+/// Each processor has one cache slot taken and refilled with a single interlocked exchange, so a thread
+/// that rents and returns on the same core never touches shared state. Overflow goes to a LIFO stack:
+/// recently used handles (warm libjpeg state) are reused first and cold ones sink to the bottom, where
+/// <see cref="Trim"/> closes them without taking the warm ones off the top. When <c>capacity</c> handles
+/// are live, renters wait for a return.
+/// With a stats reader the pool also tracks its live handles, so <see cref="Stats"/> can read them and fold
+/// the counters of closed ones into a running total.
+/// </remarks>
+internal sealed class NativeHandlePool : IDisposable
+{
+    private readonly record struct Idle(nint Handle, long ReturnedAt);
+
+    private readonly Func<nint> _create;
+    private readonly Action<nint> _close;
+    private readonly JpegTurboNative.StatsReader? _stats;
+    private readonly ConcurrentDictionary<nint, byte>? _tracked;  // Live handles when stats are read
+    private readonly object _statsSync = new();
+    private CodecStats _retired;                                   // Counters of closed handles
+    private readonly nint[] _slots;
+    private readonly long[] _slotReturnedAt;
+    private readonly List<Idle> _idle = new();  // Overflow stack, top at the end; guarded by _idleSync
+    private readonly object _idleSync = new();
+    private readonly SemaphoreSlim? _returned;  // Wakes waiters; only used when bounded
+    private readonly int _capacity;
+    private int _available;                     // Permits left when bounded
+    private int _waiters;
+    private int _live;
+    private volatile bool _disposed;
+
+    /// <param name="create">Creates a configured handle; throws on failure.</param>
+    /// <param name="close">Destroys a handle.</param>
+    /// <param name="capacity">Maximum live handles (0 = unbounded).</param>
+    /// <param name="stats">Reads a handle's native counters; null disables <see cref="Stats"/>.</param>
+    public NativeHandlePool(Func<nint> create, Action<nint> close, int capacity, JpegTurboNative.StatsReader? stats = null)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegative(capacity);
+
+        _create = create;
+        _close = close;
+        _stats = stats;
+        if (stats != null)
+            _tracked = new ConcurrentDictionary<nint, byte>();
+        _capacity = capacity;
+        _available = capacity;
+        _slots = new nint[Environment.ProcessorCount];
+        _slotReturnedAt = new long[_slots.Length];
+        if (capacity > 0)
+            _returned = new SemaphoreSlim(0);
+    }
+
+    /// <summary>Maximum live handles (0 = unbounded).</summary>
+    public int Capacity => _capacity;
+
+    /// <summary>Handles currently alive, rented or idle.</summary>
+    public int LiveCount => Volatile.Read(ref _live);
+
+    /// <summary>
+    /// Counters summed over every handle this pool has created, closed ones included.
+    /// </summary>
+    public CodecStats Stats
+    {
+        get
+        {
+            if (_tracked == null) return default;
+
+            // Close takes the same lock before destroying a handle, so none is read after it is freed
+            lock (_statsSync)
+            {
+                var total = _retired;
+                foreach (var handle in _tracked.Keys)
+                    total += JpegTurboNative.ReadStats(handle, _stats!);
+                return total;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Rents a handle, blocking while <see cref="Capacity"/> handles are rented.
+    /// </summary>
+    public nint Rent()
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        if (_capacity > 0 && !TryAcquire())
+        {
+            Interlocked.Increment(ref _waiters);
+            try
+            {
+                // Re-check after registering, a return may have raced the first attempt
+                while (!TryAcquire())
+                {
+                    _returned!.Wait();
+                    ObjectDisposedException.ThrowIf(_disposed, this);
+                }
+            }
+            finally
+            {
+                Interlocked.Decrement(ref _waiters);
+            }
+        }
+
+        return TakeOrCreate();
+    }
+
+    /// <summary>
+    /// Rents a handle without waiting. Returns false while <see cref="Capacity"/> handles are rented.
+    /// </summary>
+    public bool TryRent(out nint handle)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        handle = 0;
+        if (_capacity > 0 && !TryAcquire())
+            return false;
+
+        handle = TakeOrCreate();
+        return true;
+    }
+
+    /// <summary>
+    /// Rents a handle, waiting asynchronously while <see cref="Capacity"/> handles are rented.
+    /// </summary>
+    public ValueTask<nint> RentAsync(CancellationToken cancellationToken = default)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        if (_capacity == 0 || TryAcquire())
+            return new ValueTask<nint>(TakeOrCreate());
+
+        return WaitAndRentAsync(cancellationToken);
+    }
+
+    private async ValueTask<nint> WaitAndRentAsync(CancellationToken cancellationToken)
+    {
+        Interlocked.Increment(ref _waiters);
+        try
+        {
+            while (!TryAcquire())
+            {
+                await _returned!.WaitAsync(cancellationToken).ConfigureAwait(false);
+                ObjectDisposedException.ThrowIf(_disposed, this);
+            }
+        }
+        finally
+        {
+            Interlocked.Decrement(ref _waiters);
+        }
+
+        return TakeOrCreate();
+    }
+
+    /// <summary>
+    /// Returns a rented handle. Closes it if the pool has been disposed.
+    /// </summary>
+    public void Return(nint handle)
+    {
+        if (_disposed)
+        {
+            Close(handle);
+            Release();
+            return;
+        }
+
+        long now = Environment.TickCount64;
+        int core = CurrentSlot();
+        if (Interlocked.CompareExchange(ref _slots[core], handle, 0) == 0)
+            Volatile.Write(ref _slotReturnedAt[core], now);
+        else
+            lock (_idleSync) _idle.Add(new Idle(handle, now));
+
+        // Dispose may have drained the slots between the check above and the store
+        if (_disposed)
+            Drain();
+
+        Release();
+    }
+
+    /// <summary>
+    /// Closes handles that have been idle for at least <paramref name="idleFor"/>. Returns how many were closed.
+    /// </summary>
+    public int Trim(TimeSpan idleFor)
+    {
+        long cutoff = Environment.TickCount64 - (long)idleFor.TotalMilliseconds;
+        int closed = 0;
+
+        for (int i = 0; i < _slots.Length; i++)
+        {
+            // A handle swapped in after the timestamp read may go too; it is simply re-created
+            if (Volatile.Read(ref _slotReturnedAt[i]) > cutoff) continue;
+            var handle = Interlocked.Exchange(ref _slots[i], 0);
+            if (handle != 0)
+            {
+                Close(handle);
+                closed++;
+            }
+        }
+
+        // Oldest at the bottom: only that end is cut, renters still find the warm handles on top
+        List<Idle> expired;
+        lock (_idleSync)
+        {
+            int count = 0;
+            while (count < _idle.Count && _idle[count].ReturnedAt <= cutoff)
+                count++;
+            expired = _idle.GetRange(0, count);
+            _idle.RemoveRange(0, count);
+        }
+        foreach (var idle in expired)
+            Close(idle.Handle);
+
+        return closed + expired.Count;
+    }
+
+    private nint TakeOrCreate()
+    {
+        var spin = new SpinWait();
+        nint handle;
+        while (!TryTakeIdle(out handle))
+        {
+            if (TryReserveLive())
+            {
+                try
+                {
+                    handle = _create();
+                }
+                catch
+                {
+                    Interlocked.Decrement(ref _live);
+                    Release();
+                    throw;
+                }
+
+                _tracked?.TryAdd(handle, 0);
+                return handle;
+            }
+
+            // At capacity while holding a permit: a live handle is idle, but another renter took it first
+            spin.SpinOnce();
+        }
+        return handle;
+    }
+
+    private bool TryTakeIdle(out nint handle)
+    {
+        int core = CurrentSlot();
+        handle = Interlocked.Exchange(ref _slots[core], 0);
+        if (handle != 0)
+            return true;
+
+        lock (_idleSync)
+        {
+            if (_idle.Count > 0)
+            {
+                handle = _idle[^1].Handle;
+                _idle.RemoveAt(_idle.Count - 1);
+                return true;
+            }
+        }
+
+        // Handles returned on other cores
+        for (int i = 1; i < _slots.Length; i++)
+        {
+            handle = Interlocked.Exchange(ref _slots[(core + i) % _slots.Length], 0);
+            if (handle != 0)
+                return true;
+        }
+        return false;
+    }
+
+    // Counts a handle about to be created, never past the capacity
+    private bool TryReserveLive()
+    {
+        if (_capacity == 0)
+        {
+            Interlocked.Increment(ref _live);
+            return true;
+        }
+
+        int live = Volatile.Read(ref _live);
+        while (live < _capacity)
+        {
+            int seen = Interlocked.CompareExchange(ref _live, live + 1, live);
+            if (seen == live)
+                return true;
+            live = seen;
+        }
+        return false;
+    }
+
+    private bool TryAcquire()
+    {
+        int available = Volatile.Read(ref _available);
+        while (available > 0)
+        {
+            int seen = Interlocked.CompareExchange(ref _available, available - 1, available);
+            if (seen == available)
+                return true;
+            available = seen;
+        }
+        return false;
+    }
+
+    private void Release()
+    {
+        if (_capacity == 0) return;
+
+        Interlocked.Increment(ref _available);
+        if (Volatile.Read(ref _waiters) > 0)
+            _returned!.Release();
+    }
+
+    private int CurrentSlot() => (int)((uint)Thread.GetCurrentProcessorId() % (uint)_slots.Length);
+
+    private void Close(nint handle)
+    {
+        if (_tracked != null)
+        {
+            lock (_statsSync)
+            {
+                _retired += JpegTurboNative.ReadStats(handle, _stats!);
+                _tracked.TryRemove(handle, out _);
+            }
+        }
+
+        _close(handle);
+        Interlocked.Decrement(ref _live);
+    }
+
+    private void Drain()
+    {
+        for (int i = 0; i < _slots.Length; i++)
+        {
+            var handle = Interlocked.Exchange(ref _slots[i], 0);
+            if (handle != 0)
+                Close(handle);
+        }
+
+        Idle[] idle;
+        lock (_idleSync)
+        {
+            idle = _idle.ToArray();
+            _idle.Clear();
+        }
+        foreach (var entry in idle)
+            Close(entry.Handle);
+    }
+
+    /// <summary>
+    /// Closes all idle handles; rented handles are closed when returned. Waiting renters throw.
+    /// </summary>
+    public void Dispose()
+    {
+        if (_disposed) return;
+        _disposed = true;
+
+        Drain();
+
+        // Wake every waiter so it observes the disposal
+        if (_returned != null && Volatile.Read(ref _waiters) > 0)
+            _returned.Release(Volatile.Read(ref _waiters));
+    }
+}
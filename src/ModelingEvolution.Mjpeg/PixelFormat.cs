@@ -60,6 +60,12 @@ public enum PixelFormat : byte
 
     /// <summary>I420/YV12 planar: Y + U + V planes (12 bits/pixel)</summary>
     I420 = 132,
+
+    /// <summary>I422 planar: Y + U + V planes, chroma halved horizontally (16 bits/pixel)</summary>
+    I422 = 133,
+
+    /// <summary>I444 planar: Y + U + V planes at full resolution (24 bits/pixel)</summary>
+    I444 = 134,
 }
 
 /// <summary>
@@ -80,6 +86,8 @@ public static class PixelFormatExtensions
         PixelFormat.Cmyk32 => 4,
         PixelFormat.Yuy2 or PixelFormat.Uyvy => 2, // 4 bytes per 2 pixels
         PixelFormat.Nv12 or PixelFormat.Nv21 or PixelFormat.I420 => 2, // 12 bits = 1.5 bytes, round up
+        PixelFormat.I422 => 2,
+        PixelFormat.I444 => 3,
         _ => throw new ArgumentOutOfRangeException(nameof(format), format, "Unknown pixel format")
     };
 
@@ -87,4 +95,23 @@ public static class PixelFormatExtensions
     /// Returns true if format requires YUV to RGB conversion for JPEG encoding.
     /// </summary>
     public static bool IsYuvFormat(this PixelFormat format) => (byte)format >= 128;
+
+    /// <summary>
+    /// Returns true for formats stored as a full-size Y plane followed by chroma plane(s).
+    /// </summary>
+    public static bool IsPlanarYuv(this PixelFormat format) =>
+        format is PixelFormat.I420 or PixelFormat.I422 or PixelFormat.I444 or PixelFormat.Nv12 or PixelFormat.Nv21;
+
+    /// <summary>
+    /// Chroma samples per row of a planar YUV format. Odd widths round up, so the last column keeps its
+    /// own chroma sample; NV12/NV21 rows hold two bytes per sample.
+    /// </summary>
+    public static int GetChromaWidth(this PixelFormat format, int width) =>
+        format == PixelFormat.I444 ? width : (width + 1) / 2;
+
+    /// <summary>
+    /// Chroma rows of a planar YUV format. Odd heights round up for the vertically subsampled formats.
+    /// </summary>
+    public static int GetChromaHeight(this PixelFormat format, int height) =>
+        format is PixelFormat.I422 or PixelFormat.I444 ? height : (height + 1) / 2;
 }
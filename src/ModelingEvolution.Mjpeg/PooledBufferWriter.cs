@@ -0,0 +1,101 @@
+using System.Buffers;
+
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Contiguous IBufferWriter backed by a MemoryPool. Grows by doubling when it runs out of space.
+/// As an IMemoryOwner, Memory exposes only the written bytes, so it can be handed to FrameImage directly.
+/// </summary>
+public sealed class PooledBufferWriter : IBufferWriter<byte>, IMemoryOwner<byte>
+{
+    private const int MinimumCapacity = 4096;
+
+    private readonly MemoryPool<byte> _pool;
+    private IMemoryOwner<byte>? _owner;
+    private int _written;
+
+    /// <summary>
+    /// Creates a writer with the specified initial capacity.
+    /// </summary>
+    public PooledBufferWriter(int initialCapacity = MinimumCapacity, MemoryPool<byte>? pool = null)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegative(initialCapacity);
+
+        _pool = pool ?? MemoryPool<byte>.Shared;
+        _owner = _pool.Rent(Math.Max(initialCapacity, MinimumCapacity));
+    }
+
+    /// <summary>
+    /// Number of bytes written so far.
+    /// </summary>
+    public int WrittenCount => _written;
+
+    /// <summary>
+    /// Size of the underlying buffer.
+    /// </summary>
+    public int Capacity => Owner.Memory.Length;
+
+    /// <summary>
+    /// The written bytes.
+    /// </summary>
+    public Memory<byte> WrittenMemory => Owner.Memory.Slice(0, _written);
+
+    /// <summary>
+    /// The written bytes (IMemoryOwner view).
+    /// </summary>
+    public Memory<byte> Memory => WrittenMemory;
+
+    private IMemoryOwner<byte> Owner => _owner ?? throw new ObjectDisposedException(nameof(PooledBufferWriter));
+
+    /// <inheritdoc/>
+    public void Advance(int count)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegative(count);
+        if (_written + count > Capacity)
+            throw new InvalidOperationException("Cannot advance past the end of the buffer.");
+
+        _written += count;
+    }
+
+    /// <inheritdoc/>
+    public Memory<byte> GetMemory(int sizeHint = 0)
+    {
+        EnsureCapacity(sizeHint);
+        return Owner.Memory.Slice(_written);
+    }
+
+    /// <inheritdoc/>
+    public Span<byte> GetSpan(int sizeHint = 0) => GetMemory(sizeHint).Span;
+
+    /// <summary>
+    /// Discards written data, keeping the buffer for reuse.
+    /// </summary>
+    public void Clear() => _written = 0;
+
+    private void EnsureCapacity(int sizeHint)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegative(sizeHint);
+        if (sizeHint == 0) sizeHint = 1;
+
+        var owner = Owner;
+        if (owner.Memory.Length - _written >= sizeHint)
+            return;
+
+        int required = checked(_written + sizeHint);
+        int newSize = (int)Math.Max(required, Math.Min((long)owner.Memory.Length * 2, Array.MaxLength));
+        var grown = _pool.Rent(newSize);
+        owner.Memory.Span.Slice(0, _written).CopyTo(grown.Memory.Span);
+        owner.Dispose();
+        _owner = grown;
+    }
+
+    /// <summary>
+    /// Returns the buffer to the pool.
+    /// </summary>
+    public void Dispose()
+    {
+        _owner?.Dispose();
+        _owner = null;
+        _written = 0;
+    }
+}
@@ -0,0 +1,53 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Inputs the encoder uses to pick a quality per frame in target-size mode.
+/// </summary>
+[Flags]
+public enum RateControlMode
+{
+    /// <summary>Learn the size model from the previous frames' output sizes.</summary>
+    Feedback = 1,
+
+    /// <summary>Scale the prediction by a luma gradient estimate of the frame being encoded.
+    /// Reacts to scene changes before they overshoot.</summary>
+    Complexity = 2,
+
+    /// <summary>Both inputs.</summary>
+    Adaptive = Feedback | Complexity
+}
+
+/// <summary>
+/// Target-size rate control for I420 encoders: quality is chosen per frame so the output stays
+/// close to <paramref name="TargetFrameBytes"/>. Gray8 encodes keep the fixed quality.
+/// </summary>
+/// <param name="TargetFrameBytes">Desired encoded size of one frame in bytes.</param>
+/// <param name="MinQuality">Lowest quality the controller may pick. Below 25 libjpeg emits non-baseline tables.</param>
+/// <param name="MaxQuality">Highest quality the controller may pick.</param>
+/// <param name="Mode">Inputs used to predict the frame size.</param>
+public readonly record struct RateControl(int TargetFrameBytes, int MinQuality = 25, int MaxQuality = 95,
+    RateControlMode Mode = RateControlMode.Adaptive)
+{
+    /// <summary>
+    /// Rate control for a bitrate at a given frame rate.
+    /// </summary>
+    public static RateControl FromBitrate(long bitsPerSecond, double framesPerSecond, int minQuality = 25, int maxQuality = 95,
+        RateControlMode mode = RateControlMode.Adaptive)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(bitsPerSecond);
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(framesPerSecond);
+        return new RateControl((int)Math.Clamp(bitsPerSecond / 8.0 / framesPerSecond, 1, int.MaxValue), minQuality, maxQuality, mode);
+    }
+
+    internal void Validate()
+    {
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(TargetFrameBytes);
+        if (MinQuality < 1 || MaxQuality > 100 || MinQuality > MaxQuality)
+            throw new ArgumentOutOfRangeException(nameof(MinQuality), "Quality range must be within 1-100 and MinQuality <= MaxQuality.");
+        if ((Mode & RateControlMode.Adaptive) == 0)
+            throw new ArgumentOutOfRangeException(nameof(Mode), "At least one rate control input is required.");
+    }
+
+    internal void Apply(nint encoder) =>
+        JpegTurboNative.SetTargetSize(encoder, (ulong)TargetFrameBytes, MinQuality, MaxQuality, (int)Mode);
+}
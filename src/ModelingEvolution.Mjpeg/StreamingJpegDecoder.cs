@@ -0,0 +1,158 @@
+using System.Buffers;
+
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// Result of feeding data to a <see cref="StreamingJpegDecoder"/>.
+/// </summary>
+public enum StreamingDecodeStatus
+{
+    /// <summary>Everything fed so far was decoded; the frame needs more data.</summary>
+    NeedMoreData,
+
+    /// <summary>The frame is fully decoded; see <see cref="StreamingJpegDecoder.Header"/>.</summary>
+    Completed,
+
+    /// <summary>The frame is corrupt, truncated, too large or unsupported.</summary>
+    Failed,
+}
+
+/// <summary>
+/// Decodes a JPEG while it is still arriving: each <see cref="Feed(ReadOnlySpan{byte}, bool)"/> decodes
+/// as far as the bytes received so far allow, so decoding overlaps with reception.
+/// </summary>
+/// <remarks>
+/// Backed by a libjpeg suspending data source: when the input runs dry the native decoder suspends and
+/// the next Feed resumes where it stopped. Only the unconsumed tail of the input is kept natively.
+/// 4:2:0 frames decode as raw planes and other layouts as scanlines with chroma averaged 2x2; either
+/// way the output is identical to <see cref="JpegCodecPool.DecodeI420(nint, ReadOnlyMemory{byte}, Memory{byte})"/>,
+/// at any frame size. Uses the libjpeg backend. Not thread-safe.
+/// </remarks>
+public sealed class StreamingJpegDecoder : IDisposable
+{
+    private readonly nint _decoder;
+    private MemoryHandle _output;
+    private PixelFormat _format;
+    private bool _active;
+    private bool _disposed;
+
+    /// <summary>
+    /// Creates a streaming decoder for frames up to the given dimensions.
+    /// </summary>
+    public StreamingJpegDecoder(int maxWidth, int maxHeight)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(maxWidth);
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(maxHeight);
+
+        MaxWidth = maxWidth;
+        MaxHeight = maxHeight;
+        _decoder = JpegTurboNative.CreateStreamingDecoder(maxWidth, maxHeight);
+        if (_decoder == 0)
+            throw new InvalidOperationException("Failed to create streaming JPEG decoder.");
+    }
+
+    /// <summary>Maximum frame width.</summary>
+    public int MaxWidth { get; }
+
+    /// <summary>Maximum frame height.</summary>
+    public int MaxHeight { get; }
+
+    /// <summary>State of the current frame.</summary>
+    public StreamingDecodeStatus Status { get; private set; } = StreamingDecodeStatus.Failed;
+
+    /// <summary>Decoded frame layout; valid once <see cref="Status"/> is <see cref="StreamingDecodeStatus.Completed"/>.</summary>
+    public FrameHeader Header { get; private set; }
+
+    /// <summary>
+    /// Starts a new frame. <paramref name="output"/> stays pinned until the frame completes or fails,
+    /// and must not be touched until then.
+    /// </summary>
+    /// <param name="output">Destination, large enough for a MaxWidth x MaxHeight frame of the format.</param>
+    /// <param name="format"><see cref="PixelFormat.I420"/> or <see cref="PixelFormat.Gray8"/>.</param>
+    public unsafe void Begin(Memory<byte> output, PixelFormat format = PixelFormat.I420)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        if (format != PixelFormat.I420 && format != PixelFormat.Gray8)
+            throw new NotSupportedException($"Streaming decode supports I420 and Gray8. Got: {format}");
+
+        Release();
+        _output = output.Pin();
+        _active = true;
+        if (JpegTurboNative.StreamingDecoderBegin(_decoder, format == PixelFormat.Gray8 ? 1 : 0,
+                (nint)_output.Pointer, (ulong)output.Length) == 0)
+        {
+            Release();
+            throw new InvalidOperationException("Failed to start streaming JPEG decode.");
+        }
+
+        _format = format;
+        Header = default;
+        Status = StreamingDecodeStatus.NeedMoreData;
+    }
+
+    /// <summary>
+    /// Decodes the next piece of the frame. <paramref name="isLast"/> marks the end of the frame, which then
+    /// either completes or fails. Returns the new <see cref="Status"/>.
+    /// </summary>
+    public unsafe StreamingDecodeStatus Feed(ReadOnlySpan<byte> data, bool isLast)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        if (!_active)
+            return Status;
+
+        int result;
+        JpegTurboNative.DecodeInfo info;
+        ulong written;
+        fixed (byte* ptr = data)
+        {
+            result = JpegTurboNative.StreamingDecoderFeed(_decoder, (nint)ptr, (ulong)data.Length,
+                isLast ? 1 : 0, out info, out written);
+        }
+
+        if (result == 0)
+            return Status;
+
+        Release();
+        if (result < 0)
+            return Status = StreamingDecodeStatus.Failed;
+
+        Header = new FrameHeader(info.Width, info.Height, info.Width, _format, (int)written);
+        return Status = StreamingDecodeStatus.Completed;
+    }
+
+    /// <summary>
+    /// Feeds every segment of <paramref name="data"/>; see <see cref="Feed(ReadOnlySpan{byte}, bool)"/>.
+    /// </summary>
+    public StreamingDecodeStatus Feed(in ReadOnlySequence<byte> data, bool isLast)
+    {
+        if (data.IsSingleSegment)
+            return Feed(data.FirstSpan, isLast);
+
+        var status = Status;
+        foreach (var segment in data)
+        {
+            status = Feed(segment.Span, false);
+            if (status != StreamingDecodeStatus.NeedMoreData)
+                return status;
+        }
+
+        // The end of the frame alone lets the decoder finish or report truncation
+        return isLast ? Feed(ReadOnlySpan<byte>.Empty, true) : status;
+    }
+
+    private void Release()
+    {
+        if (!_active) return;
+        _output.Dispose();
+        _output = default;
+        _active = false;
+    }
+
+    public void Dispose()
+    {
+        if (_disposed) return;
+        _disposed = true;
+        Release();
+        JpegTurboNative.CloseStreamingDecoder(_decoder);
+    }
+}
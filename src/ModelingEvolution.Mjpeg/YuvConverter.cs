@@ -0,0 +1,67 @@
+namespace ModelingEvolution.Mjpeg;
+
+/// <summary>
+/// SIMD conversions from decoded YUV frames to display formats.
+/// </summary>
+/// <remarks>
+/// Lets one I420 decode feed both analytics and a preview: convert the same frame to BGRA/RGBA instead of
+/// decoding the JPEG a second time. Uses the JFIF (full-range BT.601) matrix libjpeg applies, within 1 of
+/// its own YCbCr to RGB output.
+/// </remarks>
+public static class YuvConverter
+{
+    /// <summary>
+    /// Converts an I420 frame to packed 32-bit pixels, e.g. straight into an SKBitmap or texture buffer.
+    /// </summary>
+    /// <param name="header">Layout of <paramref name="i420"/>; Stride is the luma row stride, chroma rows are (Stride + 1) / 2 bytes.</param>
+    /// <param name="i420">I420 planes, chroma (Width + 1) / 2 x (Height + 1) / 2 as the decoders emit them.</param>
+    /// <param name="output">Destination of at least <paramref name="outputStride"/> * Height bytes.</param>
+    /// <param name="format"><see cref="PixelFormat.Bgra32"/> or <see cref="PixelFormat.Rgba32"/>; alpha is 255.</param>
+    /// <param name="outputStride">Destination row bytes, at least Width * 4 (0 = packed rows).</param>
+    /// <returns>Header describing the converted frame.</returns>
+    public static unsafe FrameHeader I420ToBgra(in FrameHeader header, ReadOnlySpan<byte> i420, Span<byte> output,
+        PixelFormat format = PixelFormat.Bgra32, int outputStride = 0)
+    {
+        if (header.Format != PixelFormat.I420)
+            throw new ArgumentException($"Expected an I420 frame. Got: {header.Format}", nameof(header));
+        if (format != PixelFormat.Bgra32 && format != PixelFormat.Rgba32)
+            throw new NotSupportedException($"I420 converts to Bgra32 or Rgba32. Got: {format}");
+
+        int width = header.Width;
+        int height = header.Height;
+        int stride = header.Stride;
+        int chromaStride = (stride + 1) / 2;
+        long lumaSize = (long)stride * height;
+        long chromaSize = (long)chromaStride * ((height + 1) / 2);
+        if (stride < width || i420.Length < lumaSize + 2 * chromaSize)
+            throw new ArgumentException($"I420 data ({i420.Length} bytes, stride {stride}) is too small for {width}x{height}.", nameof(i420));
+
+        if (outputStride == 0)
+            outputStride = width * 4;
+        if (outputStride < width * 4 || output.Length < (long)outputStride * height)
+            throw new ArgumentException($"Output ({output.Length} bytes, stride {outputStride}) is too small for {width}x{height} {format}.", nameof(output));
+
+        ulong written;
+        fixed (byte* y = i420)
+        fixed (byte* dst = output)
+        {
+            byte* u = y + lumaSize;
+            written = JpegTurboNative.ConvertI420ToBGRA((nint)y, stride, (nint)u, (nint)(u + chromaSize), chromaStride,
+                width, height, (nint)dst, outputStride, format == PixelFormat.Rgba32 ? 1 : 0);
+        }
+
+        if (written == 0)
+            throw new InvalidOperationException("Failed to convert I420 frame.");
+
+        return new FrameHeader(width, height, outputStride, format, (int)written);
+    }
+
+    /// <summary>
+    /// Converts an I420 <see cref="FrameImage"/>; see <see cref="I420ToBgra(in FrameHeader, ReadOnlySpan{byte}, Span{byte}, PixelFormat, int)"/>.
+    /// </summary>
+    public static FrameHeader I420ToBgra(FrameImage frame, Span<byte> output,
+        PixelFormat format = PixelFormat.Bgra32, int outputStride = 0)
+    {
+        return I420ToBgra(frame.Header, frame.Data.Span, output, format, outputStride);
+    }
+}